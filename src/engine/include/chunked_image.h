@@ -0,0 +1,33 @@
+// chunked_image.h — 可随机访问的分块压缩镜像（FRCI 格式）
+//
+// 归档镜像无需解压即可直接由 DiskIO::open 打开：read_at 只解压请求涉及的块，
+// 并缓存最近解压的块。全零块以空洞存储，不占空间。
+//
+// 文件布局（小端）：
+//   [0, 64)    头部：magic "FRCIMG\0\1"，u32 version(=1)，u32 chunk_size，
+//              u64 image_size，u64 chunk_count，u64 index_offset，其余保留为 0
+//   [64, ...)  各块数据，依次存放
+//   index      chunk_count + 1 个 u64 偏移：块 i 的存储数据为 [off[i], off[i+1])。
+//              长度 0 表示空洞（全零）；长度等于块原始长度表示原样存储；
+//              否则为内置 LZ 编解码器压缩的数据。
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct ChunkedImageStats {
+    uint64_t image_bytes = 0;   // 原始镜像大小
+    uint64_t stored_bytes = 0;  // 输出文件大小
+    uint64_t chunks = 0;
+    uint64_t hole_chunks = 0;   // 全零块
+    uint64_t raw_chunks = 0;    // 不可压缩、原样存储的块
+};
+
+// 默认块大小：兼顾压缩率与随机读取放大
+static const uint32_t CHUNKED_IMAGE_DEFAULT_CHUNK = 64 * 1024;
+
+// 把 src_path（普通镜像或设备）写为分块压缩镜像 dst_path。
+// chunk_size 须为 2 的幂，范围 [4 KiB, 16 MiB]。
+// 返回: true 表示成功；失败时 err（可为 NULL）为可读错误信息，不完整的输出文件被删除。
+bool write_chunked_image(const char* src_path, const char* dst_path,
+                         uint32_t chunk_size = CHUNKED_IMAGE_DEFAULT_CHUNK,
+                         ChunkedImageStats* stats = nullptr, std::string* err = nullptr);
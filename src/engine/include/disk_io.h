@@ -4,6 +4,12 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <sys/types.h> // ssize_t
+#include <atomic>
+#include <memory>
+#include <vector>
+
+struct SimDeviceModel; // 见 sim_device.h
 
 // DiskIO: 小而明确的类接口：打开、关闭、按偏移读取、不透明错误查询。
 // 设计要点：实现细节隐藏在 impl_ 中以便在不同平台下替换实现。
@@ -11,9 +17,62 @@ struct DiskIO {
     DiskIO();
     ~DiskIO();
 
-    // 打开镜像或设备路径（例如 "C:\\images\\disk.img" 或 "\\.\\PhysicalDrive0"）
+    // 打开选项（可按位组合）
+    enum OpenFlags : uint32_t {
+        OPEN_DEFAULT = 0,
+        // 绕过页缓存直接读取（Linux O_DIRECT）。read_at 的调用方无需对齐：
+        // 实现内部使用扇区对齐的中转缓冲区。若文件系统不支持直接 I/O，
+        // 会回退为普通读取（可通过 is_direct() 查询）。非 POSIX 平台忽略此标志。
+        OPEN_DIRECT = 1u << 0,
+        // 禁用 io_uring 批量读取引擎，read_batch/submit 改用线程池回退（用于对比与排障）
+        OPEN_NO_IO_URING = 1u << 1,
+        // 只读映射整个镜像文件（mmap / MapViewOfFile），启用 map_view 零拷贝访问，
+        // read_at 也改为从映射区拷贝。块设备或映射失败时自动回退为普通读取
+        // （可通过 is_mapped() 查询）。与 OPEN_DIRECT 同时指定时以 OPEN_DIRECT 为准。
+        OPEN_MAPPED = 1u << 2,
+        // 按原始字节打开，不探测镜像容器格式（例如读取分块压缩镜像文件或单个分段本身）
+        OPEN_RAW = 1u << 3,
+    };
+
+    // 访问模式提示：用于 advise()，在顺序扫描与随机访问阶段之间切换内核预读策略
+    enum AccessHint {
+        ACCESS_NORMAL = 0,
+        ACCESS_SEQUENTIAL = 1, // 顺序扫描（加大预读、读过即可回收）
+        ACCESS_RANDOM = 2,     // 随机访问（关闭预读）
+        ACCESS_WILLNEED = 3,   // 即将访问指定区间，提前异步载入
+    };
+
+    // 只读零拷贝视图：data 指向映射区内部，pin 持有映射的引用计数，
+    // 因此视图存活期间即使句柄被 close() 或析构，data 仍然有效。
+    struct View {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<const void> pin;
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    // 批量读取中的单个请求。result 由实现填写：实际读取字节数或 -1。
+    struct ReadRequest {
+        uint64_t offset = 0;
+        void* buf = nullptr;
+        size_t size = 0;
+        ssize_t result = 0;
+    };
+
+    // 请求完成回调：可能在内部工作线程中调用，回调应尽快返回且不得阻塞等待本句柄的 wait_all()。
+    typedef void (*ReadCallback)(ReadRequest& req, void* user);
+
+    // 打开镜像或设备路径（例如 "C:\\images\\disk.img" 或 "\\.\\PhysicalDrive0"）。
+    // 分块压缩镜像（见 chunked_image.h）按文件头自动识别，作为虚拟设备透明读取。
+    // 分段镜像：打开 "<base>.001"（任意 ≥3 位的数字扩展名）时，从该编号起连续存在的
+    // 各分段按顺序拼接为一个虚拟设备。
     // 返回: true 表示成功；false 表示失败，可用 last_error() 获取可读错误信息
     bool open(const char* path);
+    bool open(const char* path, uint32_t flags);
+
+    // 以模拟设备方式打开镜像：按 model 注入延迟与故障（见 sim_device.h），
+    // 用于在快速存储上复现慢速/不可靠设备的行为。flags 作用于底层镜像。
+    bool open_simulated(const char* path, const SimDeviceModel& model, uint32_t flags = OPEN_DEFAULT);
 
     // 关闭此前打开的设备/镜像句柄
     void close();
@@ -28,9 +87,149 @@ struct DiskIO {
     //       从而支持并发读取。
     ssize_t read_at(uint64_t offset, void* buf, size_t size);
 
-    // 返回最后一次错误的可读文本（仅用于调试/日志），返回值指向内部缓冲区
+    // 批量读取：同时提交 count 个请求并等待全部完成（Linux 上使用 io_uring，
+    // 其他情况使用线程池并发 read_at）。每个请求的结果写入 req.result。
+    // 返回: true 表示所有请求都未出错（result >= 0；短读表示 EOF）。
+    bool read_batch(ReadRequest* reqs, size_t count);
+
+    // 异步提交：立即返回，请求完成时调用 on_complete（可为 NULL）。
+    // reqs 数组及其缓冲区必须在 wait_all() 返回前保持有效。
+    // 返回: false 表示参数无效或句柄未打开（此时不会调用回调）。
+    bool submit(ReadRequest* reqs, size_t count, ReadCallback on_complete, void* user);
+
+    // 等待此前通过 submit 提交的全部请求完成
+    void wait_all();
+
+    // 获取 [offset, offset+size) 的只读视图（仅映射模式可用）。
+    // 返回: true 并填充 out；false 表示未处于映射模式或区间越界，调用方应改用 read_at。
+    bool map_view(uint64_t offset, size_t size, View& out);
+
+    // 访问模式提示。len == 0 表示从 offset 到末尾。提示失败被静默忽略。
+    void advise(AccessHint hint, uint64_t offset = 0, uint64_t len = 0);
+
+    // 当前句柄是否处于映射模式
+    bool is_mapped() const;
+
+    // 元数据块缓存统计
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t bypassed = 0;     // 过大而直接透传到设备的读取次数
+        size_t resident_bytes = 0; // 当前缓存占用
+    };
+
+    // 启用线程安全、分片、容量受限的块缓存（CLOCK 淘汰）。启用后 read_at 的小请求
+    // （小于 4 个块）按 block_size 对齐的整块读取并缓存，重复的元数据读取不再访问设备；
+    // 大请求直接透传。再次调用会替换原缓存。映射模式下页缓存已足够，返回 false。
+    // 说明：启用/禁用须在没有并发读取时调用。
+    bool enable_block_cache(size_t capacity_bytes, size_t block_size = 64 * 1024);
+    void disable_block_cache();
+    CacheStats block_cache_stats() const;
+
+    // 顺序预读统计
+    struct ReadaheadStats {
+        uint64_t hits = 0;          // 完全由已就绪的预读数据满足的顺序读取次数
+        uint64_t misses = 0;        // 顺序读取中仍需等待设备的次数
+        uint64_t prefetched_bytes = 0;
+        size_t window_bytes = 0;    // 当前预读窗口（自适应增长）
+    };
+
+    // 启用自适应顺序预读：同一线程连续的首尾相接读取被识别为顺序流后，
+    // 在 I/O 线程池中双缓冲异步预读下一个窗口。窗口从 128 KiB 起步，消费方
+    // 等待设备时翻倍，直到 max_window_bytes。随机读取不受影响。
+    // 映射模式下由内核预读负责，返回 false。启用/禁用须在没有并发读取时调用。
+    bool enable_readahead(size_t max_window_bytes = 4 * 1024 * 1024);
+    void disable_readahead();
+    ReadaheadStats readahead_stats() const;
+
+    // 坏扇区容错读取
+    struct BadRange {
+        uint64_t offset;
+        uint64_t length;
+    };
+    struct ResilientStats {
+        uint64_t bad_ranges = 0;        // 跳过表中的（合并后）区间数
+        uint64_t bad_bytes = 0;         // 跳过表覆盖的字节数
+        uint64_t zero_filled_bytes = 0; // 因坏扇区以零填充返回的累计字节数
+        uint64_t split_reads = 0;       // 二分定位坏扇区时额外发起的读取次数
+        uint64_t skipped_bytes = 0;     // 因连续坏扇区而未读取、直接记为坏区的字节数
+    };
+
+    // 启用容错读取（类似 ddrescue）：请求先整块读取，失败时在失败区间内按扇区
+    // 边界二分，把无法读取的扇区记入跳过表并以零填充，read_at 仍返回完整长度。
+    // 连续遇到多个坏扇区时其后部分不再读取，直接记为坏区（跳过表文件中标记为 untried），
+    // 整片失效的区域因此只需少量设备读取。
+    // 已记录的坏区间不再访问设备。skip_map_path 非空时从该文件载入跳过表，并把
+    // 新发现的坏区间追加写入，供后续扫描复用。块缓存与预读也经过此层。
+    // 映射模式下坏扇区表现为 SIGBUS 而无法处理，返回 false；跳过表文件格式错误也返回 false。
+    // 启用/禁用须在没有并发读取时调用。
+    bool enable_resilient_reads(const char* skip_map_path = nullptr);
+    void disable_resilient_reads();
+    ResilientStats resilient_stats() const;
+    // 当前跳过表（按偏移排序、已合并）
+    std::vector<BadRange> bad_ranges() const;
+
+    // I/O 限速统计
+    struct ThrottleStats {
+        uint64_t delayed_reads = 0; // 因限速而等待的设备读取次数
+        uint64_t delay_us = 0;      // 累计等待时间（微秒）
+    };
+
+    // 设置设备读取的带宽（字节/秒）与 IOPS 上限，0 表示不限制。由令牌桶在设备读取
+    // 一侧执行（缓存命中不计入），允许约 50 ms 配额的突发。可在读取进行中随时调用，
+    // 新限额立即生效并唤醒正在等待的读取；未设置限额时读取路径只多一次原子读取。
+    void set_throttle(uint64_t bytes_per_sec, uint32_t iops);
+    ThrottleStats throttle_stats() const;
+
+    // 返回调用线程最近一次失败操作的可读错误文本（仅用于调试/日志）。
+    // 错误状态按线程保存（与 errno 语义相同）：并发读取互不覆盖，成功的读取
+    // 不会清除它；open 成功时清空。返回值在本线程下一次失败前有效。
     const char* last_error() const;
+    // 与 last_error() 对应的系统错误码（POSIX errno / Windows GetLastError()），
+    // 非系统调用错误（如参数无效）为 0
+    int last_error_code() const;
+
+    // 当前句柄是否以直接 I/O（绕过页缓存）方式打开
+    bool is_direct() const;
+
+    // 设备逻辑扇区大小（字节）；直接 I/O 的对齐粒度。未打开时返回 512。
+    size_t sector_size() const;
 
 private:
+    // 平台原始打开/关闭/读取（各平台源文件实现）。公开的 open/close/read_at 在其上
+    // 叠加缓存等平台无关的功能层（见 disk_io_common.cpp）。
+    bool open_device(const char* path, uint32_t flags);
+    void close_device();
+    ssize_t read_device(uint64_t offset, void* buf, size_t size);
+    // 平台设备句柄是否已打开（不经过任何功能层）
+    bool device_open() const;
+    // 功能层使用的设备读取：启用容错读取时经过跳过表与二分定位，否则等同 read_raw
+    ssize_t read_media(uint64_t offset, void* buf, size_t size);
+    // 镜像容器数据源（若有）或平台设备读取
+    ssize_t read_raw(uint64_t offset, void* buf, size_t size);
+    // 是否有功能层、限速或数据源需要 read_at 语义（批量读取此时不能使用原生引擎）
+    bool layered() const;
+    // 平台原生批量读取（例如 io_uring）。返回 false 表示本次不可用，由调用方回退到线程池。
+    bool read_batch_native(ReadRequest* reqs, size_t count, ReadCallback cb, void* user);
+    // 线程池回退：并发执行 read_at，调用线程也参与执行，保证不会因线程池饱和而死锁。
+    void read_batch_pooled(ReadRequest* reqs, size_t count, ReadCallback cb, void* user);
+    // 释放异步提交状态
+    void release_async();
+    // 释放全部平台无关状态（异步提交、功能层）；由各平台析构函数调用
+    void release_common();
+    // 记录/清除调用线程的错误状态（见 last_error）
+    static void set_error(const char* what, int code = 0);
+    static void clear_error();
+
     void* impl_; // 不透明实现指针（实现具体类型在各平台源文件中定义）
+    std::atomic<struct DiskIOAsyncState*> async_{nullptr}; // submit/wait_all 的挂起计数（见 disk_io_batch.cpp），首次 submit 时创建
+    class BlockCache* cache_ = nullptr;        // 可选块缓存（见 block_cache.h）
+    class Readahead* readahead_ = nullptr;     // 可选顺序预读（见 readahead.h）
+    class ResilientReader* resilient_ = nullptr; // 可选坏扇区容错读取（见 resilient_reader.h）
+    class ImageSource* source_ = nullptr;      // 镜像容器数据源（见 image_source.h），普通镜像为空
+    std::atomic<class IoThrottle*> throttle_{nullptr}; // 限速器（见 io_throttle.h），首次设置限额时创建
+
+    friend class ImageSource;
+    friend class IoUringRing; // 在调用线程上记录请求失败的错误
 };
@@ -30,13 +30,17 @@ typedef struct fr_handle_s* fr_handle_t;
 // 扫描模式：快速或深度扫描。
 typedef enum {
     FR_SCAN_QUICK = 0, // 更快、依赖文件系统元数据或简单签名
-    FR_SCAN_DEEP = 1   // 更全面，可能包含数据雕刻等耗时操作
+    FR_SCAN_DEEP = 1   // 更全面：另外读取 $Bitmap 标记为空闲的簇（孤儿 MFT 记录等），可能包含数据雕刻等耗时操作
 } fr_scan_mode_t;
 
-// 扫描参数：目前只包含扫描模式与线程数量（0 表示自动决定）。
+// 扫描参数：扫描模式、线程数量（0 表示自动决定）与读取限速。
+// 在线系统上扫描时可设置限速，避免扫描读满设备影响正常业务；调用方应将
+// 未使用的字段置 0。
 typedef struct {
     fr_scan_mode_t mode;
     uint32_t max_threads; // 0 = 自动选择（基于硬件）
+    uint32_t max_read_iops;          // 每秒读取次数上限，0 = 不限制
+    uint64_t max_read_bytes_per_sec; // 读取带宽上限（字节/秒），0 = 不限制
 } fr_scan_params_t;
 
 // 扫描候选项：向上层报告发现的可恢复文件信息。
@@ -45,7 +49,7 @@ typedef struct {
     uint64_t id;            // 引擎内部分配的候选项标识
     uint64_t offset;        // 在镜像/设备上的偏移（字节）
     uint64_t size;          // 估计大小（字节）
-    char file_name[256];    // 文件名（若可推断）
+    char file_name[256];    // 文件名（若可推断）；来自 MFT 时为以 '\\' 分隔的完整路径
     char mime_type[64];     // MIME 类型提示（可选）
 } fr_candidate_t;
 
@@ -70,6 +74,10 @@ void fr_close(fr_handle_t h);
 // 返回: FR_OK 或错误码
 fr_error_t fr_start_scan(fr_handle_t h, const fr_scan_params_t* params);
 
+// 调整句柄的读取限速（可在扫描进行中调用，立即生效）。0 表示不限制。
+// 返回: FR_OK 或错误码
+fr_error_t fr_set_io_limits(fr_handle_t h, uint64_t max_read_bytes_per_sec, uint32_t max_read_iops);
+
 // 获取下一个候选项（轮询）
 // 参数: h   - 会话句柄
 //        out - 输出缓冲区，调用者负责分配
@@ -82,7 +90,9 @@ fr_error_t fr_get_next_candidate(fr_handle_t h, fr_candidate_t* out);
 // 返回: FR_OK 或错误码
 fr_error_t fr_export_candidate(fr_handle_t h, uint64_t candidate_id, const char* out_path);
 
-// 保存/加载项目（用于断点续查）
+// 保存/加载项目（用于断点续查）：项目保存句柄上的 MFT 表及各记录的指纹，
+// 载入后对同一卷调用 fr_start_scan 只重新解析自保存以来变化的记录
+// 返回: FR_OK；FR_ERR_IO 表示写入失败或项目文件无效/损坏
 fr_error_t fr_save_project(fr_handle_t h, const char* project_path);
 fr_error_t fr_load_project(fr_handle_t h, const char* project_path);
 
@@ -0,0 +1,66 @@
+// mft_path.h — 由 parent_reference 重建完整路径（带记忆化的目录树）
+//
+// MFT 记录只保存文件名与父目录的文件引用（低 48 位为记录号，高 16 位为序列号）。
+// MFTPathResolver 在 MFTTable 上一次线性遍历建立“行 → 父目录行”索引，路径按需解析：
+// 每个目录的完整路径只拼接一次并缓存在连续的字符池中，文件路径为父目录路径加文件名，
+// 因此解析全部记录的总开销与路径总长度成线性，而不是每个文件沿父链重新遍历一次。
+//
+// 父引用的序列号与父记录不符（父目录已被删除且记录号被复用）、父记录缺失或不是目录
+// 时，记录是孤儿，路径挂在虚拟目录 MFT_ORPHAN_DIR 下；父链成环（损坏的元数据）时在
+// 环的入口处断开，同样挂到孤儿目录下。
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "mft_table.h"
+
+// 根目录的 MFT 记录号（"."，父引用指向自身）
+const uint64_t NTFS_ROOT_RECORD = 5;
+// 孤儿记录所在的虚拟目录名
+const char MFT_ORPHAN_DIR[] = "$OrphanFiles";
+
+// 路径解析结果
+enum MFTPathStatus {
+    MFT_PATH_OK = 0,     // 父链完整到达根目录
+    MFT_PATH_ORPHAN = 1, // 父链在某处断开（父记录缺失、已被复用或不是目录）
+    MFT_PATH_CYCLE = 2,  // 父链成环
+};
+
+class MFTPathResolver {
+public:
+    // 建立父目录索引（O(行数)）。table 在解析器的生命期内不得修改
+    explicit MFTPathResolver(const MFTTable& table, char separator = '\\');
+
+    // 行的父目录行；根目录或父链断开时返回 false
+    bool parent(MFTRow row, MFTRow& out) const;
+
+    // 完整路径，以分隔符开头（例如 "\Users\a.txt"；根目录为 "\"）。写入 out 并返回解析状态
+    MFTPathStatus path(MFTRow row, std::string& out);
+    std::string path(MFTRow row);
+    MFTPathStatus status(MFTRow row);
+
+    // 已缓存路径的目录数与字符池大小
+    size_t memoized() const { return prefixes_.size(); }
+    size_t memory_bytes() const;
+
+private:
+    // 解析目录 row 的完整路径（必要时沿父链向上），返回其在 prefixes_ 中的下标
+    uint32_t resolve_dir(MFTRow row);
+    // 以 parent_prefix（UINT32_MAX 表示孤儿目录）为前缀为 row 缓存路径
+    uint32_t memoize(MFTRow row, uint32_t parent_prefix, uint8_t status);
+    std::string_view prefix(uint32_t idx) const {
+        return std::string_view(chars_.data() + prefixes_[idx].first, prefixes_[idx].second);
+    }
+
+    const MFTTable& table_;
+    char sep_;
+    std::vector<uint32_t> parents_;   // 父目录行；PARENT_ROOT / PARENT_ORPHAN 为哨兵
+    std::vector<uint32_t> memo_;      // 目录行的路径在 prefixes_ 中的下标 + 1，0 表示未解析
+    std::vector<uint8_t> state_;      // 解析状态（进行中 / MFTPathStatus）
+    std::vector<std::pair<uint64_t,uint32_t>> prefixes_; // 字符池中的 <偏移, 长度>
+    std::vector<char> chars_;
+    std::vector<MFTRow> stack_;       // resolve_dir 的显式栈（复用）
+};
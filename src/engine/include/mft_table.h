@@ -0,0 +1,241 @@
+// mft_table.h — 列式 MFT 记录表（struct-of-arrays）
+//
+// 千万级文件的卷上，逐条保存 NTFSFileRecord（std::string + std::vector + 填充）要占用
+// 数 GB 内存，过滤或排序时也会不断换出缓存。MFTTable 把各字段分别存放在独立的列中，
+// 过滤只触及用到的列；文件名驻留在一个连续的名称池中（相同名称只存一份），
+// 所有记录的 runlist 连续存放在共享的区段池中。
+// 表可以直接由 NTFSParser::scan_mft_views 流式填充，填充过程不为单条记录分配内存
+// （列按需成倍增长）。
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "disk_io.h"
+#include "ntfs_mft.h"
+
+// 表中的行号（按追加顺序，从 0 开始）
+typedef uint32_t MFTRow;
+
+// 行标志：与 MFT 记录头 flags 共用一列，NTFS 只使用低位
+const uint16_t MFT_ROW_TORN = 0x8000; // USA 校验失败的记录
+
+// 名称池：驻留 UTF-8 名称，返回稳定的名称 id。所有名称首尾相接存放在一个字符数组中，
+// 以开放寻址哈希表去重。id 0 固定为空名称；池总长度上限为 4 GiB，超出后 intern 返回 0。
+class MFTNamePool {
+public:
+    MFTNamePool();
+
+    uint32_t intern(std::string_view name);
+    std::string_view get(uint32_t id) const {
+        return std::string_view(bytes_.data() + offsets_[id], offsets_[id + 1] - offsets_[id]);
+    }
+    size_t count() const { return offsets_.size() - 1; } // 含空名称
+    size_t bytes() const { return bytes_.size(); }
+    size_t memory_bytes() const;
+    void reserve(size_t names, size_t bytes);
+    void clear();
+
+private:
+    friend class MFTTable; // save / load 直接读写名称数组
+    void rehash(size_t slots);
+
+    std::vector<char> bytes_;       // 名称内容（无分隔符）
+    std::vector<uint32_t> offsets_; // 名称 id 的起始偏移，末项为总长度
+    std::vector<uint32_t> slots_;   // 哈希槽：名称 id，0 表示空槽（空名称不入表）
+};
+
+// 一行的 runlist：区段池中的一段
+struct MFTRunSpan {
+    const std::pair<uint64_t,int64_t>* first;
+    const std::pair<uint64_t,int64_t>* last;
+    const std::pair<uint64_t,int64_t>* begin() const { return first; }
+    const std::pair<uint64_t,int64_t>* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// 按行号顺序遍历满足 pred(row) 的行；pred 为空谓词时遍历全部行
+template <class Pred>
+class MFTRowRange {
+public:
+    class iterator {
+    public:
+        iterator(const MFTRowRange* range, MFTRow row) : range_(range), row_(row) { skip(); }
+        MFTRow operator*() const { return row_; }
+        iterator& operator++() {
+            ++row_;
+            skip();
+            return *this;
+        }
+        bool operator==(const iterator& o) const { return row_ == o.row_; }
+        bool operator!=(const iterator& o) const { return row_ != o.row_; }
+
+    private:
+        void skip() {
+            while (row_ < range_->end_ && !range_->pred_(row_)) ++row_;
+        }
+        const MFTRowRange* range_;
+        MFTRow row_;
+    };
+
+    MFTRowRange(MFTRow end, Pred pred) : end_(end), pred_(pred) {}
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, end_); }
+
+private:
+    MFTRow end_;
+    Pred pred_;
+};
+
+// 遍历全部行的谓词
+struct MFTAllRows {
+    bool operator()(MFTRow) const { return true; }
+};
+
+// 表对应的卷与 $UsnJrnl 位置，随表一起保存。refresh 据此判断能否增量更新：
+// 卷序列号或记录大小不同时整表重建；日志 id 不变且 next_usn 仍有效时只读取日志中的变化
+struct MFTTableStamp {
+    uint64_t serial_number = 0;
+    uint32_t mft_record_size = 0;
+    uint64_t journal_record = 0; // $Extend\$UsnJrnl 的记录号，0 表示卷上没有（或无法读取）日志
+    uint64_t journal_id = 0;
+    uint64_t next_usn = 0;       // 表最后一次与卷同步时日志的下一条 USN
+};
+
+// refresh 的统计信息
+struct MFTRefreshStats {
+    bool journal = false;    // 变化集合取自 $UsnJrnl（只读取了变化的记录，未读取整个 MFT）
+    bool rebuilt = false;    // 表为空或卷不同，整表重新填充
+    uint64_t reparsed = 0;   // 重新解析的记录数（变化或新增）
+    uint64_t unchanged = 0;  // 沿用原有行的记录数
+    uint64_t removed = 0;    // 不再是有效记录而被删除的行数
+    MFTScanStats scan;       // 读取整个 MFT 时的扫描统计（journal 为 true 时全为 0）
+};
+
+class MFTTable {
+public:
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+    // 预留 rows 行以及名称池与区段池的容量，避免填充过程中反复扩容
+    void reserve(size_t rows, size_t name_bytes = 0, size_t runs = 0);
+    void clear();
+
+    // 追加一行：名称就地转换为 UTF-8 后驻留（截断为 255 字节），runlist 解码进区段池。
+    // 只解码视图自身的 DATA 片段；fill 与 refresh 另外为 ATTRIBUTE_LIST 文件拼接扩展记录
+    MFTRow append(const NTFSRecordView& view);
+    MFTRow append(const NTFSFileRecord& record);
+
+    // 从 MFT 流式填充（追加到表尾）：按 runlist 预估记录数预留容量后，以
+    // scan_mft_views 扫描并逐条追加。解析线程数取自 parser.set_threads。
+    // DATA runlist 分布在扩展记录中的文件在扫描中登记，扫描结束后一次批量读取全部扩展记录，
+    // 再为这些行拼接完整的 runlist 与文件大小（见 MFTExtensionBatch）。
+    // 扫描完成后记录卷序列号、记录大小与 $UsnJrnl 的当前状态（见 stamp），供 refresh 使用。
+    // 返回: scan_mft_views 的结果
+    bool fill(NTFSParser& parser, DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+              uint64_t mft_size, MFTScanStats* stats = nullptr);
+    // 同上，$MFT 的 runlist 取自卷几何所指的记录 0
+    bool fill(NTFSParser& parser, DiskIO& dio, MFTScanStats* stats = nullptr);
+
+    // 增量更新：调查期间重复扫描同一卷时不再重新解析整个 MFT。
+    //  - 表上次同步时的日志仍然有效（日志 id 相同、next_usn 未被回收）时，只读取日志中
+    //    自那以后涉及的记录及其父目录（外加不写日志的元文件 0..15），按记录号批量读取；
+    //  - 否则顺序读取整个 MFT，但只重新解析指纹（LSN、序列号与记录内容哈希）变化的记录，
+    //    其余记录直接沿用原有行。
+    // 表为空或属于其他卷时等同于 clear + fill。失败时表保持不变。
+    bool refresh(NTFSParser& parser, DiskIO& dio, MFTRefreshStats* stats = nullptr);
+
+    const MFTTableStamp& stamp() const { return stamp_; }
+    void set_stamp(const MFTTableStamp& stamp) { stamp_ = stamp; }
+
+    // 保存 / 载入整张表（含指纹列与 stamp）。二进制格式按小端主机字节序存放各列，
+    // 载入时校验格式与各列长度的一致性。失败时 err 给出原因，load 失败时表保持不变
+    bool save(const char* path, std::string* err = nullptr) const;
+    bool load(const char* path, std::string* err = nullptr);
+
+    // 单元格访问
+    uint64_t id(MFTRow r) const { return ids_[r]; }
+    uint64_t file_size(MFTRow r) const { return sizes_[r]; }
+    uint16_t flags(MFTRow r) const { return flags_[r]; }
+    bool in_use(MFTRow r) const { return (flags_[r] & 0x01) != 0; }
+    bool is_directory(MFTRow r) const { return (flags_[r] & 0x02) != 0; }
+    bool torn(MFTRow r) const { return (flags_[r] & MFT_ROW_TORN) != 0; }
+    uint64_t creation_time(MFTRow r) const { return creation_times_[r]; }
+    uint64_t modified_time(MFTRow r) const { return modified_times_[r]; }
+    uint64_t parent_reference(MFTRow r) const { return parents_[r]; }
+    uint16_t sequence_number(MFTRow r) const { return sequences_[r]; }
+    uint32_t name_id(MFTRow r) const { return name_ids_[r]; }
+    // 指纹：记录头中的 LSN 与记录内容哈希（由 NTFSFileRecord 追加的行没有原始记录，均为 0）
+    uint64_t lsn(MFTRow r) const { return lsns_[r]; }
+    uint64_t record_hash(MFTRow r) const { return hashes_[r]; }
+    std::string_view name(MFTRow r) const { return names_.get(name_ids_[r]); }
+    MFTRunSpan runs(MFTRow r) const {
+        return MFTRunSpan{ runs_.data() + run_starts_[r], runs_.data() + run_starts_[r + 1] };
+    }
+
+    // 整列（供批量过滤、排序与统计直接遍历）
+    const std::vector<uint64_t>& ids() const { return ids_; }
+    const std::vector<uint64_t>& file_sizes() const { return sizes_; }
+    const std::vector<uint16_t>& flags() const { return flags_; }
+    const std::vector<uint64_t>& creation_times() const { return creation_times_; }
+    const std::vector<uint64_t>& modified_times() const { return modified_times_; }
+    const std::vector<uint64_t>& parent_references() const { return parents_; }
+    const std::vector<uint16_t>& sequence_numbers() const { return sequences_; }
+    const std::vector<uint32_t>& name_ids() const { return name_ids_; }
+    const MFTNamePool& names() const { return names_; }
+
+    // 遍历：for (MFTRow r : table.rows())；for (MFTRow r : table.filter(pred))
+    MFTRowRange<MFTAllRows> rows() const { return MFTRowRange<MFTAllRows>(static_cast<MFTRow>(size()), MFTAllRows()); }
+    template <class Pred>
+    MFTRowRange<Pred> filter(Pred pred) const { return MFTRowRange<Pred>(static_cast<MFTRow>(size()), pred); }
+
+    // 按记录号查找行（要求记录号按追加顺序递增，fill 保证这一点）
+    bool find(uint64_t id, MFTRow& row) const;
+    // 还原为拥有数据的记录（link_count 与 name_namespace 不在表中保存，置 0）
+    void materialize(MFTRow r, NTFSFileRecord& out) const;
+    // 文件尾部的 slack：使用中的非目录文件在文件大小之后、已分配簇末尾之前的部分，
+    // 按 vol 换算为磁盘字节区域 <disk_offset, bytes> 追加到 regions（稀疏区段跳过）。
+    // 与 NTFSParser::free_space_regions 的结果一起交给 scan_regions 即可连同 slack 扫描
+    void slack_regions(const NTFSVolume& vol, std::vector<std::pair<uint64_t,uint64_t>>& regions) const;
+    // 表占用的堆内存（按容量计）
+    size_t memory_bytes() const;
+
+private:
+    MFTRow push_row(uint64_t id, uint64_t size, uint16_t flags, uint16_t seq, uint64_t ctime,
+                    uint64_t mtime, uint64_t parent, uint32_t name_id, uint64_t lsn, uint64_t hash);
+    // 需要拼接 runlist 的行：扫描中登记基本记录（保存其副本，视图只在回调期间有效），
+    // 扫描结束后由 stitch_rows 一次取回全部扩展记录
+    struct PendingStitch {
+        MFTExtensionBatch ext;
+        std::vector<MFTRow> rows;
+        std::vector<uint8_t> records; // 各行基本记录的副本（已修正 USA），与 rows 一一对应
+        std::vector<uint8_t> torn;
+        size_t record_size = 0;
+    };
+    // 追加一行；视图带有指向其他记录的 DATA 片段时登记到 pending
+    MFTRow append(const NTFSRecordView& view, PendingStitch& pending);
+    // 读取 pending 登记的扩展记录，改写对应行的文件大小与 runlist（区段池重建一次）
+    void stitch_rows(NTFSParser& parser, DiskIO& dio, PendingStitch& pending, MFTScanStats* stats);
+    // 追加 src 的第 r 行；same_names 表示本表的名称池是 src 名称池的副本（名称 id 直接沿用）
+    MFTRow copy_row(const MFTTable& src, MFTRow r, bool same_names);
+    // 按卷几何与表中的 $Extend\$UsnJrnl 行更新 stamp_
+    void capture_journal(NTFSParser& parser, DiskIO& dio);
+
+    std::vector<uint64_t> ids_;
+    std::vector<uint64_t> sizes_;
+    std::vector<uint16_t> flags_;
+    std::vector<uint16_t> sequences_;
+    std::vector<uint64_t> creation_times_;
+    std::vector<uint64_t> modified_times_;
+    std::vector<uint64_t> parents_;
+    std::vector<uint32_t> name_ids_;
+    std::vector<uint64_t> lsns_;
+    std::vector<uint64_t> hashes_;
+    std::vector<uint32_t> run_starts_{0}; // 各行在区段池中的起点，末项为区段总数
+    std::vector<std::pair<uint64_t,int64_t>> runs_;
+    MFTNamePool names_;
+    NTFSRunList scratch_; // append 解码 runlist 的暂存区（复用，不逐条分配）
+    MFTTableStamp stamp_;
+};
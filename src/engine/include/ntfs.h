@@ -25,7 +25,14 @@ extern "C" {
 //  - image_path: 镜像文件路径或设备路径（实现可扩展以接受 DiskIO）
 //  - err_buf:    用于接收可读错误信息的缓冲区（可为 NULL）
 // 返回: 非空句柄表示成功
+// 说明: 镜像起始处是 NTFS 卷时，后台线程随即开始扫描 MFT，ntfs_next_record 按记录号
+//       顺序返回结果；否则（原型阶段）返回模拟记录。
 ntfs_parser_t ntfs_open(const char* image_path, char* err_buf, size_t err_buf_len);
+
+// 同 ntfs_open，另可指定卷在镜像中的字节偏移（例如分区起始位置）与解析线程数
+// （0 表示硬件并发数）
+ntfs_parser_t ntfs_open_ex(const char* image_path, uint64_t volume_offset, uint32_t max_threads,
+                           char* err_buf, size_t err_buf_len);
 void ntfs_close(ntfs_parser_t p);
 
 // 读取下一个 MFT 条目（迭代风格）
@@ -2,7 +2,10 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 #include "disk_io.h"
@@ -23,6 +26,31 @@ struct MFTHeader {
     uint16_t next_attr_id;          // Next attribute ID
 };
 
+// 区段索引：各区段起始 VCN 的前缀和（n + 1 项，末项为簇总数）。按文件偏移二分查找
+// 所在区段，map_file_range / read_file_range 的定位代价为 O(log runs) 而不是 O(runs)。
+class NTFSRunIndex {
+public:
+    explicit NTFSRunIndex(const std::vector<std::pair<uint64_t,int64_t>>& runs);
+
+    size_t size() const { return starts_.size() - 1; }
+    uint64_t total_clusters() const { return starts_.back(); }
+    uint64_t start_vcn(size_t run) const { return starts_[run]; }
+    // 包含 vcn 的区段下标（跳过长度为 0 的区段）；vcn 超出全部区段时返回 size()
+    size_t find(uint64_t vcn) const;
+    // 索引是否仍对应 runs：比较区段数与首末区段（O(1)，不逐项校验）
+    bool matches(const std::vector<std::pair<uint64_t,int64_t>>& runs) const;
+    size_t memory_bytes() const { return starts_.capacity() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> starts_;
+    std::pair<uint64_t,int64_t> first_{0, 0};
+    std::pair<uint64_t,int64_t> last_{0, 0};
+};
+
+// 区段数不少于此值时 map_file_range / read_file_range 才建立并缓存 NTFSRunIndex，
+// 更短的 runlist 线性查找更快
+const size_t NTFS_RUN_INDEX_MIN_RUNS = 16;
+
 // NTFS 文件记录（简化表示）。实际实现会从 MFT 记录中提取
 // 文件标识、文件名、大小以及其他属性。
 struct NTFSFileRecord {
@@ -32,6 +60,7 @@ struct NTFSFileRecord {
     // 新增字段用于 header 解析
     uint16_t flags;     // MFT record flags
     uint16_t link_count; // Hard link count
+    uint16_t sequence_number = 0; // 记录的序列号（记录被释放时递增，用于校验文件引用）
     // STANDARD_INFORMATION fields
     uint64_t creation_time; // FILETIME (100-ns intervals since 1601)
     uint64_t modified_time;
@@ -40,6 +69,245 @@ struct NTFSFileRecord {
     // Data runs for non-resident DATA attribute. Each pair is <cluster_count, lcn>
     // lcn == -1 indicates a sparse run (unallocated)
     std::vector<std::pair<uint64_t,int64_t>> data_runs;
+    // data_runs 的区段索引，由 map_file_range / read_file_range 在首次访问时建立并缓存
+    // （原子发布，可由多个线程同时读取同一记录）。就地修改 data_runs 中间的区段后
+    // 需调用 run_index.reset()；区段数或首末区段变化时索引会被自动识别为过期
+    mutable std::shared_ptr<const NTFSRunIndex> run_index;
+    // USA 校验失败（扇区写入中断或记录损坏）：各扇区末尾两个字节未被修正，
+    // 跨越扇区边界的属性内容可能不可信
+    bool torn = false;
+};
+
+// 小缓冲区 runlist：前 NTFS_INLINE_RUNS 个区段存放在对象内部，超出时才使用堆内存
+// （clear 保留容量，复用同一对象时不会重复分配）。绝大多数文件只有少数几个区段。
+const size_t NTFS_INLINE_RUNS = 8;
+class NTFSRunList {
+public:
+    typedef std::pair<uint64_t,int64_t> Run; // <cluster_count, lcn>，lcn == -1 为稀疏
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Run* data() const { return size_ <= NTFS_INLINE_RUNS ? inline_ : heap_.data(); }
+    Run* data() { return size_ <= NTFS_INLINE_RUNS ? inline_ : heap_.data(); }
+    const Run* begin() const { return data(); }
+    const Run* end() const { return data() + size_; }
+    const Run& operator[](size_t i) const { return data()[i]; }
+
+    void clear() { size_ = 0; heap_.clear(); }
+    void push_back(const Run& run);
+    // 截短为前 n 项（n <= size()）
+    void truncate(size_t n);
+
+private:
+    Run inline_[NTFS_INLINE_RUNS];
+    size_t size_ = 0;
+    std::vector<Run> heap_; // 超过内联容量时存放全部区段
+};
+
+// NTFSRecordView：一条（已修正 USA 的）MFT 记录的非拥有视图。reset 只校验头部并
+// 定位 STANDARD_INFORMATION、FILE_NAME、DATA 与 ATTRIBUTE_LIST 属性的位置，不解码内容；
+// 时间戳、文件名与 runlist 在访问时才从记录缓冲区解码，且都不分配堆内存。
+// 视图引用的缓冲区必须在使用期间保持有效（scan_mft_views 中即回调返回之前）。
+// 需要长期保存或拥有数据时调用 materialize 生成 NTFSFileRecord。
+class NTFSRecordView {
+public:
+    // 绑定到 data 处长 size 字节的记录。返回 false 表示签名或头部无效（视图被清空）
+    bool reset(const uint8_t* data, size_t size, uint64_t id, bool torn = false);
+
+    const uint8_t* data() const { return data_; }
+    size_t record_size() const { return size_; }
+    uint64_t id() const { return id_; }
+    uint16_t flags() const { return flags_; }
+    bool in_use() const { return (flags_ & 0x01) != 0; }
+    bool is_directory() const { return (flags_ & 0x02) != 0; }
+    uint16_t link_count() const { return link_count_; }
+    uint16_t sequence_number() const { return sequence_; }
+    uint64_t lsn() const { return lsn_; }
+    uint64_t base_record() const { return base_record_; }
+    bool torn() const { return torn_; }
+
+    // STANDARD_INFORMATION 时间戳（FILETIME；属性缺失时为 0）
+    uint64_t creation_time() const;
+    uint64_t modified_time() const;
+
+    // FILE_NAME（多个时取最后一个）
+    bool has_name() const { return name_pos_ != 0; }
+    uint64_t parent_reference() const;
+    uint8_t name_namespace() const;
+    size_t name_length() const;           // UTF-16 码元数
+    const uint8_t* name_utf16le() const;  // 原始 UTF-16LE 字节（name_length() * 2 字节，可能未对齐）
+    // 把文件名转换为 UTF-8 写入 buf（最多 cap 字节，不截断多字节字符），返回指向 buf 的视图
+    std::string_view name(char* buf, size_t cap) const;
+
+    // DATA（多个时取最后一个）：常驻时为内容长度，非常驻时为实际大小
+    bool has_data() const { return data_attr_ != 0; }
+    bool has_runlist() const;             // DATA 是否为非常驻属性
+    uint64_t data_size() const;
+    // 非常驻 DATA 片段的起始 VCN（runlist 分布在多条记录中时各片段按 VCN 衔接），常驻时为 0
+    uint64_t data_start_vcn() const;
+    // 解码并合并非常驻 DATA 的 runlist。返回 false 表示没有 runlist 或解码失败（out 被清空）
+    bool runs(NTFSRunList& out) const;
+
+    // 常驻 ATTRIBUTE_LIST 的内容（size 为可用字节数），不存在时返回 nullptr
+    const uint8_t* attribute_list(size_t& size) const;
+    // 非常驻 ATTRIBUTE_LIST（属性很多的巨型文件）：解码其 runlist 与内容的实际大小。
+    // 返回 false 表示没有非常驻 ATTRIBUTE_LIST 或 runlist 无效
+    bool attribute_list_runs(std::vector<std::pair<uint64_t,int64_t>>& runs, uint64_t& size) const;
+
+    // 记录已使用部分（记录头给出的实际长度）的 mft_record_hash
+    uint64_t content_hash() const;
+
+    // 解码全部字段到拥有数据的 NTFSFileRecord（name 截断为 255 字节）
+    void materialize(NTFSFileRecord& out) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t id_ = 0;
+    uint64_t lsn_ = 0;
+    uint64_t base_record_ = 0;
+    uint16_t flags_ = 0;
+    uint16_t link_count_ = 0;
+    uint16_t sequence_ = 0;
+    bool torn_ = false;
+    // 属性在记录内的偏移，0 表示不存在（属性不可能位于偏移 0）
+    uint32_t si_pos_ = 0;        // STANDARD_INFORMATION 内容
+    uint32_t name_pos_ = 0;      // FILE_NAME 内容
+    uint32_t data_attr_ = 0;     // DATA 属性头
+    uint32_t attr_list_pos_ = 0; // ATTRIBUTE_LIST 内容
+    uint32_t attr_list_len_ = 0;
+    uint32_t attr_list_attr_ = 0; // 非常驻 ATTRIBUTE_LIST 属性头
+};
+
+// USA（update sequence array）修正结果
+enum MFTFixupStatus {
+    MFT_FIXUP_OK = 0,      // 已校验并修正
+    MFT_FIXUP_ABSENT = 1,  // 不是 FILE 记录或没有 USA（未修改）
+    MFT_FIXUP_TORN = 2,    // 某个扇区末尾的序列号不匹配（未修改）
+    MFT_FIXUP_BAD_USA = 3, // USA 偏移/长度与记录大小不符（未修改）
+};
+
+// 对 buf 中连续存放的 count 条记录批量校验并就地应用 USA 修正。NTFS 在写入记录前把每个
+// 512 字节扇区的末尾两个字节替换为序列号（原值存放在 USA 中），读取时必须还原。
+// 各记录的扇区末尾字先被收集为连续数组，再成批（SSE2 下每次 8 个）与序列号比较。
+// 校验失败的记录保持原样。status 非空时写入每条记录的 MFTFixupStatus。
+// 返回: 校验失败（TORN 或 BAD_USA）的记录数
+size_t apply_usa_fixups(uint8_t* buf, size_t count, size_t record_size, uint8_t* status = nullptr);
+
+// 记录内容的 64 位指纹，用于重复扫描时判断记录是否变化（不是加密哈希）。
+// 四路独立地按 8 字节字混合，1 KiB 记录只需数十纳秒
+uint64_t mft_record_hash(const uint8_t* data, size_t size);
+
+// NTFS 卷几何：由引导扇区（卷起始处的 $Boot）解析得到。未解析引导扇区时使用
+// Windows 格式化的默认值（512 字节扇区、4 KiB 簇、1 KiB MFT 记录）。
+struct NTFSVolume {
+    uint64_t volume_offset = 0;       // 卷（分区）在镜像/设备中的起始字节偏移
+    uint32_t bytes_per_sector = 512;
+    uint32_t cluster_size = 4096;     // 每簇字节数
+    uint32_t mft_record_size = 1024;  // 每条 MFT 记录字节数（4K-native 卷通常为 4096）
+    uint32_t index_record_size = 4096; // 每个索引记录（INDX）字节数
+    uint64_t total_sectors = 0;
+    uint64_t mft_lcn = 0;             // $MFT 起始簇号
+    uint64_t mftmirr_lcn = 0;         // $MFTMirr 起始簇号
+    uint64_t serial_number = 0;
+
+    // 簇号对应的绝对字节偏移（含卷起始偏移）
+    uint64_t lcn_offset(uint64_t lcn) const { return volume_offset + lcn * cluster_size; }
+    uint64_t mft_offset() const { return lcn_offset(mft_lcn); }
+    uint64_t mftmirr_offset() const { return lcn_offset(mftmirr_lcn); }
+    uint64_t total_clusters() const { return total_sectors * bytes_per_sector / cluster_size; }
+};
+
+// 解析 NTFS 引导扇区（至少 512 字节）。校验 OEM 标识 "NTFS    "、0x55AA 结束标记
+// 以及各尺寸字段（均须为 2 的幂且在合理范围内）。out.volume_offset 保持不变。
+// 返回: true 表示 data 是有效的 NTFS 引导扇区并填充 out
+bool parse_ntfs_boot_sector(const uint8_t* data, size_t size, NTFSVolume& out);
+
+// read_file_range 的区段合并：文件各区段映射出的磁盘区间按磁盘偏移排序后合并，
+// 间隔不超过 max_gap 的区间以一次读取覆盖（间隔内的数据被读出后丢弃），
+// 以较少的读取次数与寻道代替逐区段读取。合并后的单次读取不超过 max_read 字节
+// （单个区间本身更大时不拆分）。
+const uint64_t NTFS_READ_DEFAULT_GAP = 64 * 1024;
+const size_t NTFS_READ_DEFAULT_MAX = 4 * 1024 * 1024;
+
+// 文件数据在磁盘上的一段：读取 [disk_offset, disk_offset+size) 写入目标缓冲区的 dest_offset 处
+struct NTFSExtent {
+    uint64_t disk_offset;
+    uint64_t dest_offset;
+    size_t size;
+};
+
+// 合并后的一次设备读取，覆盖排序后 extents 中 [first, first+count) 各区间
+struct NTFSExtentRead {
+    uint64_t disk_offset;
+    size_t size;
+    size_t first;
+    size_t count;
+};
+
+// 把 extents 按磁盘偏移排序（就地）并规划合并读取，写入 reads。
+// 返回: 读取次数（reads.size()）
+size_t coalesce_extents(std::vector<NTFSExtent>& extents, uint64_t max_gap, size_t max_read,
+                        std::vector<NTFSExtentRead>& reads);
+
+// 批量扫描 MFT 的默认单次读取大小
+const size_t MFT_SCAN_DEFAULT_CHUNK = 4 * 1024 * 1024;
+
+// 文件引用：低 48 位为记录号，高 16 位为序列号
+const uint64_t FILE_REF_RECORD_MASK = 0x0000FFFFFFFFFFFFULL;
+
+// $Bitmap 的记录号：DATA 内容为卷簇位图，每簇一位（字节内低位在前），0 表示空闲
+const uint64_t NTFS_BITMAP_RECORD = 6;
+
+// 把一段簇位图转换为空闲簇区段 <lcn, cluster_count>，追加到 out（LCN 升序）。
+// bitmap 的第 0 位对应 first_lcn，只考虑前 clusters 位（不超过 bytes * 8）；与 out 末项
+// 相接的区段直接并入末项，因此整张位图可以分段按顺序转换（分段按 8 字节对齐时最快）。
+// 按 64 位字扫描：全部已分配或全部空闲的字一次跳过，区段边界由 count-trailing-zeros 定位，
+// 代价与字数和区段数成正比，而不是与簇数成正比。
+// 返回: 本段中的空闲簇数
+uint64_t bitmap_free_extents(const uint8_t* bitmap, size_t bytes, uint64_t first_lcn, uint64_t clusters,
+                             std::vector<std::pair<uint64_t,uint64_t>>& out);
+
+// scan_mft 的统计信息
+struct MFTScanStats {
+    uint64_t records = 0;    // 解析成功并回调的记录数（含未使用/已删除记录）
+    uint64_t skipped = 0;    // 签名或头部无效的记录槽数（从未使用或已损坏）
+    uint64_t torn = 0;       // USA 校验失败、以 torn 标记回调的记录数
+    uint64_t chunks = 0;     // 发起的大块读取次数
+    uint64_t bytes_read = 0; // 从设备读取的字节数
+    uint64_t extensions = 0; // 为拼接 runlist 批量读取的扩展记录数（去重后）
+};
+
+// scan_regions / find_orphan_records 的统计信息
+struct NTFSRegionScanStats {
+    uint64_t regions = 0;    // 合并、切分后的区域数（即回调次数）
+    uint64_t reads = 0;      // 发起的设备读取次数（相近区域合并读取）
+    uint64_t bytes = 0;      // 区域本身的字节数
+    uint64_t bytes_read = 0; // 从设备读取的字节数（含合并读取时区域之间的间隔）
+    uint64_t records = 0;    // find_orphan_records 找到并回调的记录数
+};
+
+// scan_regions 的区域回调：data 为磁盘偏移 disk_offset 处的 size 字节，回调返回后失效。
+// 返回 false 提前结束扫描
+typedef std::function<bool(uint64_t disk_offset, const uint8_t* data, size_t size)> NTFSRegionCallback;
+// find_orphan_records 的记录回调：disk_offset 为记录在磁盘上的字节偏移
+typedef std::function<bool(uint64_t disk_offset, const NTFSFileRecord& record)> NTFSOrphanCallback;
+
+// scan_mft 的记录回调：record 在回调返回后即被下一条记录复用，需要保留时应拷贝。
+// 返回 false 提前结束扫描。
+typedef std::function<bool(const NTFSFileRecord& record)> MFTRecordCallback;
+// scan_mft_views 的记录回调：view 引用扫描缓冲区，回调返回后失效
+typedef std::function<bool(const NTFSRecordView& view)> MFTRecordViewCallback;
+
+// $Extend 目录的记录号（$UsnJrnl 等扩展元文件位于其下）
+const uint64_t NTFS_EXTEND_RECORD = 11;
+
+// $UsnJrnl 的状态，取自 $Max 流与 $J 流的长度。USN 即 USN 记录在 $J 流中的字节偏移；
+// 日志被删除并重建后 journal_id 改变，此前保存的 USN 不再有意义
+struct NTFSUsnJournalState {
+    uint64_t journal_id = 0;
+    uint64_t lowest_valid_usn = 0; // 更早的部分已被回收（$J 开头变为稀疏区段）
+    uint64_t next_usn = 0;         // 下一条 USN 记录写入的位置（$J 的实际大小）
 };
 
 // NTFSParser: 提供从镜像/设备读取并解析 MFT 记录的最小接口。
@@ -51,27 +319,139 @@ public:
     NTFSParser();
     ~NTFSParser();
 
+    // 读取位于 volume_offset 的 NTFS 引导扇区并采用其卷几何，此后各接口的记录大小、
+    // 簇大小与簇号换算都以此为准。
+    // 返回: false 表示读取失败或不是有效的 NTFS 引导扇区（此时几何保持不变）
+    bool open_volume(DiskIO& dio, uint64_t volume_offset = 0);
+    // 直接指定卷几何（例如引导扇区损坏时由调用方推断）
+    void set_volume(const NTFSVolume& volume) { volume_ = volume; }
+    const NTFSVolume& volume() const { return volume_; }
+
+    // scan_mft 的解析线程数：1（默认）在调用线程内解析；0 表示硬件并发数；
+    // 大于 1 时读取的块被切分为解析任务，交给工作窃取线程池并行解析
+    void set_threads(size_t threads) { threads_ = threads; }
+    size_t threads() const { return threads_; }
+
+    // read_file_range 的区段合并参数（见 coalesce_extents）。max_gap 为 0 时只合并
+    // 磁盘上首尾相接的区段。机械硬盘上一次寻道的代价约等于顺序读取数百 KiB，
+    // 可适当调大 max_gap；SSD 上可调小以减少多读的数据
+    void set_read_coalescing(uint64_t max_gap, size_t max_read) {
+        read_gap_ = max_gap;
+        read_max_ = max_read;
+    }
+    uint64_t read_gap() const { return read_gap_; }
+    size_t read_max() const { return read_max_; }
+
     // 参数:
     //  - dio:    平台无关的磁盘读取接口（DiskIO）
-    //  - offset: MFT 记录在镜像中的字节偏移
+    //  - offset: MFT 记录在镜像中的字节偏移（记录大小取自卷几何）
     //  - out:    输出解析结果
     // 返回: true 表示成功并填充 out；false 表示解析失败或数据不完整
+    // DATA runlist 分布在扩展记录中时（ATTRIBUTE_LIST），被引用的扩展记录一次批量读取并
+    // 按 VCN 拼接；out 本身是扩展记录时从其基本记录取得完整 runlist 与文件大小。
     bool read_mft_record(DiskIO& dio, uint64_t offset, NTFSFileRecord& out);
 
+    // $MFT 自身的 DATA runlist，用于把文件引用中的记录号换算为磁盘偏移（scan_mft 会设置）
+    void set_mft_runs(const std::vector<std::pair<uint64_t,int64_t>>& runs) { mft_runs_ = runs; }
+    const std::vector<std::pair<uint64_t,int64_t>>& mft_runs() const { return mft_runs_; }
+    // 记录号对应的磁盘偏移。未设置 $MFT runlist 时假定 $MFT 从卷几何所指位置起连续存放。
+    // 返回 false 表示记录位于稀疏区段、超出 runlist 或跨越碎片边界
+    bool mft_record_offset(uint64_t record_no, uint64_t& offset) const;
+
+    // 按记录号读取一组 MFT 记录：去重后按磁盘偏移合并读取（见 set_read_coalescing），
+    // 整批修正 USA 后按记录号顺序以视图回调。无法换算偏移、读取失败或签名无效的记录跳过。
+    // 返回: false 表示有记录无法读取（其余记录照常回调）或回调提前结束
+    bool read_mft_records(DiskIO& dio, const std::vector<uint64_t>& record_nos, const MFTRecordViewCallback& cb);
+
+    // 批量扫描整个 MFT：按 $MFT 自身的 runlist 以 chunk_bytes 大小的大块顺序读取
+    // （双缓冲：解析当前块时下一块已在读取中），对整块批量应用 USA 修正后
+    // 在块缓冲区内原地解析每条记录并按记录号顺序回调。记录号按 runlist 的
+    // 文件内偏移计算，因此 $MFT 碎片化时仍与记录号一一对应；跨越碎片边界的记录
+    // 会被拼接后解析。扫描不会为单条记录发起额外 I/O：DATA runlist 分布在扩展记录中的
+    // 文件，其扩展记录在每个读取块（并行时每个解析任务）内汇总后批量读取并按 VCN 拼接
+    // （见 MFTExtensionBatch）；扩展记录本身仍按自身内容回调。扫描期间 $MFT 的 runlist
+    // 被设为 mft_runs（见 set_mft_runs）。
+    // 簇大小、记录大小与簇号换算取自卷几何；chunk_bytes 向下取整为簇与记录大小的整数倍。
+    // 并行解析时（见 set_threads）回调仍在调用线程中按记录号顺序执行，无需线程安全。
+    // 参数:
+    //  - mft_runs:     $MFT 的 DATA runlist（<cluster_count, lcn>，lcn == -1 为稀疏）
+    //  - mft_size:     $MFT 的有效字节数，0 表示按 runlist 全部长度
+    // 返回: true 表示扫描完成或被回调提前结束；false 表示几何无效或读取出错
+    bool scan_mft(DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+                  uint64_t mft_size, const MFTRecordCallback& cb, MFTScanStats* stats = nullptr,
+                  size_t chunk_bytes = MFT_SCAN_DEFAULT_CHUNK);
+
+    // 同上，但先读取卷几何所指的 $MFT 记录（记录 0），以其 DATA runlist 与大小驱动扫描
+    bool scan_mft(DiskIO& dio, const MFTRecordCallback& cb, MFTScanStats* stats = nullptr);
+
+    // 与 scan_mft 相同的扫描，但以 NTFSRecordView 回调：记录不被解码为 NTFSFileRecord，
+    // 文件名、runlist 等按需从块缓冲区读取。串行扫描时除块缓冲区等一次性分配外，
+    // 每条记录不产生任何堆分配；只需要少数字段或只处理部分记录的调用方应使用此接口。
+    bool scan_mft_views(DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+                        uint64_t mft_size, const MFTRecordViewCallback& cb, MFTScanStats* stats = nullptr,
+                        size_t chunk_bytes = MFT_SCAN_DEFAULT_CHUNK);
+    bool scan_mft_views(DiskIO& dio, const MFTRecordViewCallback& cb, MFTScanStats* stats = nullptr);
+
+    // $UsnJrnl（记录号 journal_record，即 $Extend\$UsnJrnl）的当前状态。
+    // 返回: false 表示记录无法读取，或基本记录中没有 $Max 与非常驻的 $J 流
+    bool read_usn_journal_state(DiskIO& dio, uint64_t journal_record, NTFSUsnJournalState& out);
+    // 读取 $J 流中 [from_usn, next_usn) 的 USN 记录（V2/V3），把其中文件及其父目录的
+    // 记录号排序去重后写入 records；state 非空时返回读取时的日志状态。
+    // 返回: false 表示日志无法读取、journal_id 不同（日志已重建）或 from_usn 已被回收，
+    // 此时无法得知其间的全部变化
+    bool read_usn_changes(DiskIO& dio, uint64_t journal_record, uint64_t journal_id, uint64_t from_usn,
+                          std::vector<uint64_t>& records, NTFSUsnJournalState* state = nullptr);
+
+    // 深度扫描只需读取未分配的簇：已删除文件的内容只可能残留在 $Bitmap 标记为空闲的簇中。
+    // load_free_extents 读取 $Bitmap（记录号经 mft_record_offset 换算）并分段转换为空闲簇
+    // 区段（见 bitmap_free_extents），超出卷簇数的位被忽略。
+    // 返回: false 表示 $Bitmap 无法读取或不是非常驻属性
+    bool load_free_extents(DiskIO& dio, std::vector<std::pair<uint64_t,uint64_t>>& out,
+                           uint64_t* free_clusters = nullptr);
+    // 把空闲簇区段换算为磁盘字节区域 <disk_offset, bytes>，追加到 regions
+    void free_space_regions(const std::vector<std::pair<uint64_t,uint64_t>>& free_extents,
+                            std::vector<std::pair<uint64_t,uint64_t>>& regions) const;
+    // 按磁盘偏移顺序读取 regions（<disk_offset, bytes>，可无序、可重叠）并逐区域回调。
+    // 重叠或相接的区域先被合并，再按 chunk_bytes 切分；磁盘上间隔不超过 read_gap() 的
+    // 区域以一次读取覆盖（见 set_read_coalescing），因此扫描时间与区域总量成正比，
+    // 与卷大小无关。
+    // 返回: true 表示扫描完成或被回调提前结束；false 表示读取出错
+    bool scan_regions(DiskIO& dio, const std::vector<std::pair<uint64_t,uint64_t>>& regions,
+                      const NTFSRegionCallback& cb, NTFSRegionScanStats* stats = nullptr,
+                      size_t chunk_bytes = MFT_SCAN_DEFAULT_CHUNK);
+    // 在 regions 中搜索孤儿 MFT 记录（例如 $MFT 收缩或迁移后残留在空闲簇中的记录）：
+    // 检查相对卷起始按记录大小对齐的每个位置的 'FILE' 签名，修正 USA 后解码并回调。
+    // 记录 id 取自记录头中的记录号（NTFS 3.1），只解码记录自身包含的 runlist 片段。
+    bool find_orphan_records(DiskIO& dio, const std::vector<std::pair<uint64_t,uint64_t>>& regions,
+                             const NTFSOrphanCallback& cb, NTFSRegionScanStats* stats = nullptr,
+                             size_t chunk_bytes = MFT_SCAN_DEFAULT_CHUNK);
+
     // Map a file byte range [file_offset, file_offset+len) to absolute
-    // disk byte ranges using parsed `data_runs` and the provided `cluster_size`.
+    // disk byte ranges using parsed `data_runs` and the volume geometry
+    // (cluster size and volume offset).
     // Output: vector of pairs (absolute_disk_offset, bytes_to_read) in order.
     // Sparse runs (lcn == -1) are represented by entries with bytes_to_read == 0
     // for the corresponding region and are not emitted as disk offsets.
     bool map_file_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
-                        uint64_t cluster_size, std::vector<std::pair<uint64_t,size_t>>& out);
-    // Read file data using parsed data_runs.
+                        std::vector<std::pair<uint64_t,size_t>>& out);
+    // Read file data using parsed data_runs and the volume geometry.
+    // 各区段映射出的磁盘区间排序合并后（见 set_read_coalescing）以 read_batch 并发读取，
+    // 再分发到目标缓冲区中各自的位置；稀疏区段与文件末尾之后的部分填 0。
     // Variant A: writes into a caller-provided buffer of size out_buf_size.
     bool read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
                          uint64_t file_offset, size_t len,
-                         void* out_buf, size_t out_buf_size, uint64_t cluster_size);
-
+                         void* out_buf, size_t out_buf_size);
     // Variant B: appends the requested bytes into a std::vector<uint8_t>.
+    bool read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
+                         uint64_t file_offset, size_t len,
+                         std::vector<uint8_t>& out);
+
+    // 显式簇大小的旧形式：忽略卷几何，LCN 按 lcn * cluster_size 换算（卷起始偏移视为 0）
+    bool map_file_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
+                        uint64_t cluster_size, std::vector<std::pair<uint64_t,size_t>>& out);
+    bool read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
+                         uint64_t file_offset, size_t len,
+                         void* out_buf, size_t out_buf_size, uint64_t cluster_size);
     bool read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
                          uint64_t file_offset, size_t len,
                          std::vector<uint8_t>& out, uint64_t cluster_size);
@@ -79,6 +459,51 @@ private:
     // 解析 MFT record header
     // 返回: true if header is valid and parsed
     bool parse_header(const uint8_t* data, size_t size, MFTHeader& header);
+
+    NTFSVolume volume_;
+    size_t threads_ = 1;
+    uint64_t read_gap_ = NTFS_READ_DEFAULT_GAP;
+    size_t read_max_ = NTFS_READ_DEFAULT_MAX;
+    std::vector<std::pair<uint64_t,int64_t>> mft_runs_;
+};
+
+// ATTRIBUTE_LIST 扩展记录的批量解析。
+//
+// 巨型或高度碎片化文件的 DATA runlist 被分成多个片段（各自从某个起始 VCN 开始，LCN
+// 增量各自从 0 起算），存放在若干扩展记录中；基本记录的 ATTRIBUTE_LIST 列出每个片段
+// 所在的记录。collect 先为一批基本记录登记全部引用，fetch 去重后按磁盘偏移排序，以合并
+// 读取一次取回（非常驻的 ATTRIBUTE_LIST 本身在此之前同样批量读取），stitch 再为每条
+// 基本记录按 VCN 顺序拼接完整的 runlist。缺失或无法读取的片段以稀疏区段占位，
+// 其后各片段的 VCN 仍然正确。
+class MFTExtensionBatch {
+public:
+    // 登记 base 中位于其他记录的未命名 DATA 片段。返回 true 表示 base 需要 stitch
+    bool collect(const NTFSRecordView& base);
+    bool empty() const { return refs_.empty() && lists_.empty(); }
+    // 读取已登记的非常驻 ATTRIBUTE_LIST 与全部扩展记录（记录号经 parser.mft_record_offset
+    // 换算，按 parser 的区段合并参数合并读取）。返回 false 表示有记录无法读取
+    bool fetch(DiskIO& dio, const NTFSParser& parser, MFTScanStats* stats = nullptr);
+    // 把 base 的完整 runlist 写入 out.data_runs；首个片段位于扩展记录中时同时取其实际大小
+    // 写入 out.size。返回 false 表示 base 的 runlist 不需要拼接（out 不变）
+    bool stitch(const NTFSRecordView& base, NTFSFileRecord& out) const;
+    void clear();
+
+private:
+    struct List {
+        uint64_t base_id;
+        uint64_t size;
+        size_t offset; // 在 list_bytes_ 中的起点
+        std::vector<std::pair<uint64_t,int64_t>> runs;
+    };
+    const uint8_t* find_list(uint64_t base_id, size_t& size) const;
+    const uint8_t* find_record(uint64_t record_no) const;
+
+    std::vector<uint64_t> refs_;      // 扩展记录号（fetch 时排序去重）
+    std::vector<List> lists_;         // 待读取/已读取的非常驻 ATTRIBUTE_LIST
+    std::vector<uint8_t> list_bytes_;
+    std::vector<uint8_t> records_;    // 取回的扩展记录（已修正 USA），与 refs_ 一一对应
+    std::vector<uint8_t> valid_;      // 各扩展记录是否读取成功且 USA 校验通过
+    size_t record_size_ = 0;
 };
 
 
@@ -86,3 +511,24 @@ private:
 // Data-run helpers (non-member, available to other translation units)
 bool decode_data_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out);
 void normalize_data_runs(std::vector<std::pair<uint64_t,int64_t>>& runs);
+// 解码并在同一遍中合并相邻区段，结果等同于 decode_data_runs + normalize_data_runs。
+// out 被清空后复用其已有容量（调用方可跨记录复用同一个 vector / NTFSRunList）；失败时 out 为空
+bool decode_normalized_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out);
+bool decode_normalized_runs(const uint8_t* runs, size_t len, NTFSRunList& out);
+
+// UTF-16LE → UTF-8 转换（MFT 文件名）。最多写入 cap 字节，不截断多字节字符；
+// 孤立或不成对的代理项替换为 U+FFFD（高代理后跟非低代理时两个码元一并替换），
+// 末尾不完整的代理项输出 U+FFFD 后结束，末尾的奇数字节被忽略。
+// 返回: 写入的字节数
+size_t utf16le_to_utf8(const uint8_t* data, size_t bytes, char* out, size_t cap);
+
+// 转换实现：启动时按 CPU 能力选择（AVX2 > SSE2 > 标量），各实现输出完全相同
+enum UTF16Impl {
+    UTF16_IMPL_SCALAR = 0,
+    UTF16_IMPL_SSE2 = 1,
+    UTF16_IMPL_AVX2 = 2,
+};
+UTF16Impl utf16le_to_utf8_active_impl();
+bool utf16le_to_utf8_impl_available(UTF16Impl impl);
+// 使用指定实现转换（用于差分测试与基准测试）；实现不可用时使用标量实现
+size_t utf16le_to_utf8_with(UTF16Impl impl, const uint8_t* data, size_t bytes, char* out, size_t cap);
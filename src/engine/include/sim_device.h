@@ -0,0 +1,33 @@
+// sim_device.h — 模拟设备模型：延迟模拟与故障注入（用于性能测试与回归测试）
+//
+// DiskIO::open_simulated 把一个镜像包装为“慢速/不可靠”的设备：按模型注入
+// 寻道与传输延迟、带宽上限、坏扇区、瞬时错误与短读。所有随机故障都由 seed
+// 决定：坏扇区按扇区号哈希，同一 seed 下每次运行、每个线程看到的坏扇区完全
+// 相同；瞬时错误与短读按请求序号哈希，单线程下可精确复现。
+//
+// 典型模型（近似值）：
+//   5400 rpm 笔记本硬盘: seek_us = 12000, bytes_per_sec = 100 MB/s
+//   廉价 USB 桥接盘:     per_request_us = 1000, bytes_per_sec = 30 MB/s, transient_error_rate = 1e-3
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+#include "disk_io.h"
+
+struct SimDeviceModel {
+    // 延迟（单一磁头：请求按到达顺序排队串行服务，并发请求会相互等待）
+    uint32_t seek_us = 0;         // 非顺序访问（偏移不等于上次结束位置）的寻道+旋转延迟
+    uint32_t per_request_us = 0;  // 每个请求的固定开销（命令/协议开销）
+    uint64_t bytes_per_sec = 0;   // 传输带宽，0 表示不限制
+
+    // 故障
+    uint32_t sector_size = 512;   // 故障粒度
+    double bad_sector_rate = 0;   // 每个扇区为永久坏扇区的概率
+    std::vector<DiskIO::BadRange> bad_ranges; // 额外的固定坏区（字节区间）
+    double transient_error_rate = 0; // 每个请求瞬时失败（重试可能成功）的概率
+    double short_read_rate = 0;      // 每个请求只返回部分数据（按扇区截断）的概率
+    uint64_t seed = 1;
+
+    // 坏扇区与瞬时错误报告的系统错误码
+    int error_code = EIO;
+};
@@ -0,0 +1,155 @@
+// block_cache.cpp — 分片 CLOCK 块缓存实现
+#include "block_cache.h"
+#include <algorithm>
+#include <cstring>
+
+// 分片：固定数量的槽位 + 块号索引。槽位数据在首次使用时分配，
+// 因此小工作集不会占满容量上限。
+struct BlockCache::Shard {
+    struct Slot {
+        uint64_t block_no = 0;
+        size_t valid = 0;          // 块内有效字节数（文件末尾的块可能不足一块）
+        bool used = false;
+        bool referenced = false;   // CLOCK 引用位
+        std::vector<uint8_t> data;
+    };
+
+    mutable std::mutex m;
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, size_t> index; // block_no -> slot
+    size_t hand = 0;
+    size_t filled = 0;
+    uint64_t hits = 0, misses = 0, evictions = 0;
+
+    // 选择一个可用槽位：优先使用空槽，否则按 CLOCK 淘汰
+    size_t victim() {
+        if (filled < slots.size()) return filled++;
+        for (;;) {
+            Slot& s = slots[hand];
+            size_t cur = hand;
+            hand = (hand + 1) % slots.size();
+            if (s.referenced) {
+                s.referenced = false;
+                continue;
+            }
+            index.erase(s.block_no);
+            s.used = false;
+            ++evictions;
+            return cur;
+        }
+    }
+};
+
+static size_t log2_size(size_t v) {
+    size_t s = 0;
+    while ((static_cast<size_t>(1) << s) < v) ++s;
+    return s;
+}
+
+BlockCache::BlockCache(ReadFn read, size_t capacity_bytes, size_t block_size, size_t shards)
+    : read_(std::move(read)) {
+    if (block_size < 512) block_size = 512;
+    block_shift_ = log2_size(block_size);
+    block_size_ = static_cast<size_t>(1) << block_shift_; // 向上取整到 2 的幂
+    bypass_threshold_ = block_size_ * 4;
+    if (shards == 0) shards = 1;
+    size_t total_blocks = std::max<size_t>(capacity_bytes / block_size_, 1);
+    shards = std::min(shards, total_blocks);
+    size_t per_shard = total_blocks / shards;
+    for (size_t i = 0; i < shards; ++i) {
+        std::unique_ptr<Shard> sh(new Shard());
+        sh->slots.resize(per_shard);
+        sh->index.reserve(per_shard * 2);
+        shards_.push_back(std::move(sh));
+    }
+}
+
+BlockCache::~BlockCache() {}
+
+ssize_t BlockCache::read_block(uint64_t block_no, size_t in_block, uint8_t* out, size_t len) {
+    // 乘法哈希打散相邻块，避免顺序元数据集中在同一分片
+    Shard& sh = *shards_[(block_no * 0x9E3779B97F4A7C15ULL >> 32) % shards_.size()];
+    {
+        std::lock_guard<std::mutex> lk(sh.m);
+        auto it = sh.index.find(block_no);
+        if (it != sh.index.end()) {
+            Shard::Slot& s = sh.slots[it->second];
+            s.referenced = true;
+            ++sh.hits;
+            if (in_block >= s.valid) return 0;
+            size_t take = std::min(len, s.valid - in_block);
+            memcpy(out, s.data.data() + in_block, take);
+            return static_cast<ssize_t>(take);
+        }
+        ++sh.misses;
+    }
+
+    // 未命中：在锁外读取整块，期间其他分片/块的访问不受影响
+    std::vector<uint8_t> block(block_size_);
+    ssize_t got = read_(block_no << block_shift_, block.data(), block_size_);
+    if (got < 0) return -1;
+    size_t valid = static_cast<size_t>(got);
+    size_t take = (in_block >= valid) ? 0 : std::min(len, valid - in_block);
+    if (take) memcpy(out, block.data() + in_block, take);
+
+    std::lock_guard<std::mutex> lk(sh.m);
+    if (sh.index.find(block_no) == sh.index.end()) { // 并发未命中时只插入一次
+        size_t slot = sh.victim();
+        Shard::Slot& s = sh.slots[slot];
+        s.block_no = block_no;
+        s.valid = valid;
+        s.used = true;
+        s.referenced = false;
+        s.data.swap(block);
+        sh.index[block_no] = slot;
+    }
+    return static_cast<ssize_t>(take);
+}
+
+ssize_t BlockCache::read(uint64_t offset, void* buf, size_t size) {
+    if (size == 0) return 0;
+    if (!cacheable(size)) {
+        bypassed_.fetch_add(1, std::memory_order_relaxed);
+        return read_(offset, buf, size);
+    }
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    size_t total = 0;
+    while (total < size) {
+        uint64_t pos = offset + total;
+        uint64_t block_no = pos >> block_shift_;
+        size_t in_block = static_cast<size_t>(pos & (block_size_ - 1));
+        size_t want = std::min(size - total, block_size_ - in_block);
+        ssize_t got = read_block(block_no, in_block, out + total, want);
+        if (got < 0) return -1; // 与底层读取一致：中途出错不报告为短读
+        total += static_cast<size_t>(got);
+        if (static_cast<size_t>(got) < want) break; // EOF
+    }
+    return static_cast<ssize_t>(total);
+}
+
+void BlockCache::clear() {
+    for (auto& sh : shards_) {
+        std::lock_guard<std::mutex> lk(sh->m);
+        for (auto& s : sh->slots) {
+            s.used = false;
+            s.referenced = false;
+            std::vector<uint8_t>().swap(s.data);
+        }
+        sh->index.clear();
+        sh->filled = 0;
+        sh->hand = 0;
+    }
+}
+
+BlockCache::Stats BlockCache::stats() const {
+    Stats st;
+    st.bypassed = bypassed_.load(std::memory_order_relaxed);
+    for (auto& sh : shards_) {
+        std::lock_guard<std::mutex> lk(sh->m);
+        st.hits += sh->hits;
+        st.misses += sh->misses;
+        st.evictions += sh->evictions;
+        st.resident_bytes += sh->index.size() * block_size_;
+    }
+    return st;
+}
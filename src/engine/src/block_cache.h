@@ -0,0 +1,64 @@
+// block_cache.h — DiskIO 元数据块缓存（非公开头文件）
+//
+// 以固定大小、按块大小对齐的块为单位缓存设备读取结果，面向 MFT 记录、
+// 扩展记录等小而重复的元数据读取。按块号哈希分片，每个分片独立加锁并
+// 使用 CLOCK（二次机会）算法淘汰，容量有上限。
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+class BlockCache {
+public:
+    // 底层读取函数：语义与 DiskIO::read_at 相同（返回字节数，EOF 时较短，错误 -1）
+    typedef std::function<ssize_t(uint64_t offset, void* buf, size_t size)> ReadFn;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t bypassed = 0;     // 过大而直接透传到设备的读取次数
+        size_t resident_bytes = 0; // 当前缓存占用
+    };
+
+    // capacity_bytes: 总容量上限；block_size: 块大小（须为 2 的幂，默认 64 KiB）；
+    // shards: 分片数（降低锁竞争）。
+    BlockCache(ReadFn read, size_t capacity_bytes, size_t block_size = 64 * 1024, size_t shards = 16);
+    ~BlockCache();
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // 带缓存的读取。超过 bypass 阈值（4 个块）的请求直接透传，避免大块顺序
+    // 数据把元数据挤出缓存。返回值语义与 DiskIO::read_at 相同：任何一个块读取出错
+    // 都返回 -1（即使之前的块已拷贝），不会把设备错误变成较短的读取（调用方视为 EOF）。
+    ssize_t read(uint64_t offset, void* buf, size_t size);
+
+    // 小于透传阈值、应当经过缓存的请求大小
+    bool cacheable(size_t size) const { return size < bypass_threshold_; }
+
+    // 丢弃全部缓存内容（计数器保留）
+    void clear();
+
+    Stats stats() const;
+    size_t block_size() const { return block_size_; }
+
+private:
+    struct Shard;
+
+    // 读取单个块的 [in_block, in_block+len) 部分；返回拷贝字节数，-1 表示错误
+    ssize_t read_block(uint64_t block_no, size_t in_block, uint8_t* out, size_t len);
+
+    ReadFn read_;
+    size_t block_size_;
+    size_t block_shift_;
+    size_t bypass_threshold_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> bypassed_{0}; // 透传读取不涉及任何分片，计数不占用分片锁
+};
@@ -0,0 +1,242 @@
+// chunked_image.cpp — 分块压缩镜像（FRCI）的读取数据源与写入工具
+#include "../include/chunked_image.h"
+#include "image_source.h"
+#include "block_cache.h"
+#include "lz_codec.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static const uint8_t FRCI_MAGIC[8] = {'F', 'R', 'C', 'I', 'M', 'G', 0, 1};
+static const uint32_t FRCI_VERSION = 1;
+static const size_t FRCI_HEADER_SIZE = 64;
+static const uint32_t FRCI_MIN_CHUNK = 4 * 1024;
+static const uint32_t FRCI_MAX_CHUNK = 16 * 1024 * 1024;
+
+static uint32_t get_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return static_cast<uint64_t>(get_u32(p)) | (static_cast<uint64_t>(get_u32(p + 4)) << 32);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static bool valid_chunk_size(uint64_t c) {
+    return c >= FRCI_MIN_CHUNK && c <= FRCI_MAX_CHUNK && (c & (c - 1)) == 0;
+}
+
+// 读取数据源：块索引常驻内存（每块 8 字节），解压后的块经 BlockCache 缓存。
+// 块缓存的块大小即压缩块大小，因此缓存未命中恰好对应一次整块解压；
+// 跨越多个块的大请求绕过缓存，直接解压到调用方缓冲区。
+class ChunkedImageSource : public ImageSource {
+public:
+    ChunkedImageSource(std::unique_ptr<DiskIO> file, uint32_t chunk_size, uint64_t image_size,
+                       std::vector<uint64_t> offsets)
+        : file_(std::move(file)), chunk_size_(chunk_size), image_size_(image_size),
+          offsets_(std::move(offsets)) {
+        chunk_shift_ = 0;
+        while ((static_cast<uint64_t>(1) << chunk_shift_) < chunk_size_) ++chunk_shift_;
+        cache_.reset(new BlockCache([this](uint64_t off, void* b, size_t n) { return decode(off, b, n); },
+                                    std::max<size_t>(4u << 20, static_cast<size_t>(chunk_size_) * 4),
+                                    chunk_size_));
+    }
+
+    ssize_t read(uint64_t offset, void* buf, size_t size) override {
+        if (offset >= image_size_ || size == 0) return 0;
+        size = static_cast<size_t>(std::min<uint64_t>(size, image_size_ - offset));
+        return cache_->read(offset, buf, size);
+    }
+
+    uint64_t size() const override { return image_size_; }
+
+private:
+    // 解压 [offset, offset+size) 涉及的各块。整块请求直接解压到输出缓冲区，
+    // 原样存储的块只读取所需部分，空洞直接填零。
+    // 任一块读取失败或损坏都使整个请求返回 -1（短读表示 EOF，不能用来报告中途的错误）。
+    ssize_t decode(uint64_t offset, void* buf, size_t size) {
+        thread_local std::vector<uint8_t> packed, scratch;
+        uint8_t* out = static_cast<uint8_t*>(buf);
+        size_t total = 0;
+        while (total < size) {
+            uint64_t pos = offset + total;
+            if (pos >= image_size_) break;
+            uint64_t idx = pos >> chunk_shift_;
+            size_t in = static_cast<size_t>(pos & (chunk_size_ - 1));
+            size_t raw_len = static_cast<size_t>(std::min<uint64_t>(chunk_size_, image_size_ - (idx << chunk_shift_)));
+            size_t take = std::min(size - total, raw_len - in);
+            uint64_t start = offsets_[idx];
+            size_t stored = static_cast<size_t>(offsets_[idx + 1] - start);
+            if (stored == 0) {
+                memset(out + total, 0, take);
+            } else if (stored == raw_len) {
+                if (file_->read_at(start + in, out + total, take) != static_cast<ssize_t>(take)) {
+                    fail("truncated chunk data", EIO);
+                    return -1;
+                }
+            } else {
+                packed.resize(stored);
+                if (file_->read_at(start, packed.data(), stored) != static_cast<ssize_t>(stored)) {
+                    fail("truncated chunk data", EIO);
+                    return -1;
+                }
+                bool whole = (in == 0 && take == raw_len);
+                if (!whole && scratch.size() < raw_len) scratch.resize(raw_len);
+                uint8_t* dst = whole ? out + total : scratch.data();
+                if (!lz_decompress(packed.data(), stored, dst, raw_len)) {
+                    fail("corrupt compressed chunk", EIO);
+                    return -1;
+                }
+                if (!whole) memcpy(out + total, scratch.data() + in, take);
+            }
+            total += take;
+        }
+        return static_cast<ssize_t>(total);
+    }
+
+    std::unique_ptr<DiskIO> file_;
+    uint32_t chunk_size_;
+    unsigned chunk_shift_;
+    uint64_t image_size_;
+    std::vector<uint64_t> offsets_; // chunk_count + 1 项
+    std::unique_ptr<BlockCache> cache_;
+};
+
+ImageSource* open_chunked_image(const char* path, uint32_t flags, bool& failed) {
+    failed = false;
+    std::unique_ptr<DiskIO> file(new DiskIO());
+    // 打不开时交由平台实现按普通镜像打开并报告错误
+    if (!file->open(path, flags | DiskIO::OPEN_RAW)) return nullptr;
+    uint8_t hdr[FRCI_HEADER_SIZE];
+    if (file->read_at(0, hdr, sizeof(hdr)) != static_cast<ssize_t>(sizeof(hdr)) ||
+        memcmp(hdr, FRCI_MAGIC, sizeof(FRCI_MAGIC)) != 0) {
+        return nullptr;
+    }
+
+    failed = true;
+    if (get_u32(hdr + 8) != FRCI_VERSION) {
+        ImageSource::fail("unsupported chunked image version", EINVAL);
+        return nullptr;
+    }
+    uint32_t chunk_size = get_u32(hdr + 12);
+    uint64_t image_size = get_u64(hdr + 16);
+    uint64_t count = get_u64(hdr + 24);
+    uint64_t index_offset = get_u64(hdr + 32);
+    if (!valid_chunk_size(chunk_size) || count != (image_size + chunk_size - 1) / chunk_size ||
+        count > (SIZE_MAX / sizeof(uint64_t)) - 1 || index_offset < FRCI_HEADER_SIZE) {
+        ImageSource::fail("malformed chunked image header", EINVAL);
+        return nullptr;
+    }
+
+    size_t index_bytes = static_cast<size_t>(count + 1) * sizeof(uint64_t);
+    std::vector<uint8_t> raw(index_bytes);
+    if (file->read_at(index_offset, raw.data(), index_bytes) != static_cast<ssize_t>(index_bytes)) {
+        ImageSource::fail("truncated chunked image index", EINVAL);
+        return nullptr;
+    }
+    std::vector<uint64_t> offsets(static_cast<size_t>(count + 1));
+    for (size_t i = 0; i < offsets.size(); ++i) offsets[i] = get_u64(raw.data() + i * sizeof(uint64_t));
+    // 索引必须单调、落在数据区内，且存储长度不超过原始长度
+    if (offsets[0] < FRCI_HEADER_SIZE || offsets.back() > index_offset) {
+        ImageSource::fail("malformed chunked image index", EINVAL);
+        return nullptr;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t raw_len = std::min<uint64_t>(chunk_size, image_size - i * chunk_size);
+        if (offsets[i + 1] < offsets[i] || offsets[i + 1] - offsets[i] > raw_len) {
+            ImageSource::fail("malformed chunked image index", EINVAL);
+            return nullptr;
+        }
+    }
+    failed = false;
+    return new ChunkedImageSource(std::move(file), chunk_size, image_size, std::move(offsets));
+}
+
+bool write_chunked_image(const char* src_path, const char* dst_path, uint32_t chunk_size,
+                         ChunkedImageStats* stats, std::string* err) {
+    auto set_err = [err](const std::string& m) { if (err) *err = m; };
+    if (!src_path || !dst_path) { set_err("null path"); return false; }
+    if (!valid_chunk_size(chunk_size)) { set_err("chunk size must be a power of two in [4 KiB, 16 MiB]"); return false; }
+
+    DiskIO in;
+    if (!in.open(src_path, DiskIO::OPEN_RAW)) {
+        set_err(std::string("open source: ") + in.last_error());
+        return false;
+    }
+    in.advise(DiskIO::ACCESS_SEQUENTIAL);
+    FILE* out = fopen(dst_path, "wb");
+    if (!out) {
+        set_err(std::string("create output: ") + strerror(errno));
+        return false;
+    }
+    auto abort_write = [&](const std::string& m) {
+        fclose(out);
+        remove(dst_path);
+        set_err(m);
+        return false;
+    };
+
+    uint8_t hdr[FRCI_HEADER_SIZE] = {0};
+    if (fwrite(hdr, 1, sizeof(hdr), out) != sizeof(hdr)) return abort_write("write failed");
+
+    ChunkedImageStats st;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> raw(chunk_size), packed(chunk_size);
+    uint64_t pos = FRCI_HEADER_SIZE;
+    for (;;) {
+        ssize_t r = in.read_at(st.image_bytes, raw.data(), chunk_size);
+        if (r < 0) return abort_write(std::string("read source: ") + in.last_error());
+        if (r == 0) break;
+        size_t n = static_cast<size_t>(r);
+        offsets.push_back(pos);
+        ++st.chunks;
+        bool zero = raw[0] == 0 && memcmp(raw.data(), raw.data() + 1, n - 1) == 0;
+        if (zero) {
+            ++st.hole_chunks;
+        } else {
+            // 压缩结果必须严格小于原始长度，否则原样存储（读取端据此区分）
+            size_t c = lz_compress(raw.data(), n, packed.data(), n - 1);
+            const uint8_t* data = c ? packed.data() : raw.data();
+            size_t len = c ? c : n;
+            if (!c) ++st.raw_chunks;
+            if (fwrite(data, 1, len, out) != len) return abort_write("write failed");
+            pos += len;
+        }
+        st.image_bytes += n;
+        if (n < chunk_size) break; // EOF
+    }
+    offsets.push_back(pos);
+
+    std::vector<uint8_t> index(offsets.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < offsets.size(); ++i) put_u64(index.data() + i * sizeof(uint64_t), offsets[i]);
+    if (fwrite(index.data(), 1, index.size(), out) != index.size()) return abort_write("write failed");
+
+    memcpy(hdr, FRCI_MAGIC, sizeof(FRCI_MAGIC));
+    put_u32(hdr + 8, FRCI_VERSION);
+    put_u32(hdr + 12, chunk_size);
+    put_u64(hdr + 16, st.image_bytes);
+    put_u64(hdr + 24, st.chunks);
+    put_u64(hdr + 32, pos);
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(hdr, 1, sizeof(hdr), out) != sizeof(hdr)) {
+        return abort_write("write failed");
+    }
+    if (fclose(out) != 0) {
+        remove(dst_path);
+        set_err("write failed");
+        return false;
+    }
+    st.stored_bytes = pos + index.size();
+    if (stats) *stats = st;
+    return true;
+}
@@ -0,0 +1,126 @@
+// disk_io_batch.cpp — DiskIO 批量与异步读取（平台无关部分）
+//
+// read_batch 优先交给平台原生引擎（read_batch_native，例如 Linux io_uring），
+// 不可用或启用了块缓存时回退到共享线程池并发执行 read_at。submit/wait_all 在此基础上
+// 提供基于完成回调的异步提交。
+#include "../include/disk_io.h"
+#include "io_thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+// 每个句柄的异步提交状态：记录尚未完成的 submit 批次数
+struct DiskIOAsyncState {
+    std::mutex m;
+    std::condition_variable cv;
+    size_t pending = 0;
+};
+
+// 线程池回退中的一个批次。调用线程与若干池线程从同一个原子游标领取请求，
+// 因此即便池线程全部繁忙，调用线程也能独立完成整个批次。
+struct PooledBatch {
+    DiskIO* dio;
+    DiskIO::ReadRequest* reqs;
+    size_t count;
+    DiskIO::ReadCallback cb;
+    void* user;
+    std::atomic<size_t> next{0};
+    std::mutex m;
+    std::condition_variable cv;
+    size_t done = 0;
+
+    // 领取并执行请求直到游标耗尽
+    void drain() {
+        size_t finished = 0;
+        for (;;) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) break;
+            DiskIO::ReadRequest& r = reqs[i];
+            r.result = dio->read_at(r.offset, r.buf, r.size);
+            if (cb) cb(r, user);
+            ++finished;
+        }
+        if (finished) {
+            std::lock_guard<std::mutex> lk(m);
+            done += finished;
+            if (done == count) cv.notify_all();
+        }
+    }
+};
+
+void DiskIO::read_batch_pooled(ReadRequest* reqs, size_t count, ReadCallback cb, void* user) {
+    if (count == 0) return;
+    auto batch = std::make_shared<PooledBatch>();
+    batch->dio = this;
+    batch->reqs = reqs;
+    batch->count = count;
+    batch->cb = cb;
+    batch->user = user;
+    IOThreadPool& pool = IOThreadPool::instance();
+    size_t helpers = std::min(count - 1, pool.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        pool.post([batch] { batch->drain(); });
+    }
+    batch->drain();
+    std::unique_lock<std::mutex> lk(batch->m);
+    batch->cv.wait(lk, [&] { return batch->done == batch->count; });
+}
+
+bool DiskIO::read_batch(ReadRequest* reqs, size_t count) {
+    if (count == 0) return true;
+    if (!reqs) return false;
+    if (count == 1) {
+        // 单个请求无需任何调度开销
+        reqs[0].result = read_at(reqs[0].offset, reqs[0].buf, reqs[0].size);
+    } else if (layered() || !read_batch_native(reqs, count, nullptr, nullptr)) {
+        // 启用功能层或读取容器镜像时走线程池：每个请求经 read_at 处理，原生引擎会绕过它们
+        read_batch_pooled(reqs, count, nullptr, nullptr);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (reqs[i].result < 0) return false;
+    }
+    return true;
+}
+
+bool DiskIO::submit(ReadRequest* reqs, size_t count, ReadCallback on_complete, void* user) {
+    if (!reqs || count == 0) return false;
+    if (!source_ && !device_open()) {
+        set_error("not opened");
+        return false;
+    }
+    // async_ 在首次 submit 时创建并以 CAS 发布，此后存活到句柄析构：提交与等待都无需全局锁
+    DiskIOAsyncState* st = async_.load(std::memory_order_acquire);
+    if (!st) {
+        DiskIOAsyncState* fresh = new DiskIOAsyncState();
+        if (async_.compare_exchange_strong(st, fresh, std::memory_order_acq_rel)) st = fresh;
+        else delete fresh;
+    }
+    {
+        std::lock_guard<std::mutex> lk(st->m);
+        ++st->pending;
+    }
+    // 整个批次作为一个池任务执行：原生引擎在该任务中阻塞等待内核完成，
+    // 回退路径则与其他池线程协作，两者都不会等待其他池任务完成。
+    IOThreadPool::instance().post([this, st, reqs, count, on_complete, user] {
+        if (layered() || !read_batch_native(reqs, count, on_complete, user)) {
+            read_batch_pooled(reqs, count, on_complete, user);
+        }
+        std::lock_guard<std::mutex> lk(st->m);
+        if (--st->pending == 0) st->cv.notify_all();
+    });
+    return true;
+}
+
+void DiskIO::wait_all() {
+    DiskIOAsyncState* st = async_.load(std::memory_order_acquire);
+    if (!st) return;
+    std::unique_lock<std::mutex> lk(st->m);
+    st->cv.wait(lk, [st] { return st->pending == 0; });
+}
+
+void DiskIO::release_async() {
+    wait_all();
+    delete async_.exchange(nullptr);
+}
@@ -0,0 +1,217 @@
+// disk_io_common.cpp — DiskIO 平台无关前端
+//
+// 公开的 open/close/read_at 在这里实现，平台文件只负责原始设备访问
+// （open_device/close_device/read_device）。块缓存等功能层叠加在此处，
+// 因此所有平台共享同一套语义。
+#include "../include/disk_io.h"
+#include "block_cache.h"
+#include "readahead.h"
+#include "resilient_reader.h"
+#include "image_source.h"
+#include "io_throttle.h"
+#include <string>
+
+// 每线程错误状态：读路径上没有任何共享的可变状态，并发读取无需加锁
+namespace {
+struct ThreadError {
+    std::string text;
+    int code = 0;
+};
+thread_local ThreadError t_error;
+}
+
+void DiskIO::set_error(const char* what, int code) {
+    t_error.text = what ? what : "";
+    t_error.code = code;
+}
+
+void DiskIO::clear_error() {
+    t_error.text.clear();
+    t_error.code = 0;
+}
+
+const char* DiskIO::last_error() const { return t_error.text.c_str(); }
+
+int DiskIO::last_error_code() const { return t_error.code; }
+
+bool DiskIO::open(const char* path) {
+    return open(path, OPEN_DEFAULT);
+}
+
+// 重新打开前先关闭旧句柄：缓存中属于旧镜像的块必须丢弃。
+// 先探测镜像容器格式，不是容器时才由平台实现按普通镜像/设备打开。
+bool DiskIO::open(const char* path, uint32_t flags) {
+    close();
+    bool failed = false;
+    source_ = open_image_source(path, flags, failed);
+    if (source_) {
+        clear_error();
+        return true;
+    }
+    if (failed) return false;
+    return open_device(path, flags);
+}
+
+// 关闭前等待所有异步提交与在途预读完成，避免仍有读取落在旧句柄上。
+void DiskIO::close() {
+    wait_all();
+    if (readahead_) readahead_->reset();
+    if (cache_) cache_->clear();
+    delete source_;
+    source_ = nullptr;
+    close_device();
+}
+
+// 功能层顺序：预读（仅顺序流）→ 块缓存（小请求）→ 容错读取 → 设备
+ssize_t DiskIO::read_at(uint64_t offset, void* buf, size_t size) {
+    if (!buf && size > 0) { set_error("null buffer"); return -1; }
+    if (readahead_ && size > 0) {
+        ssize_t r;
+        if (readahead_->read(offset, buf, size, r)) return r;
+    }
+    if (cache_ && size > 0) return cache_->read(offset, buf, size);
+    return read_media(offset, buf, size);
+}
+
+ssize_t DiskIO::read_media(uint64_t offset, void* buf, size_t size) {
+    if (resilient_) return resilient_->read(offset, buf, size);
+    return read_raw(offset, buf, size);
+}
+
+// 限速在最靠近设备的一层执行：缓存命中不消耗配额，预读、二分定位等内部读取都计入
+ssize_t DiskIO::read_raw(uint64_t offset, void* buf, size_t size) {
+    IoThrottle* t = throttle_.load(std::memory_order_acquire);
+    if (t && t->active() && size > 0) t->acquire(size);
+    if (source_) return source_->read(offset, buf, size);
+    return read_device(offset, buf, size);
+}
+
+bool DiskIO::enable_block_cache(size_t capacity_bytes, size_t block_size) {
+    if (is_mapped() || capacity_bytes == 0) return false;
+    disable_block_cache();
+    cache_ = new BlockCache([this](uint64_t off, void* b, size_t n) { return read_media(off, b, n); },
+                            capacity_bytes, block_size);
+    return true;
+}
+
+void DiskIO::disable_block_cache() {
+    delete cache_;
+    cache_ = nullptr;
+}
+
+DiskIO::CacheStats DiskIO::block_cache_stats() const {
+    CacheStats out;
+    if (!cache_) return out;
+    BlockCache::Stats st = cache_->stats();
+    out.hits = st.hits;
+    out.misses = st.misses;
+    out.evictions = st.evictions;
+    out.bypassed = st.bypassed;
+    out.resident_bytes = st.resident_bytes;
+    return out;
+}
+
+bool DiskIO::enable_readahead(size_t max_window_bytes) {
+    if (is_mapped()) return false;
+    disable_readahead();
+    readahead_ = new Readahead([this](uint64_t off, void* b, size_t n) { return read_media(off, b, n); },
+                               128 * 1024, max_window_bytes);
+    return true;
+}
+
+void DiskIO::disable_readahead() {
+    delete readahead_; // 析构时等待在途预读
+    readahead_ = nullptr;
+}
+
+DiskIO::ReadaheadStats DiskIO::readahead_stats() const {
+    ReadaheadStats out;
+    if (!readahead_) return out;
+    Readahead::Stats st = readahead_->stats();
+    out.hits = st.hits;
+    out.misses = st.misses;
+    out.prefetched_bytes = st.prefetched_bytes;
+    out.window_bytes = st.window_bytes;
+    return out;
+}
+
+bool DiskIO::enable_resilient_reads(const char* skip_map_path) {
+    if (is_mapped()) return false;
+    disable_resilient_reads();
+    // 介质错误才值得二分：非系统调用错误（未打开、参数无效）错误码为 0，直接失败
+    ResilientReader* r = new ResilientReader(
+        [this](uint64_t off, void* b, size_t n, int& err) {
+            ssize_t got = read_raw(off, b, n);
+            err = got < 0 ? t_error.code : 0;
+            return got;
+        },
+        sector_size(), skip_map_path ? skip_map_path : "");
+    if (!r->load()) {
+        delete r;
+        set_error("malformed skip map");
+        return false;
+    }
+    resilient_ = r;
+    return true;
+}
+
+void DiskIO::disable_resilient_reads() {
+    delete resilient_;
+    resilient_ = nullptr;
+}
+
+DiskIO::ResilientStats DiskIO::resilient_stats() const {
+    ResilientStats out;
+    if (!resilient_) return out;
+    ResilientReader::Stats st = resilient_->stats();
+    out.bad_ranges = st.bad_ranges;
+    out.bad_bytes = st.bad_bytes;
+    out.zero_filled_bytes = st.zero_filled_bytes;
+    out.split_reads = st.split_reads;
+    out.skipped_bytes = st.skipped_bytes;
+    return out;
+}
+
+std::vector<DiskIO::BadRange> DiskIO::bad_ranges() const {
+    std::vector<BadRange> out;
+    if (!resilient_) return out;
+    for (const ResilientReader::Range& r : resilient_->ranges()) out.push_back(BadRange{r.offset, r.length});
+    return out;
+}
+
+bool DiskIO::layered() const {
+    IoThrottle* t = throttle_.load(std::memory_order_acquire);
+    return cache_ || resilient_ || source_ || (t && t->active());
+}
+
+void DiskIO::set_throttle(uint64_t bytes_per_sec, uint32_t iops) {
+    IoThrottle* t = throttle_.load(std::memory_order_acquire);
+    if (!t) {
+        if (bytes_per_sec == 0 && iops == 0) return;
+        // 限速器一经创建便存活到句柄析构，读取线程可无锁访问
+        IoThrottle* fresh = new IoThrottle();
+        if (throttle_.compare_exchange_strong(t, fresh, std::memory_order_acq_rel)) t = fresh;
+        else delete fresh;
+    }
+    t->set_limits(bytes_per_sec, iops);
+}
+
+DiskIO::ThrottleStats DiskIO::throttle_stats() const {
+    ThrottleStats out;
+    IoThrottle* t = throttle_.load(std::memory_order_acquire);
+    if (!t) return out;
+    IoThrottle::Stats st = t->stats();
+    out.delayed_reads = st.delayed_reads;
+    out.delay_us = st.delay_us;
+    return out;
+}
+
+void DiskIO::release_common() {
+    release_async();
+    disable_readahead();
+    disable_block_cache();
+    disable_resilient_reads();
+    delete source_;
+    source_ = nullptr;
+    delete throttle_.exchange(nullptr);
+}
@@ -0,0 +1,324 @@
+// disk_io_posix.cpp — POSIX (Linux) native DiskIO implementation
+//
+// 使用 pread 进行定位读取（不共享文件指针），可选 O_DIRECT 模式绕过页缓存，
+// 以免多 TB 级扫描把机器上其他进程的缓存全部挤出。批量读取在可用时使用 io_uring。
+#include "../include/disk_io.h"
+#ifdef FR_HAVE_IO_URING
+#include "io_uring_ring.h"
+#endif
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <linux/fs.h> // BLKSSZGET
+#endif
+
+// 整个镜像文件的只读映射。由 shared_ptr 管理，视图持有引用以延长生命周期。
+struct MappedRegion {
+    uint8_t* addr = nullptr;
+    size_t len = 0;
+    ~MappedRegion() { if (addr) munmap(addr, len); }
+};
+
+struct DiskIO_Impl {
+    int fd = -1;
+    bool direct = false;
+    size_t sector = 512;   // 直接 I/O 的对齐粒度
+    bool no_uring = false; // OPEN_NO_IO_URING
+    std::shared_ptr<MappedRegion> map; // OPEN_MAPPED 时的映射区（空表示未映射）
+#ifdef FR_HAVE_IO_URING
+    std::mutex ring_m;                 // 保护 ring 的惰性创建与销毁
+    std::unique_ptr<IoUringRing> ring; // 首次批量读取时创建
+    bool ring_failed = false;          // io_uring 不可用时不再重复尝试
+#endif
+};
+
+// io_uring 队列深度：足以让 NVMe 保持数十个请求在途
+static const unsigned URING_QUEUE_DEPTH = 64;
+
+// 直接 I/O 中转缓冲区上限：超过此大小的请求按块循环读取
+static const size_t DIRECT_BOUNCE_MAX = 1u << 20;
+
+static std::string errno_text(const char* what, int err) {
+    return std::string(what) + ": " + strerror(err);
+}
+
+// 构造函数：初始化底层实现指针
+DiskIO::DiskIO() : impl_(new DiskIO_Impl()) {}
+
+// 析构函数：确保句柄关闭并释放实现对象
+DiskIO::~DiskIO() {
+    close();
+    release_common();
+    delete static_cast<DiskIO_Impl*>(impl_);
+    impl_ = nullptr;
+}
+
+// 以只读方式打开文件或块设备。OPEN_DIRECT 时优先使用 O_DIRECT，
+// 若文件系统拒绝（EINVAL，例如 tmpfs）则回退为普通读取并提示内核不要缓存。
+bool DiskIO::open_device(const char* path, uint32_t flags) {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p) return false;
+    if (!path) { set_error("null path"); return false; }
+
+    int oflags = O_RDONLY;
+#ifdef O_CLOEXEC
+    oflags |= O_CLOEXEC;
+#endif
+    bool want_direct = (flags & OPEN_DIRECT) != 0;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (want_direct) {
+        fd = ::open(path, oflags | O_DIRECT);
+        if (fd >= 0) p->direct = true;
+        else if (errno != EINVAL) { int e = errno; set_error(errno_text("open", e).c_str(), e); return false; }
+    }
+#endif
+    if (fd < 0) {
+        fd = ::open(path, oflags);
+        if (fd < 0) { int e = errno; set_error(errno_text("open", e).c_str(), e); return false; }
+#if defined(POSIX_FADV_NOREUSE)
+        if (want_direct) posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+#endif
+    }
+
+    // 块设备查询逻辑扇区大小；普通文件使用 4096 作为保守的直接 I/O 对齐值
+    p->sector = 512;
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+#if defined(BLKSSZGET)
+        if (S_ISBLK(st.st_mode)) {
+            int ss = 0;
+            if (ioctl(fd, BLKSSZGET, &ss) == 0 && ss > 0) p->sector = static_cast<size_t>(ss);
+        } else
+#endif
+        if (p->direct) {
+            p->sector = 4096;
+        }
+    }
+    // 映射模式：仅对非空普通文件生效，映射失败（如 32 位地址空间不足）时回退 pread
+    if ((flags & OPEN_MAPPED) && !p->direct && fstat(fd, &st) == 0 &&
+        S_ISREG(st.st_mode) && st.st_size > 0 &&
+        static_cast<uint64_t>(st.st_size) <= static_cast<uint64_t>(SIZE_MAX)) {
+        size_t len = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED) {
+            auto region = std::make_shared<MappedRegion>();
+            region->addr = static_cast<uint8_t*>(addr);
+            region->len = len;
+            p->map = std::move(region);
+        }
+    }
+    p->fd = fd;
+    p->no_uring = (flags & OPEN_NO_IO_URING) != 0;
+    clear_error();
+    return true;
+}
+
+// 关闭当前已打开的句柄（如果有）。此操作幂等。
+void DiskIO::close_device() {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p) return;
+#ifdef FR_HAVE_IO_URING
+    {
+        std::lock_guard<std::mutex> lk(p->ring_m);
+        p->ring.reset();
+        p->ring_failed = false;
+    }
+#endif
+    p->map.reset(); // 仍被视图引用时延迟到最后一个视图释放再解除映射
+    if (p->fd >= 0) {
+        ::close(p->fd);
+        p->fd = -1;
+    }
+    p->direct = false;
+}
+
+// 循环 pread 直到读满 size 或遇到 EOF；EINTR 自动重试。
+static ssize_t pread_full(int fd, uint8_t* out, size_t size, uint64_t offset, int& err) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = ::pread(fd, out + total, size - total, static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            err = errno;
+            return -1;
+        }
+        if (n == 0) break; // EOF
+        total += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+// 直接 I/O 读取：把请求扩展到扇区边界，经对齐的中转缓冲区读取后拷回调用方。
+// 中转缓冲区按线程复用，避免每次调用都分配对齐内存。
+static ssize_t pread_direct(DiskIO_Impl* p, uint64_t offset, uint8_t* out, size_t size, int& err) {
+    struct Bounce {
+        void* ptr = nullptr;
+        size_t cap = 0;
+        ~Bounce() { free(ptr); }
+    };
+    thread_local Bounce bounce;
+
+    const size_t sec = p->sector;
+    size_t total = 0;
+    while (total < size) {
+        uint64_t pos = offset + total;
+        uint64_t aligned_start = pos - (pos % sec);
+        size_t head = static_cast<size_t>(pos - aligned_start);
+        size_t want = std::min(size - total, DIRECT_BOUNCE_MAX - head);
+        size_t span = ((head + want + sec - 1) / sec) * sec;
+        if (bounce.cap < span || (bounce.ptr && reinterpret_cast<uintptr_t>(bounce.ptr) % sec)) {
+            free(bounce.ptr);
+            bounce.ptr = nullptr;
+            bounce.cap = 0;
+            if (posix_memalign(&bounce.ptr, std::max<size_t>(sec, 4096), DIRECT_BOUNCE_MAX) != 0) {
+                err = ENOMEM;
+                return -1;
+            }
+            bounce.cap = DIRECT_BOUNCE_MAX;
+        }
+        ssize_t got = pread_full(p->fd, static_cast<uint8_t*>(bounce.ptr), span, aligned_start, err);
+        if (got < 0) return -1;
+        if (static_cast<size_t>(got) <= head) break; // EOF inside head padding
+        size_t usable = std::min(want, static_cast<size_t>(got) - head);
+        memcpy(out + total, static_cast<uint8_t*>(bounce.ptr) + head, usable);
+        total += usable;
+        if (usable < want) break; // EOF
+    }
+    return static_cast<ssize_t>(total);
+}
+
+// 从指定偏移量读取 `size` 字节到 `buf`。
+// 返回实际读取的字节数，出错返回 -1，遇到 EOF 返回已读取的较小字节数。
+ssize_t DiskIO::read_device(uint64_t offset, void* buf, size_t size) {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p) return -1;
+    if (p->fd < 0) { set_error("not opened"); return -1; }
+    if (size == 0) return 0;
+    if (!buf) { set_error("null buffer"); return -1; }
+
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    if (MappedRegion* m = p->map.get()) {
+        // 映射模式：直接从页缓存拷贝，无系统调用
+        if (offset >= m->len) return 0;
+        size_t take = static_cast<size_t>(std::min<uint64_t>(size, m->len - offset));
+        memcpy(out, m->addr + offset, take);
+        return static_cast<ssize_t>(take);
+    }
+    int err = 0;
+    ssize_t n;
+    // 调用方缓冲区、偏移与长度均已对齐时可直接读取，省去一次拷贝
+    const size_t sec = p->sector;
+    if (p->direct && !(offset % sec == 0 && size % sec == 0 &&
+                       reinterpret_cast<uintptr_t>(buf) % sec == 0)) {
+        n = pread_direct(p, offset, out, size, err);
+    } else {
+        n = pread_full(p->fd, out, size, offset, err);
+    }
+    if (n < 0) { set_error(errno_text("pread", err).c_str(), err); return -1; }
+    return n;
+}
+
+// io_uring 批量读取。直接 I/O 下只有全部请求都已对齐时才可走内核异步路径，
+// 否则交给线程池回退（read_at 内部负责中转缓冲区）。
+bool DiskIO::read_batch_native(ReadRequest* reqs, size_t count, ReadCallback cb, void* user) {
+#ifdef FR_HAVE_IO_URING
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p || p->fd < 0 || p->no_uring || p->map) return false; // 映射模式下线程池 memcpy 更快
+    if (p->direct) {
+        const size_t sec = p->sector;
+        for (size_t i = 0; i < count; ++i) {
+            if (reqs[i].offset % sec || reqs[i].size % sec ||
+                reinterpret_cast<uintptr_t>(reqs[i].buf) % sec) return false;
+        }
+    }
+    IoUringRing* ring = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(p->ring_m);
+        if (!p->ring && !p->ring_failed) {
+            std::unique_ptr<IoUringRing> r(new IoUringRing());
+            if (r->init(URING_QUEUE_DEPTH)) p->ring = std::move(r);
+            else p->ring_failed = true;
+        }
+        ring = p->ring.get();
+    }
+    if (!ring) return false;
+    return ring->run(p->fd, reqs, count, cb, user);
+#else
+    (void)reqs; (void)count; (void)cb; (void)user;
+    return false;
+#endif
+}
+
+bool DiskIO::map_view(uint64_t offset, size_t size, View& out) {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p || !p->map) return false;
+    const MappedRegion* m = p->map.get();
+    if (offset > m->len || size > m->len - offset) return false;
+    out.data = m->addr + offset;
+    out.size = size;
+    out.pin = std::shared_ptr<const void>(p->map, m->addr);
+    return true;
+}
+
+// 映射模式下对映射区 madvise，否则对文件描述符 posix_fadvise，两者都只是提示。
+void DiskIO::advise(AccessHint hint, uint64_t offset, uint64_t len) {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p || p->fd < 0) return;
+    if (MappedRegion* m = p->map.get()) {
+        if (offset >= m->len) return;
+        uint64_t end = (len == 0 || len > m->len - offset) ? m->len : offset + len;
+        // madvise 要求起始地址按页对齐
+        static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t start = offset - (offset % page);
+        int adv = MADV_NORMAL;
+        switch (hint) {
+        case ACCESS_SEQUENTIAL: adv = MADV_SEQUENTIAL; break;
+        case ACCESS_RANDOM:     adv = MADV_RANDOM; break;
+        case ACCESS_WILLNEED:   adv = MADV_WILLNEED; break;
+        default: break;
+        }
+        madvise(m->addr + start, static_cast<size_t>(end - start), adv);
+        return;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    int adv = POSIX_FADV_NORMAL;
+    switch (hint) {
+    case ACCESS_SEQUENTIAL: adv = POSIX_FADV_SEQUENTIAL; break;
+    case ACCESS_RANDOM:     adv = POSIX_FADV_RANDOM; break;
+    case ACCESS_WILLNEED:   adv = POSIX_FADV_WILLNEED; break;
+    default: break;
+    }
+    posix_fadvise(p->fd, static_cast<off_t>(offset), static_cast<off_t>(len), adv);
+#endif
+}
+
+bool DiskIO::is_mapped() const {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    return p && p->map;
+}
+
+bool DiskIO::device_open() const {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    return p && p->fd >= 0;
+}
+
+bool DiskIO::is_direct() const {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    return p && p->direct;
+}
+
+size_t DiskIO::sector_size() const {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    return p ? p->sector : 512;
+}
@@ -2,46 +2,42 @@
 #include "disk_io.h"
 #include <string>
 #include <cstring>
-#include <mutex>
+#include <atomic>
 
+// 读路径无锁：opened 为原子标志，错误状态按线程保存（见 disk_io_common.cpp）
 struct DiskIOImpl {
-    std::string last_err;
-    bool opened = false;
+    std::atomic<bool> opened{false};
     std::string path;
-    std::mutex m;
 };
 
 // 构造/析构：管理 stub 实现的生命周期
 DiskIO::DiskIO() : impl_(new DiskIOImpl()) {}
 
-DiskIO::~DiskIO() { delete static_cast<DiskIOImpl*>(impl_); impl_ = nullptr; }
+DiskIO::~DiskIO() { release_common(); delete static_cast<DiskIOImpl*>(impl_); impl_ = nullptr; }
 
-// 打开 stub 路径：在测试中标记为已打开并记录路径。线程安全。
-bool DiskIO::open(const char* path) {
+// 打开 stub 路径：在测试中标记为已打开并记录路径。flags 被忽略。
+bool DiskIO::open_device(const char* path, uint32_t /*flags*/) {
     if (!impl_) return false;
     DiskIOImpl* d = static_cast<DiskIOImpl*>(impl_);
-    std::lock_guard<std::mutex> lk(d->m);
-    if (!path) { d->last_err = "null path"; return false; }
+    if (!path) { set_error("null path"); return false; }
     d->path = path;
-    d->opened = true;
-    d->last_err.clear();
+    d->opened.store(true, std::memory_order_release);
+    clear_error();
     return true;
 }
 
-// 关闭 stub（将 opened 标志重置）。线程安全。
-void DiskIO::close() {
+// 关闭 stub（将 opened 标志重置）。
+void DiskIO::close_device() {
     if (!impl_) return;
     DiskIOImpl* d = static_cast<DiskIOImpl*>(impl_);
-    std::lock_guard<std::mutex> lk(d->m);
-    d->opened = false;
+    d->opened.store(false, std::memory_order_release);
 }
 
 // 模拟读取：用重复字节填充缓冲区以便测试消费。返回填充字节数或错误码。
-ssize_t DiskIO::read_at(uint64_t /*offset*/, void* buf, size_t size) {
+ssize_t DiskIO::read_device(uint64_t /*offset*/, void* buf, size_t size) {
     if (!impl_) return -1;
     DiskIOImpl* d = static_cast<DiskIOImpl*>(impl_);
-    std::lock_guard<std::mutex> lk(d->m);
-    if (!d->opened) { d->last_err = "not opened"; return -1; }
+    if (!d->opened.load(std::memory_order_acquire)) { set_error("not opened"); return -1; }
     // stub: 用固定字节填充缓冲区以模拟读取
     if (buf && size > 0) {
         memset(buf, 0xAA, size > 256 ? 256 : size);
@@ -50,11 +46,20 @@ ssize_t DiskIO::read_at(uint64_t /*offset*/, void* buf, size_t size) {
     return 0;
 }
 
-// 返回最近一次操作的错误信息字符串，指向内部存储。
-const char* DiskIO::last_error() const {
-    if (!impl_) return "no impl";
-    DiskIOImpl* d = static_cast<DiskIOImpl*>(impl_);
-    return d->last_err.c_str();
+bool DiskIO::is_direct() const { return false; }
+
+bool DiskIO::device_open() const {
+    return impl_ && static_cast<DiskIOImpl*>(impl_)->opened.load(std::memory_order_acquire);
 }
 
-// 返回最近一次操作的错误信息字符串，指向内部存储。
+// stub 无原生批量引擎，read_batch 使用线程池回退。
+bool DiskIO::read_batch_native(ReadRequest*, size_t, ReadCallback, void*) { return false; }
+
+size_t DiskIO::sector_size() const { return 512; }
+
+// stub 不支持映射模式
+bool DiskIO::map_view(uint64_t, size_t, View&) { return false; }
+
+void DiskIO::advise(AccessHint, uint64_t, uint64_t) {}
+
+bool DiskIO::is_mapped() const { return false; }
@@ -3,10 +3,23 @@
 #include <windows.h>
 #include <string>
 #include <algorithm>
+#include <cstring>
+#include <memory>
+
+// 整个镜像文件的只读映射（MapViewOfFile）。由 shared_ptr 管理，视图持有引用以延长生命周期。
+struct MappedRegion {
+    HANDLE mapping = nullptr;
+    const uint8_t* addr = nullptr;
+    uint64_t len = 0;
+    ~MappedRegion() {
+        if (addr) UnmapViewOfFile(addr);
+        if (mapping) CloseHandle(mapping);
+    }
+};
 
 struct DiskIO_Impl {
     HANDLE h = INVALID_HANDLE_VALUE;
-    std::string last_err;
+    std::shared_ptr<MappedRegion> map; // OPEN_MAPPED 时的映射区（空表示未映射）
 };
 
 // 构造函数：初始化底层实现指针
@@ -15,13 +28,15 @@ DiskIO::DiskIO() : impl_(new DiskIO_Impl()) {}
 // 析构函数：确保句柄关闭并释放实现对象
 DiskIO::~DiskIO() {
     close();
+    release_common();
     delete static_cast<DiskIO_Impl*>(impl_);
     impl_ = nullptr;
 }
 
 // 打开指定路径（文件或设备）用于只读访问。
 // 成功返回 true；失败时可通过 `last_error()` 获取详细信息。
-bool DiskIO::open(const char* path) {
+// 说明：OPEN_DIRECT 目前在 Windows 上被忽略（FILE_FLAG_NO_BUFFERING 需要调用方对齐）。
+bool DiskIO::open_device(const char* path, uint32_t flags) {
     DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
     if (!p) return false;
     p->h = CreateFileA(path,
@@ -36,17 +51,37 @@ bool DiskIO::open(const char* path) {
         char buf[512] = {0};
         FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
                        nullptr, err, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), buf, (DWORD)sizeof(buf), nullptr);
-        p->last_err = buf;
+        set_error(buf, static_cast<int>(err));
         return false;
     }
-    p->last_err.clear();
+    // 映射模式：仅对普通文件生效，失败时静默回退为 ReadFile
+    LARGE_INTEGER fsize;
+    if ((flags & OPEN_MAPPED) && GetFileType(p->h) == FILE_TYPE_DISK &&
+        GetFileSizeEx(p->h, &fsize) && fsize.QuadPart > 0 &&
+        static_cast<uint64_t>(fsize.QuadPart) <= static_cast<uint64_t>(SIZE_MAX)) {
+        HANDLE hm = CreateFileMappingA(p->h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hm) {
+            const void* addr = MapViewOfFile(hm, FILE_MAP_READ, 0, 0, 0);
+            if (addr) {
+                auto region = std::make_shared<MappedRegion>();
+                region->mapping = hm;
+                region->addr = static_cast<const uint8_t*>(addr);
+                region->len = static_cast<uint64_t>(fsize.QuadPart);
+                p->map = std::move(region);
+            } else {
+                CloseHandle(hm);
+            }
+        }
+    }
+    clear_error();
     return true;
 }
 
 // 关闭当前已打开的句柄（如果有）。此操作幂等。
-void DiskIO::close() {
+void DiskIO::close_device() {
     DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
     if (!p) return;
+    p->map.reset(); // 仍被视图引用时延迟到最后一个视图释放再解除映射
     if (p->h != INVALID_HANDLE_VALUE) {
         CloseHandle(p->h);
         p->h = INVALID_HANDLE_VALUE;
@@ -55,9 +90,17 @@ void DiskIO::close() {
 
 // 从指定偏移量读取 `size` 字节到 `buf`。
 // 返回实际读取的字节数，出错返回 -1，遇到 EOF 返回已读取的较小字节数。
-ssize_t DiskIO::read_at(uint64_t offset, void* buf, size_t size) {
+ssize_t DiskIO::read_device(uint64_t offset, void* buf, size_t size) {
     DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
-    if (!p || p->h == INVALID_HANDLE_VALUE) return -1;
+    if (!p) return -1;
+    if (p->h == INVALID_HANDLE_VALUE) { set_error("not opened"); return -1; }
+    if (MappedRegion* m = p->map.get()) {
+        // 映射模式：直接从映射区拷贝
+        if (offset >= m->len) return 0;
+        size_t take = static_cast<size_t>(std::min<uint64_t>(size, m->len - offset));
+        memcpy(buf, m->addr + offset, take);
+        return static_cast<ssize_t>(take);
+    }
     // ReadFile with OVERLAPPED to avoid moving file pointer
     // Windows ReadFile takes a DWORD for size; if caller requests > 0xFFFFFFFF, read in chunks.
     const size_t MAX_CHUNK = 0xFFFFFFFFu;
@@ -81,7 +124,7 @@ ssize_t DiskIO::read_at(uint64_t offset, void* buf, size_t size) {
             char bufErr[512] = {0};
             FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
                            nullptr, err, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), bufErr, (DWORD)sizeof(bufErr), nullptr);
-            p->last_err = bufErr;
+            set_error(bufErr, static_cast<int>(err));
             return -1;
         }
         totalRead += bytesRead;
@@ -92,11 +135,35 @@ ssize_t DiskIO::read_at(uint64_t offset, void* buf, size_t size) {
     return (ssize_t)totalRead;
 }
 
-// 返回最后一次操作的错误描述，返回值指向内部缓冲区，调用者无需释放。
-const char* DiskIO::last_error() const {
+bool DiskIO::is_direct() const { return false; }
+
+bool DiskIO::device_open() const {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    return p && p->h != INVALID_HANDLE_VALUE;
+}
+
+// Windows 暂无原生批量引擎（可后续接入 IOCP），read_batch 使用线程池回退。
+bool DiskIO::read_batch_native(ReadRequest*, size_t, ReadCallback, void*) { return false; }
+
+size_t DiskIO::sector_size() const { return 512; }
+
+bool DiskIO::map_view(uint64_t offset, size_t size, View& out) {
+    DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
+    if (!p || !p->map) return false;
+    const MappedRegion* m = p->map.get();
+    if (offset > m->len || size > m->len - offset) return false;
+    out.data = m->addr + offset;
+    out.size = size;
+    out.pin = std::shared_ptr<const void>(p->map, m->addr);
+    return true;
+}
+
+// Windows 上暂不转发访问提示（PrefetchVirtualMemory 需要 Windows 8+ 头文件）。
+void DiskIO::advise(AccessHint, uint64_t, uint64_t) {}
+
+bool DiskIO::is_mapped() const {
     DiskIO_Impl* p = static_cast<DiskIO_Impl*>(impl_);
-    if (!p) return "not-initialized";
-    return p->last_err.c_str();
+    return p && p->map;
 }
 
 // 返回最后一次操作的错误描述，返回值指向内部缓冲区，调用者无需释放。
@@ -3,6 +3,10 @@
 // 说明：此实现为占位（stub），用于在早期开发阶段验证 C API、构建和单元测试流程。
 // 真正的引擎实现会替换这些函数，增加磁盘 I/O、文件系统解析与雕刻逻辑。
 #include "fr.h"
+#include "disk_io.h"
+#include "ntfs_mft.h"
+#include "mft_table.h"
+#include "mft_path.h"
 #include <string>
 #include <mutex>
 #include <vector>
@@ -13,10 +17,13 @@
 
 struct fr_handle_s {
     std::string path;                 // 打开的镜像或设备路径
+    DiskIO dio;                       // 镜像读取句柄（stub 中打开失败不视为错误）
+    bool opened = false;              // dio 是否打开成功
     std::atomic<bool> scanning{false}; // 当前是否处于扫描状态
     std::mutex m;                      // 保护 candidates 与 next_index 的互斥量
     std::vector<fr_candidate_t> candidates; // 已发现的候选文件列表（简化）
     size_t next_index{0};              // 下一个轮询索引
+    MFTTable table;                    // 上一次扫描得到的 MFT 表（再次扫描时增量更新，随项目保存）
 };
 
 // 全局初始化标志：fr_init / fr_shutdown 控制生命周期
@@ -49,6 +56,7 @@ fr_handle_t fr_open_image(const char* path, fr_error_t* err) {
     }
     fr_handle_s* h = new fr_handle_s();
     h->path = path;
+    h->opened = h->dio.open(path);
     if (err) *err = FR_OK;
     return h;
 }
@@ -61,14 +69,83 @@ void fr_close(fr_handle_t h) {
 
 // 关闭并释放句柄及其关联资源。
 
-// 开始扫描：stub 实现只是模拟发现若干候选文件。
+// 从 MFT 收集候选项：非目录、非系统元文件（记录号 >= 16）且有文件名的记录，
+// 按记录号顺序排列，file_name 为由父目录引用重建的完整路径。MFT 由 max_threads
+// 个线程并行解析；句柄上已有（扫描或载入项目得到的）表时以 refresh 增量更新。deep 为 true 时再按 $Bitmap 只读取空闲簇，把其中残留的孤儿 MFT
+// 记录追加为候选项（id 接在 MFT 记录号之后，路径位于 MFT_ORPHAN_DIR 下）。
+// 返回: FR_OK；FR_ERR_NOT_FOUND 表示镜像不是 NTFS 卷；FR_ERR_IO 表示读取 MFT 出错
+static fr_error_t collect_mft_candidates(fr_handle_s* h, uint32_t max_threads, bool deep,
+                                         std::vector<fr_candidate_t>& out) {
+    NTFSParser parser;
+    if (!h->opened || !parser.open_volume(h->dio, 0)) return FR_ERR_NOT_FOUND;
+    parser.set_threads(max_threads);
+    MFTTable& table = h->table;
+    if (table.empty() ? !table.fill(parser, h->dio) : !table.refresh(parser, h->dio)) return FR_ERR_IO;
+    MFTPathResolver paths(table);
+    const NTFSVolume& vol = parser.volume();
+    std::string path;
+    for (MFTRow r : table.filter([&](MFTRow row) {
+             return table.id(row) >= 16 && !table.is_directory(row) && table.name_id(row) != 0;
+         })) {
+        fr_candidate_t c;
+        memset(&c, 0, sizeof(c));
+        c.id = table.id(r);
+        c.size = table.file_size(r);
+        for (const auto& run : table.runs(r)) {
+            if (run.second >= 0) {
+                c.offset = vol.lcn_offset(static_cast<uint64_t>(run.second));
+                break;
+            }
+        }
+        paths.path(r, path);
+        snprintf(c.file_name, sizeof(c.file_name), "%s", path.c_str());
+        out.push_back(c);
+    }
+    if (!deep) return FR_OK;
+
+    std::vector<std::pair<uint64_t,uint64_t>> free_extents, regions;
+    if (!parser.load_free_extents(h->dio, free_extents)) return FR_OK; // $Bitmap 不可读时只报告 MFT 结果
+    parser.free_space_regions(free_extents, regions);
+    uint64_t next_id = table.empty() ? 0 : table.ids().back() + 1;
+    parser.find_orphan_records(h->dio, regions, [&](uint64_t disk_offset, const NTFSFileRecord& rec) {
+        if ((rec.flags & 0x02) != 0 || rec.name.empty()) return true;
+        fr_candidate_t c;
+        memset(&c, 0, sizeof(c));
+        c.id = next_id++;
+        c.size = rec.size;
+        c.offset = disk_offset; // 常驻数据位于记录内
+        for (const auto& run : rec.data_runs) {
+            if (run.second >= 0) {
+                c.offset = vol.lcn_offset(static_cast<uint64_t>(run.second));
+                break;
+            }
+        }
+        snprintf(c.file_name, sizeof(c.file_name), "\\%s\\%s", MFT_ORPHAN_DIR, rec.name.c_str());
+        out.push_back(c);
+        return true;
+    });
+    return FR_OK;
+}
+
+// 开始扫描：镜像是 NTFS 卷时从 MFT 收集候选项（深度扫描另外搜索空闲簇中的孤儿记录）；
+// 否则（stub）模拟发现若干候选文件。
 // 真实实现应触发异步扫描/多线程读取、解析并将结果入队。
-// 启动扫描流程（stub 实现为同步填充模拟候选）。真实实现应异步执行并报告进度。
+// 启动扫描流程（同步）。真实实现应异步执行并报告进度。
 fr_error_t fr_start_scan(fr_handle_t h, const fr_scan_params_t* params) {
     if (!h) return FR_ERR_INVALID_ARG;
-    // 简单模拟：填充若干候选项以供轮询测试使用
     std::lock_guard<std::mutex> lk(h->m);
     h->candidates.clear();
+    h->next_index = 0;
+    if (params) h->dio.set_throttle(params->max_read_bytes_per_sec, params->max_read_iops);
+    std::vector<fr_candidate_t> found;
+    fr_error_t e = collect_mft_candidates(h, params ? params->max_threads : 0,
+                                          params && params->mode == FR_SCAN_DEEP, found);
+    if (e != FR_ERR_NOT_FOUND) {
+        h->candidates.swap(found);
+        h->scanning.store(e == FR_OK);
+        return e;
+    }
+    // 简单模拟：填充若干候选项以供轮询测试使用
     for (uint64_t i = 1; i <= 5; ++i) {
         fr_candidate_t c;
         c.id = i;
@@ -78,9 +155,14 @@ fr_error_t fr_start_scan(fr_handle_t h, const fr_scan_params_t* params) {
         strncpy(c.mime_type, "image/jpeg", sizeof(c.mime_type));
         h->candidates.push_back(c);
     }
-    h->next_index = 0;
     h->scanning.store(true);
-    (void)params; // params 在 stub 中未使用
+    return FR_OK;
+}
+
+// 调整读取限速：直接作用于句柄的 DiskIO，扫描线程的后续读取立即按新限额执行。
+fr_error_t fr_set_io_limits(fr_handle_t h, uint64_t max_read_bytes_per_sec, uint32_t max_read_iops) {
+    if (!h) return FR_ERR_INVALID_ARG;
+    h->dio.set_throttle(max_read_bytes_per_sec, max_read_iops);
     return FR_OK;
 }
 
@@ -107,16 +189,17 @@ fr_error_t fr_export_candidate(fr_handle_t h, uint64_t candidate_id, const char*
     return FR_ERR_NOT_FOUND;
 }
 
-// 保存/加载扫描项目（JSON）：stub 不做实际存储。
-// 保存扫描项目（例如 JSON）。真实实现应将扫描状态写入磁盘。
+// 保存/加载扫描项目：项目即句柄上的 MFT 表（含记录指纹与 $UsnJrnl 位置），
+// 载入后对同一卷再次 fr_start_scan 只重新解析变化的记录。
 fr_error_t fr_save_project(fr_handle_t h, const char* project_path) {
-    (void)h; (void)project_path;
-    return FR_OK;
+    if (!h || !project_path) return FR_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lk(h->m);
+    return h->table.save(project_path) ? FR_OK : FR_ERR_IO;
 }
 
+// 从磁盘加载先前保存的扫描项目到句柄中。
 fr_error_t fr_load_project(fr_handle_t h, const char* project_path) {
-    (void)h; (void)project_path;
-    return FR_OK;
+    if (!h || !project_path) return FR_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lk(h->m);
+    return h->table.load(project_path) ? FR_OK : FR_ERR_IO;
 }
-
-// 从磁盘加载先前保存的扫描项目到句柄中。
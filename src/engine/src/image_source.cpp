@@ -0,0 +1,10 @@
+// image_source.cpp — 镜像容器格式探测
+#include "image_source.h"
+
+ImageSource* open_image_source(const char* path, uint32_t flags, bool& failed) {
+    failed = false;
+    if (!path || (flags & DiskIO::OPEN_RAW)) return nullptr;
+    ImageSource* s = open_chunked_image(path, flags, failed);
+    if (s || failed) return s;
+    return open_segmented_image(path, flags, failed);
+}
@@ -0,0 +1,34 @@
+// image_source.h — DiskIO 的虚拟镜像数据源（非公开头文件）
+//
+// 普通镜像与设备由平台实现（read_device）直接读取；容器格式（分块压缩镜像、
+// 分段镜像等）则由 ImageSource 把“虚拟设备”偏移翻译为对底层文件的读取。
+// DiskIO::open 依次探测各格式，命中时由数据源取代平台读取，其上的功能层（缓存、预读、容错读取）
+// 保持不变。
+#pragma once
+#include "../include/disk_io.h"
+#include <cstddef>
+#include <cstdint>
+
+class ImageSource {
+public:
+    virtual ~ImageSource() {}
+
+    // 读取虚拟设备 [offset, offset+size)：语义同 DiskIO::read_at，须支持并发调用。
+    // 失败时返回 -1，并通过 fail() 记录调用线程的错误。
+    virtual ssize_t read(uint64_t offset, void* buf, size_t size) = 0;
+
+    // 虚拟设备大小（字节）；0 表示未知（例如包装任意设备的模拟数据源）
+    virtual uint64_t size() const = 0;
+
+    // 记录调用线程的错误（见 DiskIO::last_error）
+    static void fail(const char* what, int code = 0) { DiskIO::set_error(what, code); }
+};
+
+// 探测 path 是否为已知容器格式并打开。返回 nullptr 且 failed == false 表示不是
+// 容器格式，调用方按普通镜像打开；failed == true 表示是容器但已损坏（错误已记录）。
+// flags 含 OPEN_RAW 时不做探测。
+ImageSource* open_image_source(const char* path, uint32_t flags, bool& failed);
+
+// 各格式的探测函数（约定同 open_image_source）
+ImageSource* open_chunked_image(const char* path, uint32_t flags, bool& failed);
+ImageSource* open_segmented_image(const char* path, uint32_t flags, bool& failed);
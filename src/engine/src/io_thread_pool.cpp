@@ -0,0 +1,56 @@
+// io_thread_pool.cpp — 共享 I/O 线程池实现
+#include "io_thread_pool.h"
+#include <algorithm>
+
+// I/O 线程主要阻塞在系统调用上，因此线程数可以超过 CPU 核数：
+// 取 2 倍硬件并发，下限 4、上限 32，足以让 NVMe 保持数十个请求在途。
+IOThreadPool& IOThreadPool::instance() {
+    static IOThreadPool pool([] {
+        size_t hw = std::thread::hardware_concurrency();
+        if (hw == 0) hw = 4;
+        return std::min<size_t>(32, std::max<size_t>(4, hw * 2));
+    }());
+    return pool;
+}
+
+IOThreadPool::IOThreadPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+IOThreadPool::~IOThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void IOThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+// 工作线程：取任务执行，直到池被销毁且队列清空
+void IOThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_.wait(lk, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) return; // stop_ 且无剩余任务
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,38 @@
+// io_thread_pool.h — 引擎内部共享的 I/O 线程池（非公开头文件）
+//
+// 用于 DiskIO 批量/异步读取的回退路径：没有原生异步引擎（io_uring）的平台上，
+// 通过多个阻塞 read_at 并发来维持设备队列深度。任务不得在池内等待其他池任务，
+// 否则可能在线程池饱和时死锁。
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class IOThreadPool {
+public:
+    // 进程级共享实例（首次使用时创建，线程数见 io_thread_pool.cpp）
+    static IOThreadPool& instance();
+
+    explicit IOThreadPool(size_t threads);
+    ~IOThreadPool();
+
+    IOThreadPool(const IOThreadPool&) = delete;
+    IOThreadPool& operator=(const IOThreadPool&) = delete;
+
+    // 投递一个任务，由任意工作线程执行
+    void post(std::function<void()> task);
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    void worker_loop();
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+};
@@ -0,0 +1,58 @@
+// io_throttle.cpp — 令牌桶限速实现
+#include "io_throttle.h"
+#include <algorithm>
+#include <chrono>
+
+// 允许的突发量：相当于 50 ms 的配额，避免小请求逐个被精确节拍化
+static const int64_t BURST_NS = 50 * 1000 * 1000;
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t IoThrottle::Bucket::reserve(double units, int64_t now) {
+    double per = ns_per_unit.load(std::memory_order_relaxed);
+    if (per <= 0) return 0;
+    int64_t cost = static_cast<int64_t>(units * per);
+    int64_t tat_old = tat.load(std::memory_order_relaxed);
+    int64_t tat_new;
+    do {
+        tat_new = std::max(tat_old, now - BURST_NS) + cost;
+    } while (!tat.compare_exchange_weak(tat_old, tat_new, std::memory_order_relaxed));
+    return tat_new - now - BURST_NS;
+}
+
+void IoThrottle::set_limits(uint64_t bytes_per_sec, uint32_t iops) {
+    bytes_.ns_per_unit.store(bytes_per_sec ? 1e9 / static_cast<double>(bytes_per_sec) : 0.0,
+                             std::memory_order_relaxed);
+    ops_.ns_per_unit.store(iops ? 1e9 / static_cast<double>(iops) : 0.0, std::memory_order_relaxed);
+    // 新限额从当前时刻起计算，已积累的欠账作废
+    bytes_.tat.store(0, std::memory_order_relaxed);
+    ops_.tat.store(0, std::memory_order_relaxed);
+    active_.store(bytes_per_sec != 0 || iops != 0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(wait_m_);
+        generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wait_cv_.notify_all();
+}
+
+void IoThrottle::acquire(size_t bytes) {
+    int64_t now = now_ns();
+    int64_t wait = std::max(bytes_.reserve(static_cast<double>(bytes), now), ops_.reserve(1.0, now));
+    if (wait <= 0) return;
+    std::unique_lock<std::mutex> lk(wait_m_);
+    uint64_t gen = generation_.load(std::memory_order_relaxed);
+    wait_cv_.wait_for(lk, std::chrono::nanoseconds(wait),
+                      [&] { return generation_.load(std::memory_order_relaxed) != gen; });
+    delayed_.fetch_add(1, std::memory_order_relaxed);
+    delay_us_.fetch_add(static_cast<uint64_t>(now_ns() - now) / 1000, std::memory_order_relaxed);
+}
+
+IoThrottle::Stats IoThrottle::stats() const {
+    Stats st;
+    st.delayed_reads = delayed_.load(std::memory_order_relaxed);
+    st.delay_us = delay_us_.load(std::memory_order_relaxed);
+    return st;
+}
@@ -0,0 +1,45 @@
+// io_throttle.h — DiskIO 带宽/IOPS 限速（非公开头文件）
+//
+// 令牌桶以“理论到达时间”（GCRA）形式实现：每个桶只有一个原子时间戳，
+// 每次读取用一次 CAS 预约令牌，无需加锁；只有确实需要等待的线程才进入
+// 条件变量睡眠。限额可在读取进行中随时调整，调整会唤醒等待中的线程。
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class IoThrottle {
+public:
+    struct Stats {
+        uint64_t delayed_reads = 0; // 因限速而等待的读取次数
+        uint64_t delay_us = 0;      // 累计等待时间
+    };
+
+    // 0 表示不限制对应维度
+    void set_limits(uint64_t bytes_per_sec, uint32_t iops);
+    bool active() const { return active_.load(std::memory_order_relaxed); }
+
+    // 为一次 bytes 字节的读取取得令牌，必要时阻塞等待
+    void acquire(size_t bytes);
+
+    Stats stats() const;
+
+private:
+    struct Bucket {
+        std::atomic<double> ns_per_unit{0}; // 0 表示不限制
+        std::atomic<int64_t> tat{0};        // 理论到达时间（纳秒，单调时钟）
+        // 预约 units 个令牌，返回需要等待的纳秒数（<= 0 表示无需等待）
+        int64_t reserve(double units, int64_t now);
+    };
+
+    Bucket bytes_;
+    Bucket ops_;
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> generation_{0}; // 每次调整限额递增，用于唤醒等待者
+    std::mutex wait_m_;
+    std::condition_variable wait_cv_;
+    std::atomic<uint64_t> delayed_{0};
+    std::atomic<uint64_t> delay_us_{0};
+};
@@ -0,0 +1,284 @@
+// io_uring_ring.cpp — 最小 io_uring 读取引擎实现（原始系统调用）
+#include "io_uring_ring.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 一个 run() 调用的请求批次。请求的 user_data 指向其 Tag，
+// 收割到完成的线程据此把结果交给所属批次，由所属线程处理。
+struct IoUringRing::Batch {
+    struct Tag {
+        Batch* batch;
+        size_t index;
+    };
+
+    DiskIO::ReadRequest* reqs;
+    size_t count;
+    std::vector<iovec> iov;        // 必须在请求完成前保持有效
+    std::vector<Tag> tags;
+    std::vector<uint8_t> finished;
+    std::vector<std::pair<size_t, int>> ready; // 已收割、待所属线程处理的 (请求, 内核结果)
+    size_t next = 0;               // 下一个待放入提交队列的请求
+    size_t done = 0;               // 已处理完毕的请求数
+
+    Batch(DiskIO::ReadRequest* r, size_t n) : reqs(r), count(n), iov(n), tags(n), finished(n, 0) {
+        for (size_t i = 0; i < n; ++i) tags[i] = Tag{this, i};
+    }
+};
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// 环的头尾指针与内核共享，需要 acquire/release 语义
+static inline unsigned load_acquire(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void store_release(unsigned* p, unsigned v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static std::string errno_text(const char* what, int err) {
+    return std::string(what) + ": " + strerror(err);
+}
+
+static bool transient_errno(int err) {
+    return err == EINTR || err == EAGAIN || err == EBUSY;
+}
+
+// 同步补读：用于短读后的剩余部分以及环失效后的兜底
+static ssize_t pread_rest(int fd, uint8_t* out, size_t size, uint64_t offset) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = ::pread(fd, out + total, size - total, static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        total += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+IoUringRing::~IoUringRing() { teardown(); }
+
+void IoUringRing::teardown() {
+    if (sqes_ptr_) munmap(sqes_ptr_, sqes_len_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_len_);
+    if (sq_ptr_) munmap(sq_ptr_, sq_len_);
+    sqes_ptr_ = cq_ptr_ = sq_ptr_ = nullptr;
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+    ring_fd_ = -1;
+}
+
+bool IoUringRing::init(unsigned entries) {
+    teardown();
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = sys_io_uring_setup(entries, &p);
+    if (fd < 0) return false;
+    ring_fd_ = fd;
+    sq_entries_ = p.sq_entries;
+
+    sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (cq_len_ > sq_len_) sq_len_ = cq_len_;
+        cq_len_ = sq_len_;
+    }
+    sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) { sq_ptr_ = nullptr; teardown(); return false; }
+    if (single) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) { cq_ptr_ = nullptr; teardown(); return false; }
+    }
+    sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ptr_ = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ptr_ == MAP_FAILED) { sqes_ptr_ = nullptr; teardown(); return false; }
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ptr_);
+    uint8_t* cq = static_cast<uint8_t*>(cq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = cq + p.cq_off.cqes;
+    return true;
+}
+
+// 收割完成队列：结果追加到各请求所属批次的 ready，并唤醒等待中的线程
+void IoUringRing::reap_locked() {
+    io_uring_cqe* cqes = static_cast<io_uring_cqe*>(cqes_);
+    unsigned head = *cq_head_;
+    const unsigned ctail = load_acquire(cq_tail_);
+    const unsigned cmask = *cq_mask_;
+    if (head == ctail) return;
+    while (head != ctail) {
+        io_uring_cqe* cqe = &cqes[head & cmask];
+        Batch::Tag* t = reinterpret_cast<Batch::Tag*>(static_cast<uintptr_t>(cqe->user_data));
+        t->batch->ready.emplace_back(t->index, cqe->res);
+        ++head;
+        --inflight_;
+    }
+    store_release(cq_head_, head);
+    cv_.notify_all();
+}
+
+// 环失效（理论上仅在 EFAULT/EBADF 等编程错误时发生）：在途请求仍可能写入调用方缓冲区，
+// 必须等它们全部完成并收割后才能销毁环，之后各批次用 pread 同步补齐未完成的请求。
+// 提交队列中内核尚未消费的条目随环一起丢弃，不会再被执行。
+void IoUringRing::drain_and_teardown_locked(std::unique_lock<std::mutex>& lk) {
+    cv_.wait(lk, [this] { return !waiter_; });
+    if (ring_fd_ < 0) return; // 其他线程已完成清理
+    while (inflight_ > 0) {
+        if (sys_io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && !transient_errno(errno)) {
+            // 无法在内核中等待时轮询完成队列：完成事件仍由内核写入共享内存
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reap_locked();
+    }
+    teardown();
+    unsubmitted_ = 0;
+    cv_.notify_all();
+}
+
+bool IoUringRing::run(int fd, DiskIO::ReadRequest* reqs, size_t count,
+                      DiskIO::ReadCallback cb, void* user) {
+    std::unique_lock<std::mutex> lk(m_);
+    if (ring_fd_ < 0) return false;
+
+    Batch b(reqs, count);
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(sqes_ptr_);
+
+    // 处理一个完成（锁外，在调用线程上）：短读补读、记录错误、调用回调
+    auto complete = [&](size_t i, ssize_t res) {
+        DiskIO::ReadRequest& r = reqs[i];
+        if (res < 0) {
+            DiskIO::set_error(errno_text("io_uring read", static_cast<int>(-res)).c_str(), static_cast<int>(-res));
+            res = -1;
+        } else if (res > 0 && static_cast<size_t>(res) < r.size) {
+            // 短读通常意味着 EOF；补读失败（例如 O_DIRECT 下的非对齐尾部）时保留已读部分
+            ssize_t rest = pread_rest(fd, static_cast<uint8_t*>(r.buf) + res, r.size - res, r.offset + res);
+            if (rest > 0) res += rest;
+        }
+        r.result = res;
+        b.finished[i] = 1;
+        ++b.done;
+        if (cb) cb(r, user);
+    };
+
+    while (b.done < count && ring_fd_ >= 0) {
+        // 填充提交队列：环深度由所有并发批次共享
+        unsigned tail = *sq_tail_;
+        const unsigned mask = *sq_mask_;
+        unsigned queued = 0;
+        while (b.next < count && inflight_ + unsubmitted_ + queued < sq_entries_) {
+            DiskIO::ReadRequest& r = reqs[b.next];
+            if (r.size == 0) {
+                b.ready.emplace_back(b.next, 0);
+                ++b.next;
+                continue;
+            }
+            b.iov[b.next].iov_base = r.buf;
+            b.iov[b.next].iov_len = r.size;
+            unsigned idx = tail & mask;
+            io_uring_sqe* sqe = &sqes[idx];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = fd;
+            sqe->off = r.offset;
+            sqe->addr = reinterpret_cast<uint64_t>(&b.iov[b.next]);
+            sqe->len = 1;
+            sqe->user_data = reinterpret_cast<uint64_t>(&b.tags[b.next]);
+            sq_array_[idx] = idx;
+            ++tail;
+            ++queued;
+            ++b.next;
+        }
+        if (queued) {
+            store_release(sq_tail_, tail);
+            unsubmitted_ += queued;
+        }
+        if (unsubmitted_) {
+            int rc = sys_io_uring_enter(ring_fd_, static_cast<unsigned>(unsubmitted_), 0, 0);
+            if (rc < 0) {
+                if (!transient_errno(errno)) {
+                    drain_and_teardown_locked(lk);
+                    continue;
+                }
+            } else {
+                unsubmitted_ -= static_cast<size_t>(rc);
+                inflight_ += static_cast<size_t>(rc);
+            }
+        }
+
+        // 等待者在锁外时由它负责收割，否则它可能在完成已被别人取走后阻塞在内核中
+        if (!waiter_) reap_locked();
+        if (!b.ready.empty()) {
+            std::vector<std::pair<size_t, int>> ready;
+            ready.swap(b.ready);
+            lk.unlock();
+            for (const auto& c : ready) complete(c.first, c.second);
+            lk.lock();
+            continue;
+        }
+        if (b.done == count) break;
+
+        if (!waiter_ && inflight_ > 0) {
+            // 成为等待者：在锁外阻塞到至少一个请求完成（可能属于其他批次）
+            const int ring_fd = ring_fd_;
+            waiter_ = true;
+            lk.unlock();
+            int rc = sys_io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+            int err = errno;
+            lk.lock();
+            waiter_ = false;
+            cv_.notify_all();
+            if (rc < 0 && !transient_errno(err)) drain_and_teardown_locked(lk);
+            continue;
+        }
+        if (!waiter_ && inflight_ == 0) {
+            // 内核暂时拒绝提交（EAGAIN/EBUSY）：让出锁后重试
+            lk.unlock();
+            std::this_thread::yield();
+            lk.lock();
+            continue;
+        }
+        cv_.wait(lk);
+    }
+    lk.unlock();
+
+    // 环已销毁：在途请求已全部收割，其余请求同步补读，后续批次将回退到线程池
+    for (const auto& c : b.ready) complete(c.first, c.second);
+    for (size_t i = 0; i < count; ++i) {
+        if (b.finished[i]) continue;
+        DiskIO::ReadRequest& r = reqs[i];
+        r.result = pread_rest(fd, static_cast<uint8_t*>(r.buf), r.size, r.offset);
+        if (r.result < 0) {
+            int e = errno;
+            DiskIO::set_error(errno_text("pread", e).c_str(), e);
+        }
+        b.finished[i] = 1;
+        if (cb) cb(r, user);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+// io_uring_ring.h — 最小 io_uring 读取引擎（Linux，非公开头文件）
+//
+// 直接使用 io_uring_setup/io_uring_enter 系统调用，不依赖 liburing。
+// 只支持本引擎需要的一种操作：对同一 fd 的一批定位读取（IORING_OP_READV）。
+// 内核不支持或被 seccomp 拒绝时 init() 返回 false，调用方应回退到线程池。
+#pragma once
+#include "../include/disk_io.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class IoUringRing {
+public:
+    IoUringRing() = default;
+    ~IoUringRing();
+
+    IoUringRing(const IoUringRing&) = delete;
+    IoUringRing& operator=(const IoUringRing&) = delete;
+
+    // 创建深度为 entries 的环。返回 false 表示 io_uring 不可用。
+    bool init(unsigned entries);
+    bool ready() const { return ring_fd_ >= 0; }
+
+    // 在 fd 上执行一批读取，全部完成后返回。短读会同步补读剩余部分（EOF 时保留短结果），
+    // 失败的请求结果为 -1 并记录调用线程的错误。每个请求完成时在调用线程上调用 cb（可为 NULL）。
+    // 返回 false 表示环不可用（未初始化或此前已失效），请求未被处理；
+    // 运行中出现不可恢复错误时，等在途请求全部完成后销毁环，未完成的请求用 pread
+    // 同步补齐后仍返回 true。
+    //
+    // 多个线程可以在同一个环上并发运行批次，共享最多 entries 个在途请求：
+    // 内部互斥只保护填充提交队列与收割完成队列，等待内核与调用回调都在锁外进行。
+    // 同一时刻只有一个线程（等待者）阻塞在内核中并收割，收割到的其他批次的完成
+    // 转交给其所属线程处理。
+    bool run(int fd, DiskIO::ReadRequest* reqs, size_t count,
+             DiskIO::ReadCallback cb, void* user);
+
+private:
+    struct Batch;
+
+    // 以下函数要求持有 m_
+    void reap_locked();             // 收割完成队列，把结果转交给各批次
+    void drain_and_teardown_locked(std::unique_lock<std::mutex>& lk); // 等在途请求完成后销毁环
+    void teardown();
+
+    std::mutex m_;
+    std::condition_variable cv_;    // 有完成被转交、提交队列腾出空间或等待者让出时通知
+    bool waiter_ = false;           // 是否有线程正在锁外等待内核完成
+    size_t inflight_ = 0;           // 已被内核消费、尚未收割的请求数（全部批次）
+    size_t unsubmitted_ = 0;        // 已放入提交队列、内核尚未消费的条目数
+    int ring_fd_ = -1;
+    unsigned sq_entries_ = 0;
+    // 映射区域
+    void* sq_ptr_ = nullptr;
+    size_t sq_len_ = 0;
+    void* cq_ptr_ = nullptr;
+    size_t cq_len_ = 0;
+    void* sqes_ptr_ = nullptr;
+    size_t sqes_len_ = 0;
+    // 环内字段指针
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    void* cqes_ = nullptr;
+};
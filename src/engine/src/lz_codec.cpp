@@ -0,0 +1,114 @@
+// lz_codec.cpp — 内置 LZ77 块编解码器实现
+#include "lz_codec.h"
+#include <cstring>
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+static const unsigned HASH_BITS = 12;
+
+static inline uint32_t load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+// 写入长度扩展字节；空间不足返回 false
+static bool put_length(uint8_t*& op, uint8_t* end, size_t len) {
+    while (len >= 255) {
+        if (op >= end) return false;
+        *op++ = 255;
+        len -= 255;
+    }
+    if (op >= end) return false;
+    *op++ = static_cast<uint8_t>(len);
+    return true;
+}
+
+// 写入一个序列：literals 之后跟一个匹配（match_len == 0 表示最后一个序列）
+static bool put_sequence(uint8_t*& op, uint8_t* end, const uint8_t* lit, size_t lit_len,
+                         size_t offset, size_t match_len) {
+    if (op >= end) return false;
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15 && !put_length(op, end, lit_len - 15)) return false;
+    if (static_cast<size_t>(end - op) < lit_len) return false;
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len == 0) return true;
+    size_t ml = match_len - MIN_MATCH;
+    *token |= static_cast<uint8_t>(ml >= 15 ? 15 : ml);
+    if (end - op < 2) return false;
+    *op++ = static_cast<uint8_t>(offset & 0xFF);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (ml >= 15 && !put_length(op, end, ml - 15)) return false;
+    return true;
+}
+
+size_t lz_compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+    uint32_t table[1u << HASH_BITS];
+    memset(table, 0xFF, sizeof(table));
+    uint8_t* op = dst;
+    uint8_t* end = dst + cap;
+    size_t ip = 0, anchor = 0;
+    while (ip + MIN_MATCH <= n) {
+        uint32_t seq = load32(src + ip);
+        uint32_t h = hash4(seq);
+        uint32_t ref = table[h];
+        table[h] = static_cast<uint32_t>(ip);
+        if (ref != 0xFFFFFFFFu && ip - ref <= MAX_OFFSET && load32(src + ref) == seq) {
+            size_t len = MIN_MATCH;
+            while (ip + len < n && src[ref + len] == src[ip + len]) ++len;
+            if (!put_sequence(op, end, src + anchor, ip - anchor, ip - ref, len)) return 0;
+            ip += len;
+            anchor = ip;
+        } else {
+            ++ip;
+        }
+    }
+    if (!put_sequence(op, end, src + anchor, n - anchor, 0, 0)) return 0;
+    return static_cast<size_t>(op - dst);
+}
+
+// 读取长度扩展字节；输入截断返回 false
+static bool get_length(const uint8_t*& ip, const uint8_t* end, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip >= end) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lz_decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t out_len) {
+    const uint8_t* ip = src;
+    const uint8_t* end = src + n;
+    size_t op = 0;
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(ip, end, lit)) return false;
+        if (static_cast<size_t>(end - ip) < lit || out_len - op < lit) return false;
+        memcpy(dst + op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == end) break; // 最后一个序列
+        if (end - ip < 2) return false;
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t ml = token & 15;
+        if (ml == 15 && !get_length(ip, end, ml)) return false;
+        ml += MIN_MATCH;
+        if (offset == 0 || offset > op || out_len - op < ml) return false;
+        const uint8_t* from = dst + op - offset;
+        if (offset >= ml) {
+            memcpy(dst + op, from, ml);
+        } else {
+            for (size_t i = 0; i < ml; ++i) dst[op + i] = from[i]; // 重叠复制
+        }
+        op += ml;
+    }
+    return op == out_len;
+}
@@ -0,0 +1,19 @@
+// lz_codec.h — 内置的小型 LZ77 块压缩编解码器（非公开头文件）
+//
+// 面向分块压缩镜像：单个块独立压缩，无外部依赖。格式与 LZ4 块格式相似：
+// 由若干序列组成，每个序列为
+//   token(高 4 位字面量长度, 低 4 位匹配长度-4) [字面量长度扩展] 字面量
+//   [偏移(2 字节小端) [匹配长度扩展]]
+// 长度字段为 15 时后跟扩展字节（逐字节累加，255 表示继续）。最后一个序列只有
+// 字面量。偏移允许小于匹配长度（重叠复制），因此全零等重复数据压缩率很高。
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 压缩 src[0, n) 到 dst（容量 cap）。返回压缩后字节数；输出超过 cap 时返回 0，
+// 调用方应改为原样存储。
+size_t lz_compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap);
+
+// 解压 src[0, n) 到 dst，解压结果必须恰好为 out_len 字节。
+// 输入损坏（越界引用、长度不符）时返回 false，不会越界读写。
+bool lz_decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t out_len);
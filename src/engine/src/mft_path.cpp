@@ -0,0 +1,172 @@
+// mft_path.cpp — 由 parent_reference 重建完整路径
+#include "mft_path.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// parents_ 的哨兵：根目录（无父目录）与父链断开
+static const uint32_t PARENT_ROOT = 0xFFFFFFFFu;
+static const uint32_t PARENT_ORPHAN = 0xFFFFFFFEu;
+// memoize 的父前缀哨兵：row 本身是根目录 / 父目录是孤儿目录
+static const uint32_t PREFIX_ROOT = 0xFFFFFFFFu;
+static const uint32_t PREFIX_ORPHAN = 0xFFFFFFFEu;
+// state_：0 未解析，1 正在解析（位于 resolve_dir 的栈上），2 + MFTPathStatus 已缓存
+static const uint8_t STATE_ACTIVE = 1;
+static const uint8_t STATE_DONE = 2;
+
+MFTPathResolver::MFTPathResolver(const MFTTable& table, char separator)
+    : table_(table), sep_(separator) {
+    const size_t n = table.size();
+    parents_.assign(n, PARENT_ORPHAN);
+    memo_.assign(n, 0);
+    state_.assign(n, 0);
+
+    // 记录号 → 行：记录号密集（fill 按 MFT 顺序追加）时直接建数组，否则排序后二分
+    const std::vector<uint64_t>& ids = table.ids();
+    uint64_t max_id = 0;
+    for (uint64_t id : ids) max_id = std::max(max_id, id);
+    std::vector<uint32_t> direct;
+    std::vector<std::pair<uint64_t,uint32_t>> sorted;
+    const bool dense = max_id <= n * 4 + 1024;
+    if (dense) {
+        direct.assign(static_cast<size_t>(max_id) + 1, PARENT_ORPHAN);
+        for (size_t r = 0; r < n; ++r) direct[static_cast<size_t>(ids[r])] = static_cast<uint32_t>(r);
+    } else {
+        sorted.reserve(n);
+        for (size_t r = 0; r < n; ++r) sorted.emplace_back(ids[r], static_cast<uint32_t>(r));
+        std::sort(sorted.begin(), sorted.end());
+    }
+    auto lookup = [&](uint64_t id) -> uint32_t {
+        if (dense) return id <= max_id ? direct[static_cast<size_t>(id)] : PARENT_ORPHAN;
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(id, 0u));
+        return (it != sorted.end() && it->first == id) ? it->second : PARENT_ORPHAN;
+    };
+
+    for (size_t r = 0; r < n; ++r) {
+        if (ids[r] == NTFS_ROOT_RECORD) {
+            parents_[r] = PARENT_ROOT;
+            continue;
+        }
+        uint64_t ref = table.parent_reference(static_cast<MFTRow>(r));
+        uint32_t p = lookup(ref & FILE_REF_RECORD_MASK);
+        if (p == PARENT_ORPHAN || p == r || !table.is_directory(p)) continue;
+        // 序列号校验：0 表示引用未携带序列号；父目录被删除时其序列号会递增一次，
+        // 已删除文件引用已删除的父目录时允许相差 1
+        uint16_t want = static_cast<uint16_t>(ref >> 48);
+        uint16_t have = table.sequence_number(p);
+        if (want != 0 && want != have && (table.in_use(p) || static_cast<uint16_t>(want + 1) != have)) continue;
+        parents_[r] = p;
+    }
+}
+
+bool MFTPathResolver::parent(MFTRow row, MFTRow& out) const {
+    uint32_t p = parents_[row];
+    if (p == PARENT_ROOT || p == PARENT_ORPHAN) return false;
+    out = p;
+    return true;
+}
+
+uint32_t MFTPathResolver::memoize(MFTRow row, uint32_t parent_prefix, uint8_t status) {
+    uint64_t off = chars_.size();
+    if (parent_prefix != PREFIX_ROOT) {
+        // 父前缀 + 分隔符 + 名称；无名记录以 "#记录号" 代替
+        char fallback[32];
+        std::string_view name = table_.name(row);
+        if (name.empty()) {
+            int len = snprintf(fallback, sizeof(fallback), "#%llu", (unsigned long long)table_.id(row));
+            name = std::string_view(fallback, static_cast<size_t>(len));
+        }
+        if (parent_prefix == PREFIX_ORPHAN) {
+            chars_.push_back(sep_);
+            chars_.insert(chars_.end(), MFT_ORPHAN_DIR, MFT_ORPHAN_DIR + strlen(MFT_ORPHAN_DIR));
+        } else {
+            // 先扩容再按偏移拷贝：父前缀位于同一字符池内
+            const std::pair<uint64_t,uint32_t> pp = prefixes_[parent_prefix];
+            chars_.resize(off + pp.second);
+            memcpy(chars_.data() + off, chars_.data() + pp.first, pp.second);
+        }
+        chars_.push_back(sep_);
+        chars_.insert(chars_.end(), name.begin(), name.end());
+    }
+    prefixes_.emplace_back(off, static_cast<uint32_t>(chars_.size() - off));
+    memo_[row] = static_cast<uint32_t>(prefixes_.size());
+    state_[row] = static_cast<uint8_t>(STATE_DONE + status);
+    return static_cast<uint32_t>(prefixes_.size() - 1);
+}
+
+uint32_t MFTPathResolver::resolve_dir(MFTRow row) {
+    if (memo_[row]) return memo_[row] - 1;
+    // 沿父链向上直到已缓存的目录、根目录、断点或环，再自顶向下逐级缓存
+    stack_.clear();
+    for (MFTRow cur = row; memo_[cur] == 0 && state_[cur] != STATE_ACTIVE;) {
+        state_[cur] = STATE_ACTIVE;
+        stack_.push_back(cur);
+        uint32_t p = parents_[cur];
+        if (p == PARENT_ROOT || p == PARENT_ORPHAN) break;
+        cur = p;
+    }
+    for (size_t i = stack_.size(); i-- > 0;) {
+        MFTRow x = stack_[i];
+        uint32_t p = parents_[x];
+        if (p == PARENT_ROOT) {
+            memoize(x, PREFIX_ROOT, MFT_PATH_OK);
+        } else if (p == PARENT_ORPHAN) {
+            memoize(x, PREFIX_ORPHAN, MFT_PATH_ORPHAN);
+        } else if (memo_[p]) {
+            memoize(x, memo_[p] - 1, static_cast<uint8_t>(state_[p] - STATE_DONE));
+        } else {
+            // 父目录仍在栈上：x 的父链接闭合了一个环，在此断开
+            memoize(x, PREFIX_ORPHAN, MFT_PATH_CYCLE);
+        }
+    }
+    return memo_[row] - 1;
+}
+
+MFTPathStatus MFTPathResolver::path(MFTRow row, std::string& out) {
+    uint32_t p = parents_[row];
+    if (table_.is_directory(row) || p == PARENT_ROOT) {
+        uint32_t idx = resolve_dir(row);
+        std::string_view s = prefix(idx);
+        if (s.empty()) out.assign(1, sep_);
+        else out.assign(s.data(), s.size());
+        return static_cast<MFTPathStatus>(state_[row] - STATE_DONE);
+    }
+    MFTPathStatus st = MFT_PATH_ORPHAN;
+    out.clear();
+    if (p == PARENT_ORPHAN) {
+        out.push_back(sep_);
+        out.append(MFT_ORPHAN_DIR);
+    } else {
+        std::string_view s = prefix(resolve_dir(p));
+        out.assign(s.data(), s.size());
+        st = static_cast<MFTPathStatus>(state_[p] - STATE_DONE);
+    }
+    out.push_back(sep_);
+    std::string_view name = table_.name(row);
+    if (name.empty()) out.append("#" + std::to_string(table_.id(row)));
+    else out.append(name.data(), name.size());
+    return st;
+}
+
+std::string MFTPathResolver::path(MFTRow row) {
+    std::string out;
+    path(row, out);
+    return out;
+}
+
+MFTPathStatus MFTPathResolver::status(MFTRow row) {
+    uint32_t p = parents_[row];
+    if (table_.is_directory(row) || p == PARENT_ROOT) {
+        resolve_dir(row);
+        return static_cast<MFTPathStatus>(state_[row] - STATE_DONE);
+    }
+    if (p == PARENT_ORPHAN) return MFT_PATH_ORPHAN;
+    resolve_dir(p);
+    return static_cast<MFTPathStatus>(state_[p] - STATE_DONE);
+}
+
+size_t MFTPathResolver::memory_bytes() const {
+    return (parents_.capacity() + memo_.capacity()) * sizeof(uint32_t) + state_.capacity() +
+           prefixes_.capacity() * sizeof(std::pair<uint64_t,uint32_t>) + chars_.capacity() +
+           stack_.capacity() * sizeof(MFTRow);
+}
@@ -0,0 +1,492 @@
+// mft_table.cpp — 列式 MFT 记录表实现
+#include "mft_table.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// 名称池初始哈希槽数（2 的幂）；装载因子超过 1/2 时加倍
+static const size_t NAME_POOL_INITIAL_SLOTS = 1024;
+
+// FNV-1a：名称短且多为 ASCII，足够均匀
+static uint64_t hash_name(std::string_view s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (char c : s) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+MFTNamePool::MFTNamePool() {
+    clear();
+}
+
+void MFTNamePool::clear() {
+    bytes_.clear();
+    offsets_.assign(2, 0); // id 0：空名称
+    slots_.assign(NAME_POOL_INITIAL_SLOTS, 0);
+}
+
+void MFTNamePool::reserve(size_t names, size_t bytes) {
+    bytes_.reserve(bytes);
+    offsets_.reserve(names + 2);
+    size_t want = NAME_POOL_INITIAL_SLOTS;
+    while (want < names * 2) want *= 2;
+    if (want > slots_.size()) rehash(want);
+}
+
+void MFTNamePool::rehash(size_t slots) {
+    slots_.assign(slots, 0);
+    const size_t mask = slots - 1;
+    for (uint32_t id = 1; id < count(); ++id) {
+        size_t i = static_cast<size_t>(hash_name(get(id))) & mask;
+        while (slots_[i] != 0) i = (i + 1) & mask;
+        slots_[i] = id;
+    }
+}
+
+uint32_t MFTNamePool::intern(std::string_view name) {
+    if (name.empty()) return 0;
+    const size_t mask = slots_.size() - 1;
+    size_t i = static_cast<size_t>(hash_name(name)) & mask;
+    for (; slots_[i] != 0; i = (i + 1) & mask) {
+        if (get(slots_[i]) == name) return slots_[i];
+    }
+    if (bytes_.size() + name.size() > UINT32_MAX || count() >= UINT32_MAX) return 0;
+
+    uint32_t id = static_cast<uint32_t>(count());
+    bytes_.insert(bytes_.end(), name.begin(), name.end());
+    offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+    slots_[i] = id;
+    if (count() * 2 > slots_.size()) rehash(slots_.size() * 2);
+    return id;
+}
+
+size_t MFTNamePool::memory_bytes() const {
+    return bytes_.capacity() + offsets_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(uint32_t);
+}
+
+void MFTTable::reserve(size_t rows, size_t name_bytes, size_t runs) {
+    ids_.reserve(rows);
+    sizes_.reserve(rows);
+    flags_.reserve(rows);
+    sequences_.reserve(rows);
+    creation_times_.reserve(rows);
+    modified_times_.reserve(rows);
+    parents_.reserve(rows);
+    name_ids_.reserve(rows);
+    lsns_.reserve(rows);
+    hashes_.reserve(rows);
+    run_starts_.reserve(rows + 1);
+    runs_.reserve(runs);
+    names_.reserve(rows, name_bytes);
+}
+
+void MFTTable::clear() {
+    ids_.clear();
+    sizes_.clear();
+    flags_.clear();
+    sequences_.clear();
+    creation_times_.clear();
+    modified_times_.clear();
+    parents_.clear();
+    name_ids_.clear();
+    lsns_.clear();
+    hashes_.clear();
+    run_starts_.assign(1, 0);
+    runs_.clear();
+    names_.clear();
+    stamp_ = MFTTableStamp();
+}
+
+MFTRow MFTTable::push_row(uint64_t id, uint64_t size, uint16_t flags, uint16_t seq, uint64_t ctime,
+                          uint64_t mtime, uint64_t parent, uint32_t name_id, uint64_t lsn, uint64_t hash) {
+    MFTRow row = static_cast<MFTRow>(ids_.size());
+    ids_.push_back(id);
+    sizes_.push_back(size);
+    flags_.push_back(flags);
+    sequences_.push_back(seq);
+    creation_times_.push_back(ctime);
+    modified_times_.push_back(mtime);
+    parents_.push_back(parent);
+    name_ids_.push_back(name_id);
+    lsns_.push_back(lsn);
+    hashes_.push_back(hash);
+    run_starts_.push_back(static_cast<uint32_t>(runs_.size()));
+    return row;
+}
+
+MFTRow MFTTable::append(const NTFSRecordView& view) {
+    char buf[255];
+    uint32_t name_id = names_.intern(view.name(buf, sizeof(buf)));
+    if (view.runs(scratch_)) runs_.insert(runs_.end(), scratch_.begin(), scratch_.end());
+    uint16_t flags = static_cast<uint16_t>((view.flags() & ~MFT_ROW_TORN) | (view.torn() ? MFT_ROW_TORN : 0));
+    return push_row(view.id(), view.data_size(), flags, view.sequence_number(), view.creation_time(),
+                    view.modified_time(), view.parent_reference(), name_id, view.lsn(), view.content_hash());
+}
+
+MFTRow MFTTable::append(const NTFSFileRecord& record) {
+    uint32_t name_id = names_.intern(std::string_view(record.name).substr(0, 255));
+    runs_.insert(runs_.end(), record.data_runs.begin(), record.data_runs.end());
+    uint16_t flags = static_cast<uint16_t>((record.flags & ~MFT_ROW_TORN) | (record.torn ? MFT_ROW_TORN : 0));
+    return push_row(record.id, record.size, flags, record.sequence_number, record.creation_time,
+                    record.modified_time, record.parent_reference, name_id, 0, 0);
+}
+
+MFTRow MFTTable::append(const NTFSRecordView& view, PendingStitch& pending) {
+    MFTRow row = append(view);
+    if (pending.ext.collect(view)) {
+        pending.record_size = view.record_size();
+        pending.rows.push_back(row);
+        pending.records.insert(pending.records.end(), view.data(), view.data() + view.record_size());
+        pending.torn.push_back(view.torn() ? 1 : 0);
+    }
+    return row;
+}
+
+void MFTTable::stitch_rows(NTFSParser& parser, DiskIO& dio, PendingStitch& pending, MFTScanStats* stats) {
+    if (pending.rows.empty()) return;
+    // 个别扩展记录无法读取时 stitch 以稀疏区段占位，不影响其余行
+    pending.ext.fetch(dio, parser, stats);
+
+    // 行按追加顺序登记：从第一个登记的行起重建区段池，之前的部分保持不动
+    const MFTRow first = pending.rows.front();
+    const uint32_t base = run_starts_[first];
+    std::vector<std::pair<uint64_t,int64_t>> tail(runs_.begin() + base, runs_.end());
+    runs_.resize(base);
+    NTFSFileRecord rec;
+    NTFSRecordView view;
+    size_t k = 0;
+    uint32_t old_begin = base;
+    for (MFTRow r = first; r < size(); ++r) {
+        const uint32_t old_end = run_starts_[r + 1];
+        run_starts_[r] = static_cast<uint32_t>(runs_.size());
+        bool stitched = false;
+        if (k < pending.rows.size() && pending.rows[k] == r) {
+            rec.size = sizes_[r];
+            const uint8_t* data = pending.records.data() + k * pending.record_size;
+            if (view.reset(data, pending.record_size, ids_[r], pending.torn[k] != 0) && pending.ext.stitch(view, rec)) {
+                sizes_[r] = rec.size;
+                runs_.insert(runs_.end(), rec.data_runs.begin(), rec.data_runs.end());
+                stitched = true;
+            }
+            ++k;
+        }
+        if (!stitched) runs_.insert(runs_.end(), tail.begin() + (old_begin - base), tail.begin() + (old_end - base));
+        old_begin = old_end;
+    }
+    run_starts_.back() = static_cast<uint32_t>(runs_.size());
+    pending = PendingStitch();
+}
+
+MFTRow MFTTable::copy_row(const MFTTable& src, MFTRow r, bool same_names) {
+    uint32_t name_id = same_names ? src.name_ids_[r] : names_.intern(src.name(r));
+    MFTRunSpan span = src.runs(r);
+    runs_.insert(runs_.end(), span.begin(), span.end());
+    return push_row(src.ids_[r], src.sizes_[r], src.flags_[r], src.sequences_[r], src.creation_times_[r],
+                    src.modified_times_[r], src.parents_[r], name_id, src.lsns_[r], src.hashes_[r]);
+}
+
+bool MFTTable::fill(NTFSParser& parser, DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+                    uint64_t mft_size, MFTScanStats* stats) {
+    // 按 runlist 覆盖的字节数预估记录数（稀疏与空槽位会使预估偏大，但只多占容量）
+    uint64_t bytes = 0;
+    for (const auto& run : mft_runs) bytes += run.first * parser.volume().cluster_size;
+    if (mft_size) bytes = std::min(bytes, mft_size);
+    size_t rows = static_cast<size_t>(bytes / std::max<uint32_t>(1, parser.volume().mft_record_size));
+    // 经验值：平均名称约 16 字节，大多数文件只有一个区段
+    reserve(size() + rows, names_.bytes() + rows * 16, runs_.size() + rows);
+    PendingStitch pending;
+    bool ok = parser.scan_mft_views(dio, mft_runs, mft_size, [this, &pending](const NTFSRecordView& v) {
+        append(v, pending);
+        return true;
+    }, stats);
+    if (ok) {
+        stitch_rows(parser, dio, pending, stats);
+        capture_journal(parser, dio);
+    }
+    return ok;
+}
+
+bool MFTTable::fill(NTFSParser& parser, DiskIO& dio, MFTScanStats* stats) {
+    NTFSFileRecord mft;
+    if (!parser.read_mft_record(dio, parser.volume().mft_offset(), mft) || mft.data_runs.empty()) return false;
+    return fill(parser, dio, mft.data_runs, mft.size, stats);
+}
+
+void MFTTable::capture_journal(NTFSParser& parser, DiskIO& dio) {
+    stamp_ = MFTTableStamp();
+    stamp_.serial_number = parser.volume().serial_number;
+    stamp_.mft_record_size = parser.volume().mft_record_size;
+    for (MFTRow r = 0; r < size(); ++r) {
+        if ((parents_[r] & FILE_REF_RECORD_MASK) != NTFS_EXTEND_RECORD || name(r) != "$UsnJrnl") continue;
+        NTFSUsnJournalState js;
+        if (parser.read_usn_journal_state(dio, ids_[r], js)) {
+            stamp_.journal_record = ids_[r];
+            stamp_.journal_id = js.journal_id;
+            stamp_.next_usn = js.next_usn;
+        }
+        break;
+    }
+}
+
+bool MFTTable::refresh(NTFSParser& parser, DiskIO& dio, MFTRefreshStats* stats) {
+    MFTRefreshStats local;
+    MFTRefreshStats& st = stats ? *stats : local;
+    st = MFTRefreshStats();
+    const NTFSVolume& vol = parser.volume();
+    NTFSFileRecord mft;
+    if (!parser.read_mft_record(dio, vol.mft_offset(), mft) || mft.data_runs.empty()) return false;
+    if (empty() || stamp_.serial_number != vol.serial_number || stamp_.mft_record_size != vol.mft_record_size) {
+        MFTTable old(std::move(*this));
+        clear();
+        st.rebuilt = true;
+        if (!fill(parser, dio, mft.data_runs, mft.size, &st.scan)) {
+            *this = std::move(old);
+            return false;
+        }
+        st.reparsed = size();
+        return true;
+    }
+
+    // 新表沿用原名称池：未变化的行直接复用名称 id，重新解析的行按需追加名称
+    // （不再被引用的旧名称留在池中，直到下一次整表重建）
+    MFTTable old(std::move(*this));
+    clear();
+    names_ = old.names_;
+    reserve(old.size(), 0, old.runs_.size());
+    parser.set_mft_runs(mft.data_runs);
+
+    std::vector<uint64_t> changed;
+    NTFSUsnJournalState js;
+    MFTTable fresh;
+    PendingStitch pending;
+    bool journal = old.stamp_.journal_id != 0 &&
+                   parser.read_usn_changes(dio, old.stamp_.journal_record, old.stamp_.journal_id,
+                                           old.stamp_.next_usn, changed, &js);
+    if (journal) {
+        // 元文件与日志自身的变化不写入日志，总是重新读取
+        for (uint64_t id = 0; id < 16; ++id) changed.push_back(id);
+        changed.push_back(old.stamp_.journal_record);
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        // 有记录无法读取时不能确定其现状，改为整表比较
+        journal = parser.read_mft_records(dio, changed, [&fresh, &pending](const NTFSRecordView& v) {
+            fresh.append(v, pending);
+            return true;
+        });
+    }
+    if (journal) {
+        fresh.stitch_rows(parser, dio, pending, nullptr);
+        // 按记录号归并：重新读取的记录取新行，日志涉及但已无效的记录删除，其余沿用
+        size_t a = 0, b = 0, c = 0;
+        while (a < old.size() || b < fresh.size()) {
+            const uint64_t ida = a < old.size() ? old.ids_[a] : UINT64_MAX;
+            const uint64_t idb = b < fresh.size() ? fresh.ids_[b] : UINT64_MAX;
+            if (idb <= ida) {
+                copy_row(fresh, static_cast<MFTRow>(b++), false);
+                ++st.reparsed;
+                if (idb == ida) ++a;
+                continue;
+            }
+            while (c < changed.size() && changed[c] < ida) ++c;
+            if (c < changed.size() && changed[c] == ida) {
+                ++st.removed;
+            } else {
+                copy_row(old, static_cast<MFTRow>(a), true);
+                ++st.unchanged;
+            }
+            ++a;
+        }
+        st.journal = true;
+        stamp_ = old.stamp_;
+        stamp_.next_usn = js.next_usn;
+        return true;
+    }
+
+    // 整表比较：记录号递增，与原表同步推进游标。LSN 与序列号不同即已变化；
+    // 两者相同时再比较内容哈希（卷在别处被修改且未经日志时 LSN 可能不变）
+    pending = PendingStitch(); // 日志路径中途失败时登记的是 fresh 的行
+    size_t a = 0;
+    bool ok = parser.scan_mft_views(dio, mft.data_runs, mft.size, [&](const NTFSRecordView& v) {
+        while (a < old.size() && old.ids_[a] < v.id()) {
+            ++a;
+            ++st.removed;
+        }
+        if (a < old.size() && old.ids_[a] == v.id()) {
+            if (old.lsns_[a] == v.lsn() && old.sequences_[a] == v.sequence_number() &&
+                old.hashes_[a] == v.content_hash()) {
+                copy_row(old, static_cast<MFTRow>(a++), true);
+                ++st.unchanged;
+                return true;
+            }
+            ++a;
+        }
+        append(v, pending);
+        ++st.reparsed;
+        return true;
+    }, &st.scan);
+    if (!ok) {
+        *this = std::move(old);
+        return false;
+    }
+    st.removed += old.size() - a;
+    stitch_rows(parser, dio, pending, &st.scan);
+    capture_journal(parser, dio);
+    return true;
+}
+
+bool MFTTable::find(uint64_t id, MFTRow& row) const {
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+    if (it == ids_.end() || *it != id) return false;
+    row = static_cast<MFTRow>(it - ids_.begin());
+    return true;
+}
+
+void MFTTable::materialize(MFTRow r, NTFSFileRecord& out) const {
+    out.id = ids_[r];
+    out.name.assign(name(r));
+    out.size = sizes_[r];
+    out.flags = static_cast<uint16_t>(flags_[r] & ~MFT_ROW_TORN);
+    out.link_count = 0;
+    out.sequence_number = sequences_[r];
+    out.creation_time = creation_times_[r];
+    out.modified_time = modified_times_[r];
+    out.parent_reference = parents_[r];
+    out.name_namespace = 0;
+    MFTRunSpan span = runs(r);
+    out.data_runs.assign(span.begin(), span.end());
+    out.run_index.reset();
+    out.torn = torn(r);
+}
+
+void MFTTable::slack_regions(const NTFSVolume& vol, std::vector<std::pair<uint64_t,uint64_t>>& regions) const {
+    const uint64_t cs = vol.cluster_size;
+    if (cs == 0) return;
+    for (MFTRow r = 0; r < size(); ++r) {
+        if (!in_use(r) || is_directory(r)) continue;
+        // 从文件大小所在的位置起，把其后已分配的部分逐区段换算到磁盘
+        uint64_t vcn_begin = 0;
+        const uint64_t eof = sizes_[r];
+        for (const auto& run : runs(r)) {
+            const uint64_t run_begin = vcn_begin * cs;
+            const uint64_t run_end = (vcn_begin + run.first) * cs;
+            vcn_begin += run.first;
+            if (run_end <= eof || run.second < 0) continue;
+            const uint64_t skip = eof > run_begin ? eof - run_begin : 0;
+            regions.emplace_back(vol.lcn_offset(static_cast<uint64_t>(run.second)) + skip, run_end - run_begin - skip);
+        }
+    }
+}
+
+// 保存文件：头部（魔数、版本、stamp、各列长度）之后依次是各列的原始内容
+static const char MFT_TABLE_MAGIC[8] = { 'F', 'R', 'M', 'T', 'A', 'B', 0, 0 };
+static const uint32_t MFT_TABLE_VERSION = 1;
+
+template <class T>
+static bool write_column(FILE* f, const std::vector<T>& v) {
+    return v.empty() || fwrite(v.data(), sizeof(T), v.size(), f) == v.size();
+}
+
+template <class T>
+static bool read_column(FILE* f, std::vector<T>& v, uint64_t n) {
+    // 长度来自文件头：先确认文件中确有这么多字节，避免损坏的头部导致巨量分配
+    long pos = ftell(f);
+    if (pos < 0 || fseek(f, 0, SEEK_END) != 0) return false;
+    long end = ftell(f);
+    if (end < pos || fseek(f, pos, SEEK_SET) != 0) return false;
+    if (n > static_cast<uint64_t>(end - pos) / sizeof(T)) return false;
+    v.resize(static_cast<size_t>(n));
+    return n == 0 || fread(v.data(), sizeof(T), v.size(), f) == v.size();
+}
+
+bool MFTTable::save(const char* path, std::string* err) const {
+    auto set_err = [err](const std::string& m) { if (err) *err = m; };
+    if (!path) { set_err("null path"); return false; }
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        set_err(std::string("create output: ") + strerror(errno));
+        return false;
+    }
+    uint64_t hdr[10] = {
+        0, MFT_TABLE_VERSION, stamp_.serial_number, stamp_.mft_record_size, stamp_.journal_record,
+        stamp_.journal_id, stamp_.next_usn, size(), runs_.size(), names_.count(),
+    };
+    memcpy(hdr, MFT_TABLE_MAGIC, sizeof(MFT_TABLE_MAGIC));
+    bool ok = fwrite(hdr, sizeof(hdr), 1, out) == 1 &&
+              write_column(out, ids_) && write_column(out, sizes_) && write_column(out, flags_) &&
+              write_column(out, sequences_) && write_column(out, creation_times_) &&
+              write_column(out, modified_times_) && write_column(out, parents_) && write_column(out, name_ids_) &&
+              write_column(out, lsns_) && write_column(out, hashes_) && write_column(out, run_starts_) &&
+              write_column(out, runs_) && write_column(out, names_.offsets_) && write_column(out, names_.bytes_);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) {
+        remove(path);
+        set_err("write failed");
+    }
+    return ok;
+}
+
+bool MFTTable::load(const char* path, std::string* err) {
+    auto set_err = [err](const std::string& m) { if (err) *err = m; };
+    if (!path) { set_err("null path"); return false; }
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        set_err(std::string("open: ") + strerror(errno));
+        return false;
+    }
+    MFTTable t;
+    uint64_t hdr[10];
+    bool ok = fread(hdr, sizeof(hdr), 1, in) == 1;
+    if (!ok || memcmp(hdr, MFT_TABLE_MAGIC, sizeof(MFT_TABLE_MAGIC)) != 0 || hdr[1] != MFT_TABLE_VERSION) {
+        fclose(in);
+        set_err("not a table file");
+        return false;
+    }
+    const uint64_t rows = hdr[7], runs = hdr[8], names = hdr[9];
+    ok = rows < UINT32_MAX && names >= 1 && names < UINT32_MAX &&
+         read_column(in, t.ids_, rows) && read_column(in, t.sizes_, rows) && read_column(in, t.flags_, rows) &&
+         read_column(in, t.sequences_, rows) && read_column(in, t.creation_times_, rows) &&
+         read_column(in, t.modified_times_, rows) && read_column(in, t.parents_, rows) &&
+         read_column(in, t.name_ids_, rows) && read_column(in, t.lsns_, rows) && read_column(in, t.hashes_, rows) &&
+         read_column(in, t.run_starts_, rows + 1) && read_column(in, t.runs_, runs) &&
+         read_column(in, t.names_.offsets_, names + 1);
+    ok = ok && t.names_.offsets_.back() <= UINT32_MAX && read_column(in, t.names_.bytes_, t.names_.offsets_.back());
+    fclose(in);
+    if (!ok) {
+        set_err("truncated table file");
+        return false;
+    }
+
+    // 各列之间的引用必须一致，否则单元格访问会越界
+    bool valid = t.run_starts_.front() == 0 && t.run_starts_.back() == runs && t.names_.offsets_[0] == 0 &&
+                 t.names_.offsets_[1] == 0;
+    for (size_t i = 1; valid && i < t.run_starts_.size(); ++i) valid = t.run_starts_[i - 1] <= t.run_starts_[i];
+    for (size_t i = 1; valid && i < t.names_.offsets_.size(); ++i) valid = t.names_.offsets_[i - 1] <= t.names_.offsets_[i];
+    for (size_t i = 0; valid && i < t.name_ids_.size(); ++i) valid = t.name_ids_[i] < names;
+    if (!valid) {
+        set_err("corrupt table file");
+        return false;
+    }
+    size_t slots = NAME_POOL_INITIAL_SLOTS;
+    while (slots < names * 2) slots *= 2;
+    t.names_.rehash(slots);
+    t.stamp_.serial_number = hdr[2];
+    t.stamp_.mft_record_size = static_cast<uint32_t>(hdr[3]);
+    t.stamp_.journal_record = hdr[4];
+    t.stamp_.journal_id = hdr[5];
+    t.stamp_.next_usn = hdr[6];
+    *this = std::move(t);
+    return true;
+}
+
+size_t MFTTable::memory_bytes() const {
+    return ids_.capacity() * sizeof(uint64_t) + sizes_.capacity() * sizeof(uint64_t) +
+           (flags_.capacity() + sequences_.capacity()) * sizeof(uint16_t) +
+           creation_times_.capacity() * sizeof(uint64_t) + modified_times_.capacity() * sizeof(uint64_t) +
+           parents_.capacity() * sizeof(uint64_t) +
+           name_ids_.capacity() * sizeof(uint32_t) + run_starts_.capacity() * sizeof(uint32_t) +
+           (lsns_.capacity() + hashes_.capacity()) * sizeof(uint64_t) +
+           runs_.capacity() * sizeof(std::pair<uint64_t,int64_t>) + names_.memory_bytes();
+}
@@ -1,7 +1,8 @@
 // ntfs_capi.cpp - minimal C API helpers for extracting DATA runlists from an MFT record
 #include "ntfs.h"
 #include "ntfs_mft.h"
-#include <fstream>
+#include "disk_io.h"
+#include <algorithm>
 #include <vector>
 #include <cstdint>
 
@@ -18,37 +19,42 @@ extern "C" {
 int ntfs_extract_data_runs(const char* image_path, uint64_t mft_offset,
                           uint64_t* counts, int64_t* lcns, size_t max_runs) {
     if (!image_path || !counts || !lcns || max_runs == 0) return -1;
-    std::ifstream ifs(image_path, std::ios::binary);
-    if (!ifs) return -1;
-    const size_t MFT_RECORD_SIZE = 1024;
-    std::vector<uint8_t> buf(MFT_RECORD_SIZE);
-    ifs.seekg(mft_offset);
-    if (!ifs.read(reinterpret_cast<char*>(buf.data()), buf.size())) return -1;
+    DiskIO dio;
+    if (!dio.open(image_path)) return -1;
+    // 记录大小取自镜像起始处的引导扇区；不是完整卷镜像（例如单独导出的记录）时使用默认值
+    NTFSParser parser;
+    parser.open_volume(dio, 0);
+    const size_t MFT_RECORD_SIZE = parser.volume().mft_record_size;
+    // 读入可写缓冲区并应用 USA 修正，跨越扇区边界的 runlist 才能正确解码
+    std::vector<uint8_t> storage(MFT_RECORD_SIZE);
+    if (dio.read_at(mft_offset, storage.data(), storage.size()) != static_cast<ssize_t>(MFT_RECORD_SIZE)) return -1;
+    uint8_t fixup = MFT_FIXUP_ABSENT;
+    apply_usa_fixups(storage.data(), 1, MFT_RECORD_SIZE, &fixup);
+    if (fixup == MFT_FIXUP_TORN || fixup == MFT_FIXUP_BAD_USA) return -1;
+    const uint8_t* buf = storage.data();
 
     // Find DATA attribute similarly to NTFSParser::read_mft_record
-    uint16_t attribute_offset = 0;
-    if (buf.size() >= 22) attribute_offset = buf[20] | (buf[21] << 8);
+    uint16_t attribute_offset = buf[20] | (buf[21] << 8);
     if (attribute_offset == 0 || attribute_offset >= MFT_RECORD_SIZE) return -1;
     size_t attr_off = attribute_offset;
-    while (attr_off + 8 < buf.size()) {
+    while (attr_off + 8 < MFT_RECORD_SIZE) {
         uint32_t attr_type = 0;
         // read 4 bytes LE
         for (int i = 0; i < 4; ++i) attr_type |= (uint32_t)buf[attr_off + i] << (8 * i);
         uint32_t attr_len = 0;
         for (int i = 0; i < 4; ++i) attr_len |= (uint32_t)buf[attr_off + 4 + i] << (8 * i);
         if (attr_type == 0xFFFFFFFF) break;
-        if (attr_len == 0) break;
+        if (attr_len < 24 || attr_len > MFT_RECORD_SIZE - attr_off) break; // 属性必须完整落在记录内
         if (attr_type == 0x80) {
             uint8_t non_res = buf[attr_off + 8];
             if (non_res != 0) {
                 uint16_t runlist_offset = buf[attr_off + 32] | (buf[attr_off + 33] << 8);
                 size_t run_pos = attr_off + runlist_offset;
-                if (run_pos < attr_off + attr_len && run_pos < buf.size()) {
-                    size_t avail = attr_off + attr_len - run_pos;
+                if (run_pos < attr_off + attr_len && run_pos < MFT_RECORD_SIZE) {
+                    size_t avail = std::min<size_t>(attr_off + attr_len, MFT_RECORD_SIZE) - run_pos;
                     std::vector<std::pair<uint64_t,int64_t>> runs_parsed;
-                    // reuse decode_data_runs from ntfs_mft.cpp via declaration
-                    if (decode_data_runs(buf.data() + run_pos, avail, runs_parsed)) {
-                        normalize_data_runs(runs_parsed);
+                    // 解码与相邻区段合并在同一遍完成（ntfs_mft.cpp）
+                    if (decode_normalized_runs(buf + run_pos, avail, runs_parsed)) {
                         size_t take = std::min<size_t>(runs_parsed.size(), max_runs);
                         for (size_t i = 0; i < take; ++i) {
                             counts[i] = runs_parsed[i].first;
@@ -0,0 +1,216 @@
+// ntfs_free_space.cpp — $Bitmap 空闲簇区段与只读未分配空间的深度扫描
+//
+// 已删除文件的内容只可能残留在 $Bitmap 标记为空闲的簇中（以及已分配文件末尾的
+// slack）。深度扫描先把 $Bitmap 转换为紧凑的空闲簇区段列表，再只读取这些区段：
+// 繁忙卷上空闲簇往往只占一小部分，扫描时间随空闲空间而不是卷大小增长。
+#include "ntfs_mft.h"
+#include "disk_io.h"
+#include <algorithm>
+#include <cstring>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// load_free_extents 每次读取的 $Bitmap 字节数（8 的倍数：每段从字边界开始）
+static const size_t BITMAP_READ_CHUNK = 1024 * 1024;
+
+// v != 0
+static inline unsigned count_trailing_zeros(uint64_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+uint64_t bitmap_free_extents(const uint8_t* bitmap, size_t bytes, uint64_t first_lcn, uint64_t clusters,
+                             std::vector<std::pair<uint64_t,uint64_t>>& out) {
+    if (!bitmap) return 0;
+    clusters = std::min<uint64_t>(clusters, static_cast<uint64_t>(bytes) * 8);
+    uint64_t total = 0;
+    auto emit = [&](uint64_t begin, uint64_t end) {
+        const uint64_t lcn = first_lcn + begin;
+        total += end - begin;
+        if (!out.empty() && out.back().first + out.back().second == lcn) out.back().second += end - begin;
+        else out.emplace_back(lcn, end - begin);
+    };
+    bool in_run = false;
+    uint64_t run_begin = 0;
+    // 一个字内交替查找下一个 0（区段起点）与下一个 1（区段终点）
+    auto scan_word = [&](uint64_t v, uint64_t base) {
+        unsigned b = 0;
+        while (b < 64) {
+            const uint64_t above = ~0ULL << b;
+            if (in_run) {
+                const uint64_t set = v & above;
+                if (set == 0) return;
+                b = count_trailing_zeros(set);
+                emit(run_begin, base + b);
+                in_run = false;
+            } else {
+                const uint64_t clear = ~v & above;
+                if (clear == 0) return;
+                b = count_trailing_zeros(clear);
+                run_begin = base + b;
+                in_run = true;
+            }
+        }
+    };
+    const uint64_t words = clusters / 64;
+    for (uint64_t w = 0; w < words; ++w) {
+        uint64_t v;
+        memcpy(&v, bitmap + w * 8, 8);
+        // 常见情况：整字已分配且不在区段中，或整字空闲且区段继续
+        if (v == (in_run ? 0 : ~0ULL)) continue;
+        scan_word(v, w * 64);
+    }
+    if (const unsigned tail = static_cast<unsigned>(clusters % 64)) {
+        // 末尾不足一个字：超出 clusters 的位视为已分配
+        uint64_t v = 0;
+        memcpy(&v, bitmap + words * 8, (tail + 7) / 8);
+        scan_word(v | (~0ULL << tail), words * 64);
+    }
+    if (in_run) emit(run_begin, clusters);
+    return total;
+}
+
+bool NTFSParser::load_free_extents(DiskIO& dio, std::vector<std::pair<uint64_t,uint64_t>>& out,
+                                   uint64_t* free_clusters) {
+    out.clear();
+    if (free_clusters) *free_clusters = 0;
+    uint64_t off;
+    NTFSFileRecord bitmap;
+    if (!mft_record_offset(NTFS_BITMAP_RECORD, off) || !read_mft_record(dio, off, bitmap) ||
+        bitmap.data_runs.empty()) {
+        return false;
+    }
+    // 位图按 8 字节向上取整分配，末尾多出的位不对应任何簇
+    uint64_t clusters = bitmap.size * 8;
+    if (volume_.total_clusters() != 0) clusters = std::min(clusters, volume_.total_clusters());
+    std::vector<uint8_t> buf(static_cast<size_t>(std::min<uint64_t>(BITMAP_READ_CHUNK, (clusters + 7) / 8)));
+    uint64_t total = 0;
+    for (uint64_t lcn = 0; lcn < clusters;) {
+        const uint64_t count = std::min<uint64_t>(clusters - lcn, static_cast<uint64_t>(buf.size()) * 8);
+        const size_t n = static_cast<size_t>((count + 7) / 8);
+        if (!read_file_range(dio, bitmap, lcn / 8, n, buf.data(), n)) {
+            out.clear();
+            return false;
+        }
+        total += bitmap_free_extents(buf.data(), n, lcn, count, out);
+        lcn += count;
+    }
+    if (free_clusters) *free_clusters = total;
+    return true;
+}
+
+void NTFSParser::free_space_regions(const std::vector<std::pair<uint64_t,uint64_t>>& free_extents,
+                                    std::vector<std::pair<uint64_t,uint64_t>>& regions) const {
+    regions.reserve(regions.size() + free_extents.size());
+    for (const auto& e : free_extents) {
+        regions.emplace_back(volume_.lcn_offset(e.first), e.second * volume_.cluster_size);
+    }
+}
+
+bool NTFSParser::scan_regions(DiskIO& dio, const std::vector<std::pair<uint64_t,uint64_t>>& regions,
+                              const NTFSRegionCallback& cb, NTFSRegionScanStats* stats, size_t chunk_bytes) {
+    NTFSRegionScanStats local;
+    NTFSRegionScanStats& st = stats ? *stats : local;
+    st = NTFSRegionScanStats();
+    if (!cb) return false;
+    if (chunk_bytes == 0) chunk_bytes = MFT_SCAN_DEFAULT_CHUNK;
+
+    // 合并重叠或相接的区域，再切分为不超过 chunk_bytes 的片段
+    std::vector<std::pair<uint64_t,uint64_t>> merged;
+    merged.reserve(regions.size());
+    for (const auto& r : regions) {
+        if (r.second != 0) merged.push_back(r);
+    }
+    std::sort(merged.begin(), merged.end());
+    size_t m = 0;
+    for (const auto& r : merged) {
+        if (m != 0 && merged[m - 1].first + merged[m - 1].second >= r.first) {
+            merged[m - 1].second = std::max(merged[m - 1].first + merged[m - 1].second, r.first + r.second) -
+                                   merged[m - 1].first;
+        } else {
+            merged[m++] = r;
+        }
+    }
+    merged.resize(m);
+    std::vector<NTFSExtent> extents;
+    for (const auto& r : merged) {
+        for (uint64_t pos = 0; pos < r.second; pos += chunk_bytes) {
+            extents.push_back(NTFSExtent{ r.first + pos, 0, static_cast<size_t>(std::min<uint64_t>(chunk_bytes, r.second - pos)) });
+        }
+    }
+
+    // 相近的片段合并读取：空闲簇常被零散的已分配簇隔开，跨过小间隔比多一次寻道便宜
+    std::vector<NTFSExtentRead> reads;
+    coalesce_extents(extents, read_gap_, chunk_bytes, reads);
+    std::vector<uint8_t> buf;
+    for (const NTFSExtentRead& rd : reads) {
+        buf.resize(rd.size);
+        ssize_t n = dio.read_at(rd.disk_offset, buf.data(), rd.size);
+        if (n < 0) return false;
+        // 镜像在卷末尾被截断时不足部分按 0 处理
+        if (static_cast<size_t>(n) < rd.size) memset(buf.data() + n, 0, rd.size - static_cast<size_t>(n));
+        ++st.reads;
+        st.bytes_read += rd.size;
+        for (size_t i = rd.first; i < rd.first + rd.count; ++i) {
+            const NTFSExtent& e = extents[i];
+            ++st.regions;
+            st.bytes += e.size;
+            if (!cb(e.disk_offset, buf.data() + (e.disk_offset - rd.disk_offset), e.size)) return true;
+        }
+    }
+    return true;
+}
+
+bool NTFSParser::find_orphan_records(DiskIO& dio, const std::vector<std::pair<uint64_t,uint64_t>>& regions,
+                                     const NTFSOrphanCallback& cb, NTFSRegionScanStats* stats, size_t chunk_bytes) {
+    NTFSRegionScanStats local;
+    NTFSRegionScanStats& st = stats ? *stats : local;
+    const uint64_t rs = volume_.mft_record_size;
+    if (!cb || rs == 0) return false;
+
+    // 区域两端收缩到记录边界；片段大小取记录大小的整数倍，记录不会跨越两次回调
+    const uint64_t base = volume_.volume_offset;
+    std::vector<std::pair<uint64_t,uint64_t>> aligned;
+    aligned.reserve(regions.size());
+    for (const auto& r : regions) {
+        const uint64_t end = r.first + r.second;
+        if (end <= base) continue;
+        const uint64_t b = base + (std::max(r.first, base) - base + rs - 1) / rs * rs;
+        const uint64_t e = base + (end - base) / rs * rs;
+        if (b < e) aligned.emplace_back(b, e - b);
+    }
+    if (chunk_bytes == 0) chunk_bytes = MFT_SCAN_DEFAULT_CHUNK;
+    chunk_bytes = static_cast<size_t>(std::max<uint64_t>(rs, chunk_bytes / rs * rs));
+
+    std::vector<uint8_t> rec(static_cast<size_t>(rs));
+    NTFSRecordView view;
+    NTFSFileRecord out;
+    uint64_t found = 0;
+    bool ok = scan_regions(dio, aligned, [&](uint64_t disk_offset, const uint8_t* data, size_t size) {
+        for (size_t pos = 0; pos + rs <= size; pos += static_cast<size_t>(rs)) {
+            if (memcmp(data + pos, "FILE", 4) != 0) continue;
+            // USA 修正需要可写副本；签名命中的位置很少，逐条拷贝即可
+            memcpy(rec.data(), data + pos, rec.size());
+            uint8_t fixup = MFT_FIXUP_ABSENT;
+            apply_usa_fixups(rec.data(), 1, rec.size(), &fixup);
+            // NTFS 3.1 记录头：USA 位于 0x30 及之后时 +44 处为记录号
+            uint16_t usa_off;
+            memcpy(&usa_off, rec.data() + 4, 2);
+            uint32_t id = 0;
+            if (usa_off >= 48) memcpy(&id, rec.data() + 44, 4);
+            if (!view.reset(rec.data(), rec.size(), id, fixup == MFT_FIXUP_TORN || fixup == MFT_FIXUP_BAD_USA)) continue;
+            view.materialize(out);
+            ++found;
+            if (!cb(disk_offset + pos, out)) return false;
+        }
+        return true;
+    }, &st, chunk_bytes);
+    st.records = found;
+    return ok;
+}
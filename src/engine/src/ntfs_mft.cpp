@@ -7,188 +7,302 @@
 #include <algorithm>
 #include <cstdio>
 #include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "ntfs_record.h"
+#include "work_stealing_pool.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FR_NTFS_SSE2 1
+#endif
 
 // 构造/析构：轻量解析器初始化（当前无资源需要释放）
 NTFSParser::NTFSParser() {}
 NTFSParser::~NTFSParser() {}
 
-// 小端安全读取辅助（通过 memcpy 避免未对齐访问）
-static inline uint16_t read_u16_le(const uint8_t* p) {
-    uint16_t v;
-    memcpy(&v, p, sizeof(v));
-    return (uint16_t)v;
-}
-static inline uint32_t read_u32_le(const uint8_t* p) {
-    uint32_t v;
-    memcpy(&v, p, sizeof(v));
-    return (uint32_t)v;
-}
-static inline uint64_t read_u64_le(const uint8_t* p) {
-    uint64_t v;
-    memcpy(&v, p, sizeof(v));
-    return (uint64_t)v;
-}
+// runlist 字段掩码：按头部半字节给出的字节数（0..8）截取 8 字节小端载入的低位
+static const uint64_t RUN_FIELD_MASK[9] = {
+    0ULL, 0xFFULL, 0xFFFFULL, 0xFFFFFFULL, 0xFFFFFFFFULL, 0xFFFFFFFFFFULL,
+    0xFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFULL, ~0ULL,
+};
 
-// Read signed little-endian integer of up to 8 bytes and sign-extend to int64_t
-static inline int64_t read_signed_le(const uint8_t* p, int size) {
-    if (size <= 0) return 0;
-    uint64_t v = 0;
-    for (int i = 0; i < size; ++i) {
-        v |= (static_cast<uint64_t>(p[i]) << (8 * i));
-    }
-    // if highest bit of the most-significant byte is set, sign extend
-    uint64_t sign_bit = 1ULL << ((size * 8) - 1);
-    if (v & sign_bit) {
-        // sign extend to 64 bits
-        uint64_t mask = (~0ULL) << (size * 8);
-        v |= mask;
+// 读取 size 字节的小端无符号字段（size <= 8，avail 为缓冲区中剩余的字节数）。
+// 剩余不少于 8 字节时做一次未对齐 8 字节载入再按表掩码，只有 runlist 末尾才逐字节拷贝
+static inline uint64_t read_run_field(const uint8_t* p, size_t avail, int size) {
+    uint64_t v;
+    if (avail >= 8) {
+        memcpy(&v, p, 8);
+        return v & RUN_FIELD_MASK[size];
     }
-    return static_cast<int64_t>(v);
+    v = 0;
+    for (int i = 0; i < size; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
 }
 
-// Decode NTFS data runs.
-// Input: pointer to runlist data and its max length (not necessarily null-terminated).
-// Output: vector of pairs <cluster_count, lcn> where lcn == -1 means sparse run.
-bool decode_data_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out) {
+// Decode NTFS data runs into any container with clear()/push_back(pair)/data()/size().
+// Output: pairs <cluster_count, lcn> where lcn == -1 means sparse run.
+// Merge 为 true 时在解码的同一遍中合并相邻区段（LCN 连续且均非稀疏），结果与
+// 先解码再 merge_adjacent_runs 相同。out 只 clear 不释放，可跨调用复用容量。
+template <bool Merge, class Out>
+static bool decode_runs_into(const uint8_t* runs, size_t len, Out& out) {
     out.clear();
     size_t pos = 0;
     int64_t prev_lcn = 0;
     while (pos < len) {
-        uint8_t header = runs[pos];
-        pos++;
+        const uint8_t header = runs[pos++];
         if (header == 0) break; // terminator
-        int len_size = header & 0x0F;
-        int off_size = (header >> 4) & 0x0F;
-        if (len_size == 0) return false; // invalid
+        const int len_size = header & 0x0F;
+        const int off_size = header >> 4;
+        // 长度与偏移字段最多 8 字节（超出的字段无法表示为 64 位值）
+        if (len_size == 0 || len_size > 8 || off_size > 8) return false; // invalid
         if (pos + len_size + off_size > len) return false; // bounds
 
-        // read cluster count (unsigned little-endian)
-        uint64_t cluster_count = 0;
-        for (int i = 0; i < len_size; ++i) {
-            cluster_count |= (static_cast<uint64_t>(runs[pos + i]) << (8 * i));
-        }
+        const uint64_t cluster_count = read_run_field(runs + pos, len - pos, len_size);
         pos += len_size;
 
-        int64_t lcn = -1;
-        if (off_size == 0) {
-            // sparse run
-            lcn = -1;
-        } else {
-            int64_t delta = read_signed_le(runs + pos, off_size);
-            lcn = prev_lcn + delta;
+        int64_t lcn = -1; // off_size == 0: sparse run
+        if (off_size != 0) {
+            // 左移到最高字节后算术右移完成符号扩展
+            const int shift = 64 - 8 * off_size;
+            const uint64_t raw = read_run_field(runs + pos, len - pos, off_size);
+            lcn = prev_lcn + (static_cast<int64_t>(raw << shift) >> shift);
             prev_lcn = lcn;
+            pos += off_size;
         }
-        pos += off_size;
 
-        out.emplace_back(cluster_count, lcn);
+        if (Merge && out.size() != 0) {
+            std::pair<uint64_t,int64_t>& last = out.data()[out.size() - 1];
+            if (lcn != -1 && last.second != -1 && last.second + static_cast<int64_t>(last.first) == lcn) {
+                last.first += cluster_count;
+                continue;
+            }
+        }
+        out.push_back(std::make_pair(cluster_count, lcn));
     }
     return true;
 }
 
+// Decode NTFS data runs.
+// Input: pointer to runlist data and its max length (not necessarily null-terminated).
+bool decode_data_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out) {
+    return decode_runs_into<false>(runs, len, out);
+}
+
+bool decode_normalized_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out) {
+    if (decode_runs_into<true>(runs, len, out)) return true;
+    out.clear(); // 解码失败时不保留不完整的 runlist
+    return false;
+}
+
+bool decode_normalized_runs(const uint8_t* runs, size_t len, NTFSRunList& out) {
+    if (decode_runs_into<true>(runs, len, out)) return true;
+    out.clear();
+    return false;
+}
+
+// 原地合并相邻区段（LCN 连续且均非稀疏），返回合并后的区段数
+static size_t merge_adjacent_runs(std::pair<uint64_t,int64_t>* runs, size_t n) {
+    if (n < 2) return n;
+    size_t w = 0;
+    for (size_t i = 1; i < n; ++i) {
+        std::pair<uint64_t,int64_t>& cur = runs[w];
+        const std::pair<uint64_t,int64_t>& next = runs[i];
+        if (cur.second != -1 && next.second != -1 &&
+            cur.second + static_cast<int64_t>(cur.first) == next.second) {
+            cur.first += next.first;
+            continue;
+        }
+        runs[++w] = next;
+    }
+    return w + 1;
+}
+
 // Normalize data runs: merge adjacent runs when possible (contiguous LCNs
 // and non-sparse). This reduces fragmentation in the internal representation.
 void normalize_data_runs(std::vector<std::pair<uint64_t,int64_t>>& runs) {
-    if (runs.size() < 2) return;
-    std::vector<std::pair<uint64_t,int64_t>> out;
-    out.reserve(runs.size());
-    auto cur = runs[0];
-    for (size_t i = 1; i < runs.size(); ++i) {
-        auto next = runs[i];
-        if (cur.second != -1 && next.second != -1) {
-            // if LCNs are contiguous
-            if (cur.second + static_cast<int64_t>(cur.first) == next.second) {
-                cur.first += next.first;
-                continue;
-            }
-        }
-        // cannot merge (including sparse), push current
-        out.push_back(cur);
-        cur = next;
+    runs.resize(merge_adjacent_runs(runs.data(), runs.size()));
+}
+
+void NTFSRunList::push_back(const Run& run) {
+    if (size_ < NTFS_INLINE_RUNS) {
+        inline_[size_++] = run;
+        return;
     }
-    out.push_back(cur);
-    runs.swap(out);
+    if (size_ == NTFS_INLINE_RUNS) heap_.assign(inline_, inline_ + NTFS_INLINE_RUNS);
+    heap_.push_back(run);
+    ++size_;
 }
 
-// Parse an ATTRIBUTE_LIST resident content for referenced MFT record offsets.
-// This is a tolerant parser: it reads entries as (type, length, ... , file_reference)
-// and collects non-zero file_reference values. It's robust to varying entry
-// lengths by reading a 16-bit length first and falling back to 32-bit length.
-static void parse_attribute_list_refs(const uint8_t* data, size_t size, std::vector<uint64_t>& out_refs) {
-    out_refs.clear();
-    size_t pos = 0;
-    while (pos + 24 <= size) {
-        uint32_t atype = read_u32_le(data + pos);
-        if (atype == 0) break;
-        uint16_t len16 = read_u16_le(data + pos + 4);
-        uint32_t len32 = read_u32_le(data + pos + 4);
-        size_t entry_len = (len16 >= 24) ? static_cast<size_t>(len16) : static_cast<size_t>(len32);
-        if (entry_len < 24 || pos + entry_len > size) break;
-        // file reference usually at offset 16 inside the entry
-        uint64_t file_ref = read_u64_le(data + pos + 16);
-        if (file_ref != 0) out_refs.push_back(file_ref);
-        pos += entry_len;
+void NTFSRunList::truncate(size_t n) {
+    if (n >= size_) return;
+    if (size_ > NTFS_INLINE_RUNS && n <= NTFS_INLINE_RUNS) std::copy(heap_.begin(), heap_.begin() + n, inline_);
+    if (n > NTFS_INLINE_RUNS) heap_.resize(n);
+    else heap_.clear();
+    size_ = n;
+}
+
+// USA 修正的扇区跨度：与设备扇区大小无关，NTFS 固定按 512 字节分段
+static const size_t USA_STRIDE = 512;
+// 单批收集的扇区末尾字数量上限（64 KiB 记录为 128 个扇区，至少容纳一条记录）
+static const size_t FIXUP_BATCH_WORDS = 1024;
+
+// 比较 n 个 16 位字，不相等的位置在 bits 中置 1（bits 至少 (n + 63) / 64 个元素）
+static void mismatch_bits(const uint16_t* a, const uint16_t* b, size_t n, uint64_t* bits) {
+    memset(bits, 0, ((n + 63) / 64) * sizeof(uint64_t));
+    size_t j = 0;
+#ifdef FR_NTFS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; j + 8 <= n; j += 8) {
+        __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + j)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j)));
+        // 16 位比较结果压缩为 8 个字节，每个字一位
+        unsigned ne = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(eq, zero))) & 0xFFu;
+        bits[j / 64] |= static_cast<uint64_t>(ne) << (j % 64);
+    }
+#endif
+    for (; j < n; ++j) {
+        if (a[j] != b[j]) bits[j / 64] |= 1ULL << (j % 64);
     }
 }
 
-// Convert UTF-16LE bytes to UTF-8 string. Handles surrogate pairs and
-// replaces invalid sequences with Unicode replacement char (U+FFFD).
-static std::string utf16le_to_utf8(const uint8_t* data, size_t bytes) {
-    std::string out;
-    size_t pos = 0;
-    auto append_utf8 = [&](uint32_t cp){
-        if (cp <= 0x7F) {
-            out.push_back(static_cast<char>(cp));
-        } else if (cp <= 0x7FF) {
-            out.push_back(static_cast<char>(0xC0 | ((cp >> 6) & 0x1F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-        } else if (cp <= 0xFFFF) {
-            out.push_back(static_cast<char>(0xE0 | ((cp >> 12) & 0x0F)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-        } else {
-            out.push_back(static_cast<char>(0xF0 | ((cp >> 18) & 0x07)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+// [start, start + n) 范围内是否有置位
+static bool any_bit(const uint64_t* bits, size_t start, size_t n) {
+    for (size_t k = start; k < start + n; ++k) {
+        if (bits[k / 64] & (1ULL << (k % 64))) return true;
+    }
+    return false;
+}
+
+size_t apply_usa_fixups(uint8_t* buf, size_t count, size_t record_size, uint8_t* status) {
+    const size_t sectors = record_size / USA_STRIDE;
+    if (!buf || sectors == 0 || record_size % USA_STRIDE != 0 || sectors > FIXUP_BATCH_WORDS) {
+        if (status) memset(status, MFT_FIXUP_ABSENT, count);
+        return 0;
+    }
+    size_t failed = 0;
+    uint16_t got[FIXUP_BATCH_WORDS];
+    uint16_t want[FIXUP_BATCH_WORDS];
+    uint64_t bits[FIXUP_BATCH_WORDS / 64];
+    uint16_t starts[FIXUP_BATCH_WORDS]; // 批内各记录（仅 OK 者）首个扇区末尾字的下标
+    uint8_t st[FIXUP_BATCH_WORDS];
+
+    size_t i = 0;
+    while (i < count) {
+        // 收集：校验头部，把扇区末尾字与期望的序列号排成连续数组
+        const size_t first = i;
+        size_t n = 0;
+        for (; i < count && i - first < FIXUP_BATCH_WORDS && n + sectors <= FIXUP_BATCH_WORDS; ++i) {
+            const uint8_t* rec = buf + i * record_size;
+            size_t k = i - first;
+            uint16_t usa_off = read_u16_le(rec + 4);
+            uint16_t usa_cnt = read_u16_le(rec + 6);
+            if (memcmp(rec, "FILE", 4) != 0 || usa_cnt == 0) {
+                st[k] = MFT_FIXUP_ABSENT;
+                continue;
+            }
+            // USA 必须位于首个扇区的末尾字之前，且每个扇区各有一项
+            if (usa_cnt != sectors + 1 || (usa_off & 1) != 0 ||
+                usa_off + 2 * static_cast<size_t>(usa_cnt) > USA_STRIDE - 2) {
+                st[k] = MFT_FIXUP_BAD_USA;
+                continue;
+            }
+            st[k] = MFT_FIXUP_OK;
+            starts[k] = static_cast<uint16_t>(n);
+            uint16_t usn = read_u16_le(rec + usa_off);
+            for (size_t s = 0; s < sectors; ++s) {
+                got[n + s] = read_u16_le(rec + s * USA_STRIDE + USA_STRIDE - 2);
+                want[n + s] = usn;
+            }
+            n += sectors;
         }
-    };
 
-    while (pos + 1 < bytes) {
-        uint16_t w1 = read_u16_le(data + pos);
-        pos += 2;
-        if (w1 >= 0xD800 && w1 <= 0xDBFF) {
-            // high surrogate, need low surrogate
-            if (pos + 1 < bytes) {
-                uint16_t w2 = read_u16_le(data + pos);
-                pos += 2;
-                if (w2 >= 0xDC00 && w2 <= 0xDFFF) {
-                    uint32_t cp = 0x10000 + (((uint32_t)w1 - 0xD800) << 10) + ((uint32_t)w2 - 0xDC00);
-                    append_utf8(cp);
-                    continue;
+        // 比较：整批一次完成
+        mismatch_bits(got, want, n, bits);
+
+        // 应用：只修改校验通过的记录
+        for (size_t k = 0; k < i - first; ++k) {
+            if (st[k] == MFT_FIXUP_OK) {
+                if (any_bit(bits, starts[k], sectors)) {
+                    st[k] = MFT_FIXUP_TORN;
+                } else {
+                    uint8_t* rec = buf + (first + k) * record_size;
+                    const uint8_t* usa = rec + read_u16_le(rec + 4);
+                    for (size_t s = 0; s < sectors; ++s) {
+                        memcpy(rec + s * USA_STRIDE + USA_STRIDE - 2, usa + 2 * (s + 1), 2);
+                    }
                 }
-                // invalid low surrogate — emit replacement char and continue
-                append_utf8(0xFFFD);
-                continue;
-            } else {
-                // truncated surrogate
-                append_utf8(0xFFFD);
-                break;
             }
-        } else if (w1 >= 0xDC00 && w1 <= 0xDFFF) {
-            // unexpected low surrogate
-            append_utf8(0xFFFD);
-            continue;
-        } else {
-            append_utf8(w1);
-            continue;
+            if (st[k] == MFT_FIXUP_TORN || st[k] == MFT_FIXUP_BAD_USA) ++failed;
         }
+        if (status) memcpy(status + first, st, i - first);
+    }
+    return failed;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// 64 位终混（murmur3 fmix64）
+static inline uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t mft_record_hash(const uint8_t* data, size_t size) {
+    const uint64_t M = 0x9FB21C651E98DF25ULL;
+    // 四条相互独立的依赖链：乘法延迟互相重叠，而不是每个字串行等待
+    uint64_t a = 0x9E3779B97F4A7C15ULL, b = 0xC2B2AE3D27D4EB4FULL;
+    uint64_t c = 0x165667B19E3779F9ULL, d = 0x27D4EB2F165667C5ULL;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        uint64_t w[4];
+        memcpy(w, data + i, 32);
+        a = (a ^ w[0]) * M; a ^= a >> 29;
+        b = (b ^ w[1]) * M; b ^= b >> 29;
+        c = (c ^ w[2]) * M; c ^= c >> 29;
+        d = (d ^ w[3]) * M; d ^= d >> 29;
+    }
+    uint64_t h = fmix64(a) ^ rotl64(fmix64(b), 16) ^ rotl64(fmix64(c), 32) ^ rotl64(fmix64(d), 48) ^ size;
+    for (; i < size; i += 8) {
+        uint64_t w = 0;
+        memcpy(&w, data + i, std::min<size_t>(8, size - i));
+        h = fmix64(h ^ w);
     }
-    return out;
+    return fmix64(h);
 }
 
+// 遍历 ATTRIBUTE_LIST 中未命名 DATA 属性（0x80）的条目，对每个片段调用
+// fn(start_vcn, file_reference)。条目布局：type(4) length(2) name_length(1) name_offset(1)
+// starting_vcn(8) file_reference(8) attribute_id(2) name...
+template <class Fn>
+static void for_each_data_entry(const uint8_t* list, size_t size, Fn fn) {
+    size_t pos = 0;
+    while (pos + 24 <= size) {
+        uint32_t atype = read_u32_le(list + pos);
+        size_t entry_len = read_u16_le(list + pos + 4);
+        if (atype == 0 || atype == 0xFFFFFFFF) break;
+        if (entry_len < 24 || pos + entry_len > size) break;
+        if (atype == 0x80 && list[pos + 6] == 0) fn(read_u64_le(list + pos + 8), read_u64_le(list + pos + 16));
+        pos += entry_len;
+    }
+}
+
+// 解析 MFT 记录头（NTFSParser 与 NTFSRecordView 共用）
+static bool parse_mft_header(const uint8_t* data, size_t size, MFTHeader& header);
+
 // 解析 MFT record header（使用安全读取）。
 // 返回: true if header is valid and parsed
 bool NTFSParser::parse_header(const uint8_t* data, size_t size, MFTHeader& header) {
+    return parse_mft_header(data, size, header);
+}
+
+static bool parse_mft_header(const uint8_t* data, size_t size, MFTHeader& header) {
     const size_t MIN_HEADER_SIZE = 42; // next_attr_id at offset 40 + 2
     if (!data || size < MIN_HEADER_SIZE) return false;
 
@@ -220,16 +334,124 @@ bool NTFSParser::parse_header(const uint8_t* data, size_t size, MFTHeader& heade
     return true;
 }
 
+// v 是否为 [lo, hi] 内的 2 的幂
+static bool valid_pow2(uint64_t v, uint64_t lo, uint64_t hi) {
+    return v >= lo && v <= hi && (v & (v - 1)) == 0;
+}
+
+// 引导扇区中“每记录簇数”字段换算为字节数；无效时返回 0
+static uint64_t boot_record_size(int8_t v, uint64_t cluster_size) {
+    if (v > 0) return static_cast<uint64_t>(v) * cluster_size;
+    if (v < 0 && v >= -31) return 1ULL << (-v);
+    return 0;
+}
+
+// 解析 NTFS 引导扇区。字段布局（偏移均相对扇区起点）:
+//   0x03 OEM 标识 "NTFS    "       0x0B 每扇区字节数 (u16)
+//   0x0D 每簇扇区数 (u8，>= 0xF0 时表示 2^(256-v))
+//   0x28 总扇区数 (u64)             0x30 $MFT 簇号 (u64)        0x38 $MFTMirr 簇号 (u64)
+//   0x40 每 MFT 记录簇数 (s8)       0x44 每索引记录簇数 (s8)    0x48 卷序列号 (u64)
+//   0x1FE 结束标记 0x55 0xAA
+// 每记录簇数为负值 v 时记录大小为 2^(-v) 字节（簇大于记录时的常见编码）。
+bool parse_ntfs_boot_sector(const uint8_t* data, size_t size, NTFSVolume& out) {
+    if (!data || size < 512) return false;
+    if (memcmp(data + 3, "NTFS    ", 8) != 0) return false;
+    if (data[510] != 0x55 || data[511] != 0xAA) return false;
+
+    uint32_t bps = read_u16_le(data + 0x0B);
+    if (!valid_pow2(bps, 256, 4096)) return false;
+    uint8_t spc = data[0x0D];
+    uint64_t sectors_per_cluster = (spc >= 0xF0) ? (1ULL << (256 - spc)) : spc;
+    uint64_t cluster_size = sectors_per_cluster * bps;
+    if (!valid_pow2(cluster_size, bps, 2 * 1024 * 1024)) return false;
+    uint64_t record_size = boot_record_size(static_cast<int8_t>(data[0x40]), cluster_size);
+    uint64_t index_size = boot_record_size(static_cast<int8_t>(data[0x44]), cluster_size);
+    if (!valid_pow2(record_size, 256, 65536)) return false;
+    if (!valid_pow2(index_size, 256, 2 * 1024 * 1024)) return false;
+
+    uint64_t total_sectors = read_u64_le(data + 0x28);
+    uint64_t mft_lcn = read_u64_le(data + 0x30);
+    uint64_t mftmirr_lcn = read_u64_le(data + 0x38);
+    uint64_t total_clusters = total_sectors * bps / cluster_size;
+    if (total_sectors == 0 || mft_lcn >= total_clusters || mftmirr_lcn >= total_clusters) return false;
+
+    out.bytes_per_sector = bps;
+    out.cluster_size = static_cast<uint32_t>(cluster_size);
+    out.mft_record_size = static_cast<uint32_t>(record_size);
+    out.index_record_size = static_cast<uint32_t>(index_size);
+    out.total_sectors = total_sectors;
+    out.mft_lcn = mft_lcn;
+    out.mftmirr_lcn = mftmirr_lcn;
+    out.serial_number = read_u64_le(data + 0x48);
+    return true;
+}
+
+bool NTFSParser::open_volume(DiskIO& dio, uint64_t volume_offset) {
+    // 引导扇区的字段都在前 512 字节内（4K-native 卷的结束标记同样位于 0x1FE）
+    uint8_t boot[512];
+    if (dio.read_at(volume_offset, boot, sizeof(boot)) != static_cast<ssize_t>(sizeof(boot))) return false;
+    NTFSVolume vol;
+    vol.volume_offset = volume_offset;
+    if (!parse_ntfs_boot_sector(boot, sizeof(boot), vol)) return false;
+    volume_ = vol;
+    return true;
+}
+
+NTFSRunIndex::NTFSRunIndex(const std::vector<std::pair<uint64_t,int64_t>>& runs) {
+    starts_.resize(runs.size() + 1);
+    uint64_t vcn = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        starts_[i] = vcn;
+        vcn += runs[i].first;
+    }
+    starts_[runs.size()] = vcn;
+    if (!runs.empty()) {
+        first_ = runs.front();
+        last_ = runs.back();
+    }
+}
+
+size_t NTFSRunIndex::find(uint64_t vcn) const {
+    // 最后一个起点 <= vcn 的区段；长度为 0 的区段与下一区段起点相同，upper_bound 会越过它
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), vcn);
+    if (it == starts_.end()) return size();
+    return static_cast<size_t>(it - starts_.begin()) - 1;
+}
+
+bool NTFSRunIndex::matches(const std::vector<std::pair<uint64_t,int64_t>>& runs) const {
+    if (runs.size() != size()) return false;
+    return runs.empty() || (runs.front() == first_ && runs.back() == last_);
+}
+
+// 定位 file_offset 所在的区段：返回区段下标，cursor 为该区段起点的文件字节偏移。
+// 长 runlist 使用记录上缓存的前缀和索引（必要时建立），短 runlist 从头开始即可
+static size_t seek_run(const NTFSFileRecord& rec, uint64_t file_offset, uint64_t cluster_size, uint64_t& cursor) {
+    cursor = 0;
+    if (rec.data_runs.size() < NTFS_RUN_INDEX_MIN_RUNS || cluster_size == 0) return 0;
+    std::shared_ptr<const NTFSRunIndex> index = std::atomic_load(&rec.run_index);
+    if (!index || !index->matches(rec.data_runs)) {
+        index = std::make_shared<const NTFSRunIndex>(rec.data_runs);
+        std::atomic_store(&rec.run_index, index);
+    }
+    size_t run = index->find(file_offset / cluster_size);
+    if (run >= index->size()) return rec.data_runs.size();
+    cursor = index->start_vcn(run) * cluster_size;
+    return run;
+}
+
 // Map a file byte range into absolute disk offsets using data_runs.
-bool NTFSParser::map_file_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
-                                uint64_t cluster_size, std::vector<std::pair<uint64_t,size_t>>& out) {
+// base: 卷起始偏移，LCN 换算为 base + lcn * cluster_size
+static bool map_runs_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
+                           uint64_t cluster_size, uint64_t base,
+                           std::vector<std::pair<uint64_t,size_t>>& out) {
     out.clear();
     if (len == 0) return true;
     if (cluster_size == 0) return false;
 
     // Iterate runs and compute file-space spans
     uint64_t file_cursor = 0; // byte offset within file as we scan runs
-    for (const auto &run : rec.data_runs) {
+    for (size_t i = seek_run(rec, file_offset, cluster_size, file_cursor); i < rec.data_runs.size(); ++i) {
+        const auto &run = rec.data_runs[i];
         uint64_t cluster_count = run.first;
         int64_t lcn = run.second; // -1 => sparse
         uint64_t run_bytes = cluster_count * cluster_size;
@@ -251,8 +473,8 @@ bool NTFSParser::map_file_range(const NTFSFileRecord& rec, uint64_t file_offset,
         uint64_t take = (remaining <= avail) ? remaining : avail;
 
         if (lcn != -1) {
-            // absolute disk offset: lcn * cluster_size + start_in_run
-            uint64_t disk_off = static_cast<uint64_t>(lcn) * cluster_size + start_in_run;
+            // absolute disk offset: base + lcn * cluster_size + start_in_run
+            uint64_t disk_off = base + static_cast<uint64_t>(lcn) * cluster_size + start_in_run;
             out.emplace_back(disk_off, static_cast<size_t>(take));
         } else {
             // sparse region - not a disk mapping; we skip adding disk offsets
@@ -269,18 +491,61 @@ bool NTFSParser::map_file_range(const NTFSFileRecord& rec, uint64_t file_offset,
     return (len == 0);
 }
 
-bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
-                                 uint64_t file_offset, size_t len,
-                                 void* out_buf, size_t out_buf_size, uint64_t cluster_size) {
-    if (!out_buf) return false;
-    if (out_buf_size < len) return false;
-    uint8_t* dest = reinterpret_cast<uint8_t*>(out_buf);
+bool NTFSParser::map_file_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
+                                std::vector<std::pair<uint64_t,size_t>>& out) {
+    return map_runs_range(rec, file_offset, len, volume_.cluster_size, volume_.volume_offset, out);
+}
 
-    uint64_t file_cursor = 0; // byte offset within file as we scan runs
-    size_t remaining = len;
-    uint64_t write_pos = 0; // within dest
+bool NTFSParser::map_file_range(const NTFSFileRecord& rec, uint64_t file_offset, size_t len,
+                                uint64_t cluster_size, std::vector<std::pair<uint64_t,size_t>>& out) {
+    return map_runs_range(rec, file_offset, len, cluster_size, 0, out);
+}
+
+size_t coalesce_extents(std::vector<NTFSExtent>& extents, uint64_t max_gap, size_t max_read,
+                        std::vector<NTFSExtentRead>& reads) {
+    reads.clear();
+    if (extents.empty()) return 0;
+    std::sort(extents.begin(), extents.end(), [](const NTFSExtent& a, const NTFSExtent& b) {
+        return a.disk_offset < b.disk_offset;
+    });
+    NTFSExtentRead cur{ extents[0].disk_offset, extents[0].size, 0, 1 };
+    for (size_t i = 1; i < extents.size(); ++i) {
+        const NTFSExtent& e = extents[i];
+        const uint64_t cur_end = cur.disk_offset + cur.size;
+        const uint64_t e_end = e.disk_offset + e.size;
+        // 间隔足够小且合并后不超过上限时并入当前读取（重叠的区间同样并入）
+        if (e.disk_offset <= cur_end + max_gap && std::max(cur_end, e_end) - cur.disk_offset <= max_read) {
+            cur.size = static_cast<size_t>(std::max(cur_end, e_end) - cur.disk_offset);
+            ++cur.count;
+            continue;
+        }
+        reads.push_back(cur);
+        cur = NTFSExtentRead{ e.disk_offset, e.size, i, 1 };
+    }
+    reads.push_back(cur);
+    return reads.size();
+}
+
+// 合并读取中的区间是否在磁盘与目标缓冲区中都首尾相接（此时可直接读入目标缓冲区）
+static bool extents_contiguous(const NTFSExtent* e, size_t count) {
+    for (size_t i = 1; i < count; ++i) {
+        if (e[i].disk_offset != e[i - 1].disk_offset + e[i - 1].size ||
+            e[i].dest_offset != e[i - 1].dest_offset + e[i - 1].size) return false;
+    }
+    return true;
+}
 
-    for (const auto &run : rec.data_runs) {
+// 把 runs 中文件范围 [file_offset, file_offset+len) 映射为磁盘区间追加到 extents
+// （目标位置从 dest_base 起），稀疏部分直接在 dest 中填 0。first / file_cursor 为起始
+// 区段及其文件偏移（见 seek_run）。返回映射覆盖的字节数，不足 len 时其余部分超出 runlist
+static uint64_t map_read_extents(const std::vector<std::pair<uint64_t,int64_t>>& runs, size_t first,
+                                 uint64_t file_cursor, uint64_t file_offset, size_t len,
+                                 uint64_t cluster_size, uint64_t base, uint8_t* dest, uint64_t dest_base,
+                                 std::vector<NTFSExtent>& extents) {
+    size_t remaining = len;
+    uint64_t write_pos = dest_base;
+    for (size_t i = first; i < runs.size(); ++i) {
+        const auto &run = runs[i];
         if (remaining == 0) break;
         uint64_t cluster_count = run.first;
         int64_t lcn = run.second;
@@ -301,9 +566,8 @@ bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
             // sparse: fill zeros
             memset(dest + write_pos, 0, static_cast<size_t>(take));
         } else {
-            uint64_t disk_off = static_cast<uint64_t>(lcn) * cluster_size + start_in_run;
-            ssize_t got = dio.read_at(disk_off, dest + write_pos, static_cast<size_t>(take));
-            if (got < 0 || static_cast<uint64_t>(got) != take) return false;
+            extents.push_back(NTFSExtent{ base + static_cast<uint64_t>(lcn) * cluster_size + start_in_run,
+                                          write_pos, static_cast<size_t>(take) });
         }
 
         remaining -= take;
@@ -311,15 +575,93 @@ bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
         file_offset += take;
         file_cursor += run_bytes;
     }
+    return len - remaining;
+}
 
-    // If after scanning runs still remaining > 0, treat as zeros or EOF
-    if (remaining > 0) {
-        // If file size smaller than requested, zero-fill remainder
-        memset(dest + write_pos, 0, remaining);
-        remaining = 0;
+// 排序合并 extents 后以 read_batch 并发读取并分发到 dest。区间在磁盘与目标中都连续的
+// 读取直接写入 dest；其余（跨越间隔或目标顺序与磁盘顺序不同）读入暂存区，完成后分发。
+// failed 非空时收集读取失败或短读的区间（其余区间照常分发）
+static bool read_extents(DiskIO& dio, std::vector<NTFSExtent>& extents, uint8_t* dest,
+                         uint64_t max_gap, size_t max_read, std::vector<NTFSExtent>* failed = nullptr) {
+    std::vector<NTFSExtentRead> plan;
+    coalesce_extents(extents, max_gap, max_read, plan);
+    std::vector<DiskIO::ReadRequest> reqs(plan.size());
+    std::vector<size_t> staged(plan.size(), SIZE_MAX);
+    size_t staging_bytes = 0;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        if (extents_contiguous(&extents[plan[i].first], plan[i].count)) continue;
+        staged[i] = staging_bytes;
+        staging_bytes += plan[i].size;
+    }
+    std::vector<uint8_t> staging(staging_bytes);
+    for (size_t i = 0; i < plan.size(); ++i) {
+        reqs[i].offset = plan[i].disk_offset;
+        reqs[i].buf = staged[i] == SIZE_MAX ? dest + extents[plan[i].first].dest_offset : staging.data() + staged[i];
+        reqs[i].size = plan[i].size;
     }
 
-    return true;
+    bool ok = dio.read_batch(reqs.data(), reqs.size());
+    for (size_t i = 0; i < plan.size(); ++i) {
+        if (reqs[i].result < 0 || static_cast<size_t>(reqs[i].result) != reqs[i].size) {
+            ok = false;
+            if (!failed) return false;
+            failed->insert(failed->end(), extents.begin() + plan[i].first,
+                           extents.begin() + plan[i].first + plan[i].count);
+            continue;
+        }
+        if (staged[i] == SIZE_MAX) continue;
+        const uint8_t* src = staging.data() + staged[i];
+        for (size_t k = plan[i].first; k < plan[i].first + plan[i].count; ++k) {
+            const NTFSExtent& e = extents[k];
+            memcpy(dest + e.dest_offset, src + (e.disk_offset - plan[i].disk_offset), e.size);
+        }
+    }
+    return ok;
+}
+
+static bool read_runs_range(DiskIO& dio, const NTFSFileRecord& rec,
+                            uint64_t file_offset, size_t len,
+                            void* out_buf, size_t out_buf_size, uint64_t cluster_size, uint64_t base,
+                            uint64_t max_gap, size_t max_read) {
+    if (!out_buf) return false;
+    if (out_buf_size < len) return false;
+    uint8_t* dest = reinterpret_cast<uint8_t*>(out_buf);
+
+    // 先收集所有非稀疏区段映射出的磁盘区间，再排序合并后一次性批量提交
+    std::vector<NTFSExtent> extents;
+    uint64_t file_cursor = 0;
+    size_t first = len != 0 ? seek_run(rec, file_offset, cluster_size, file_cursor) : rec.data_runs.size();
+    uint64_t mapped = map_read_extents(rec.data_runs, first, file_cursor, file_offset, len, cluster_size, base,
+                                       dest, 0, extents);
+    // If file size smaller than requested, zero-fill remainder
+    if (mapped < len) memset(dest + mapped, 0, static_cast<size_t>(len - mapped));
+    return read_extents(dio, extents, dest, max_gap, max_read);
+}
+
+bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
+                                 uint64_t file_offset, size_t len,
+                                 void* out_buf, size_t out_buf_size) {
+    return read_runs_range(dio, rec, file_offset, len, out_buf, out_buf_size,
+                           volume_.cluster_size, volume_.volume_offset, read_gap_, read_max_);
+}
+
+bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
+                                 uint64_t file_offset, size_t len,
+                                 void* out_buf, size_t out_buf_size, uint64_t cluster_size) {
+    return read_runs_range(dio, rec, file_offset, len, out_buf, out_buf_size, cluster_size, 0,
+                           read_gap_, read_max_);
+}
+
+bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
+                                 uint64_t file_offset, size_t len,
+                                 std::vector<uint8_t>& out) {
+    out.clear();
+    try {
+        out.resize(len);
+    } catch (...) {
+        return false;
+    }
+    return read_file_range(dio, rec, file_offset, len, out.data(), out.size());
 }
 
 bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
@@ -334,12 +676,435 @@ bool NTFSParser::read_file_range(DiskIO& dio, const NTFSFileRecord& rec,
     return read_file_range(dio, rec, file_offset, len, out.data(), out.size(), cluster_size);
 }
 
-// 这是一个最小实现：读取一个 MFT 记录（1024 字节），验证前 4 字节是否为 'FILE'
-// 如果匹配则填充返回的 NTFSFileRecord（用于单元测试与后续迭代）。
+// 绑定视图并定位属性：只读取各属性头的类型与长度（以及常驻内容的位置校验），
+// 不解码任何内容，因此不发起 I/O 也不分配内存。
+bool NTFSRecordView::reset(const uint8_t* data, size_t size, uint64_t id, bool torn) {
+    *this = NTFSRecordView();
+    MFTHeader header;
+    if (!parse_mft_header(data, size, header)) return false;
+    data_ = data;
+    size_ = size;
+    id_ = id;
+    lsn_ = header.lsn;
+    base_record_ = header.base_record;
+    flags_ = header.flags;
+    link_count_ = header.link_count;
+    sequence_ = header.sequence_number;
+    torn_ = torn;
+
+    for_each_attribute(data, size, header.attribute_offset, [&](size_t attr_off, uint32_t attr_type, uint32_t attr_len) {
+        uint8_t non_resident = data[attr_off + 8];
+
+        if (non_resident == 0 && (attr_type == 0x10 || attr_type == 0x20 || attr_type == 0x30)) {
+            uint32_t content_size = read_u32_le(data + attr_off + 16);
+            uint16_t content_offset = read_u16_le(data + attr_off + 20);
+            size_t content_pos = attr_off + content_offset;
+            // STANDARD_INFORMATION: creation (0), modified (8)
+            if (attr_type == 0x10 && content_pos + 16 <= size && content_size >= 16) {
+                si_pos_ = static_cast<uint32_t>(content_pos);
+            }
+            // ATTRIBUTE_LIST (0x20) - resident attribute list
+            if (attr_type == 0x20 && content_pos + 8 <= size && content_size >= 8) {
+                attr_list_pos_ = static_cast<uint32_t>(content_pos);
+                attr_list_len_ = static_cast<uint32_t>(std::min<size_t>(content_size, size - content_pos));
+            }
+            // FILE_NAME content layout (resident):
+            // 0: parent reference (8)
+            // 8: creation_time (8)
+            // 16: modified_time (8)
+            // 24: mft_changed_time (8)
+            // 32: access_time (8)
+            // 40: allocated_size (8)
+            // 48: real_size (8)
+            // 56: flags (4)
+            // 60: reparse (4)
+            // 64: name_length (1)
+            // 65: name_namespace (1)
+            // 66: filename (UTF-16LE)
+            if (attr_type == 0x30 && content_pos + 66 <= size && content_size >= 66 &&
+                content_pos + 66 + static_cast<size_t>(data[content_pos + 64]) * 2 <= size) {
+                name_pos_ = static_cast<uint32_t>(content_pos);
+            }
+        }
+        // 非常驻 ATTRIBUTE_LIST：内容在记录之外，由 attribute_list_runs 描述
+        if (attr_type == 0x20 && non_resident != 0 && attr_len >= 64) attr_list_attr_ = static_cast<uint32_t>(attr_off);
+        // 未命名的 DATA 属性（0x80，name_length (+9) == 0）；命名流（如 Zone.Identifier）不是文件内容
+        if (attr_type == 0x80 && data[attr_off + 9] == 0 && (non_resident == 0 || attr_len >= 64)) {
+            data_attr_ = static_cast<uint32_t>(attr_off);
+        }
+        return true;
+    });
+    return true;
+}
+
+uint64_t NTFSRecordView::creation_time() const {
+    return si_pos_ ? read_u64_le(data_ + si_pos_) : 0;
+}
+
+uint64_t NTFSRecordView::modified_time() const {
+    return si_pos_ ? read_u64_le(data_ + si_pos_ + 8) : 0;
+}
+
+uint64_t NTFSRecordView::parent_reference() const {
+    return name_pos_ ? read_u64_le(data_ + name_pos_) : 0;
+}
+
+uint8_t NTFSRecordView::name_namespace() const {
+    return name_pos_ ? data_[name_pos_ + 65] : 0;
+}
+
+size_t NTFSRecordView::name_length() const {
+    return name_pos_ ? data_[name_pos_ + 64] : 0;
+}
+
+const uint8_t* NTFSRecordView::name_utf16le() const {
+    return name_pos_ ? data_ + name_pos_ + 66 : nullptr;
+}
+
+std::string_view NTFSRecordView::name(char* buf, size_t cap) const {
+    if (!name_pos_ || !buf) return std::string_view();
+    return std::string_view(buf, utf16le_to_utf8(name_utf16le(), name_length() * 2, buf, cap));
+}
+
+bool NTFSRecordView::has_runlist() const {
+    return data_attr_ != 0 && data_[data_attr_ + 8] != 0;
+}
+
+uint64_t NTFSRecordView::data_size() const {
+    if (!data_attr_) return 0;
+    if (data_[data_attr_ + 8] == 0) {
+        // resident DATA — content offset at +20, size at +16
+        uint32_t content_size = read_u32_le(data_ + data_attr_ + 16);
+        size_t content_pos = data_attr_ + read_u16_le(data_ + data_attr_ + 20);
+        return content_pos + content_size <= size_ ? content_size : 0;
+    }
+    // non-resident DATA: real size at +48
+    return data_attr_ + 48 + 8 <= size_ ? read_u64_le(data_ + data_attr_ + 48) : 0;
+}
+
+// 非常驻 DATA 的 runlist 字节范围（runlist offset at +32），不存在时返回 false
+static bool view_runlist(const uint8_t* data, size_t data_attr, const uint8_t*& runs, size_t& len) {
+    uint32_t attr_len = read_u32_le(data + data_attr + 4);
+    if (attr_len < 64) return false; // 非常驻属性头（至 +56 的 initialized size）不完整
+    size_t runlist_pos = data_attr + read_u16_le(data + data_attr + 32);
+    if (runlist_pos >= data_attr + attr_len) return false;
+    runs = data + runlist_pos;
+    len = data_attr + attr_len - runlist_pos;
+    return true;
+}
+
+bool NTFSRecordView::runs(NTFSRunList& out) const {
+    out.clear();
+    const uint8_t* rl;
+    size_t len;
+    if (!has_runlist() || !view_runlist(data_, data_attr_, rl, len)) return false;
+    return decode_normalized_runs(rl, len, out);
+}
+
+const uint8_t* NTFSRecordView::attribute_list(size_t& size) const {
+    size = attr_list_len_;
+    return attr_list_pos_ ? data_ + attr_list_pos_ : nullptr;
+}
+
+bool NTFSRecordView::attribute_list_runs(std::vector<std::pair<uint64_t,int64_t>>& runs, uint64_t& size) const {
+    runs.clear();
+    size = 0;
+    const uint8_t* rl;
+    size_t len;
+    if (!attr_list_attr_ || !view_runlist(data_, attr_list_attr_, rl, len)) return false;
+    if (!decode_normalized_runs(rl, len, runs)) return false;
+    size = read_u64_le(data_ + attr_list_attr_ + 48); // real size
+    return true;
+}
+
+uint64_t NTFSRecordView::content_hash() const {
+    // 实际长度（+24）之后的部分是上次写入残留的内容，不参与比较
+    size_t used = static_cast<size_t>(read_u32_le(data_ + 24));
+    return mft_record_hash(data_, used != 0 && used <= size_ ? used : size_);
+}
+
+uint64_t NTFSRecordView::data_start_vcn() const {
+    // non-resident: lowest VCN at +16
+    return has_runlist() ? read_u64_le(data_ + data_attr_ + 16) : 0;
+}
+
+void NTFSRecordView::materialize(NTFSFileRecord& out) const {
+    out.id = id_;
+    out.flags = flags_;
+    out.link_count = link_count_;
+    out.sequence_number = sequence_;
+    out.torn = torn_;
+    out.creation_time = creation_time();
+    out.modified_time = modified_time();
+    out.parent_reference = parent_reference();
+    out.name_namespace = name_namespace();
+    // Truncate to 255 bytes to avoid unbounded growth in this struct
+    char name_buf[255];
+    out.name.assign(name(name_buf, sizeof(name_buf)));
+    out.size = data_size();
+    // Store absolute LCNs in out.data_runs (sparse runs keep lcn == -1)
+    out.data_runs.clear();
+    out.run_index.reset(); // 复用的记录对象不保留上一条记录的区段索引
+    const uint8_t* rl;
+    size_t len;
+    if (has_runlist() && view_runlist(data_, data_attr_, rl, len)) {
+        decode_normalized_runs(rl, len, out.data_runs);
+    }
+}
+
+// USA 校验失败的记录以 torn 标记交付
+static bool fixup_failed(uint8_t fixup) {
+    return fixup == MFT_FIXUP_TORN || fixup == MFT_FIXUP_BAD_USA;
+}
+
+bool NTFSParser::mft_record_offset(uint64_t record_no, uint64_t& offset) const {
+    const uint64_t record_size = volume_.mft_record_size;
+    const uint64_t pos = record_no * record_size;
+    if (mft_runs_.empty()) {
+        offset = volume_.mft_offset() + pos;
+        return true;
+    }
+    uint64_t cursor = 0;
+    for (const auto& run : mft_runs_) {
+        const uint64_t run_bytes = run.first * volume_.cluster_size;
+        if (pos < cursor + run_bytes) {
+            // 稀疏区段中的记录不存在；跨越碎片边界的记录无法以一次读取取回
+            if (run.second < 0 || pos + record_size > cursor + run_bytes) return false;
+            offset = volume_.lcn_offset(static_cast<uint64_t>(run.second)) + (pos - cursor);
+            return true;
+        }
+        cursor += run_bytes;
+    }
+    return false;
+}
+
+// 在记录中查找起始 VCN 为 vcn 的未命名非常驻 DATA 片段，返回属性头偏移（0 表示不存在）
+static size_t find_data_segment(const uint8_t* rec, size_t size, uint64_t vcn) {
+    MFTHeader header;
+    if (!parse_mft_header(rec, size, header)) return 0;
+    return for_each_attribute(rec, size, header.attribute_offset, [&](size_t attr_off, uint32_t attr_type, uint32_t attr_len) {
+        // non-resident (+8), name_length (+9) == 0, lowest VCN (+16)
+        return !(attr_type == 0x80 && rec[attr_off + 8] != 0 && rec[attr_off + 9] == 0 && attr_len >= 64 &&
+                 read_u64_le(rec + attr_off + 16) == vcn);
+    });
+}
+
+bool MFTExtensionBatch::collect(const NTFSRecordView& base) {
+    size_t list_len = 0;
+    const uint8_t* list = base.attribute_list(list_len);
+    if (list) {
+        // 基本记录自身的片段不需要读取。has_runlist / data_start_vcn 只反映未命名 DATA，
+        // 与 for_each_data_entry 的过滤一致：基本记录中 VCN 0 的命名流不会顶替扩展记录中的片段
+        const bool own = base.has_runlist();
+        const uint64_t own_vcn = base.data_start_vcn();
+        bool foreign = false;
+        for_each_data_entry(list, list_len, [&](uint64_t vcn, uint64_t ref) {
+            if (own && vcn == own_vcn) return;
+            refs_.push_back(ref & FILE_REF_RECORD_MASK);
+            foreign = true;
+        });
+        return foreign;
+    }
+    List l;
+    if (!base.attribute_list_runs(l.runs, l.size) || l.size == 0) return false;
+    l.base_id = base.id();
+    l.offset = 0;
+    lists_.push_back(std::move(l));
+    return true;
+}
+
+bool MFTExtensionBatch::fetch(DiskIO& dio, const NTFSParser& parser, MFTScanStats* stats) {
+    const NTFSVolume& vol = parser.volume();
+    record_size_ = vol.mft_record_size;
+    bool ok = true;
+    std::vector<NTFSExtent> extents;
+    std::vector<NTFSExtent> failed;
+
+    // 第一阶段：非常驻 ATTRIBUTE_LIST 的内容（全部列表的区间一起合并读取）
+    if (!lists_.empty()) {
+        std::sort(lists_.begin(), lists_.end(), [](const List& a, const List& b) { return a.base_id < b.base_id; });
+        size_t total = 0;
+        for (List& l : lists_) {
+            l.offset = total;
+            total += static_cast<size_t>(l.size);
+        }
+        list_bytes_.assign(total, 0);
+        for (const List& l : lists_) {
+            map_read_extents(l.runs, 0, 0, 0, static_cast<size_t>(l.size), vol.cluster_size, vol.volume_offset,
+                             list_bytes_.data(), l.offset, extents);
+        }
+        // 读取失败的部分保持为 0，解析列表时在该处结束
+        if (!read_extents(dio, extents, list_bytes_.data(), parser.read_gap(), parser.read_max(), &failed)) {
+            ok = false;
+            for (const NTFSExtent& e : failed) memset(list_bytes_.data() + e.dest_offset, 0, e.size);
+        }
+        for (const List& l : lists_) {
+            for_each_data_entry(list_bytes_.data() + l.offset, static_cast<size_t>(l.size), [&](uint64_t, uint64_t ref) {
+                if ((ref & FILE_REF_RECORD_MASK) != l.base_id) refs_.push_back(ref & FILE_REF_RECORD_MASK);
+            });
+        }
+    }
+
+    // 第二阶段：扩展记录。去重后按记录号换算磁盘偏移，合并读取（read_extents 内部按偏移排序）
+    std::sort(refs_.begin(), refs_.end());
+    refs_.erase(std::unique(refs_.begin(), refs_.end()), refs_.end());
+    if (refs_.empty()) return ok;
+    records_.assign(refs_.size() * record_size_, 0);
+    valid_.assign(refs_.size(), 0);
+    extents.clear();
+    failed.clear();
+    for (size_t i = 0; i < refs_.size(); ++i) {
+        uint64_t off;
+        if (!parser.mft_record_offset(refs_[i], off)) {
+            ok = false;
+            continue;
+        }
+        valid_[i] = 1;
+        extents.push_back(NTFSExtent{ off, i * record_size_, record_size_ });
+    }
+    if (!read_extents(dio, extents, records_.data(), parser.read_gap(), parser.read_max(), &failed)) {
+        ok = false;
+        for (const NTFSExtent& e : failed) valid_[e.dest_offset / record_size_] = 0;
+    }
+    std::vector<uint8_t> fixups(refs_.size());
+    apply_usa_fixups(records_.data(), refs_.size(), record_size_, fixups.data());
+    for (size_t i = 0; i < refs_.size(); ++i) {
+        // 扇区写入中断的扩展记录中 runlist 不可信，按缺失处理
+        if (fixup_failed(fixups[i])) valid_[i] = 0;
+        if (!valid_[i]) ok = false;
+    }
+    if (stats) stats->extensions += refs_.size();
+    return ok;
+}
+
+const uint8_t* MFTExtensionBatch::find_list(uint64_t base_id, size_t& size) const {
+    auto it = std::lower_bound(lists_.begin(), lists_.end(), base_id,
+                               [](const List& l, uint64_t id) { return l.base_id < id; });
+    if (it == lists_.end() || it->base_id != base_id || list_bytes_.empty()) return nullptr;
+    size = static_cast<size_t>(it->size);
+    return list_bytes_.data() + it->offset;
+}
+
+const uint8_t* MFTExtensionBatch::find_record(uint64_t record_no) const {
+    auto it = std::lower_bound(refs_.begin(), refs_.end(), record_no);
+    if (it == refs_.end() || *it != record_no) return nullptr;
+    size_t i = static_cast<size_t>(it - refs_.begin());
+    return i < valid_.size() && valid_[i] ? records_.data() + i * record_size_ : nullptr;
+}
+
+bool MFTExtensionBatch::stitch(const NTFSRecordView& base, NTFSFileRecord& out) const {
+    size_t list_len = 0;
+    const uint8_t* list = base.attribute_list(list_len);
+    if (!list) list = find_list(base.id(), list_len);
+    if (!list) return false;
+
+    // 各片段：<起始 VCN, 在 runs 中的 [begin, end)>
+    struct Segment {
+        uint64_t vcn;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Segment> segs;
+    std::vector<std::pair<uint64_t,int64_t>> runs;
+    std::vector<std::pair<uint64_t,int64_t>> piece;
+    // 基本记录自身的未命名 DATA 片段（命名流不参与拼接）
+    const bool own = base.has_runlist();
+    if (own) {
+        NTFSRunList own_runs;
+        base.runs(own_runs);
+        runs.assign(own_runs.begin(), own_runs.end());
+        segs.push_back(Segment{ base.data_start_vcn(), 0, runs.size() });
+    }
+    bool foreign = false;
+    for_each_data_entry(list, list_len, [&](uint64_t vcn, uint64_t ref) {
+        for (const Segment& sg : segs) {
+            if (sg.vcn == vcn) return;
+        }
+        foreign = true;
+        const uint8_t* rec = find_record(ref & FILE_REF_RECORD_MASK);
+        size_t attr = rec ? find_data_segment(rec, record_size_, vcn) : 0;
+        const uint8_t* rl;
+        size_t len;
+        if (!attr || !view_runlist(rec, attr, rl, len) || !decode_data_runs(rl, len, piece)) return;
+        if (vcn == 0) out.size = read_u64_le(rec + attr + 48); // 首个片段记录实际大小
+        segs.push_back(Segment{ vcn, runs.size(), runs.size() + piece.size() });
+        runs.insert(runs.end(), piece.begin(), piece.end());
+    });
+    if (!foreign) return false;
+
+    // 按 VCN 顺序衔接；缺失的片段以稀疏区段占位，重叠（损坏）的片段被丢弃
+    std::sort(segs.begin(), segs.end(), [](const Segment& a, const Segment& b) { return a.vcn < b.vcn; });
+    out.data_runs.clear();
+    out.run_index.reset();
+    uint64_t cursor = 0;
+    for (const Segment& sg : segs) {
+        if (sg.vcn < cursor) continue;
+        if (sg.vcn > cursor) out.data_runs.emplace_back(sg.vcn - cursor, -1);
+        cursor = sg.vcn;
+        for (size_t i = sg.begin; i < sg.end; ++i) {
+            out.data_runs.push_back(runs[i]);
+            cursor += runs[i].first;
+        }
+    }
+    normalize_data_runs(out.data_runs);
+    return true;
+}
+
+bool NTFSParser::read_mft_records(DiskIO& dio, const std::vector<uint64_t>& record_nos,
+                                  const MFTRecordViewCallback& cb) {
+    const size_t record_size = volume_.mft_record_size;
+    if (!cb || record_size == 0) return false;
+    std::vector<uint64_t> ids(record_nos);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (ids.empty()) return true;
+
+    bool ok = true;
+    std::vector<uint8_t> records(ids.size() * record_size, 0);
+    std::vector<uint8_t> valid(ids.size(), 0);
+    std::vector<NTFSExtent> extents;
+    std::vector<NTFSExtent> failed;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        uint64_t off;
+        if (!mft_record_offset(ids[i], off)) {
+            ok = false;
+            continue;
+        }
+        valid[i] = 1;
+        extents.push_back(NTFSExtent{ off, i * record_size, record_size });
+    }
+    if (!read_extents(dio, extents, records.data(), read_gap_, read_max_, &failed)) {
+        ok = false;
+        for (const NTFSExtent& e : failed) valid[e.dest_offset / record_size] = 0;
+    }
+    std::vector<uint8_t> fixups(ids.size());
+    apply_usa_fixups(records.data(), ids.size(), record_size, fixups.data());
+    NTFSRecordView view;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (!valid[i] || !view.reset(records.data() + i * record_size, record_size, ids[i], fixup_failed(fixups[i]))) {
+            continue;
+        }
+        if (!cb(view)) return false;
+    }
+    return ok;
+}
+
+void MFTExtensionBatch::clear() {
+    refs_.clear();
+    lists_.clear();
+    list_bytes_.clear();
+    records_.clear();
+    valid_.clear();
+}
+
+// 这是一个最小实现：读取一个 MFT 记录（大小取自卷几何，默认 1024 字节），验证前 4 字节
+// 是否为 'FILE'，如果匹配则填充返回的 NTFSFileRecord（用于单元测试与后续迭代）。
 bool NTFSParser::read_mft_record(DiskIO& dio, uint64_t offset, NTFSFileRecord& out) {
-    const size_t MFT_RECORD_SIZE = 1024;
-    std::vector<uint8_t> buf(MFT_RECORD_SIZE);
-    ssize_t n = dio.read_at(offset, buf.data(), buf.size());
+    const size_t MFT_RECORD_SIZE = volume_.mft_record_size;
+    // USA 修正需要可写副本：读入本地缓冲区（不足部分为 0；映射模式下 read_at 直接从映射区拷贝）
+    std::vector<uint8_t> storage(MFT_RECORD_SIZE);
+    uint8_t* buf = storage.data();
+    ssize_t n = dio.read_at(offset, buf, storage.size());
     if (n <= 0) return false;
 
     // 需要至少能读取到签名
@@ -352,209 +1117,465 @@ bool NTFSParser::read_mft_record(DiskIO& dio, uint64_t offset, NTFSFileRecord& o
 
     // Parse header
     MFTHeader header;
-    if (!parse_header(buf.data(), n, header)) return false;
-
-    // 最小可用字段填充：id、name 与 size（后续可以从记录内部解析真实值）
-    out.id = offset ? static_cast<uint64_t>(offset / MFT_RECORD_SIZE) : 1;
-    out.flags = header.flags;
-    out.link_count = header.link_count;
-    out.name = "PARSED_FILE.TXT";
-    out.creation_time = 0;
-    out.modified_time = 0;
-    // 此实现将 size 设为读取到的数据乘以 2，作为示例
-    out.size = static_cast<uint64_t>(n) * 2;
-
-    // 尝试解析属性：扫描 STANDARD_INFORMATION (0x10) 与 FILE_NAME (0x30)
-    if (header.attribute_offset > 0 && header.attribute_offset < (int)MFT_RECORD_SIZE) {
-        size_t attr_off = header.attribute_offset;
-        while (attr_off + 8 < buf.size()) {
-            uint32_t attr_type = read_u32_le(buf.data() + attr_off);
-            uint32_t attr_len = read_u32_le(buf.data() + attr_off + 4);
-            if (attr_type == 0xFFFFFFFF) break; // end marker
-            if (attr_len == 0) break;
-
-            // STANDARD_INFORMATION
-            if (attr_type == 0x10 && attr_len > 0) {
-                uint8_t non_resident = buf[attr_off + 8];
-                if (non_resident == 0) {
-                    uint32_t content_size = read_u32_le(buf.data() + attr_off + 16);
-                    uint16_t content_offset = read_u16_le(buf.data() + attr_off + 20);
-                    size_t content_pos = attr_off + content_offset;
-                    if (content_pos + 16 <= buf.size() && content_size >= 16) {
-                        out.creation_time = read_u64_le(buf.data() + content_pos);
-                        out.modified_time = read_u64_le(buf.data() + content_pos + 8);
-                    }
-                }
-            }
+    if (!parse_header(buf, n, header)) return false;
 
-            // ATTRIBUTE_LIST (0x20) - resident attribute list; parse proper entries
-            if (attr_type == 0x20 && attr_len > 0) {
-                uint8_t non_resident = buf[attr_off + 8];
-                if (non_resident == 0) {
-                    uint32_t content_size = read_u32_le(buf.data() + attr_off + 16);
-                    uint16_t content_offset = read_u16_le(buf.data() + attr_off + 20);
-                    size_t content_pos = attr_off + content_offset;
-                    if (content_pos + 8 <= buf.size() && content_size >= 8) {
-                        std::vector<uint64_t> refs;
-                        parse_attribute_list_refs(buf.data() + content_pos, content_size, refs);
-                        for (uint64_t ref_off : refs) {
-                            if (ref_off == 0) continue;
-                            std::vector<uint8_t> refbuf(MFT_RECORD_SIZE);
-                            ssize_t rn = dio.read_at(ref_off, refbuf.data(), refbuf.size());
-                            if (rn <= 0) continue;
-                            if (rn >= 4 && refbuf[0] == 'F' && refbuf[1] == 'I' && refbuf[2] == 'L' && refbuf[3] == 'E') {
-                                size_t ra = read_u16_le(refbuf.data() + 20);
-                                if (ra > 0 && ra < refbuf.size()) {
-                                    while (ra + 8 < refbuf.size()) {
-                                        uint32_t at = read_u32_le(refbuf.data() + ra);
-                                        uint32_t al = read_u32_le(refbuf.data() + ra + 4);
-                                        if (at == 0xFFFFFFFF) break;
-                                        if (al == 0) break;
-                                        if (at == 0x80) {
-                                            uint8_t nr = refbuf[ra + 8];
-                                            if (nr != 0) {
-                                                uint16_t runoff = read_u16_le(refbuf.data() + ra + 32);
-                                                size_t rpos = ra + runoff;
-                                                if (rpos < ra + al && rpos < refbuf.size()) {
-                                                    size_t avail = ra + al - rpos;
-                                                    std::vector<std::pair<uint64_t,int64_t>> runs_parsed;
-                                                    if (decode_data_runs(refbuf.data() + rpos, avail, runs_parsed)) {
-                                                        out.data_runs.clear();
-                                                        for (auto &pr : runs_parsed) out.data_runs.emplace_back(pr.first, pr.second);
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        ra += al;
-                                    }
-                                }
-                            }
-                        }
-                    }
+    uint8_t fixup = MFT_FIXUP_ABSENT;
+    apply_usa_fixups(buf, 1, MFT_RECORD_SIZE, &fixup);
+
+    NTFSRecordView view;
+    if (!view.reset(buf, MFT_RECORD_SIZE, offset ? static_cast<uint64_t>(offset / MFT_RECORD_SIZE) : 1,
+                    fixup_failed(fixup))) {
+        return false;
+    }
+    view.materialize(out);
+    // 最小实现的占位值：记录没有 FILE_NAME / DATA 属性时沿用示例名称与大小
+    if (!view.has_name()) out.name = "PARSED_FILE.TXT";
+    if (!view.has_data()) out.size = static_cast<uint64_t>(n) * 2;
+
+    // ATTRIBUTE_LIST：DATA runlist 分布在扩展记录中时，一次批量读取全部扩展记录后按 VCN 拼接
+    MFTExtensionBatch ext;
+    if (ext.collect(view)) {
+        ext.fetch(dio, *this);
+        ext.stitch(view, out);
+    }
+    // 扩展记录：base_record 是基本记录的文件引用，完整的 DATA runlist 从基本记录取得
+    // （基本记录不可读或没有 DATA 时保留扩展记录自身的片段）
+    uint64_t base_off;
+    if (header.base_record != 0 &&
+        mft_record_offset(header.base_record & FILE_REF_RECORD_MASK, base_off)) {
+        std::vector<uint8_t> basebuf(MFT_RECORD_SIZE);
+        if (dio.read_at(base_off, basebuf.data(), basebuf.size()) > 0) {
+            apply_usa_fixups(basebuf.data(), 1, basebuf.size());
+            NTFSRecordView base;
+            if (base.reset(basebuf.data(), basebuf.size(), header.base_record & FILE_REF_RECORD_MASK)) {
+                NTFSFileRecord full;
+                base.materialize(full);
+                ext.clear();
+                if (ext.collect(base)) {
+                    ext.fetch(dio, *this);
+                    ext.stitch(base, full);
+                }
+                if (!full.data_runs.empty()) {
+                    out.data_runs.swap(full.data_runs);
+                    out.run_index.reset();
+                    out.size = full.size;
                 }
             }
+        }
+    }
+    return true;
+}
 
-            // FILE_NAME attribute
-            if (attr_type == 0x30 && attr_len > 0) {
-                uint8_t non_resident = buf[attr_off + 8];
-                if (non_resident == 0) {
-                    uint32_t content_size = read_u32_le(buf.data() + attr_off + 16);
-                    uint16_t content_offset = read_u16_le(buf.data() + attr_off + 20);
-                    size_t content_pos = attr_off + content_offset;
-                    // FILE_NAME content layout (resident):
-                    // 0: parent reference (8)
-                    // 8: creation_time (8)
-                    // 16: modified_time (8)
-                    // 24: mft_changed_time (8)
-                    // 32: access_time (8)
-                    // 40: allocated_size (8)
-                    // 48: real_size (8)
-                    // 56: flags (4)
-                    // 60: reparse (4)
-                    // 64: name_length (1)
-                    // 65: name_namespace (1)
-                    // 66: filename (UTF-16LE)
-                    if (content_pos + 66 <= buf.size() && content_size >= 66) {
-                        out.parent_reference = read_u64_le(buf.data() + content_pos + 0);
-                        uint8_t name_len = buf[content_pos + 64];
-                        uint8_t name_ns = buf[content_pos + 65];
-                        size_t name_bytes = static_cast<size_t>(name_len) * 2;
-                        size_t name_pos = content_pos + 66;
-                        if (name_pos + name_bytes <= buf.size()) {
-                            // Convert UTF-16LE name to UTF-8 and assign to string
-                            std::string name_utf8 = utf16le_to_utf8(buf.data() + name_pos, name_bytes);
-                            // Truncate to 255 bytes to avoid unbounded growth in this struct
-                            if (name_utf8.size() > 255) name_utf8.resize(255);
-                            out.name = name_utf8;
-                            // store namespace
-                            out.name_namespace = name_ns;
-                        }
-                    }
-                }
+
+// 批量扫描中的一次大块读取：$MFT 文件内偏移与对应的磁盘偏移
+struct MFTScanChunk {
+    uint64_t file_off;
+    uint64_t disk_off;
+    size_t len;
+};
+
+// 并行扫描时每个解析任务覆盖的字节数（读取块被切分为多个任务，小 MFT 也能并行）
+static const size_t MFT_PARSE_TASK_BYTES = 256 * 1024;
+
+static bool record_torn(const NTFSFileRecord& r) { return r.torn; }
+static bool record_torn(const NTFSRecordView& v) { return v.torn(); }
+
+// 校验几何并把 runlist 切分为大块读取计划；稀疏区段不读取，其中的记录号被跳过。
+// chunk_bytes 被调整为簇与记录大小（均为 2 的幂）中较大者的整数倍：读取按簇对齐，
+// 块内记录也不被切断（碎片边界处除外）
+static bool plan_mft_scan(DiskIO& dio, const NTFSVolume& vol,
+                          const std::vector<std::pair<uint64_t,int64_t>>& mft_runs, uint64_t mft_size,
+                          size_t& chunk_bytes, std::vector<MFTScanChunk>& plan) {
+    const uint64_t cluster_size = vol.cluster_size;
+    const size_t record_size = vol.mft_record_size;
+    if (cluster_size == 0 || record_size < 256 || (record_size & (record_size - 1)) != 0) return false;
+    const size_t unit = static_cast<size_t>(std::max<uint64_t>(record_size, cluster_size));
+    chunk_bytes = std::max(unit, chunk_bytes / unit * unit);
+
+    uint64_t file_cursor = 0;
+    for (const auto& run : mft_runs) {
+        if (mft_size && file_cursor >= mft_size) break;
+        uint64_t run_bytes = run.first * cluster_size;
+        if (mft_size && run_bytes > mft_size - file_cursor) run_bytes = mft_size - file_cursor;
+        if (run.second >= 0 && run_bytes > 0) {
+            uint64_t disk = vol.lcn_offset(static_cast<uint64_t>(run.second));
+            dio.advise(DiskIO::ACCESS_SEQUENTIAL, disk, run_bytes);
+            for (uint64_t done = 0; done < run_bytes; done += chunk_bytes) {
+                MFTScanChunk c;
+                c.file_off = file_cursor + done;
+                c.disk_off = disk + done;
+                c.len = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, run_bytes - done));
+                plan.push_back(c);
             }
+        }
+        file_cursor += run_bytes;
+    }
+    return true;
+}
 
-            // DATA attribute (0x80)
-            if (attr_type == 0x80 && attr_len > 0) {
-                uint8_t non_resident = buf[attr_off + 8];
-                if (non_resident == 0) {
-                    // resident DATA — content offset at +16, size at +16
-                    uint32_t content_size = read_u32_le(buf.data() + attr_off + 16);
-                    uint16_t content_offset = read_u16_le(buf.data() + attr_off + 20);
-                    size_t content_pos = attr_off + content_offset;
-                    if (content_pos + content_size <= buf.size()) {
-                        out.size = content_size;
-                    }
-                } else {
-                    // non-resident DATA: runlist offset at +32, real size at +48
-                    uint16_t runlist_offset = read_u16_le(buf.data() + attr_off + 32);
-                    size_t runlist_pos = attr_off + runlist_offset;
-                    // real size
-                    if (attr_off + 48 + 8 <= buf.size()) {
-                        out.size = read_u64_le(buf.data() + attr_off + 48);
-                    }
-                    if (runlist_pos < buf.size()) {
-                        size_t avail = attr_off + attr_len - runlist_pos;
-                        if (avail > 0) {
-                            std::vector<std::pair<uint64_t,int64_t>> runs_parsed;
-                            if (decode_data_runs(buf.data() + runlist_pos, avail, runs_parsed)) {
-                                // Store absolute LCNs in out.data_runs (sparse runs keep lcn == -1)
-                                out.data_runs.clear();
-                                int64_t prev = 0;
-                                for (auto &pr : runs_parsed) {
-                                    uint64_t cnt = pr.first;
-                                    int64_t lcn = pr.second;
-                                    out.data_runs.emplace_back(cnt, lcn);
-                                }
-                                normalize_data_runs(out.data_runs);
-                            }
-                        }
-                    }
-                }
+// 并行扫描：调用线程按顺序读取各块并拼接跨块记录，块内记录切分为解析任务投递到
+// 工作窃取线程池；结果按块、按任务顺序交付给回调，保证记录号顺序。同时在途的块数
+// 有上限（线程数的两倍加二），回调跟不上时读取会等待，内存占用不随 MFT 大小增长。
+// 槽位与任务的结果数组在块之间复用（视图指向槽位缓冲区，交付前缓冲区不会被覆盖）。
+// parse(p, rec_no, fixup, rec, st) 解析一条已修正的记录，返回 false 表示无效槽位；
+// 每批记录解析前先调用 parse.begin(recs, count, fixups, first_no, st)（可为该批记录预取
+// 扩展记录）。每个解析任务使用 parse 的一份副本，因此 parse 可以持有按批复用的状态。
+template <class Rec, class ParseFn>
+static bool scan_chunks_parallel(DiskIO& dio, const std::vector<MFTScanChunk>& plan, size_t record_size,
+                                 size_t threads, const ParseFn& parse,
+                                 const std::function<bool(const Rec&)>& cb, MFTScanStats& st) {
+    // 解析任务：块内一段连续的完整记录，首个任务还负责拼接出的跨块记录
+    struct Part {
+        size_t pos = 0;
+        size_t count = 0;
+        std::vector<Rec> out; // 前 n 项有效，其余为可复用的对象
+        size_t n = 0;
+        std::vector<uint8_t> fixups;
+        MFTScanStats st;
+        bool ready = false;
+    };
+    struct Slot {
+        std::vector<uint8_t> buf;
+        uint64_t file_off = 0;
+        std::vector<uint8_t> lead; // 与上一块尾部拼接出的完整记录
+        bool has_lead = false;
+        uint64_t lead_no = 0;
+        std::vector<Part> parts;
+    };
+
+    WorkStealingPool pool(threads);
+    std::vector<Slot> slots(std::min(pool.size() * 2 + 2, plan.size()));
+    std::mutex m;
+    std::condition_variable cv;
+    const size_t per_part = std::max<size_t>(1, MFT_PARSE_TASK_BYTES / record_size);
+    bool stop = false;
+
+    auto run_part = [&](Slot& s, Part& part, bool with_lead) {
+        ParseFn local(parse);
+        auto emit = [&](const uint8_t* p, uint64_t rec_no, uint8_t fixup) {
+            if (part.n == part.out.size()) part.out.emplace_back();
+            if (local(p, rec_no, fixup, part.out[part.n], part.st)) ++part.n;
+        };
+        if (with_lead) {
+            uint8_t fixup = MFT_FIXUP_ABSENT;
+            apply_usa_fixups(s.lead.data(), 1, record_size, &fixup);
+            local.begin(s.lead.data(), 1, &fixup, s.lead_no, part.st);
+            emit(s.lead.data(), s.lead_no, fixup);
+        }
+        part.fixups.resize(part.count);
+        uint8_t* base = s.buf.data() + part.pos;
+        apply_usa_fixups(base, part.count, record_size, part.fixups.data());
+        local.begin(base, part.count, part.fixups.data(), (s.file_off + part.pos) / record_size, part.st);
+        for (size_t k = 0; k < part.count; ++k) {
+            emit(base + k * record_size, (s.file_off + part.pos + k * record_size) / record_size, part.fixups[k]);
+        }
+        std::lock_guard<std::mutex> lk(m);
+        part.ready = true;
+        cv.notify_all();
+    };
+
+    // 等待第 ci 块的全部任务完成并按顺序回调（已停止时只等待，不再回调）
+    auto deliver = [&](size_t ci) {
+        Slot& s = slots[ci % slots.size()];
+        for (Part& part : s.parts) {
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv.wait(lk, [&] { return part.ready; });
+            }
+            st.skipped += part.st.skipped;
+            st.extensions += part.st.extensions;
+            for (size_t k = 0; k < part.n && !stop; ++k) {
+                ++st.records;
+                if (record_torn(part.out[k])) ++st.torn;
+                if (!cb(part.out[k])) stop = true;
             }
+        }
+    };
 
-            attr_off += attr_len;
-        }
-    }
-    // If this record references a base record (extension), try to read DATA attributes from base record
-    if (header.base_record != 0 && out.data_runs.empty()) {
-        uint64_t base_off = static_cast<uint64_t>(header.base_record);
-        if (base_off < buf.size() * 1000) { // avoid ridiculous seeks in test env
-            std::vector<uint8_t> basebuf(MFT_RECORD_SIZE);
-            ssize_t bn = dio.read_at(base_off, basebuf.data(), basebuf.size());
-            if (bn > 0) {
-                // scan attributes in base record for DATA attribute
-                size_t base_attr_off = read_u16_le(basebuf.data() + 20);
-                if (base_attr_off > 0 && base_attr_off < basebuf.size()) {
-                    size_t aoff = base_attr_off;
-                    while (aoff + 8 < basebuf.size()) {
-                        uint32_t atype = read_u32_le(basebuf.data() + aoff);
-                        uint32_t alen = read_u32_le(basebuf.data() + aoff + 4);
-                        if (atype == 0xFFFFFFFF) break;
-                        if (alen == 0) break;
-                        if (atype == 0x80) {
-                            uint8_t non_res = basebuf[aoff + 8];
-                            if (non_res != 0) {
-                                uint16_t runlist_offset = read_u16_le(basebuf.data() + aoff + 32);
-                                size_t runpos = aoff + runlist_offset;
-                                if (runpos < aoff + alen && runpos < basebuf.size()) {
-                                    size_t avail = aoff + alen - runpos;
-                                    std::vector<std::pair<uint64_t,int64_t>> runs_parsed;
-                                    if (decode_data_runs(basebuf.data() + runpos, avail, runs_parsed)) {
-                                        out.data_runs.clear();
-                                        int64_t prev = 0;
-                                        for (auto &pr : runs_parsed) {
-                                            out.data_runs.emplace_back(pr.first, pr.second);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        aoff += alen;
-                    }
-                }
+    std::vector<uint8_t> carry(record_size);
+    size_t carry_len = 0;
+    uint64_t carry_end = 0;
+    bool ok = true;
+    size_t posted = 0;    // 已投递解析任务的块数
+    size_t delivered = 0; // 已交付的块数
+    for (size_t i = 0; i < plan.size(); ++i) {
+        if (i >= slots.size()) deliver(delivered++); // 复用槽位前交付其上的结果
+        if (stop) break;
+        Slot& s = slots[i % slots.size()];
+        if (s.buf.size() < plan[i].len) s.buf.resize(plan[i].len);
+        ssize_t rn = dio.read_at(plan[i].disk_off, s.buf.data(), plan[i].len);
+        if (rn < 0) {
+            ok = false;
+            break;
+        }
+        const size_t n = static_cast<size_t>(rn);
+        ++st.chunks;
+        st.bytes_read += n;
+        s.file_off = plan[i].file_off;
+        s.has_lead = false;
+
+        // 跨块记录的拼接与串行扫描相同，在读取线程中按块顺序完成
+        size_t pos = 0;
+        if (carry_len > 0 && carry_end != s.file_off) {
+            carry_len = 0;
+            ++st.skipped;
+        }
+        if (carry_len > 0) {
+            size_t take = std::min(record_size - carry_len, n);
+            memcpy(carry.data() + carry_len, s.buf.data(), take);
+            carry_len += take;
+            carry_end += take;
+            pos = take;
+            if (carry_len == record_size) {
+                s.lead.assign(carry.begin(), carry.end());
+                s.has_lead = true;
+                s.lead_no = (carry_end - record_size) / record_size;
+                carry_len = 0;
             }
+        } else {
+            pos = static_cast<size_t>((record_size - s.file_off % record_size) % record_size);
+        }
+        size_t whole = (n > pos) ? (n - pos) / record_size : 0;
+        size_t tail = pos + whole * record_size;
+        if (tail < n) {
+            carry_len = n - tail;
+            memcpy(carry.data(), s.buf.data() + tail, carry_len);
+            carry_end = s.file_off + n;
         }
+
+        size_t nparts = std::max<size_t>(1, (whole + per_part - 1) / per_part);
+        s.parts.resize(nparts);
+        for (size_t k = 0; k < nparts; ++k) {
+            Part& part = s.parts[k];
+            part.pos = pos + k * per_part * record_size;
+            part.count = std::min(per_part, whole - std::min(whole, k * per_part));
+            part.n = 0;
+            part.st = MFTScanStats();
+            part.ready = false;
+        }
+        for (size_t k = 0; k < nparts; ++k) {
+            Slot* sp = &s;
+            Part* pp = &s.parts[k];
+            bool with_lead = (k == 0 && s.has_lead);
+            pool.post([&run_part, sp, pp, with_lead] { run_part(*sp, *pp, with_lead); });
+        }
+        posted = i + 1;
     }
-    return true;
+    // 交付（或在停止后等待）其余在途的块；线程池析构前不得释放槽位
+    while (delivered < posted) deliver(delivered++);
+    return ok;
+}
+
+// 串行扫描中一个块的异步读取。完成标志由读取回调设置，扫描只等待自己提交的块：
+// 同一句柄上其他线程（或记录回调）的 submit 不会让扫描随之阻塞（wait_all 会）
+struct MFTChunkRead {
+    DiskIO::ReadRequest req;
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = true;
+
+    static void on_complete(DiskIO::ReadRequest&, void* user) {
+        MFTChunkRead* c = static_cast<MFTChunkRead*>(user);
+        // 持锁通知：等待方醒来后可能立即释放本对象
+        std::lock_guard<std::mutex> lk(c->m);
+        c->done = true;
+        c->cv.notify_all();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [this] { return done; });
+    }
+};
+
+// 串行扫描：回调复用同一个记录对象（NTFSFileRecord 的 name/data_runs 容量在记录之间
+// 保留），除缓冲区外不为单条记录分配内存。双缓冲：等待当前块完成后立即提交下一块，
+// 再解析当前块，使解析与设备读取重叠。
+template <class Rec, class ParseFn>
+static bool scan_chunks_serial(DiskIO& dio, const std::vector<MFTScanChunk>& plan, size_t record_size,
+                               size_t chunk_bytes, const ParseFn& parse,
+                               const std::function<bool(const Rec&)>& cb, MFTScanStats& st) {
+    Rec rec;
+    ParseFn local(parse);
+    auto emit = [&](const uint8_t* p, uint64_t rec_no, uint8_t fixup) -> bool {
+        if (!local(p, rec_no, fixup, rec, st)) return true;
+        ++st.records;
+        if (record_torn(rec)) ++st.torn;
+        return cb(rec);
+    };
+
+    // 跨越块边界（即碎片边界）的记录：先把前半部分暂存，与下一块的开头拼接后解析
+    std::vector<uint8_t> carry(record_size);
+    size_t carry_len = 0;
+    uint64_t carry_end = 0; // 暂存部分在 $MFT 内的结束偏移
+    std::vector<uint8_t> fixups(chunk_bytes / record_size + 1); // 块内各记录的 USA 修正结果
+    auto parse_chunk = [&](uint8_t* data, size_t n, uint64_t file_off) -> bool {
+        size_t pos = 0;
+        if (carry_len > 0 && carry_end != file_off) {
+            // 中间隔着稀疏区段或读取失败的尾部：这条记录不完整
+            carry_len = 0;
+            ++st.skipped;
+        }
+        if (carry_len > 0) {
+            size_t take = std::min(record_size - carry_len, n);
+            memcpy(carry.data() + carry_len, data, take);
+            carry_len += take;
+            carry_end += take;
+            pos = take;
+            if (carry_len < record_size) return true;
+            carry_len = 0;
+            uint8_t fixup = MFT_FIXUP_ABSENT;
+            apply_usa_fixups(carry.data(), 1, record_size, &fixup);
+            local.begin(carry.data(), 1, &fixup, (carry_end - record_size) / record_size, st);
+            if (!emit(carry.data(), (carry_end - record_size) / record_size, fixup)) return false;
+        } else {
+            // 从块内第一个记录边界开始（块起点不在记录边界上时，之前的部分已无法拼接）
+            pos = static_cast<size_t>((record_size - file_off % record_size) % record_size);
+        }
+        // 块内完整的记录一次性批量修正，再逐条解析
+        size_t whole = (n > pos) ? (n - pos) / record_size : 0;
+        apply_usa_fixups(data + pos, whole, record_size, fixups.data());
+        local.begin(data + pos, whole, fixups.data(), (file_off + pos) / record_size, st);
+        for (size_t k = 0; k < whole; ++k, pos += record_size) {
+            if (!emit(data + pos, (file_off + pos) / record_size, fixups[k])) return false;
+        }
+        if (pos < n) {
+            carry_len = n - pos;
+            memcpy(carry.data(), data + pos, carry_len);
+            carry_end = file_off + n;
+        }
+        return true;
+    };
+
+    // USA 修正需要可写缓冲区，映射模式下同样读入块缓冲区（read_at 直接从映射区拷贝）
+    size_t buf_size = 0;
+    for (const auto& c : plan) buf_size = std::max(buf_size, c.len);
+    std::vector<uint8_t> bufs[2];
+    bufs[0].resize(buf_size);
+    if (plan.size() > 1) bufs[1].resize(buf_size);
+    MFTChunkRead reads[2];
+    auto start = [&](size_t i) {
+        MFTChunkRead& c = reads[i & 1];
+        DiskIO::ReadRequest& r = c.req;
+        r.offset = plan[i].disk_off;
+        r.buf = bufs[i & 1].data();
+        r.size = plan[i].len;
+        r.result = 0;
+        c.done = false; // 上一次使用该槽位的读取已完成，此时没有并发访问
+        if (!dio.submit(&r, 1, &MFTChunkRead::on_complete, &c)) {
+            r.result = dio.read_at(r.offset, r.buf, r.size);
+            c.done = true;
+        }
+    };
+    bool ok = true;
+    start(0);
+    for (size_t i = 0; i < plan.size(); ++i) {
+        reads[i & 1].wait();
+        if (i + 1 < plan.size()) start(i + 1);
+        ssize_t n = reads[i & 1].req.result;
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        ++st.chunks;
+        st.bytes_read += static_cast<uint64_t>(n);
+        // 短读（镜像被截断）：解析已读到的部分，之后的记录按缺失处理
+        if (!parse_chunk(bufs[i & 1].data(), static_cast<size_t>(n), plan[i].file_off)) break;
+    }
+    // 提前结束时仍可能有一块在途，缓冲区与完成标志释放前必须等待
+    reads[0].wait();
+    reads[1].wait();
+    return ok;
+}
+
+template <class Rec, class ParseFn>
+static bool scan_chunks(DiskIO& dio, const std::vector<MFTScanChunk>& plan, size_t record_size,
+                        size_t chunk_bytes, size_t threads, const ParseFn& parse,
+                        const std::function<bool(const Rec&)>& cb, MFTScanStats& st) {
+    if (plan.empty()) return true;
+    if (threads != 1) return scan_chunks_parallel<Rec>(dio, plan, record_size, threads, parse, cb, st);
+    return scan_chunks_serial<Rec>(dio, plan, record_size, chunk_bytes, parse, cb, st);
+}
+
+// scan_mft_views 的解析：绑定视图；无效槽位计入 skipped 并返回 false。并行扫描时在工作线程中调用
+struct MFTViewParse {
+    size_t record_size;
+    void begin(const uint8_t*, size_t, const uint8_t*, uint64_t, MFTScanStats&) {}
+    bool operator()(const uint8_t* p, uint64_t rec_no, uint8_t fixup, NTFSRecordView& view, MFTScanStats& pst) const {
+        if (view.reset(p, record_size, rec_no, fixup_failed(fixup))) return true;
+        ++pst.skipped;
+        return false;
+    }
+};
+
+// scan_mft 的解析：绑定视图后解码到 rec（并行扫描时解码也在工作线程中完成）。
+// begin 为一批记录汇总 ATTRIBUTE_LIST 引用并批量读取扩展记录，解码时再拼接 runlist
+struct MFTRecordParse {
+    const NTFSParser* parser;
+    DiskIO* dio;
+    size_t record_size;
+    MFTExtensionBatch ext;
+
+    MFTRecordParse(const NTFSParser& p, DiskIO& d)
+        : parser(&p), dio(&d), record_size(p.volume().mft_record_size) {}
+
+    void begin(const uint8_t* recs, size_t count, const uint8_t* fixups, uint64_t first_no, MFTScanStats& pst) {
+        ext.clear();
+        NTFSRecordView view;
+        for (size_t k = 0; k < count; ++k) {
+            if (view.reset(recs + k * record_size, record_size, first_no + k, fixup_failed(fixups[k]))) ext.collect(view);
+        }
+        if (!ext.empty()) ext.fetch(*dio, *parser, &pst);
+    }
+    bool operator()(const uint8_t* p, uint64_t rec_no, uint8_t fixup, NTFSFileRecord& rec, MFTScanStats& pst) const {
+        NTFSRecordView view;
+        if (!view.reset(p, record_size, rec_no, fixup_failed(fixup))) {
+            ++pst.skipped;
+            return false;
+        }
+        view.materialize(rec);
+        if (!ext.empty()) ext.stitch(view, rec);
+        return true;
+    }
+};
+
+bool NTFSParser::scan_mft_views(DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+                                uint64_t mft_size, const MFTRecordViewCallback& cb, MFTScanStats* stats,
+                                size_t chunk_bytes) {
+    MFTScanStats local;
+    MFTScanStats& st = stats ? *stats : local;
+    st = MFTScanStats();
+    std::vector<MFTScanChunk> plan;
+    if (!cb || !plan_mft_scan(dio, volume_, mft_runs, mft_size, chunk_bytes, plan)) return false;
+    const size_t record_size = volume_.mft_record_size;
+
+    mft_runs_ = mft_runs;
+    MFTViewParse parse{ record_size };
+    return scan_chunks<NTFSRecordView>(dio, plan, record_size, chunk_bytes, threads_, parse, cb, st);
 }
 
+bool NTFSParser::scan_mft(DiskIO& dio, const std::vector<std::pair<uint64_t,int64_t>>& mft_runs,
+                          uint64_t mft_size, const MFTRecordCallback& cb, MFTScanStats* stats,
+                          size_t chunk_bytes) {
+    MFTScanStats local;
+    MFTScanStats& st = stats ? *stats : local;
+    st = MFTScanStats();
+    std::vector<MFTScanChunk> plan;
+    if (!cb || !plan_mft_scan(dio, volume_, mft_runs, mft_size, chunk_bytes, plan)) return false;
+    const size_t record_size = volume_.mft_record_size;
+
+    mft_runs_ = mft_runs;
+    MFTRecordParse parse(*this, dio);
+    return scan_chunks<NTFSFileRecord>(dio, plan, record_size, chunk_bytes, threads_, parse, cb, st);
+}
+
+bool NTFSParser::scan_mft(DiskIO& dio, const MFTRecordCallback& cb, MFTScanStats* stats) {
+    NTFSFileRecord mft;
+    if (!read_mft_record(dio, volume_.mft_offset(), mft) || mft.data_runs.empty()) return false;
+    return scan_mft(dio, mft.data_runs, mft.size, cb, stats);
+}
+
+bool NTFSParser::scan_mft_views(DiskIO& dio, const MFTRecordViewCallback& cb, MFTScanStats* stats) {
+    NTFSFileRecord mft;
+    if (!read_mft_record(dio, volume_.mft_offset(), mft) || mft.data_runs.empty()) return false;
+    return scan_mft_views(dio, mft.data_runs, mft.size, cb, stats);
+}
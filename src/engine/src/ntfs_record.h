@@ -0,0 +1,40 @@
+// ntfs_record.h — MFT 记录的小端字段读取与属性遍历（引擎内部，供各 NTFS 实现文件共用）
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 小端安全读取辅助（通过 memcpy 避免未对齐访问）
+inline uint16_t read_u16_le(const uint8_t* p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+inline uint32_t read_u32_le(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+inline uint64_t read_u64_le(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 从 attr_off（记录头中的首个属性偏移）起依次对记录中的属性调用 fn(offset, type, length)，
+// fn 返回 false 时停止。遇到结束标记、或属性长度不足属性头 / 超出记录时结束：属性必须完整
+// 落在记录内，映射模式下越界读取可能越过映射区末尾。
+// 返回: fn 停止时所在属性的偏移；遍历完全部属性时为 0（属性不可能位于偏移 0）
+template <class Fn>
+inline size_t for_each_attribute(const uint8_t* rec, size_t size, size_t attr_off, Fn fn) {
+    if (attr_off == 0) return 0;
+    while (attr_off + 8 < size) {
+        uint32_t attr_type = read_u32_le(rec + attr_off);
+        uint32_t attr_len = read_u32_le(rec + attr_off + 4);
+        if (attr_type == 0xFFFFFFFF) break; // end marker
+        if (attr_len < 24 || attr_len > size - attr_off) break;
+        if (!fn(attr_off, attr_type, attr_len)) return attr_off;
+        attr_off += attr_len;
+    }
+    return 0;
+}
@@ -1,26 +1,89 @@
-// ntfs_stub.cpp — NTFS MFT 解析骨架的 stub 实现（用于原型与单元测试）
+// ntfs_stub.cpp — NTFS MFT 解析会话的 C API 实现
+//
+// 镜像是 NTFS 卷时，后台线程用 NTFSParser::scan_mft（可并行解析）按记录号顺序扫描
+// MFT，结果经有界队列交付给 ntfs_next_record；队列满时扫描暂停，调用方取走记录后继续。
+// 无法按 NTFS 卷打开时保留原型阶段的模拟记录，便于上层在没有镜像时联调。
 #include "ntfs.h"
+#include "ntfs_mft.h"
+#include "disk_io.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
-#include <cstring>
+
+// 扫描线程与 ntfs_next_record 之间的队列容量（记录数）
+static const size_t NTFS_QUEUE_CAPACITY = 4096;
 
 struct ntfs_parser_s {
     std::string path;
     size_t next_index = 0;
-    std::vector<ntfs_file_record_t> records;
+    std::vector<ntfs_file_record_t> records; // 模拟记录（非 NTFS 镜像）
+
+    bool live = false; // 是否正在扫描真实的 MFT
+    DiskIO dio;
+    NTFSParser parser;
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<ntfs_file_record_t> queue; // 按记录号顺序排队的结果
+    bool done = false;   // 扫描已结束（完成、出错或被取消）
+    bool cancel = false; // ntfs_close 请求停止扫描
 };
 
-// 打开 NTFS 解析上下文（stub）。返回解析器句柄或 nullptr 并在 err_buf 中写入错误。
-ntfs_parser_t ntfs_open(const char* image_path, char* err_buf, size_t err_buf_len) {
+static void set_err(char* err_buf, size_t err_buf_len, const char* msg) {
+    if (err_buf && err_buf_len) snprintf(err_buf, err_buf_len, "%s", msg);
+}
+
+// 直接从记录视图填充 C 结构（文件名就地转换为 UTF-8，不经过 std::string）
+static void to_c_record(const NTFSRecordView& v, ntfs_file_record_t& out) {
+    memset(&out, 0, sizeof(out));
+    out.file_reference = v.id();
+    out.size = v.data_size();
+    out.creation_time = v.creation_time();
+    v.name(out.file_name, sizeof(out.file_name) - 1);
+    out.name_namespace = v.name_namespace();
+}
+
+// 扫描线程：把回调结果放入有界队列，取消时让 scan_mft 提前结束
+static void scan_thread(ntfs_parser_s* p) {
+    p->parser.scan_mft_views(p->dio, [p](const NTFSRecordView& r) {
+        ntfs_file_record_t rec;
+        to_c_record(r, rec);
+        std::unique_lock<std::mutex> lk(p->m);
+        p->cv.wait(lk, [p] { return p->cancel || p->queue.size() < NTFS_QUEUE_CAPACITY; });
+        if (p->cancel) return false;
+        p->queue.push_back(rec);
+        p->cv.notify_all();
+        return true;
+    });
+    std::lock_guard<std::mutex> lk(p->m);
+    p->done = true;
+    p->cv.notify_all();
+}
+
+ntfs_parser_t ntfs_open_ex(const char* image_path, uint64_t volume_offset, uint32_t max_threads,
+                           char* err_buf, size_t err_buf_len) {
     if (!image_path) {
-        if (err_buf && err_buf_len) strncpy(err_buf, "null path", err_buf_len-1);
+        set_err(err_buf, err_buf_len, "null path");
         return nullptr;
     }
     ntfs_parser_s* p = new ntfs_parser_s();
     p->path = image_path;
+    if (p->dio.open(image_path) && p->parser.open_volume(p->dio, volume_offset)) {
+        p->parser.set_threads(max_threads);
+        p->live = true;
+        p->worker = std::thread(scan_thread, p);
+        return p;
+    }
+    p->dio.close();
     // 模拟填充几个记录
     for (uint64_t i = 1; i <= 3; ++i) {
         ntfs_file_record_t r;
+        memset(&r, 0, sizeof(r));
         r.file_reference = i;
         r.size = 1024 * i;
         r.creation_time = 0;
@@ -31,17 +94,39 @@ ntfs_parser_t ntfs_open(const char* image_path, char* err_buf, size_t err_buf_le
     return p;
 }
 
-// 关闭并释放解析器句柄。
+// 打开 NTFS 解析上下文。返回解析器句柄或 nullptr 并在 err_buf 中写入错误。
+ntfs_parser_t ntfs_open(const char* image_path, char* err_buf, size_t err_buf_len) {
+    return ntfs_open_ex(image_path, 0, 0, err_buf, err_buf_len);
+}
+
+// 关闭并释放解析器句柄（先停止并等待扫描线程）。
 void ntfs_close(ntfs_parser_t p) {
+    if (!p) return;
+    if (p->worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(p->m);
+            p->cancel = true;
+        }
+        p->cv.notify_all();
+        p->worker.join();
+    }
     delete p;
 }
 
 // 获取下一个记录：返回 0 表示成功，1 表示无更多记录，负值表示参数错误。
+// 扫描进行中且暂无结果时阻塞等待。
 int ntfs_next_record(ntfs_parser_t p, ntfs_file_record_t* out) {
     if (!p || !out) return -1;
+    if (p->live) {
+        std::unique_lock<std::mutex> lk(p->m);
+        p->cv.wait(lk, [p] { return p->done || !p->queue.empty(); });
+        if (p->queue.empty()) return 1; // no more
+        *out = p->queue.front();
+        p->queue.pop_front();
+        p->cv.notify_all();
+        return 0;
+    }
     if (p->next_index >= p->records.size()) return 1; // no more
     *out = p->records[p->next_index++];
     return 0;
 }
-
-// 获取下一个记录：返回 0 表示成功，1 表示无更多记录，负值表示参数错误。
@@ -0,0 +1,111 @@
+// ntfs_usn.cpp — $UsnJrnl 变化日志：取得日志状态并列出自某个 USN 以来变化的记录
+//
+// $Extend\$UsnJrnl 有两个命名的 DATA 流：常驻的 $Max 保存日志 id 与最早的有效 USN，
+// 非常驻的 $J 依次追加 USN 记录（USN 即记录在流中的偏移，流的实际大小为下一条 USN）。
+// 旧记录被回收时 $J 开头变为稀疏区段，因此只读取 [from_usn, next_usn) 的部分。
+#include "ntfs_mft.h"
+#include "disk_io.h"
+#include "ntfs_record.h"
+#include <algorithm>
+#include <cstring>
+
+// 每次读取的 $J 字节数
+static const size_t USN_READ_CHUNK = 1024 * 1024;
+// USN_RECORD_V2 的最小长度（文件名之前的固定部分）
+static const uint32_t USN_RECORD_V2_MIN = 60;
+static const uint32_t USN_RECORD_V3_MIN = 76;
+
+// 在（已修正 USA 的）记录中查找类型为 DATA、名称为 name（ASCII）的属性，返回属性头偏移，0 表示不存在
+static size_t find_named_data(const uint8_t* rec, size_t size, const char* name) {
+    const size_t name_len = strlen(name);
+    return for_each_attribute(rec, size, read_u16_le(rec + 20), [&](size_t off, uint32_t type, uint32_t len) {
+        const size_t n = rec[off + 9];
+        const size_t name_off = read_u16_le(rec + off + 10);
+        if (type != 0x80 || n != name_len || name_off + n * 2 > len) return true;
+        for (size_t k = 0; k < n; ++k) {
+            if (read_u16_le(rec + off + name_off + 2 * k) != static_cast<uint8_t>(name[k])) return true;
+        }
+        return false;
+    });
+}
+
+// 读取日志记录并取得 $J 的 runlist 与大小（写入 j）以及日志状态
+static bool load_journal(NTFSParser& parser, DiskIO& dio, uint64_t journal_record, NTFSFileRecord& j,
+                         NTFSUsnJournalState& state) {
+    const size_t rs = parser.volume().mft_record_size;
+    uint64_t off;
+    if (rs == 0 || !parser.mft_record_offset(journal_record, off)) return false;
+    std::vector<uint8_t> rec(rs);
+    if (dio.read_at(off, rec.data(), rs) != static_cast<ssize_t>(rs) || memcmp(rec.data(), "FILE", 4) != 0) return false;
+    uint8_t fixup = MFT_FIXUP_ABSENT;
+    apply_usa_fixups(rec.data(), 1, rs, &fixup);
+    if (fixup == MFT_FIXUP_TORN || fixup == MFT_FIXUP_BAD_USA) return false;
+
+    // $Max（常驻）：MaximumSize, AllocationDelta, UsnJournalID, LowestValidUsn
+    const size_t max_attr = find_named_data(rec.data(), rs, "$Max");
+    if (!max_attr || rec[max_attr + 8] != 0) return false;
+    const size_t content = max_attr + read_u16_le(rec.data() + max_attr + 20);
+    if (read_u32_le(rec.data() + max_attr + 16) < 32 || content + 32 > rs) return false;
+    state.journal_id = read_u64_le(rec.data() + content + 16);
+    state.lowest_valid_usn = read_u64_le(rec.data() + content + 24);
+
+    // $J（非常驻、通常大部分稀疏）；位于扩展记录中的 $J 不处理
+    const size_t j_attr = find_named_data(rec.data(), rs, "$J");
+    if (!j_attr || rec[j_attr + 8] == 0) return false;
+    const size_t attr_len = read_u32_le(rec.data() + j_attr + 4);
+    const size_t runs_off = read_u16_le(rec.data() + j_attr + 32);
+    if (attr_len < 64 || runs_off >= attr_len) return false;
+    if (read_u64_le(rec.data() + j_attr + 16) != 0) return false; // 首个片段不在本记录中
+    if (!decode_normalized_runs(rec.data() + j_attr + runs_off, attr_len - runs_off, j.data_runs)) return false;
+    j.run_index.reset();
+    j.size = read_u64_le(rec.data() + j_attr + 48);
+    state.next_usn = j.size;
+    return true;
+}
+
+bool NTFSParser::read_usn_journal_state(DiskIO& dio, uint64_t journal_record, NTFSUsnJournalState& out) {
+    NTFSFileRecord j{};
+    NTFSUsnJournalState state;
+    if (!load_journal(*this, dio, journal_record, j, state)) return false;
+    out = state;
+    return true;
+}
+
+bool NTFSParser::read_usn_changes(DiskIO& dio, uint64_t journal_record, uint64_t journal_id, uint64_t from_usn,
+                                  std::vector<uint64_t>& records, NTFSUsnJournalState* state) {
+    records.clear();
+    NTFSFileRecord j{};
+    NTFSUsnJournalState st;
+    if (!load_journal(*this, dio, journal_record, j, st)) return false;
+    if (st.journal_id != journal_id || from_usn < st.lowest_valid_usn || from_usn > st.next_usn) return false;
+
+    // 分块读取；跨越块边界的 USN 记录在下一块中从其起点重新读取
+    std::vector<uint8_t> buf(USN_READ_CHUNK);
+    uint64_t pos = from_usn & ~7ULL;
+    while (pos < st.next_usn) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(buf.size(), st.next_usn - pos));
+        if (!read_file_range(dio, j, pos, n, buf.data(), n)) return false;
+        size_t i = 0;
+        while (i + 8 <= n) {
+            const uint32_t len = read_u32_le(buf.data() + i);
+            const uint16_t major = read_u16_le(buf.data() + i + 4);
+            // 页尾的填充为 0；长度或版本异常时按 8 字节对齐向后寻找下一条记录
+            const uint32_t min_len = major == 3 ? USN_RECORD_V3_MIN : USN_RECORD_V2_MIN;
+            if (len == 0 || (len & 7) != 0 || (major != 2 && major != 3) || len < min_len || len > USN_READ_CHUNK) {
+                i += 8;
+                continue;
+            }
+            if (i + len > n) break;
+            // V2 与 V3 的文件引用都从 +8 开始（V3 为 128 位，NTFS 上低 64 位即文件引用）
+            records.push_back(read_u64_le(buf.data() + i + 8) & FILE_REF_RECORD_MASK);
+            records.push_back(read_u64_le(buf.data() + i + (major == 3 ? 24 : 16)) & FILE_REF_RECORD_MASK);
+            i += len;
+        }
+        pos += i;
+        if (n < buf.size()) break;
+    }
+    std::sort(records.begin(), records.end());
+    records.erase(std::unique(records.begin(), records.end()), records.end());
+    if (state) *state = st;
+    return true;
+}
@@ -0,0 +1,210 @@
+// ntfs_utf16.cpp — MFT 文件名的 UTF-16LE → UTF-8 转换
+//
+// 文件名绝大多数是纯 ASCII：向量实现每次检查 8（SSE2）或 16（AVX2）个码元，
+// 全部小于 0x80 时直接压缩为字节写出；块内含非 ASCII 码元时按码元逐个转换该块，
+// 之后回到向量路径。代理项与 U+FFFD 替换规则只在逐码元路径中实现，各实现输出一致。
+// AVX2 代码以函数级 target 属性编译，运行时按 CPU 能力选择，无需额外编译选项。
+#include "ntfs_mft.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FR_UTF16_X86 1
+#endif
+#if defined(FR_UTF16_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define FR_UTF16_SSE2 1
+#endif
+#if defined(FR_UTF16_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define FR_UTF16_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define FR_TARGET_AVX2
+#else
+#define FR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static inline uint16_t load_unit(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// 写出一个码点；空间不足时返回 false（不写出部分字节）
+static inline bool put_utf8(uint32_t cp, char* out, size_t cap, size_t& n) {
+    if (cp <= 0x7F) {
+        if (n + 1 > cap) return false;
+        out[n++] = static_cast<char>(cp);
+    } else if (cp <= 0x7FF) {
+        if (n + 2 > cap) return false;
+        out[n++] = static_cast<char>(0xC0 | ((cp >> 6) & 0x1F));
+        out[n++] = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp <= 0xFFFF) {
+        if (n + 3 > cap) return false;
+        out[n++] = static_cast<char>(0xE0 | ((cp >> 12) & 0x0F));
+        out[n++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        if (n + 4 > cap) return false;
+        out[n++] = static_cast<char>(0xF0 | ((cp >> 18) & 0x07));
+        out[n++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return true;
+}
+
+// 转换 pos 处的一个码点（代理对消费两个码元）。返回 false 表示转换结束
+// （输出已满或输入以不完整的代理项结尾）
+static inline bool convert_one(const uint8_t* data, size_t bytes, size_t& pos, char* out, size_t cap, size_t& n) {
+    uint16_t w1 = load_unit(data + pos);
+    pos += 2;
+    uint32_t cp = w1;
+    if (w1 >= 0xD800 && w1 <= 0xDBFF) {
+        // high surrogate, need low surrogate
+        if (pos + 1 >= bytes) {
+            // truncated surrogate
+            put_utf8(0xFFFD, out, cap, n);
+            return false;
+        }
+        uint16_t w2 = load_unit(data + pos);
+        pos += 2;
+        // invalid low surrogate — the pair is replaced as a whole
+        cp = (w2 >= 0xDC00 && w2 <= 0xDFFF)
+                 ? 0x10000 + ((static_cast<uint32_t>(w1) - 0xD800) << 10) + (static_cast<uint32_t>(w2) - 0xDC00)
+                 : 0xFFFD;
+    } else if (w1 >= 0xDC00 && w1 <= 0xDFFF) {
+        // unexpected low surrogate
+        cp = 0xFFFD;
+    }
+    return put_utf8(cp, out, cap, n);
+}
+
+static size_t convert_scalar(const uint8_t* data, size_t bytes, char* out, size_t cap) {
+    size_t pos = 0;
+    size_t n = 0;
+    while (pos + 1 < bytes) {
+        if (!convert_one(data, bytes, pos, out, cap, n)) break;
+    }
+    return n;
+}
+
+#ifdef FR_UTF16_SSE2
+static size_t convert_sse2(const uint8_t* data, size_t bytes, char* out, size_t cap) {
+    size_t pos = 0;
+    size_t n = 0;
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    while (pos + 16 <= bytes && n + 8 <= cap) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, non_ascii), zero)) == 0xFFFF) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + n), _mm_packus_epi16(v, v));
+            pos += 16;
+            n += 8;
+            continue;
+        }
+        const size_t block_end = pos + 16;
+        while (pos < block_end) {
+            if (!convert_one(data, bytes, pos, out, cap, n)) return n;
+        }
+    }
+    while (pos + 1 < bytes) {
+        if (!convert_one(data, bytes, pos, out, cap, n)) break;
+    }
+    return n;
+}
+#endif
+
+#ifdef FR_UTF16_AVX2
+FR_TARGET_AVX2 static size_t convert_avx2(const uint8_t* data, size_t bytes, char* out, size_t cap) {
+    size_t pos = 0;
+    size_t n = 0;
+    const __m256i non_ascii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    while (pos + 32 <= bytes && n + 16 <= cap) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        if (_mm256_testz_si256(v, non_ascii)) {
+            // packus 按 128 位通道交错，重排 64 位块后前 16 字节即为顺序结果
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm256_castsi256_si128(packed));
+            pos += 32;
+            n += 16;
+            continue;
+        }
+        const size_t block_end = pos + 32;
+        while (pos < block_end) {
+            if (!convert_one(data, bytes, pos, out, cap, n)) {
+                _mm256_zeroupper();
+                return n;
+            }
+        }
+    }
+    // 离开 256 位代码前清除 YMM 高半部分，避免随后的 SSE 指令承受状态切换开销
+    // （函数级 target 属性下编译器不一定自动插入 vzeroupper）
+    _mm256_zeroupper();
+    // 不足 16 个码元的尾部交给 SSE2 路径的同一套逻辑
+    size_t rest = bytes > pos ? bytes - pos : 0;
+    return n + convert_sse2(data + pos, rest, out + n, cap - n);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // OSXSAVE 与 AVX，且操作系统保存 YMM 状态
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+bool utf16le_to_utf8_impl_available(UTF16Impl impl) {
+    switch (impl) {
+    case UTF16_IMPL_SCALAR:
+        return true;
+#ifdef FR_UTF16_SSE2
+    case UTF16_IMPL_SSE2:
+        return true;
+#endif
+#ifdef FR_UTF16_AVX2
+    case UTF16_IMPL_AVX2: {
+        static const bool has_avx2 = cpu_has_avx2();
+        return has_avx2;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+UTF16Impl utf16le_to_utf8_active_impl() {
+    static const UTF16Impl impl = utf16le_to_utf8_impl_available(UTF16_IMPL_AVX2)   ? UTF16_IMPL_AVX2
+                                  : utf16le_to_utf8_impl_available(UTF16_IMPL_SSE2) ? UTF16_IMPL_SSE2
+                                                                                    : UTF16_IMPL_SCALAR;
+    return impl;
+}
+
+size_t utf16le_to_utf8_with(UTF16Impl impl, const uint8_t* data, size_t bytes, char* out, size_t cap) {
+    if (!data || !out) return 0;
+    if (!utf16le_to_utf8_impl_available(impl)) impl = UTF16_IMPL_SCALAR;
+    switch (impl) {
+#ifdef FR_UTF16_AVX2
+    case UTF16_IMPL_AVX2:
+        return convert_avx2(data, bytes, out, cap);
+#endif
+#ifdef FR_UTF16_SSE2
+    case UTF16_IMPL_SSE2:
+        return convert_sse2(data, bytes, out, cap);
+#endif
+    default:
+        return convert_scalar(data, bytes, out, cap);
+    }
+}
+
+size_t utf16le_to_utf8(const uint8_t* data, size_t bytes, char* out, size_t cap) {
+    return utf16le_to_utf8_with(utf16le_to_utf8_active_impl(), data, bytes, out, cap);
+}
@@ -0,0 +1,268 @@
+// readahead.cpp — 自适应顺序预读实现
+#include "readahead.h"
+#include "io_thread_pool.h"
+#include <algorithm>
+#include <cstring>
+
+// 同时跟踪的顺序流上限；每个流最多占用 2 个窗口的内存
+static const size_t MAX_STREAMS = 8;
+
+// 每个线程缓存的 (实例, 流) 项数
+static const size_t THREAD_CACHE_SLOTS = 4;
+
+static std::atomic<uint64_t> g_next_id{1};
+
+struct Readahead::Buffer {
+    std::mutex m;
+    std::condition_variable cv;
+    uint64_t start = 0;
+    size_t want = 0;
+    std::vector<uint8_t> data;
+    ssize_t result = 0;
+    bool pending = false;
+    bool started = false; // 已被线程池任务或消费方认领
+};
+
+// 流由所属线程独占使用：使用期间 busy 为 true。替换流的线程在 m_ 内以 CAS 认领
+// busy 后才改写 owner，因此持有 busy 的线程看到的 owner 总是稳定的。
+struct Readahead::Stream {
+    std::thread::id owner;
+    uint64_t next_expected = UINT64_MAX;
+    std::atomic<size_t> window{0};
+    std::atomic<uint64_t> last_used{0};
+    std::atomic<bool> busy{false}; // 正在被使用，不可被替换
+    std::shared_ptr<Buffer> cur;  // 正在消费的窗口
+    std::shared_ptr<Buffer> next; // 异步预读中的下一个窗口
+};
+
+Readahead::Readahead(ReadFn read, size_t min_window, size_t max_window)
+    : read_(std::move(read)),
+      min_window_(std::max<size_t>(min_window, 4096)),
+      max_window_(std::max(max_window, std::max<size_t>(min_window, 4096))),
+      id_(g_next_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+Readahead::~Readahead() { reset(); }
+
+static bool try_claim(std::atomic<bool>& busy) {
+    bool expected = false;
+    return busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+}
+
+// 取得并认领（busy = true）当前线程的流。先查线程缓存，命中且流仍属于本线程时
+// 不获取锁；否则在 m_ 内查找或替换最久未用的流。所有流都在使用中时返回 nullptr。
+Readahead::Stream* Readahead::stream_for_this_thread() {
+    struct CacheSlot { uint64_t id; Stream* s; };
+    thread_local CacheSlot cache[THREAD_CACHE_SLOTS] = {};
+    thread_local size_t cache_next = 0;
+
+    const std::thread::id me = std::this_thread::get_id();
+    const uint64_t id = id_.load(std::memory_order_relaxed);
+    const uint64_t now = clock_.fetch_add(1, std::memory_order_relaxed) + 1;
+    for (CacheSlot& c : cache) {
+        if (c.id != id) continue;
+        if (try_claim(c.s->busy)) {
+            if (c.s->owner == me) {
+                c.s->last_used.store(now, std::memory_order_relaxed);
+                return c.s;
+            }
+            c.s->busy.store(false, std::memory_order_release); // 已被其他线程替换
+        }
+        c.id = 0;
+        break;
+    }
+
+    Stream* found = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        Stream* victim = nullptr;
+        for (auto& s : streams_) {
+            if (s->owner == me) {
+                found = s.get();
+                break;
+            }
+            if (!s->busy.load(std::memory_order_relaxed) &&
+                (!victim || s->last_used.load(std::memory_order_relaxed) <
+                                victim->last_used.load(std::memory_order_relaxed))) {
+                victim = s.get();
+            }
+        }
+        if (found) {
+            if (!try_claim(found->busy)) return nullptr;
+        } else {
+            if (streams_.size() < MAX_STREAMS) {
+                streams_.emplace_back(new Stream());
+                victim = streams_.back().get();
+            } else if (!victim) {
+                return nullptr; // 所有流都在使用中
+            }
+            if (!try_claim(victim->busy)) return nullptr;
+            // 替换最久未用的流；其在途缓冲区由预读任务持有至完成
+            victim->owner = me;
+            victim->next_expected = UINT64_MAX;
+            victim->window.store(min_window_, std::memory_order_relaxed);
+            victim->cur.reset();
+            victim->next.reset();
+            found = victim;
+        }
+    }
+    found->last_used.store(now, std::memory_order_relaxed);
+    cache[cache_next] = CacheSlot{id, found};
+    cache_next = (cache_next + 1) % THREAD_CACHE_SLOTS;
+    return found;
+}
+
+void Readahead::prefetch(const std::shared_ptr<Buffer>& b, uint64_t start, size_t len) {
+    b->start = start;
+    b->want = len;
+    b->result = 0;
+    b->pending = true;
+    b->started = false;
+    if (b->data.size() < len) b->data.resize(len);
+    {
+        std::lock_guard<std::mutex> lk(inflight_m_);
+        ++inflight_;
+    }
+    prefetched_.fetch_add(len, std::memory_order_relaxed);
+    std::shared_ptr<Buffer> keep = b;
+    IOThreadPool::instance().post([this, keep] {
+        bool mine = false;
+        {
+            std::lock_guard<std::mutex> lk(keep->m);
+            if (!keep->started) keep->started = mine = true;
+        }
+        if (mine) complete(*keep);
+        std::lock_guard<std::mutex> lk(inflight_m_);
+        if (--inflight_ == 0) inflight_cv_.notify_all();
+    });
+}
+
+void Readahead::complete(Buffer& b) {
+    ssize_t got = read_(b.start, b.data.data(), b.want);
+    {
+        std::lock_guard<std::mutex> lk(b.m);
+        b.result = got;
+        b.pending = false;
+    }
+    b.cv.notify_all();
+}
+
+// 任务尚未开始时由消费方认领并就地读取：调用方本身可能是线程池线程，
+// 等待排在自己后面的任务会导致池耗尽死锁
+bool Readahead::wait_ready(Buffer& b) {
+    std::unique_lock<std::mutex> lk(b.m);
+    if (!b.pending) return false;
+    if (!b.started) {
+        b.started = true;
+        lk.unlock();
+        complete(b);
+        return true;
+    }
+    b.cv.wait(lk, [&] { return !b.pending; });
+    return true;
+}
+
+bool Readahead::read(uint64_t offset, void* buf, size_t size, ssize_t& result) {
+    if (size == 0) return false;
+    Stream* s = stream_for_this_thread();
+    if (!s) return false;
+    auto release = [&] { s->busy.store(false, std::memory_order_release); };
+
+    // 非顺序读取：重置流（在途预读被放弃），交还常规路径
+    if (offset != s->next_expected) {
+        s->window.store(min_window_, std::memory_order_relaxed);
+        s->cur.reset();
+        s->next.reset();
+        s->next_expected = offset + size;
+        release();
+        return false;
+    }
+    s->next_expected = offset + size;
+    // 超过窗口上限的大请求本身已足够高效，直接读取
+    if (size >= max_window_) {
+        s->cur.reset();
+        s->next.reset();
+        release();
+        return false;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    size_t total = 0;
+    bool stalled = false, issued = false;
+    while (total < size) {
+        uint64_t pos = offset + total;
+        auto covers = [pos](const std::shared_ptr<Buffer>& b) {
+            return b && b->start <= pos && pos < b->start + b->want;
+        };
+        bool ahead = false; // 当前缓冲区是此前提前发出的预读（而不是为本次请求同步发出的）
+        if (!covers(s->cur)) {
+            if (covers(s->next)) {
+                ahead = true;
+                // 进入下一个窗口：旧窗口已消费完毕，可作为再下一个窗口的缓冲区复用
+                std::shared_ptr<Buffer> spent = std::move(s->cur);
+                s->cur = std::move(s->next);
+                if (spent && spent.use_count() == 1 && !spent->pending) s->next = std::move(spent);
+            } else {
+                s->cur = std::make_shared<Buffer>();
+                s->next.reset();
+                prefetch(s->cur, pos, s->window.load(std::memory_order_relaxed));
+                issued = true;
+            }
+        }
+        // 新流或重启的流第一次读取总要等待刚发出的读取，这不说明设备跟不上
+        const bool waited = wait_ready(*s->cur);
+        if (waited) stalled = true;
+        Buffer& cur = *s->cur;
+        if (cur.result < 0) {
+            // 预读失败：放弃缓冲区，剩余部分直接读取以得到准确的错误语义。
+            // 直接读取也失败时整个请求返回 -1（短读表示 EOF，不能用来报告中途的错误）
+            s->cur.reset();
+            s->next.reset();
+            ssize_t r = read_(pos, out + total, size - total);
+            result = (r < 0) ? -1 : static_cast<ssize_t>(total + r);
+            release();
+            return true;
+        }
+        size_t valid = static_cast<size_t>(cur.result);
+        size_t in = static_cast<size_t>(pos - cur.start);
+        if (in >= valid) break; // EOF
+        size_t take = std::min(size - total, valid - in);
+        memcpy(out + total, cur.data.data() + in, take);
+        total += take;
+
+        // 消费方追上了提前发出的预读，说明设备吞吐跟不上：扩大窗口以加深预读
+        const size_t window = s->window.load(std::memory_order_relaxed);
+        if (waited && ahead) s->window.store(std::min(window * 2, max_window_), std::memory_order_relaxed);
+        // 当前窗口完整（未到 EOF）时，保证下一个窗口已在预读
+        if (valid == cur.want && !(s->next && s->next->start == cur.start + cur.want)) {
+            if (!s->next || s->next.use_count() > 1 || s->next->pending) s->next = std::make_shared<Buffer>();
+            prefetch(s->next, cur.start + cur.want, s->window.load(std::memory_order_relaxed));
+        }
+        if (valid < cur.want && in + take >= valid) break; // EOF
+    }
+    result = static_cast<ssize_t>(total);
+    if (stalled || issued) misses_.fetch_add(1, std::memory_order_relaxed);
+    else hits_.fetch_add(1, std::memory_order_relaxed);
+    release();
+    return true;
+}
+
+void Readahead::reset() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        streams_.clear();
+        // 使各线程缓存的流指针失效
+        id_.store(g_next_id.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    std::unique_lock<std::mutex> lk(inflight_m_);
+    inflight_cv_.wait(lk, [this] { return inflight_ == 0; });
+}
+
+Readahead::Stats Readahead::stats() const {
+    Stats st;
+    st.hits = hits_.load(std::memory_order_relaxed);
+    st.misses = misses_.load(std::memory_order_relaxed);
+    st.prefetched_bytes = prefetched_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(m_);
+    for (auto& s : streams_) st.window_bytes = std::max(st.window_bytes, s->window.load(std::memory_order_relaxed));
+    return st;
+}
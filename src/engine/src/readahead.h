@@ -0,0 +1,70 @@
+// readahead.h — DiskIO 自适应顺序预读（非公开头文件）
+//
+// 按调用线程识别顺序读取流：同一线程连续的读取首尾相接即视为顺序流。
+// 各线程在 thread_local 表中缓存自己的流，稳态下的读取不获取任何共享锁；
+// 只有首次读取或流被其他线程替换后才在锁内查找流表。
+// 每个流使用两个窗口大小的缓冲区轮换（双缓冲）：消费一个的同时在 I/O
+// 线程池中异步预读下一个。消费方等待预读完成（设备跟不上消费速度）时
+// 窗口翻倍，直到上限，因此窗口大小随实际吞吐自动调整。
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+class Readahead {
+public:
+    // 底层读取函数：语义与 DiskIO::read_at 相同
+    typedef std::function<ssize_t(uint64_t offset, void* buf, size_t size)> ReadFn;
+
+    struct Stats {
+        uint64_t hits = 0;          // 完全由已就绪的预读数据满足的读取次数
+        uint64_t misses = 0;        // 顺序流中需要等待或直接读取设备的次数
+        uint64_t prefetched_bytes = 0;
+        size_t window_bytes = 0;    // 当前最大的流窗口
+    };
+
+    Readahead(ReadFn read, size_t min_window, size_t max_window);
+    ~Readahead();
+
+    Readahead(const Readahead&) = delete;
+    Readahead& operator=(const Readahead&) = delete;
+
+    // 尝试由预读层满足读取。返回 false 表示该请求不属于顺序流，调用方应
+    // 走常规路径；返回 true 时 result 为读取结果（语义同 read_at）。
+    bool read(uint64_t offset, void* buf, size_t size, ssize_t& result);
+
+    // 丢弃所有流并等待在途预读完成（关闭设备前必须调用）
+    void reset();
+
+    Stats stats() const;
+
+private:
+    struct Buffer;
+    struct Stream;
+
+    Stream* stream_for_this_thread();
+    void prefetch(const std::shared_ptr<Buffer>& b, uint64_t start, size_t len);
+    void complete(Buffer& b);   // 执行一次预读并唤醒等待者
+    bool wait_ready(Buffer& b); // 返回 true 表示预读未就绪（等待或就地读取）
+
+    ReadFn read_;
+    size_t min_window_;
+    size_t max_window_;
+
+    mutable std::mutex m_;               // 保护 streams_ 的增删与流的替换
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::atomic<uint64_t> id_;           // 线程缓存的键：每个实例及每次 reset() 取新值
+    std::atomic<uint64_t> clock_{0};     // 流表的 LRU 时钟
+    std::atomic<uint64_t> hits_{0}, misses_{0}, prefetched_{0};
+
+    std::mutex inflight_m_;
+    std::condition_variable inflight_cv_;
+    size_t inflight_ = 0;                // 在途预读任务数
+};
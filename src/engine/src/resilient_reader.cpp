@@ -0,0 +1,195 @@
+// resilient_reader.cpp — 坏扇区容错读取实现
+#include "resilient_reader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// 跳过表文件格式：每行 "<起始偏移> <长度>"（十六进制带 0x 前缀），'#' 开头为注释。
+// 未读取而直接跳过的区间在行尾带 "untried" 标记，删除这些行即可让后续轮次重新读取。
+// 每次读取调用发现的新坏区间合并后一次追加，加载时合并，因此扫描中断后文件依然可用。
+
+// 二分中连续遇到这么多个坏扇区后，片段的其余部分不再读取
+static const size_t SKIP_AFTER_BAD_SECTORS = 8;
+
+ResilientReader::ResilientReader(ReadFn read, size_t sector, const std::string& map_path)
+    : read_(std::move(read)), sector_(sector ? sector : 512), map_path_(map_path) {}
+
+// 插入并与相邻/重叠区间合并；调用方持有写锁
+static void insert_merged(std::map<uint64_t, uint64_t>& bad, uint64_t start, uint64_t end) {
+    auto it = bad.upper_bound(start);
+    if (it != bad.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            it = bad.erase(prev);
+        }
+    }
+    while (it != bad.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = bad.erase(it);
+    }
+    bad[start] = end;
+}
+
+bool ResilientReader::load() {
+    if (map_path_.empty()) return true;
+    std::ifstream in(map_path_);
+    if (!in) return true;
+    std::string line;
+    std::unique_lock<std::shared_mutex> lk(m_);
+    while (std::getline(in, line)) {
+        size_t p = line.find_first_not_of(" \t\r");
+        if (p == std::string::npos || line[p] == '#') continue;
+        char* endp = nullptr;
+        uint64_t off = strtoull(line.c_str() + p, &endp, 0);
+        if (endp == line.c_str() + p) return false;
+        char* endp2 = nullptr;
+        uint64_t len = strtoull(endp, &endp2, 0);
+        if (endp2 == endp) return false;
+        if (len) insert_merged(bad_, off, off + len);
+    }
+    any_bad_.store(!bad_.empty(), std::memory_order_release);
+    return true;
+}
+
+void ResilientReader::Found::add(uint64_t offset, uint64_t length, bool untried) {
+    if (!ranges.empty()) {
+        Entry& last = ranges.back();
+        if (last.untried == untried && last.offset + last.length == offset) {
+            last.length += length;
+            return;
+        }
+    }
+    ranges.push_back(Entry{offset, length, untried});
+}
+
+// 并入跳过表后在锁外追加到文件：文件 I/O 不阻塞其他线程查询跳过表
+void ResilientReader::publish(const Found& found) {
+    {
+        std::unique_lock<std::shared_mutex> lk(m_);
+        for (const Found::Entry& e : found.ranges) insert_merged(bad_, e.offset, e.offset + e.length);
+        any_bad_.store(true, std::memory_order_release);
+    }
+    if (map_path_.empty()) return;
+    std::lock_guard<std::mutex> lk(file_m_);
+    if (FILE* f = fopen(map_path_.c_str(), "a")) {
+        for (const Found::Entry& e : found.ranges) {
+            fprintf(f, "0x%llx 0x%llx%s\n", (unsigned long long)e.offset, (unsigned long long)e.length,
+                    e.untried ? " untried" : "");
+        }
+        fclose(f);
+    }
+}
+
+ssize_t ResilientReader::read_span(uint64_t offset, uint8_t* out, size_t size, bool& fatal, Found& found) {
+    int err = 0;
+    ssize_t r = read_(offset, out, size, err);
+    if (r >= 0) {
+        found.bad_run = 0;
+        return r;
+    }
+    if (err == 0) { fatal = true; return -1; }
+
+    uint64_t first_sec = offset / sector_;
+    uint64_t last_sec = (offset + size - 1) / sector_;
+    if (first_sec == last_sec) {
+        // 已到扇区粒度：整个扇区记为坏区，只对请求部分填零
+        memset(out, 0, size);
+        found.add(first_sec * sector_, sector_, false);
+        ++found.bad_run;
+        zero_filled_.fetch_add(size, std::memory_order_relaxed);
+        return static_cast<ssize_t>(size);
+    }
+    // 在扇区边界处二分，只有包含坏扇区的一半会继续细分
+    uint64_t mid = (first_sec + (last_sec - first_sec + 1) / 2) * sector_;
+    size_t left_len = static_cast<size_t>(mid - offset);
+    size_t right_len = size - left_len;
+    split_reads_.fetch_add(1, std::memory_order_relaxed);
+    ssize_t left = read_span(offset, out, left_len, fatal, found);
+    if (left < 0) return -1;
+    if (static_cast<size_t>(left) < left_len) return left; // EOF
+    if (found.bad_run >= SKIP_AFTER_BAD_SECTORS) {
+        // 左半以连续坏扇区结束：整片失效的区域逐扇区二分代价过高（每次失败都可能
+        // 等待设备超时），右半不再读取，整体记为坏区留给后续轮次
+        memset(out + left_len, 0, right_len);
+        found.add(mid, (last_sec + 1) * sector_ - mid, true);
+        zero_filled_.fetch_add(right_len, std::memory_order_relaxed);
+        skipped_.fetch_add(right_len, std::memory_order_relaxed);
+        return static_cast<ssize_t>(size);
+    }
+    split_reads_.fetch_add(1, std::memory_order_relaxed);
+    ssize_t right = read_span(mid, out + left_len, right_len, fatal, found);
+    if (right < 0) return -1;
+    return left + right;
+}
+
+ssize_t ResilientReader::read(uint64_t offset, void* buf, size_t size) {
+    if (size == 0) return 0;
+    bool fatal = false;
+    Found found;
+    ssize_t r = read_known(offset, static_cast<uint8_t*>(buf), size, fatal, found);
+    if (!found.ranges.empty()) publish(found);
+    return r;
+}
+
+// 绕开已知坏区间读取 [offset, offset+size)
+ssize_t ResilientReader::read_known(uint64_t offset, uint8_t* out, size_t size, bool& fatal, Found& found) {
+    if (!any_bad_.load(std::memory_order_acquire)) return read_span(offset, out, size, fatal, found);
+
+    // 取出与请求相交的已知坏区间，读取时绕开它们
+    const uint64_t end = offset + size;
+    std::vector<Range> skip;
+    {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        auto it = bad_.upper_bound(offset);
+        if (it != bad_.begin() && std::prev(it)->second > offset) --it;
+        for (; it != bad_.end() && it->first < end; ++it) {
+            uint64_t s = std::max(it->first, offset);
+            uint64_t e = std::min(it->second, end);
+            if (s < e) skip.push_back(Range{s, e - s});
+        }
+    }
+
+    uint64_t pos = offset;
+    for (const Range& r : skip) {
+        if (r.offset > pos) {
+            size_t len = static_cast<size_t>(r.offset - pos);
+            ssize_t got = read_span(pos, out + (pos - offset), len, fatal, found);
+            if (got < 0) return -1;
+            if (static_cast<size_t>(got) < len) return static_cast<ssize_t>(pos - offset + got); // EOF
+        }
+        memset(out + (r.offset - offset), 0, static_cast<size_t>(r.length));
+        zero_filled_.fetch_add(r.length, std::memory_order_relaxed);
+        pos = r.offset + r.length;
+    }
+    if (pos < end) {
+        ssize_t got = read_span(pos, out + (pos - offset), static_cast<size_t>(end - pos), fatal, found);
+        if (got < 0) return -1;
+        pos += static_cast<uint64_t>(got);
+    }
+    return static_cast<ssize_t>(pos - offset);
+}
+
+std::vector<ResilientReader::Range> ResilientReader::ranges() const {
+    std::shared_lock<std::shared_mutex> lk(m_);
+    std::vector<Range> out;
+    out.reserve(bad_.size());
+    for (auto& kv : bad_) out.push_back(Range{kv.first, kv.second - kv.first});
+    return out;
+}
+
+ResilientReader::Stats ResilientReader::stats() const {
+    Stats st;
+    {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        st.bad_ranges = bad_.size();
+        for (auto& kv : bad_) st.bad_bytes += kv.second - kv.first;
+    }
+    st.zero_filled_bytes = zero_filled_.load(std::memory_order_relaxed);
+    st.split_reads = split_reads_.load(std::memory_order_relaxed);
+    st.skipped_bytes = skipped_.load(std::memory_order_relaxed);
+    return st;
+}
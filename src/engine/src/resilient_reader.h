@@ -0,0 +1,86 @@
+// resilient_reader.h — 坏扇区容错读取（非公开头文件）
+//
+// 类似 ddrescue 的读取策略：请求先按原大小整块读取，只有失败时才在失败
+// 区间内二分到扇区粒度，把无法读取的扇区记入跳过表（坏区间表）并以零填充。
+// 已知坏区间此后不再访问设备，因此健康区域保持整块吞吐。二分中连续遇到
+// SKIP_AFTER_BAD_SECTORS 个坏扇区时，片段的其余部分不再读取，整体记为坏区
+// （在跳过表文件中标记为 untried，留给后续轮次），因此整片失效的区域代价也有界。
+// 跳过表可持久化到文本文件，供后续扫描轮次复用。
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+class ResilientReader {
+public:
+    // 底层读取函数：语义与 DiskIO::read_at 相同；失败时 err 为系统错误码
+    // （0 表示非介质错误，例如句柄未打开，此时不做容错处理）
+    typedef std::function<ssize_t(uint64_t offset, void* buf, size_t size, int& err)> ReadFn;
+
+    struct Range {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct Stats {
+        uint64_t bad_ranges = 0;        // 跳过表中的（合并后）区间数
+        uint64_t bad_bytes = 0;         // 跳过表覆盖的字节数
+        uint64_t zero_filled_bytes = 0; // 因坏扇区以零填充返回的累计字节数
+        uint64_t split_reads = 0;       // 二分定位过程中额外发起的读取次数
+        uint64_t skipped_bytes = 0;     // 因连续坏扇区而未读取、直接记为坏区的字节数
+    };
+
+    // sector: 二分的最小粒度；map_path: 持久化跳过表路径（可为空）。
+    ResilientReader(ReadFn read, size_t sector, const std::string& map_path);
+
+    ResilientReader(const ResilientReader&) = delete;
+    ResilientReader& operator=(const ResilientReader&) = delete;
+
+    // 载入跳过表文件（不存在视为空表）。返回 false 表示文件格式错误。
+    bool load();
+
+    // 容错读取：坏扇区以零填充，返回值语义同 read_at（EOF 时较短）；
+    // 仅在非介质错误时返回 -1。
+    ssize_t read(uint64_t offset, void* buf, size_t size);
+
+    std::vector<Range> ranges() const;
+    Stats stats() const;
+
+private:
+    // 一次 read 调用中新发现的坏区间（按偏移递增产生，相邻且标记相同的就地合并），
+    // 调用结束时一次性并入跳过表并追加到文件
+    struct Found {
+        struct Entry {
+            uint64_t offset;
+            uint64_t length;
+            bool untried; // 未读取而直接跳过
+        };
+        std::vector<Entry> ranges;
+        size_t bad_run = 0; // 当前连续坏扇区数
+        void add(uint64_t offset, uint64_t length, bool untried);
+    };
+
+    ssize_t read_known(uint64_t offset, uint8_t* out, size_t size, bool& fatal, Found& found);
+    // 读取一个不含已知坏区间的片段，失败时二分
+    ssize_t read_span(uint64_t offset, uint8_t* out, size_t size, bool& fatal, Found& found);
+    void publish(const Found& found);
+
+    ReadFn read_;
+    size_t sector_;
+    std::string map_path_;
+
+    mutable std::shared_mutex m_;        // 保护 bad_（读多写少）
+    std::map<uint64_t, uint64_t> bad_;   // start -> end（半开区间，已合并）
+    std::atomic<bool> any_bad_{false};   // 快速路径：表为空时读取无需加锁
+    std::mutex file_m_;                  // 串行化跳过表文件的追加（不持有 m_）
+    std::atomic<uint64_t> zero_filled_{0};
+    std::atomic<uint64_t> split_reads_{0};
+    std::atomic<uint64_t> skipped_{0};
+};
@@ -0,0 +1,146 @@
+// segmented_image.cpp — 分段原始镜像（image.001 … image.NNN）数据源
+//
+// 各分段按编号顺序拼接为一个虚拟设备。分段起始偏移为前缀和，定位用二分查找；
+// 跨越分段边界的读取按段依次直接读入调用方缓冲区，不经中转拷贝。
+// 分段句柄按需打开并限制同时打开的数量（LRU 淘汰），上千个分段也不会耗尽句柄。
+#include "image_source.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 同时打开的分段句柄上限
+static const size_t SEGMENT_OPEN_LIMIT = 64;
+
+class SegmentedImageSource : public ImageSource {
+public:
+    SegmentedImageSource(std::vector<std::string> paths, std::vector<uint64_t> sizes, uint32_t flags)
+        : paths_(std::move(paths)), flags_(flags | DiskIO::OPEN_RAW),
+          handles_(paths_.size()), last_used_(paths_.size()) {
+        starts_.reserve(sizes.size() + 1);
+        uint64_t pos = 0;
+        for (uint64_t s : sizes) {
+            starts_.push_back(pos);
+            pos += s;
+        }
+        starts_.push_back(pos);
+        for (auto& t : last_used_) t.store(0, std::memory_order_relaxed);
+    }
+
+    ssize_t read(uint64_t offset, void* buf, size_t size) override {
+        const uint64_t total_size = starts_.back();
+        if (offset >= total_size || size == 0) return 0;
+        size = static_cast<size_t>(std::min<uint64_t>(size, total_size - offset));
+        // 最后一个起始偏移 <= offset 的分段（空分段与下一段起点相同，会被跳过）
+        size_t seg = static_cast<size_t>(std::upper_bound(starts_.begin(), starts_.end() - 1, offset) -
+                                         starts_.begin()) - 1;
+        uint8_t* out = static_cast<uint8_t*>(buf);
+        size_t total = 0;
+        while (total < size && seg < paths_.size()) {
+            uint64_t pos = offset + total;
+            uint64_t seg_len = starts_[seg + 1] - starts_[seg];
+            if (pos >= starts_[seg + 1]) { ++seg; continue; }
+            uint64_t in = pos - starts_[seg];
+            size_t want = static_cast<size_t>(std::min<uint64_t>(size - total, seg_len - in));
+            // 任一分段打开失败、读取失败或被截断都使整个请求失败：短读在 read_at 中表示 EOF，
+            // 返回已读字节数会让上层把中间分段的错误当作镜像结尾而提前停止
+            std::shared_ptr<DiskIO> h = acquire(seg);
+            if (!h) return -1;
+            ssize_t r = h->read_at(in, out + total, want);
+            if (r < 0) return -1;
+            if (static_cast<size_t>(r) < want) {
+                // 分段在打开后被截断：视为介质错误而非 EOF，避免拼接出错位的数据
+                fail("segment shorter than expected", EIO);
+                return -1;
+            }
+            total += want;
+            ++seg;
+        }
+        return static_cast<ssize_t>(total);
+    }
+
+    uint64_t size() const override { return starts_.back(); }
+
+private:
+    // 取得分段句柄：已打开时无锁返回，否则在锁内打开并在超出上限时淘汰最久未用的句柄。
+    // 返回的 shared_ptr 保证读取期间句柄不会因淘汰而关闭。
+    std::shared_ptr<DiskIO> acquire(size_t seg) {
+        uint64_t now = clock_.fetch_add(1, std::memory_order_relaxed);
+        last_used_[seg].store(now, std::memory_order_relaxed);
+        std::shared_ptr<DiskIO> h = std::atomic_load(&handles_[seg]);
+        if (h) return h;
+
+        std::lock_guard<std::mutex> lk(open_m_);
+        h = std::atomic_load(&handles_[seg]);
+        if (h) return h;
+        h = std::make_shared<DiskIO>();
+        if (!h->open(paths_[seg].c_str(), flags_)) return nullptr;
+        if (open_.size() >= SEGMENT_OPEN_LIMIT) {
+            size_t victim = 0;
+            for (size_t i = 1; i < open_.size(); ++i) {
+                if (last_used_[open_[i]].load(std::memory_order_relaxed) <
+                    last_used_[open_[victim]].load(std::memory_order_relaxed)) victim = i;
+            }
+            std::atomic_store(&handles_[open_[victim]], std::shared_ptr<DiskIO>());
+            open_[victim] = open_.back();
+            open_.pop_back();
+        }
+        std::atomic_store(&handles_[seg], h);
+        open_.push_back(seg);
+        return h;
+    }
+
+    std::vector<std::string> paths_;
+    uint32_t flags_;
+    std::vector<uint64_t> starts_;                  // 分段起始偏移（前缀和），末项为总大小
+    std::vector<std::shared_ptr<DiskIO>> handles_;  // 按需打开的分段句柄（原子访问）
+    std::vector<std::atomic<uint64_t>> last_used_;  // LRU 时间戳
+    std::atomic<uint64_t> clock_{0};
+    std::mutex open_m_;                             // 保护打开/淘汰与 open_
+    std::vector<size_t> open_;                      // 当前打开的分段编号
+};
+
+// 识别 "<base>.<数字>" 形式的分段路径（至少 3 位数字，例如 image.001），
+// 从给定编号起按相同位宽枚举连续存在的分段。
+ImageSource* open_segmented_image(const char* path, uint32_t flags, bool& failed) {
+    failed = false;
+    std::string p(path);
+    size_t dot = p.find_last_of('.');
+    if (dot == std::string::npos || p.size() - dot - 1 < 3 || p.find_first_of("/\\", dot) != std::string::npos) {
+        return nullptr;
+    }
+    std::string digits = p.substr(dot + 1);
+    for (char c : digits) {
+        if (!isdigit(static_cast<unsigned char>(c))) return nullptr;
+    }
+    const std::string base = p.substr(0, dot + 1);
+    const size_t width = digits.size();
+    unsigned long long first = strtoull(digits.c_str(), nullptr, 10);
+
+    std::vector<std::string> paths;
+    std::vector<uint64_t> sizes;
+    for (unsigned long long n = first;; ++n) {
+        char num[32];
+        snprintf(num, sizeof(num), "%0*llu", static_cast<int>(width), n);
+        if (strlen(num) > width) break; // 编号溢出位宽
+        std::string seg = base + num;
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(seg, ec)) break;
+        uint64_t sz = std::filesystem::file_size(seg, ec);
+        if (ec) break;
+        paths.push_back(seg);
+        sizes.push_back(sz);
+    }
+    // 首个分段不存在时交由平台实现报告错误；只有单个分段时按普通镜像打开，
+    // 保留内存映射、O_DIRECT 与 io_uring 等平台读取路径
+    if (paths.size() < 2) return nullptr;
+    return new SegmentedImageSource(std::move(paths), std::move(sizes), flags);
+}
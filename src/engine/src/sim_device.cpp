@@ -0,0 +1,115 @@
+// sim_device.cpp — 延迟模拟与故障注入数据源
+#include "../include/sim_device.h"
+#include "image_source.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// splitmix64：把 (seed, key) 映射为均匀分布的 64 位值
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 以概率 p 返回 true（由 seed 与 key 决定）
+static bool chance(uint64_t seed, uint64_t key, double p) {
+    if (p <= 0) return false;
+    if (p >= 1) return true;
+    return static_cast<double>(mix64(seed ^ mix64(key)) >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+class SimulatedSource : public ImageSource {
+public:
+    SimulatedSource(std::unique_ptr<DiskIO> inner, const SimDeviceModel& model)
+        : inner_(std::move(inner)), model_(model) {
+        if (model_.sector_size == 0) model_.sector_size = 512;
+        std::sort(model_.bad_ranges.begin(), model_.bad_ranges.end(),
+                  [](const DiskIO::BadRange& a, const DiskIO::BadRange& b) { return a.offset < b.offset; });
+    }
+
+    ssize_t read(uint64_t offset, void* buf, size_t size) override {
+        if (size == 0) return inner_->read_at(offset, buf, 0);
+        uint64_t req_no = requests_.fetch_add(1, std::memory_order_relaxed);
+        delay(offset, size);
+
+        if (chance(model_.seed, 0x7472616E73ULL ^ (req_no << 8), model_.transient_error_rate)) {
+            fail("simulated transient I/O error", model_.error_code);
+            return -1;
+        }
+        if (hits_bad_sector(offset, size)) {
+            fail("simulated unreadable sector", model_.error_code);
+            return -1;
+        }
+        ssize_t r = inner_->read_at(offset, buf, size);
+        if (r <= 0) return r;
+        if (chance(model_.seed, 0x73686F7274ULL ^ (req_no << 8), model_.short_read_rate)) {
+            // 按扇区边界截断（可能为 0 字节），与真实桥接芯片的短读行为一致
+            size_t keep = static_cast<size_t>(mix64(model_.seed ^ req_no) % static_cast<uint64_t>(r));
+            keep -= keep % model_.sector_size;
+            return static_cast<ssize_t>(keep);
+        }
+        return r;
+    }
+
+    uint64_t size() const override { return 0; }
+
+private:
+    bool hits_bad_sector(uint64_t offset, size_t size) const {
+        uint64_t end = offset + size;
+        auto it = std::upper_bound(model_.bad_ranges.begin(), model_.bad_ranges.end(), offset,
+                                   [](uint64_t off, const DiskIO::BadRange& r) { return off < r.offset; });
+        if (it != model_.bad_ranges.begin()) {
+            auto prev = std::prev(it);
+            if (prev->offset + prev->length > offset) return true;
+        }
+        if (it != model_.bad_ranges.end() && it->offset < end) return true;
+        if (model_.bad_sector_rate > 0) {
+            const uint64_t ss = model_.sector_size;
+            for (uint64_t s = offset / ss; s <= (end - 1) / ss; ++s) {
+                if (chance(model_.seed, s, model_.bad_sector_rate)) return true;
+            }
+        }
+        return false;
+    }
+
+    // 单磁头排队模型：每个请求在设备时间线上预约一段服务时间，然后睡到完成时刻
+    void delay(uint64_t offset, size_t size) {
+        if (!model_.seek_us && !model_.per_request_us && !model_.bytes_per_sec) return;
+        using clock = std::chrono::steady_clock;
+        clock::time_point done;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            std::chrono::nanoseconds service(static_cast<int64_t>(model_.per_request_us) * 1000);
+            if (offset != head_) service += std::chrono::microseconds(model_.seek_us);
+            if (model_.bytes_per_sec) {
+                service += std::chrono::nanoseconds(static_cast<int64_t>(
+                    static_cast<double>(size) * 1e9 / static_cast<double>(model_.bytes_per_sec)));
+            }
+            clock::time_point start = std::max(clock::now(), busy_until_);
+            busy_until_ = start + service;
+            done = busy_until_;
+            head_ = offset + size;
+        }
+        std::this_thread::sleep_until(done);
+    }
+
+    std::unique_ptr<DiskIO> inner_;
+    SimDeviceModel model_;
+    std::atomic<uint64_t> requests_{0};
+    std::mutex m_;                                 // 保护设备时间线
+    std::chrono::steady_clock::time_point busy_until_;
+    uint64_t head_ = UINT64_MAX;                   // 磁头位置（上次请求结束偏移，初始未知）
+};
+
+bool DiskIO::open_simulated(const char* path, const SimDeviceModel& model, uint32_t flags) {
+    close();
+    std::unique_ptr<DiskIO> inner(new DiskIO());
+    if (!inner->open(path, flags)) return false; // 错误已由内部句柄记录
+    source_ = new SimulatedSource(std::move(inner), model);
+    clear_error();
+    return true;
+}
@@ -0,0 +1,85 @@
+// work_stealing_pool.cpp — 工作窃取线程池实现
+#include "work_stealing_pool.h"
+
+// 当前线程所属的池与队列编号（非工作线程为空）
+static thread_local const WorkStealingPool* t_pool = nullptr;
+static thread_local size_t t_index = 0;
+
+size_t WorkStealingPool::default_threads() {
+    size_t hw = std::thread::hardware_concurrency();
+    return hw ? hw : 4;
+}
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    if (threads == 0) threads = default_threads();
+    queues_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) queues_.emplace_back(new Queue());
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lk(sleep_m_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void WorkStealingPool::post(std::function<void()> task) {
+    size_t q = (t_pool == this) ? t_index : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lk(queues_[q]->m);
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+    {
+        // 在睡眠锁内递增，避免与工作线程的条件检查之间丢失唤醒
+        std::lock_guard<std::mutex> lk(sleep_m_);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    sleep_cv_.notify_one();
+}
+
+bool WorkStealingPool::try_pop(size_t self, std::function<void()>& task) {
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lk(own.m);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues_.size(); ++k) {
+        Queue& victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> lk(victim.m);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// 工作线程：取任务执行，直到池被销毁且所有队列清空
+void WorkStealingPool::worker_loop(size_t self) {
+    t_pool = this;
+    t_index = self;
+    for (;;) {
+        std::function<void()> task;
+        if (try_pop(self, task)) {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(sleep_m_);
+        sleep_cv_.wait(lk, [this] { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+        if (stop_ && pending_.load(std::memory_order_relaxed) <= 0) return;
+    }
+}
@@ -0,0 +1,53 @@
+// work_stealing_pool.h — CPU 密集任务的工作窃取线程池（非公开头文件）
+//
+// 每个工作线程有自己的任务队列：外部投递的任务轮流分配到各队列，工作线程
+// 优先从自己队列的尾部取任务（缓存友好），自己的队列为空时从其他队列的头部
+// 窃取，从而在任务耗时不均时保持所有线程忙碌。与 IOThreadPool 不同，此池用于
+// 解析等计算任务，线程数通常等于 CPU 核数，由使用方按需创建。
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    // threads == 0 表示使用硬件并发数
+    explicit WorkStealingPool(size_t threads);
+    // 等待已投递的任务全部完成后退出
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // 投递一个任务。工作线程内投递的任务进入该线程自己的队列
+    void post(std::function<void()> task);
+
+    size_t size() const { return workers_.size(); }
+
+    // threads == 0 时使用的线程数
+    static size_t default_threads();
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // 先取自己队列的尾部，再依次窃取其他队列的头部
+    bool try_pop(size_t self, std::function<void()>& task);
+    void worker_loop(size_t self);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_{0};    // 外部投递的轮转位置
+    std::atomic<int64_t> pending_{0}; // 已投递但尚未被取走的任务数（投递与取走并发时可能短暂为负）
+    std::mutex sleep_m_;
+    std::condition_variable sleep_cv_;
+    bool stop_ = false;
+};
@@ -0,0 +1,95 @@
+// fr_runmap_bench.cpp — 高度碎片化文件的区段定位微基准
+//
+// 用法: fr_runmap_bench [runs (default 100000)] [chunk_kb (default 64)]
+// 构造一个含 runs 个区段（每区段 1..16 簇，约 1/16 为稀疏区段）的合成文件，
+// 以 chunk_kb 为单位顺序映射整个文件并随机映射同样次数，对比逐区段线性查找
+// （建立区段索引之前的做法）与 map_file_range 的前缀和索引。
+#include "ntfs_mft.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// 线性查找的参考实现：每次调用都从第 0 个区段开始累加
+static size_t map_linear(const NTFSFileRecord& rec, uint64_t file_offset, size_t len, uint64_t cluster_size,
+                         std::vector<std::pair<uint64_t,size_t>>& out) {
+    out.clear();
+    uint64_t cursor = 0;
+    for (const auto& run : rec.data_runs) {
+        uint64_t run_bytes = run.first * cluster_size;
+        if (file_offset >= cursor + run_bytes) {
+            cursor += run_bytes;
+            continue;
+        }
+        uint64_t start = file_offset - cursor;
+        uint64_t take = std::min<uint64_t>(run_bytes - start, len);
+        if (run.second != -1) out.emplace_back(static_cast<uint64_t>(run.second) * cluster_size + start, take);
+        len -= take;
+        file_offset += take;
+        cursor += run_bytes;
+        if (len == 0) break;
+    }
+    return out.size();
+}
+
+int main(int argc, char** argv) {
+    size_t runs = argc > 1 ? static_cast<size_t>(strtoull(argv[1], nullptr, 10)) : 100000;
+    size_t chunk = (argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 64) * 1024;
+    if (runs == 0 || chunk == 0) {
+        fprintf(stderr, "usage: %s [runs] [chunk_kb]\n", argv[0]);
+        return 2;
+    }
+    const uint64_t cluster = 4096;
+    uint32_t seed = 99;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    NTFSFileRecord rec{};
+    int64_t lcn = 1000;
+    for (size_t i = 0; i < runs; ++i) {
+        uint64_t count = 1 + rnd() % 16;
+        if (rnd() % 16 == 0) {
+            rec.data_runs.emplace_back(count, -1);
+            continue;
+        }
+        lcn += count + 1 + rnd() % 64; // 留出间隔，避免区段被合并
+        rec.data_runs.emplace_back(count, lcn);
+    }
+    uint64_t file_bytes = 0;
+    for (const auto& r : rec.data_runs) file_bytes += r.first * cluster;
+    const size_t calls = static_cast<size_t>((file_bytes + chunk - 1) / chunk);
+    std::vector<uint64_t> random_offsets(calls);
+    for (uint64_t& off : random_offsets) off = (static_cast<uint64_t>(rnd()) << 24 ^ rnd()) % file_bytes;
+    printf("%zu runs, %.1f MiB, %zu x %zu KiB chunks\n", runs, file_bytes / 1048576.0, calls, chunk / 1024);
+
+    NTFSParser p;
+    std::vector<std::pair<uint64_t,size_t>> out;
+    size_t sink = 0;
+    auto bench = [&](const char* label, bool indexed, bool sequential) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            uint64_t off = sequential ? i * chunk : random_offsets[i];
+            size_t len = static_cast<size_t>(std::min<uint64_t>(chunk, file_bytes - off));
+            if (indexed) {
+                p.map_file_range(rec, off, len, cluster, out);
+                sink += out.size();
+            } else {
+                sink += map_linear(rec, off, len, cluster, out);
+            }
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        printf("%-22s %10.3f ms total  %9.1f ns/call\n", label, sec * 1e3, sec * 1e9 / calls);
+    };
+    bench("linear sequential", false, true);
+    bench("linear random", false, false);
+    rec.run_index.reset();
+    auto t0 = std::chrono::steady_clock::now();
+    p.map_file_range(rec, 0, 1, cluster, out); // 首次调用建立索引
+    double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%-22s %10.3f ms (%zu KiB)\n", "index build", build * 1e3, rec.run_index->memory_bytes() / 1024);
+    bench("indexed sequential", true, true);
+    bench("indexed random", true, false);
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// fr_utf16_bench.cpp — 文件名 UTF-16LE → UTF-8 转换的微基准
+//
+// 用法: fr_utf16_bench [names (default 1000000)]
+// 生成三组典型的 MFT 文件名（纯 ASCII、带少量非 ASCII 字符、CJK），
+// 对每个可用实现分别计时并报告吞吐量（MB/s，按输入的 UTF-16 字节计）。
+#include "ntfs_mft.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct NameSet {
+    const char* label;
+    std::vector<uint8_t> data;      // 所有名称首尾相接（UTF-16LE）
+    std::vector<size_t> offsets;    // 各名称起点，末项为总长度
+};
+
+static void add_unit(std::vector<uint8_t>& out, uint16_t u) {
+    out.push_back(static_cast<uint8_t>(u & 0xFF));
+    out.push_back(static_cast<uint8_t>(u >> 8));
+}
+
+// kind: 0 纯 ASCII，1 名称中偶有重音字符，2 中文名称
+static NameSet make_names(const char* label, int kind, size_t count) {
+    NameSet s;
+    s.label = label;
+    uint32_t seed = 12345;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        s.offsets.push_back(s.data.size());
+        size_t len = 6 + rnd() % 26;
+        for (size_t k = 0; k < len; ++k) {
+            uint16_t u;
+            if (kind == 2) u = static_cast<uint16_t>(0x4E00 + rnd() % 0x5000);
+            else if (kind == 1 && rnd() % 16 == 0) u = static_cast<uint16_t>(0xC0 + rnd() % 0x40);
+            else u = static_cast<uint16_t>('a' + rnd() % 26);
+            add_unit(s.data, u);
+        }
+        for (const char* ext = ".docx"; *ext; ++ext) add_unit(s.data, static_cast<uint16_t>(*ext));
+    }
+    s.offsets.push_back(s.data.size());
+    return s;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? static_cast<size_t>(strtoull(argv[1], nullptr, 10)) : 1000000;
+    if (count == 0) {
+        fprintf(stderr, "usage: %s [names]\n", argv[0]);
+        return 2;
+    }
+    NameSet sets[] = { make_names("ascii", 0, count), make_names("latin-1", 1, count),
+                       make_names("cjk", 2, count) };
+    const UTF16Impl impls[] = { UTF16_IMPL_SCALAR, UTF16_IMPL_SSE2, UTF16_IMPL_AVX2 };
+    const char* impl_names[] = { "scalar", "sse2", "avx2" };
+
+    printf("active implementation: %s\n", impl_names[utf16le_to_utf8_active_impl()]);
+    char buf[1024];
+    for (const NameSet& s : sets) {
+        for (UTF16Impl impl : impls) {
+            if (!utf16le_to_utf8_impl_available(impl)) continue;
+            size_t total = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i + 1 < s.offsets.size(); ++i) {
+                total += utf16le_to_utf8_with(impl, s.data.data() + s.offsets[i],
+                                              s.offsets[i + 1] - s.offsets[i], buf, sizeof(buf));
+            }
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            printf("%-8s %-7s %8.1f MB/s  (%zu bytes out)\n", s.label, impl_names[impl],
+                   s.data.size() / sec / 1e6, total);
+        }
+    }
+    return 0;
+}
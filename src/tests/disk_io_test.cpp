@@ -1,11 +1,18 @@
 // disk_io_test.cpp — 验证 DiskIO 抽象的最小单元测试
 #include "disk_io.h"
+#include "ntfs_mft.h"
+#include "chunked_image.h"
+#include "sim_device.h"
 #include <gtest/gtest.h>
 #include <fstream>
 #include <filesystem>
 #include <vector>
 #include <chrono>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstring>
 
 TEST(DiskIOStub, OpenReadClose) {
     using namespace std::filesystem;
@@ -36,3 +43,993 @@ TEST(DiskIOStub, OpenReadClose) {
     std::error_code ec;
     remove(tmp, ec);
 }
+
+// 写入带位置特征的数据（每字节 = 偏移的低 8 位），便于校验读取位置是否正确
+static std::filesystem::path make_pattern_file(const char* tag, size_t bytes) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-") + tag + "-" + suffix + ".bin");
+    std::ofstream of(tmp, std::ios::binary);
+    std::vector<unsigned char> data(bytes);
+    for (size_t i = 0; i < bytes; ++i) data[i] = static_cast<unsigned char>(i & 0xFF);
+    of.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return tmp;
+}
+
+TEST(DiskIONative, ReadAtHonorsOffsetAndEOF) {
+    auto tmp = make_pattern_file("pread", 10000);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    unsigned char buf[300];
+    ASSERT_EQ(d.read_at(1234, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+    for (size_t i = 0; i < sizeof(buf); ++i) ASSERT_EQ(buf[i], (unsigned char)((1234 + i) & 0xFF));
+    // 跨越文件末尾时返回较短长度
+    EXPECT_EQ(d.read_at(9900, buf, sizeof(buf)), 100);
+    EXPECT_EQ(d.read_at(20000, buf, sizeof(buf)), 0);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIONative, OpenMissingFileFails) {
+    DiskIO d;
+    EXPECT_FALSE(d.open("/nonexistent/filerecover/none.img"));
+    EXPECT_STRNE(d.last_error(), "");
+}
+
+TEST(DiskIONative, DirectModeUnalignedReads) {
+    auto tmp = make_pattern_file("direct", 3 * 1024 * 1024 + 77);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str(), DiskIO::OPEN_DIRECT));
+    EXPECT_GE(d.sector_size(), 512u);
+    // 非对齐偏移、长度与缓冲区，且跨越中转缓冲区上限
+    std::vector<unsigned char> buf(2 * 1024 * 1024 + 3);
+    ssize_t n = d.read_at(4097, buf.data() + 1, buf.size() - 1);
+    ASSERT_EQ(n, (ssize_t)(buf.size() - 1));
+    for (size_t i = 0; i < buf.size() - 1; ++i) ASSERT_EQ(buf[i + 1], (unsigned char)((4097 + i) & 0xFF));
+    // 末尾的非整扇区尾部
+    n = d.read_at(3 * 1024 * 1024, buf.data(), 1000);
+    ASSERT_EQ(n, 77);
+    for (size_t i = 0; i < 77; ++i) ASSERT_EQ(buf[i], (unsigned char)((3 * 1024 * 1024 + i) & 0xFF));
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+// 校验批量读取：覆盖 io_uring 路径与线程池回退路径
+static void check_read_batch(uint32_t flags) {
+    auto tmp = make_pattern_file("batch", 1 << 20);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str(), flags));
+    const size_t N = 100;
+    std::vector<std::vector<unsigned char>> bufs(N, std::vector<unsigned char>(777));
+    std::vector<DiskIO::ReadRequest> reqs(N);
+    for (size_t i = 0; i < N; ++i) {
+        reqs[i].offset = (i * 9973) % ((1 << 20) - 1000);
+        reqs[i].buf = bufs[i].data();
+        reqs[i].size = bufs[i].size();
+    }
+    // 最后一个请求越过 EOF，应得到短读而非错误
+    reqs[N - 1].offset = (1 << 20) - 100;
+    ASSERT_TRUE(d.read_batch(reqs.data(), reqs.size()));
+    for (size_t i = 0; i + 1 < N; ++i) {
+        ASSERT_EQ(reqs[i].result, 777);
+        for (size_t k = 0; k < 777; ++k) ASSERT_EQ(bufs[i][k], (unsigned char)((reqs[i].offset + k) & 0xFF));
+    }
+    EXPECT_EQ(reqs[N - 1].result, 100);
+
+    // 异步提交 + 完成回调
+    std::atomic<int> completed{0};
+    for (auto& r : reqs) r.result = -2;
+    ASSERT_TRUE(d.submit(reqs.data(), 50, [](DiskIO::ReadRequest& r, void* u) {
+        if (r.result == (ssize_t)r.size) static_cast<std::atomic<int>*>(u)->fetch_add(1);
+    }, &completed));
+    ASSERT_TRUE(d.submit(reqs.data() + 50, 49, [](DiskIO::ReadRequest& r, void* u) {
+        if (r.result == (ssize_t)r.size) static_cast<std::atomic<int>*>(u)->fetch_add(1);
+    }, &completed));
+    d.wait_all();
+    EXPECT_EQ(completed.load(), 99);
+
+    d.close();
+    EXPECT_FALSE(d.read_batch(reqs.data(), 2));
+    EXPECT_FALSE(d.submit(reqs.data(), 2, nullptr, nullptr));
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOBatch, ReadBatchDefaultEngine) { check_read_batch(DiskIO::OPEN_DEFAULT); }
+
+TEST(DiskIOBatch, ReadBatchThreadPoolFallback) { check_read_batch(DiskIO::OPEN_NO_IO_URING); }
+
+TEST(DiskIOBatch, ConcurrentBatchesOnOneHandle) {
+    const size_t file_size = 1 << 20;
+    auto tmp = make_pattern_file("batch-concurrent", file_size);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+
+    // 一个异步批次的回调阻塞时，同一句柄上的其他批次照常完成
+    struct Gate {
+        std::atomic<bool> open{false};
+        std::atomic<int> entered{0};
+    } gate;
+    std::vector<unsigned char> slow_buf(4 * 512);
+    std::vector<DiskIO::ReadRequest> slow(4);
+    for (size_t i = 0; i < slow.size(); ++i) {
+        slow[i].offset = i * 4096;
+        slow[i].buf = slow_buf.data() + i * 512;
+        slow[i].size = 512;
+    }
+    ASSERT_TRUE(d.submit(slow.data(), slow.size(), [](DiskIO::ReadRequest&, void* u) {
+        Gate* g = static_cast<Gate*>(u);
+        g->entered++;
+        while (!g->open.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }, &gate));
+    auto t0 = std::chrono::steady_clock::now();
+    while (gate.entered.load() == 0 && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_GT(gate.entered.load(), 0);
+    std::thread opener([&] {
+        // 兜底：回归时 read_batch 会一直等待被阻塞的回调，3 秒后放行以免测试永久挂起
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (!gate.open.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        gate.open = true;
+    });
+    std::vector<unsigned char> buf(64 * 512);
+    std::vector<DiskIO::ReadRequest> reqs(64);
+    for (size_t i = 0; i < reqs.size(); ++i) {
+        reqs[i].offset = (i * 7919) % (file_size - 512);
+        reqs[i].buf = buf.data() + i * 512;
+        reqs[i].size = 512;
+    }
+    ASSERT_TRUE(d.read_batch(reqs.data(), reqs.size()));
+    EXPECT_FALSE(gate.open.load());
+    gate.open = true;
+    opener.join();
+    d.wait_all();
+    for (size_t i = 0; i < reqs.size(); ++i) {
+        ASSERT_EQ(buf[i * 512 + 7], (unsigned char)((reqs[i].offset + 7) & 0xFF)) << i;
+    }
+
+    // 多个线程同时在同一句柄上批量读取
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 8; ++t) {
+        ts.emplace_back([&, t] {
+            std::vector<unsigned char> tb(100 * 700);
+            std::vector<DiskIO::ReadRequest> tr(100);
+            for (int round = 0; round < 20; ++round) {
+                for (size_t i = 0; i < tr.size(); ++i) {
+                    tr[i].offset = (i * 104729u + t * 7919u + round * 31u) % (file_size - 700);
+                    tr[i].buf = tb.data() + i * 700;
+                    tr[i].size = 700;
+                    tr[i].result = -2;
+                }
+                if (!d.read_batch(tr.data(), tr.size())) { bad++; continue; }
+                for (size_t i = 0; i < tr.size(); ++i) {
+                    if (tr[i].result != 700 || tb[i * 700] != (unsigned char)(tr[i].offset & 0xFF) ||
+                        tb[i * 700 + 699] != (unsigned char)((tr[i].offset + 699) & 0xFF)) { bad++; break; }
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(bad.load(), 0);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+// 两条 1 KiB 的 MFT 记录：记录 0 是以记录 1 为基本记录的扩展记录（自身没有 DATA），
+// 记录 1 带非常驻 DATA，runlist 含稀疏区段与负的 LCN 增量：<2@5> <3@10> <1 稀疏> <2@8>
+static std::filesystem::path make_record_file(const char* tag) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-") + tag + "-" + suffix + ".bin");
+    std::vector<uint8_t> data(2048, 0);
+    auto put = [&](size_t off, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) data[off + i] = (v >> (8 * i)) & 0xFF; };
+    for (size_t rec : { 0, 1024 }) {
+        memcpy(&data[rec], "FILE", 4);
+        put(rec + 20, 48, 2);
+    }
+    put(32, (1ULL << 48) | 1, 8);
+    const size_t a = 1024 + 48;
+    put(a + 0, 0x80, 4);
+    put(a + 4, 128, 4);
+    data[a + 8] = 1;
+    put(a + 32, 56, 2);
+    put(a + 48, 8, 8);
+    const uint8_t runlist[] = { 0x11, 0x02, 0x05, 0x11, 0x03, 0x05, 0x01, 0x01, 0x11, 0x02, 0xFE, 0x00 };
+    memcpy(&data[a + 56], runlist, sizeof(runlist));
+    std::ofstream of(tmp, std::ios::binary);
+    of.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return tmp;
+}
+
+TEST(DiskIOMapped, ViewsArePinnedAndZeroCopy) {
+    auto tmp = make_pattern_file("mapped", 64 * 1024);
+    DiskIO::View v;
+    {
+        DiskIO d;
+        ASSERT_TRUE(d.open(tmp.string().c_str(), DiskIO::OPEN_MAPPED));
+        ASSERT_TRUE(d.is_mapped());
+        d.advise(DiskIO::ACCESS_SEQUENTIAL);
+        ASSERT_TRUE(d.map_view(1000, 4096, v));
+        EXPECT_EQ(v.size, 4096u);
+        // 越界区间不可映射
+        DiskIO::View bad;
+        EXPECT_FALSE(d.map_view(64 * 1024 - 10, 11, bad));
+        // read_at 在映射模式下仍可用，且 EOF 语义不变
+        unsigned char buf[64];
+        EXPECT_EQ(d.read_at(64 * 1024 - 10, buf, sizeof(buf)), 10);
+        EXPECT_EQ(buf[0], (unsigned char)((64 * 1024 - 10) & 0xFF));
+        d.advise(DiskIO::ACCESS_RANDOM, 0, 4096);
+    } // 句柄析构后视图仍然有效
+    for (size_t i = 0; i < v.size; ++i) ASSERT_EQ(v.data[i], (unsigned char)((1000 + i) & 0xFF));
+    v = DiskIO::View();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOMapped, UnmappedHandleRefusesViews) {
+    auto tmp = make_pattern_file("unmapped", 4096);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    EXPECT_FALSE(d.is_mapped());
+    DiskIO::View v;
+    EXPECT_FALSE(d.map_view(0, 16, v));
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOMapped, RecordParseMatchesBufferedRead) {
+    auto tmp = make_record_file("mapped-rec");
+    DiskIO d, dm;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(dm.open(tmp.string().c_str(), DiskIO::OPEN_MAPPED));
+    ASSERT_TRUE(dm.is_mapped());
+    NTFSParser p;
+    // 映射模式下零拷贝解析应得到完全相同的结果（含经 base_record 回到基本记录的情形）
+    for (uint64_t off : { 1024, 0 }) {
+        NTFSFileRecord r, rm;
+        ASSERT_TRUE(p.read_mft_record(d, off, r));
+        ASSERT_TRUE(p.read_mft_record(dm, off, rm));
+        EXPECT_EQ(rm.data_runs, r.data_runs);
+        EXPECT_EQ(rm.size, r.size);
+        const std::vector<std::pair<uint64_t,int64_t>> want = { {2, 5}, {3, 10}, {1, -1}, {2, 8} };
+        EXPECT_EQ(r.data_runs, want);
+    }
+    d.close();
+    dm.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOBlockCache, HitsMissesAndEvictions) {
+    auto tmp = make_pattern_file("cache", 1 << 20);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    // 4 个 4 KiB 块的容量、单分片粒度足够小以观察淘汰
+    ASSERT_TRUE(d.enable_block_cache(4 * 4096, 4096));
+    unsigned char buf[1024];
+    for (int round = 0; round < 3; ++round) {
+        ASSERT_EQ(d.read_at(8192 + 100, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+        for (size_t i = 0; i < sizeof(buf); ++i) ASSERT_EQ(buf[i], (unsigned char)((8192 + 100 + i) & 0xFF));
+    }
+    DiskIO::CacheStats st = d.block_cache_stats();
+    EXPECT_EQ(st.misses, 1u);
+    EXPECT_EQ(st.hits, 2u);
+    // 跨块读取
+    ASSERT_EQ(d.read_at(4096 - 10, buf, 20), 20);
+    EXPECT_EQ(buf[0], (unsigned char)((4096 - 10) & 0xFF));
+    // 访问大量不同块触发淘汰
+    for (uint64_t b = 16; b < 64; ++b) ASSERT_EQ(d.read_at(b * 4096, buf, 16), 16);
+    st = d.block_cache_stats();
+    EXPECT_GT(st.evictions, 0u);
+    EXPECT_LE(st.resident_bytes, 4u * 4096u);
+    // 大请求透传
+    std::vector<unsigned char> big(64 * 1024);
+    ASSERT_EQ(d.read_at(0, big.data(), big.size()), (ssize_t)big.size());
+    EXPECT_EQ(d.block_cache_stats().bypassed, 1u);
+    // 文件末尾的不完整块
+    ASSERT_EQ(d.read_at((1 << 20) - 8, buf, 64), 8);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOBlockCache, ErrorInLaterBlockFailsWholeRead) {
+    auto tmp = make_pattern_file("cache-err", 64 * 1024);
+    SimDeviceModel model;
+    model.bad_ranges.push_back(DiskIO::BadRange{0x2000, 0x200});
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), model));
+    ASSERT_TRUE(d.enable_block_cache(16 * 4096, 4096));
+    unsigned char buf[1024];
+    // 块 1 可读、块 2 含坏扇区：与不带缓存时一样整体失败，而不是返回块 1 的部分（调用方会当作 EOF）
+    EXPECT_EQ(d.read_at(0x2000 - 512, buf, sizeof(buf)), -1);
+    EXPECT_EQ(d.last_error_code(), EIO);
+    ASSERT_EQ(d.read_at(0x2000 - 512, buf, 512), 512); // 块 1 已缓存
+    EXPECT_EQ(buf[0], (unsigned char)((0x2000 - 512) & 0xFF));
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOBlockCache, RepeatedRecordParseHitsCache) {
+    auto tmp = make_record_file("cache-rec");
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(d.enable_block_cache(1 << 20));
+    NTFSParser p;
+    NTFSFileRecord r;
+    ASSERT_TRUE(p.read_mft_record(d, 0, r));
+    ASSERT_EQ(r.data_runs.size(), 4u);
+    // 再次解析：扩展记录与基本记录都应从块缓存命中，不再访问设备
+    uint64_t misses = d.block_cache_stats().misses;
+    NTFSFileRecord r2;
+    ASSERT_TRUE(p.read_mft_record(d, 0, r2));
+    EXPECT_EQ(r2.data_runs, r.data_runs);
+    EXPECT_EQ(d.block_cache_stats().misses, misses);
+    EXPECT_GE(d.block_cache_stats().hits, 2u);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOBlockCache, ConcurrentReadersAndReopen) {
+    auto tmp = make_pattern_file("cache-mt", 1 << 20);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(d.enable_block_cache(256 * 1024));
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 8; ++t) {
+        ts.emplace_back([&, t] {
+            unsigned char buf[1024];
+            for (int i = 0; i < 2000; ++i) {
+                uint64_t off = (static_cast<uint64_t>(i * 7919 + t * 104729) % ((1 << 20) - 1024));
+                if (d.read_at(off, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) { bad++; continue; }
+                for (size_t k = 0; k < sizeof(buf); ++k) {
+                    if (buf[k] != (unsigned char)((off + k) & 0xFF)) { bad++; break; }
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(bad.load(), 0);
+    EXPECT_GT(d.block_cache_stats().hits, 0u);
+
+    // 重新打开另一个镜像后不得返回旧镜像的缓存块
+    auto other = tmp;
+    other += ".zero";
+    {
+        std::ofstream of(other, std::ios::binary);
+        std::vector<char> z(8192, 0);
+        of.write(z.data(), z.size());
+    }
+    ASSERT_TRUE(d.open(other.string().c_str()));
+    unsigned char b = 0xFF;
+    ASSERT_EQ(d.read_at(5, &b, 1), 1);
+    EXPECT_EQ(b, 0);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    std::filesystem::remove(other, ec);
+}
+
+TEST(DiskIOReadahead, SequentialStreamsAndRandomAccess) {
+    const size_t file_size = 4 * 1024 * 1024 + 123;
+    auto tmp = make_pattern_file("readahead", file_size);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(d.enable_readahead(1024 * 1024));
+    // 单线程顺序小块读取直到 EOF
+    std::vector<unsigned char> buf(4000);
+    uint64_t off = 0;
+    for (;;) {
+        ssize_t r = d.read_at(off, buf.data(), buf.size());
+        ASSERT_GE(r, 0);
+        for (ssize_t i = 0; i < r; ++i) ASSERT_EQ(buf[i], (unsigned char)((off + i) & 0xFF)) << off + i;
+        off += r;
+        if (static_cast<size_t>(r) < buf.size()) break;
+    }
+    EXPECT_EQ(off, file_size);
+    DiskIO::ReadaheadStats st = d.readahead_stats();
+    EXPECT_GT(st.hits, 0u);
+    EXPECT_GT(st.prefetched_bytes, 0u);
+    EXPECT_GE(st.window_bytes, 128u * 1024u);
+    EXPECT_LE(st.window_bytes, 1024u * 1024u);
+
+    // 随机读取不受影响
+    unsigned char b[16];
+    ASSERT_EQ(d.read_at(777777, b, sizeof(b)), (ssize_t)sizeof(b));
+    EXPECT_EQ(b[0], (unsigned char)(777777 & 0xFF));
+
+    // 多线程各自顺序读取不同区间
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 4; ++t) {
+        ts.emplace_back([&, t] {
+            unsigned char lb[512];
+            uint64_t base = static_cast<uint64_t>(t) * (1 << 20);
+            for (uint64_t o = base; o < base + (1 << 20); o += sizeof(lb)) {
+                if (d.read_at(o, lb, sizeof(lb)) != (ssize_t)sizeof(lb)) { bad++; continue; }
+                for (size_t k = 0; k < sizeof(lb); ++k) {
+                    if (lb[k] != (unsigned char)((o + k) & 0xFF)) { bad++; break; }
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(bad.load(), 0);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOReadahead, WindowGrowsOnlyWhenPrefetchFallsBehind) {
+    auto tmp = make_pattern_file("readahead-grow", 2 * 1024 * 1024);
+    // 每个请求 5 ms：消费方总能追上提前发出的预读
+    SimDeviceModel slow;
+    slow.per_request_us = 5000;
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), slow));
+    ASSERT_TRUE(d.enable_readahead(1024 * 1024));
+    std::vector<unsigned char> buf(4000);
+    // 新流与重启的流等待的是为本次请求同步发出的读取：窗口保持最小值
+    ASSERT_EQ(d.read_at(0, buf.data(), buf.size()), (ssize_t)buf.size());
+    EXPECT_EQ(d.readahead_stats().window_bytes, 128u * 1024u);
+    ASSERT_EQ(d.read_at(777777, buf.data(), buf.size()), (ssize_t)buf.size());
+    ASSERT_EQ(d.read_at(777777 + buf.size(), buf.data(), buf.size()), (ssize_t)buf.size());
+    EXPECT_EQ(buf[0], (unsigned char)((777777 + buf.size()) & 0xFF));
+    EXPECT_EQ(d.readahead_stats().window_bytes, 128u * 1024u);
+    // 顺序消费追上预读的下一个窗口：窗口扩大
+    for (uint64_t off = 777777 + 2 * buf.size(); off < 777777 + 600 * 1024; off += buf.size()) {
+        ASSERT_EQ(d.read_at(off, buf.data(), buf.size()), (ssize_t)buf.size());
+    }
+    EXPECT_GT(d.readahead_stats().window_bytes, 128u * 1024u);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOReadahead, MoreThreadsThanStreams) {
+    const size_t file_size = 2 * 1024 * 1024;
+    auto tmp = make_pattern_file("readahead-threads", file_size);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(d.enable_readahead(256 * 1024));
+    // 线程数超过流表容量：流在线程之间被替换，各线程缓存的流随之失效
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 16; ++t) {
+        ts.emplace_back([&, t] {
+            unsigned char lb[1000];
+            for (int pass = 0; pass < 3; ++pass) {
+                uint64_t base = static_cast<uint64_t>((t + pass * 5) % 16) * (file_size / 16);
+                for (uint64_t o = base; o + sizeof(lb) <= base + file_size / 16; o += sizeof(lb)) {
+                    if (d.read_at(o, lb, sizeof(lb)) != (ssize_t)sizeof(lb)) { bad++; continue; }
+                    for (size_t k = 0; k < sizeof(lb); ++k) {
+                        if (lb[k] != (unsigned char)((o + k) & 0xFF)) { bad++; break; }
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(bad.load(), 0);
+    EXPECT_GT(d.readahead_stats().hits, 0u);
+    d.disable_readahead();
+    ASSERT_TRUE(d.enable_readahead(256 * 1024));
+    unsigned char b[1000];
+    for (uint64_t o = 0; o < 64 * 1000; o += sizeof(b)) ASSERT_EQ(d.read_at(o, b, sizeof(b)), (ssize_t)sizeof(b));
+    EXPECT_GT(d.readahead_stats().hits, 0u);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOReadahead, FailedPrefetchFailsWholeRead) {
+    auto tmp = make_pattern_file("readahead-bad", 1024 * 1024);
+    // 流从第二次读取（偏移 4000）开始预读，坏区恰好从第二个预读窗口开始
+    const uint64_t second_window = 4000 + 128 * 1024;
+    SimDeviceModel model;
+    model.bad_ranges.push_back(DiskIO::BadRange{second_window, 4096});
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), model));
+    ASSERT_TRUE(d.enable_readahead(1024 * 1024));
+    std::vector<unsigned char> buf(4000);
+    uint64_t off = 0;
+    for (; off + buf.size() <= second_window; off += buf.size()) {
+        ASSERT_EQ(d.read_at(off, buf.data(), buf.size()), (ssize_t)buf.size()) << off;
+    }
+    // 前半部分来自已就绪的窗口，后半部分落在坏区：整个读取报错而不是返回短读
+    EXPECT_EQ(d.read_at(off, buf.data(), buf.size()), -1);
+    EXPECT_STRNE(d.last_error(), "");
+    EXPECT_GT(d.readahead_stats().hits, 0u);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOConcurrency, SixteenReadersKeepPerThreadErrors) {
+    const size_t file_size = 1 << 20;
+    auto tmp = make_pattern_file("stress", file_size);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    DiskIO closed; // 从未打开的句柄：每次读取都失败
+
+    const int kThreads = 16;
+    const int kIters = 4000;
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < kThreads; ++t) {
+        ts.emplace_back([&, t] {
+            unsigned char buf[512];
+            for (int i = 0; i < kIters; ++i) {
+                uint64_t off = static_cast<uint64_t>(i * 2654435761u + t * 40503u) % (file_size - sizeof(buf));
+                switch (t % 4) {
+                case 0:
+                case 1:
+                    // 成功的读取：数据正确，且不会看到其他线程的错误
+                    if (d.read_at(off, buf, sizeof(buf)) != (ssize_t)sizeof(buf) ||
+                        buf[0] != (unsigned char)(off & 0xFF) ||
+                        buf[sizeof(buf) - 1] != (unsigned char)((off + sizeof(buf) - 1) & 0xFF) ||
+                        d.last_error()[0] != '\0') bad++;
+                    break;
+                case 2:
+                    if (d.read_at(off, nullptr, sizeof(buf)) != -1 ||
+                        std::string(d.last_error()) != "null buffer" || d.last_error_code() != 0) bad++;
+                    break;
+                default:
+                    if (closed.read_at(off, buf, sizeof(buf)) != -1 ||
+                        std::string(closed.last_error()) != "not opened") bad++;
+                    break;
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    RecordProperty("elapsed_ms", static_cast<int>(ms));
+    EXPECT_EQ(bad.load(), 0);
+
+    // 打开失败的错误码对调用线程可见
+    DiskIO missing;
+    EXPECT_FALSE(missing.open("/nonexistent/filerecover/none.img"));
+    EXPECT_NE(missing.last_error_code(), 0);
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOResilient, SkipMapZeroFillsAndPersists) {
+    const size_t file_size = 256 * 1024;
+    auto tmp = make_pattern_file("resilient", file_size);
+    auto map = tmp;
+    map += ".skipmap";
+    {
+        std::ofstream mf(map);
+        mf << "# offset length\n0x2000 0x400\n0x2400 0x200\n0x10000 4096\n";
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    ASSERT_TRUE(d.enable_resilient_reads(map.string().c_str()));
+    // 相邻区间在载入时合并
+    std::vector<DiskIO::BadRange> bad = d.bad_ranges();
+    ASSERT_EQ(bad.size(), 2u);
+    EXPECT_EQ(bad[0].offset, 0x2000u);
+    EXPECT_EQ(bad[0].length, 0x600u);
+    EXPECT_EQ(bad[1].offset, 0x10000u);
+
+    // 跨越坏区间的大请求：坏区为零，其余数据正确，返回完整长度
+    std::vector<unsigned char> buf(128 * 1024);
+    ASSERT_EQ(d.read_at(0x1000, buf.data(), buf.size()), (ssize_t)buf.size());
+    for (size_t i = 0; i < buf.size(); ++i) {
+        uint64_t off = 0x1000 + i;
+        bool in_bad = (off >= 0x2000 && off < 0x2600) || (off >= 0x10000 && off < 0x11000);
+        ASSERT_EQ(buf[i], in_bad ? 0 : (unsigned char)(off & 0xFF)) << off;
+    }
+    DiskIO::ResilientStats st = d.resilient_stats();
+    EXPECT_EQ(st.bad_ranges, 2u);
+    EXPECT_EQ(st.bad_bytes, 0x600u + 4096u);
+    EXPECT_EQ(st.zero_filled_bytes, 0x600u + 4096u);
+    EXPECT_EQ(st.split_reads, 0u);
+
+    // 完全落在坏区内的小请求，以及通过块缓存的读取
+    unsigned char small[16];
+    ASSERT_EQ(d.read_at(0x2100, small, sizeof(small)), (ssize_t)sizeof(small));
+    EXPECT_EQ(small[0], 0);
+    ASSERT_TRUE(d.enable_block_cache(64 * 1024, 4096));
+    ASSERT_EQ(d.read_at(0x25F8, small, sizeof(small)), (ssize_t)sizeof(small));
+    EXPECT_EQ(small[7], 0);
+    EXPECT_EQ(small[8], (unsigned char)(0x2600 & 0xFF));
+    // EOF 语义不变
+    ASSERT_EQ(d.read_at(file_size - 4, small, sizeof(small)), 4);
+    d.close();
+
+    // 格式错误的跳过表被拒绝
+    {
+        std::ofstream mf(map);
+        mf << "garbage\n";
+    }
+    DiskIO e;
+    ASSERT_TRUE(e.open(tmp.string().c_str()));
+    EXPECT_FALSE(e.enable_resilient_reads(map.string().c_str()));
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    std::filesystem::remove(map, ec);
+}
+
+TEST(DiskIOChunkedImage, RoundTripRandomReadsAndCorruption) {
+    using namespace std::filesystem;
+    // 混合内容：全零区（空洞）、可压缩的规律数据、不可压缩的伪随机数据、不足一块的尾部
+    const size_t chunk = 4096;
+    std::vector<unsigned char> data(64 * chunk + 1000);
+    uint32_t x = 12345;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (i < 8 * chunk) data[i] = 0;
+        else if (i < 40 * chunk) data[i] = static_cast<unsigned char>((i / 7) & 0xFF);
+        else { x = x * 1103515245u + 12345u; data[i] = static_cast<unsigned char>(x >> 24); }
+    }
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path src = temp_directory_path() / ("filerecover-frci-src-" + suffix + ".bin");
+    path dst = temp_directory_path() / ("filerecover-frci-" + suffix + ".frci");
+    {
+        std::ofstream of(src, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+    ChunkedImageStats st;
+    std::string err;
+    ASSERT_TRUE(write_chunked_image(src.string().c_str(), dst.string().c_str(), chunk, &st, &err)) << err;
+    EXPECT_EQ(st.image_bytes, data.size());
+    EXPECT_EQ(st.chunks, 65u);
+    EXPECT_EQ(st.hole_chunks, 8u);
+    EXPECT_GT(st.raw_chunks, 0u);
+    EXPECT_LT(st.stored_bytes, data.size());
+    EXPECT_EQ(file_size(dst), st.stored_bytes);
+    EXPECT_FALSE(write_chunked_image(src.string().c_str(), dst.string().c_str(), 3000));
+
+    DiskIO d;
+    ASSERT_TRUE(d.open(dst.string().c_str())) << d.last_error();
+    // 整体读取（绕过解压块缓存）与 EOF
+    std::vector<unsigned char> all(data.size() + 100);
+    ASSERT_EQ(d.read_at(0, all.data(), all.size()), (ssize_t)data.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), all.begin()));
+    // 跨块的随机小读取
+    unsigned char buf[5000];
+    for (int i = 0; i < 500; ++i) {
+        uint64_t off = (static_cast<uint64_t>(i) * 7919u) % (data.size() - sizeof(buf));
+        ASSERT_EQ(d.read_at(off, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+        ASSERT_EQ(memcmp(buf, data.data() + off, sizeof(buf)), 0) << off;
+    }
+    ASSERT_EQ(d.read_at(data.size() - 10, buf, 100), 10);
+    ASSERT_EQ(d.read_at(data.size() + 10, buf, 100), 0);
+    // 批量读取与块缓存叠加在容器之上
+    ASSERT_TRUE(d.enable_block_cache(64 * 1024, 4096));
+    std::vector<DiskIO::ReadRequest> reqs(8);
+    std::vector<std::vector<unsigned char>> bufs(8, std::vector<unsigned char>(3000));
+    for (size_t i = 0; i < reqs.size(); ++i) {
+        reqs[i].offset = i * 30011;
+        reqs[i].buf = bufs[i].data();
+        reqs[i].size = bufs[i].size();
+    }
+    ASSERT_TRUE(d.read_batch(reqs.data(), reqs.size()));
+    for (size_t i = 0; i < reqs.size(); ++i) {
+        ASSERT_EQ(reqs[i].result, 3000);
+        ASSERT_EQ(memcmp(bufs[i].data(), data.data() + reqs[i].offset, 3000), 0);
+    }
+    d.close();
+
+    // OPEN_RAW 读取容器文件本身
+    ASSERT_TRUE(d.open(dst.string().c_str(), DiskIO::OPEN_RAW));
+    char magic[6];
+    ASSERT_EQ(d.read_at(0, magic, sizeof(magic)), 6);
+    EXPECT_EQ(std::string(magic, 6), "FRCIMG");
+    d.close();
+
+    // 损坏的压缩块在读取时报错，损坏的头部在打开时报错
+    {
+        std::fstream f(dst, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(64 + 10);
+        const char junk[16] = {'\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f',
+                               '\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f', '\x7f'};
+        f.write(junk, sizeof(junk));
+    }
+    ASSERT_TRUE(d.open(dst.string().c_str()));
+    EXPECT_EQ(d.read_at(8 * chunk, buf, 16), -1);
+    EXPECT_STRNE(d.last_error(), "");
+    // 先经过完好的块再遇到损坏块的读取整体报错，而不是返回短读：
+    // 大请求绕过块缓存直接解压，小请求经块缓存逐块读取
+    EXPECT_EQ(d.read_at(4 * chunk, all.data(), 8 * chunk), -1);
+    EXPECT_STRNE(d.last_error(), "");
+    EXPECT_EQ(d.read_at(8 * chunk - 100, buf, 200), -1);
+    EXPECT_EQ(d.read_at(7 * chunk, buf, 100), 100);
+    d.close();
+    {
+        std::fstream f(dst, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(12);
+        const char bad_chunk[4] = {1, 2, 3, 0};
+        f.write(bad_chunk, sizeof(bad_chunk));
+    }
+    EXPECT_FALSE(d.open(dst.string().c_str()));
+    std::error_code ec;
+    remove(src, ec);
+    remove(dst, ec);
+}
+
+TEST(DiskIOSegmented, VirtualDeviceAcrossSegments) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path dir = temp_directory_path() / ("filerecover-seg-" + suffix);
+    create_directories(dir);
+    // 300 个大小不一的分段（含空分段与 1 字节分段），超过同时打开的句柄上限
+    std::vector<size_t> sizes;
+    size_t total = 0;
+    for (int i = 0; i < 300; ++i) {
+        size_t sz = (i % 17 == 5) ? 0 : (i % 13 == 3) ? 1 : 512 + (i * 37) % 3000;
+        path seg = dir / ("image." + std::string(i + 1 < 10 ? "00" : i + 1 < 100 ? "0" : "") + std::to_string(i + 1));
+        std::ofstream of(seg, std::ios::binary);
+        for (size_t k = 0; k < sz; ++k) of.put(static_cast<char>((total + k) & 0xFF));
+        total += sz;
+        sizes.push_back(sz);
+    }
+
+    DiskIO d;
+    ASSERT_TRUE(d.open((dir / "image.001").string().c_str())) << d.last_error();
+    // 整体读取（跨越全部分段边界）
+    std::vector<unsigned char> all(total + 50);
+    ASSERT_EQ(d.read_at(0, all.data(), all.size()), (ssize_t)total);
+    for (size_t i = 0; i < total; ++i) ASSERT_EQ(all[i], (unsigned char)(i & 0xFF)) << i;
+    ASSERT_EQ(d.read_at(total, all.data(), 10), 0);
+
+    // 多线程随机读取：句柄池在并发淘汰下保持正确
+    std::atomic<int> bad{0};
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 8; ++t) {
+        ts.emplace_back([&, t] {
+            unsigned char buf[4000];
+            for (int i = 0; i < 1500; ++i) {
+                uint64_t off = (static_cast<uint64_t>(i) * 104729u + t * 7919u) % (total - sizeof(buf));
+                if (d.read_at(off, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) { bad++; continue; }
+                for (size_t k = 0; k < sizeof(buf); ++k) {
+                    if (buf[k] != (unsigned char)((off + k) & 0xFF)) { bad++; break; }
+                }
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(bad.load(), 0);
+    d.close();
+
+    // 从中间编号打开只包含其后的分段；OPEN_RAW 只读取单个分段
+    ASSERT_TRUE(d.open((dir / "image.300").string().c_str()));
+    unsigned char b[8];
+    EXPECT_EQ(d.read_at(0, b, sizeof(b)), (ssize_t)std::min<size_t>(sizes.back(), sizeof(b)));
+    ASSERT_TRUE(d.open((dir / "image.002").string().c_str(), DiskIO::OPEN_RAW));
+    EXPECT_EQ(d.read_at(0, all.data(), all.size()), (ssize_t)sizes[1]);
+    d.close();
+    std::error_code ec;
+    remove_all(dir, ec);
+}
+
+TEST(DiskIOSegmented, MissingOrTruncatedSegmentFailsRead) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path dir = temp_directory_path() / ("filerecover-segerr-" + suffix);
+    create_directories(dir);
+    const size_t SEG = 4096;
+    for (int i = 0; i < 3; ++i) {
+        std::ofstream of(dir / ("image.00" + std::to_string(i + 1)), std::ios::binary);
+        for (size_t k = 0; k < SEG; ++k) of.put(static_cast<char>((i * SEG + k) & 0xFF));
+    }
+    std::vector<unsigned char> buf(3 * SEG);
+
+    // 中间分段在打开镜像后被截断：跨越它的读取报错，而不是返回短读（EOF）
+    DiskIO d;
+    ASSERT_TRUE(d.open((dir / "image.001").string().c_str()));
+    ASSERT_EQ(d.read_at(0, buf.data(), buf.size()), (ssize_t)buf.size());
+    resize_file(dir / "image.002", SEG / 2);
+    EXPECT_EQ(d.read_at(0, buf.data(), buf.size()), -1);
+    EXPECT_STRNE(d.last_error(), "");
+    EXPECT_EQ(d.read_at(SEG + SEG / 2 - 100, buf.data(), 200), -1);
+    EXPECT_EQ(d.read_at(0, buf.data(), SEG), (ssize_t)SEG);
+    d.close();
+
+    // 中间分段在打开镜像后被删除：首次访问它时打开失败，整个读取报错
+    resize_file(dir / "image.002", SEG);
+    ASSERT_TRUE(d.open((dir / "image.001").string().c_str()));
+    remove(dir / "image.002");
+    EXPECT_EQ(d.read_at(0, buf.data(), buf.size()), -1);
+    EXPECT_STRNE(d.last_error(), "");
+    EXPECT_EQ(d.read_at(2 * SEG, buf.data(), SEG), (ssize_t)SEG);
+    EXPECT_EQ(buf[0], (unsigned char)((2 * SEG) & 0xFF));
+    d.close();
+
+    // 没有后续分段的 image.003 按普通镜像打开，可使用内存映射
+    ASSERT_TRUE(d.open((dir / "image.003").string().c_str(), DiskIO::OPEN_MAPPED));
+    EXPECT_TRUE(d.is_mapped());
+    EXPECT_EQ(d.read_at(0, buf.data(), buf.size()), (ssize_t)SEG);
+    d.close();
+    std::error_code ec;
+    remove_all(dir, ec);
+}
+
+TEST(DiskIOThrottle, BandwidthAndIopsLimitsAdjustableAtRuntime) {
+    auto tmp = make_pattern_file("throttle", 1 << 20);
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    unsigned char buf[4096];
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point t0) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    // 1 MiB/s：读取 256 KiB（减去约 50 ms 的突发配额）至少需要约 200 ms
+    d.set_throttle(1 << 20, 0);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 64; ++i) ASSERT_EQ(d.read_at(i * 4096, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+    EXPECT_GE(elapsed_ms(t0), 150);
+    EXPECT_GT(d.throttle_stats().delayed_reads, 0u);
+    EXPECT_EQ(buf[1], (unsigned char)((63 * 4096 + 1) & 0xFF));
+
+    // 200 IOPS：40 次读取至少约 150 ms
+    d.set_throttle(0, 200);
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 40; ++i) ASSERT_EQ(d.read_at(i, buf, 1), 1);
+    EXPECT_GE(elapsed_ms(t0), 100);
+
+    // 极低限额下被阻塞的读取，在运行时解除限速后立即返回
+    d.set_throttle(1, 0);
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        d.set_throttle(0, 0);
+    });
+    t0 = std::chrono::steady_clock::now();
+    ASSERT_EQ(d.read_at(0, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+    EXPECT_LT(elapsed_ms(t0), 5000);
+    releaser.join();
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) ASSERT_EQ(d.read_at(0, buf, sizeof(buf)), (ssize_t)sizeof(buf));
+    EXPECT_LT(elapsed_ms(t0), 1000);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOSimulated, ResilientReadsBisectInjectedBadSectors) {
+    auto tmp = make_pattern_file("sim-bad", 256 * 1024);
+    SimDeviceModel model;
+    model.bad_ranges.push_back(DiskIO::BadRange{0x3000, 0x200});
+    model.bad_ranges.push_back(DiskIO::BadRange{0x9000, 0x400});
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), model));
+    std::vector<unsigned char> buf(64 * 1024);
+    // 未启用容错时整个请求失败
+    EXPECT_EQ(d.read_at(0, buf.data(), buf.size()), -1);
+    EXPECT_EQ(d.last_error_code(), EIO);
+
+    ASSERT_TRUE(d.enable_resilient_reads());
+    ASSERT_EQ(d.read_at(0, buf.data(), buf.size()), (ssize_t)buf.size());
+    for (size_t i = 0; i < buf.size(); ++i) {
+        bool in_bad = (i >= 0x3000 && i < 0x3200) || (i >= 0x9000 && i < 0x9400);
+        ASSERT_EQ(buf[i], in_bad ? 0 : (unsigned char)(i & 0xFF)) << i;
+    }
+    std::vector<DiskIO::BadRange> bad = d.bad_ranges();
+    ASSERT_EQ(bad.size(), 2u);
+    EXPECT_EQ(bad[0].offset, 0x3000u);
+    EXPECT_EQ(bad[0].length, 0x200u);
+    EXPECT_EQ(bad[1].offset, 0x9000u);
+    EXPECT_EQ(bad[1].length, 0x400u);
+    DiskIO::ResilientStats st = d.resilient_stats();
+    EXPECT_GT(st.split_reads, 0u);
+    // 二分代价有界：远小于逐扇区读取
+    EXPECT_LT(st.split_reads, 128u);
+
+    // 已知坏区不再触发二分
+    ASSERT_EQ(d.read_at(0, buf.data(), buf.size()), (ssize_t)buf.size());
+    EXPECT_EQ(d.resilient_stats().split_reads, st.split_reads);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
+
+TEST(DiskIOSimulated, ResilientReadsSkipAheadOverDeadRegion) {
+    const size_t file_size = 4 * 1024 * 1024;
+    auto tmp = make_pattern_file("sim-dead", file_size);
+    auto map = tmp;
+    map += ".skipmap";
+    // 1 MiB 的整片失效区域
+    SimDeviceModel model;
+    model.bad_ranges.push_back(DiskIO::BadRange{1 << 20, 1 << 20});
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), model));
+    ASSERT_TRUE(d.enable_resilient_reads(map.string().c_str()));
+
+    // 请求从健康区域开始、覆盖整个失效区域：连续坏扇区后不再逐扇区二分
+    const uint64_t start = (1 << 20) - 64 * 1024;
+    std::vector<unsigned char> buf(64 * 1024 + (1 << 20) + 64 * 1024);
+    ASSERT_EQ(d.read_at(start, buf.data(), buf.size()), (ssize_t)buf.size());
+    for (size_t i = 0; i < 64 * 1024; ++i) ASSERT_EQ(buf[i], (unsigned char)((start + i) & 0xFF)) << i;
+    for (size_t i = 64 * 1024; i < 64 * 1024 + 4096; ++i) ASSERT_EQ(buf[i], 0) << i;
+    DiskIO::ResilientStats st = d.resilient_stats();
+    EXPECT_LT(st.split_reads, 64u);
+    EXPECT_GT(st.skipped_bytes, 512u * 1024u);
+    // 跳过的部分整体记为坏区，不再访问设备
+    std::vector<DiskIO::BadRange> bad = d.bad_ranges();
+    ASSERT_EQ(bad.size(), 1u);
+    EXPECT_EQ(bad[0].offset, 1u << 20);
+    EXPECT_EQ(bad[0].offset + bad[0].length, start + buf.size());
+    ASSERT_EQ(d.read_at(start, buf.data(), buf.size()), (ssize_t)buf.size());
+    EXPECT_EQ(d.resilient_stats().split_reads, st.split_reads);
+    d.close();
+
+    // 同一次读取发现的区间合并后一次写入，跳过的区间带 untried 标记
+    std::ifstream mf(map);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(mf, line);) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].find("untried"), std::string::npos);
+    EXPECT_NE(lines[1].find("untried"), std::string::npos);
+    // 带标记的跳过表可以重新载入
+    DiskIO e;
+    ASSERT_TRUE(e.open(tmp.string().c_str()));
+    ASSERT_TRUE(e.enable_resilient_reads(map.string().c_str()));
+    EXPECT_EQ(e.bad_ranges().size(), 1u);
+    e.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    std::filesystem::remove(map, ec);
+}
+
+TEST(DiskIOSimulated, SeekLatencyAndDeterministicFaults) {
+    auto tmp = make_pattern_file("sim-model", 1 << 20);
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point t0) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    };
+    unsigned char buf[4096];
+    {
+        SimDeviceModel hdd;
+        hdd.seek_us = 3000;
+        DiskIO d;
+        ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), hdd));
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10; ++i) ASSERT_EQ(d.read_at((i * 37 % 200) * 4096, buf, sizeof(buf)), 4096);
+        EXPECT_GE(elapsed_ms(t0), 30); // 每次随机访问都要寻道
+        ASSERT_EQ(buf[5], (unsigned char)((9 * 37 % 200 * 4096 + 5) & 0xFF));
+    }
+
+    // 相同 seed 下两个句柄看到完全相同的坏扇区与瞬时错误序列
+    SimDeviceModel flaky;
+    flaky.bad_sector_rate = 0.002;
+    flaky.transient_error_rate = 0.2;
+    flaky.seed = 42;
+    auto run = [&](std::vector<int>& out) {
+        DiskIO d;
+        ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), flaky));
+        for (uint64_t off = 0; off < (1 << 20); off += sizeof(buf)) {
+            out.push_back(static_cast<int>(d.read_at(off, buf, sizeof(buf))));
+        }
+    };
+    std::vector<int> a, b;
+    run(a);
+    run(b);
+    EXPECT_EQ(a, b);
+    EXPECT_GT(std::count(a.begin(), a.end(), -1), 0);
+    EXPECT_GT(std::count(a.begin(), a.end(), 4096), 0);
+
+    // 短读按扇区截断
+    SimDeviceModel usb;
+    usb.short_read_rate = 1.0;
+    DiskIO d;
+    ASSERT_TRUE(d.open_simulated(tmp.string().c_str(), usb));
+    ssize_t r = d.read_at(0, buf, sizeof(buf));
+    EXPECT_LT(r, 4096);
+    EXPECT_EQ(r % 512, 0);
+    d.close();
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+}
@@ -56,7 +56,7 @@ TEST(EngineStub, InitOpenScanCandidatesExport) {
     ASSERT_EQ(FR_OK, err);
 
     // 配置扫描参数并启动扫描（stub 会填充若干候选项）
-    fr_scan_params_t params;
+    fr_scan_params_t params = {};
     params.mode = FR_SCAN_QUICK;
     params.max_threads = 0; // 0 表示自动选择线程数
     ASSERT_EQ(FR_OK, fr_start_scan(h, &params));
@@ -71,6 +71,11 @@ TEST(EngineStub, InitOpenScanCandidatesExport) {
     }
     ASSERT_GT(found, 0);
 
+    // 读取限速可随时调整
+    EXPECT_EQ(FR_OK, fr_set_io_limits(h, 8u * 1024 * 1024, 500));
+    EXPECT_EQ(FR_OK, fr_set_io_limits(h, 0, 0));
+    EXPECT_EQ(FR_ERR_INVALID_ARG, fr_set_io_limits(nullptr, 0, 0));
+
     // 关闭句柄并释放全局资源
     fr_close(h);
     fr_shutdown();
@@ -0,0 +1,139 @@
+// ntfs_alloc_test.cpp — 验证记录视图扫描不为单条记录分配内存
+//
+// 本文件替换全局 operator new / delete 以统计堆分配次数，因此单独构建为一个测试程序，
+// 不影响其他测试所用的分配器。
+#include "ntfs_mft.h"
+#include "disk_io.h"
+#include "ntfs_test_util.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FR_NOINLINE __declspec(noinline)
+#else
+#define FR_NOINLINE __attribute__((noinline))
+#endif
+
+// 统计堆分配次数。所有形式的 new / delete 都经由下面两个函数，成对使用 malloc 与 free；
+// 两者不内联，编译器不会把内联后的 free 与 operator new 的返回值配对检查
+static std::atomic<size_t> g_heap_allocs{0};
+
+static FR_NOINLINE void* heap_alloc(size_t n, size_t align) {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (n == 0) n = 1;
+    if (align <= alignof(std::max_align_t)) return malloc(n);
+#if defined(_MSC_VER)
+    return _aligned_malloc(n, align);
+#else
+    return aligned_alloc(align, (n + align - 1) / align * align); // 长度须为对齐值的整数倍
+#endif
+}
+
+static FR_NOINLINE void heap_free(void* p, size_t align) {
+#if defined(_MSC_VER)
+    if (align > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    (void)align;
+    free(p);
+}
+
+static void* heap_alloc_or_throw(size_t n, size_t align) {
+    if (void* p = heap_alloc(n, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t n) { return heap_alloc_or_throw(n, 0); }
+void* operator new[](size_t n) { return heap_alloc_or_throw(n, 0); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return heap_alloc(n, 0); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return heap_alloc(n, 0); }
+void* operator new(size_t n, std::align_val_t a) { return heap_alloc_or_throw(n, static_cast<size_t>(a)); }
+void* operator new[](size_t n, std::align_val_t a) { return heap_alloc_or_throw(n, static_cast<size_t>(a)); }
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return heap_alloc(n, static_cast<size_t>(a)); }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return heap_alloc(n, static_cast<size_t>(a)); }
+void operator delete(void* p) noexcept { heap_free(p, 0); }
+void operator delete[](void* p) noexcept { heap_free(p, 0); }
+void operator delete(void* p, size_t) noexcept { heap_free(p, 0); }
+void operator delete[](void* p, size_t) noexcept { heap_free(p, 0); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { heap_free(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { heap_free(p, 0); }
+void operator delete(void* p, std::align_val_t a) noexcept { heap_free(p, static_cast<size_t>(a)); }
+void operator delete[](void* p, std::align_val_t a) noexcept { heap_free(p, static_cast<size_t>(a)); }
+void operator delete(void* p, size_t, std::align_val_t a) noexcept { heap_free(p, static_cast<size_t>(a)); }
+void operator delete[](void* p, size_t, std::align_val_t a) noexcept { heap_free(p, static_cast<size_t>(a)); }
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept { heap_free(p, static_cast<size_t>(a)); }
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { heap_free(p, static_cast<size_t>(a)); }
+
+// 4 KiB 簇、1 KiB 记录的卷：$MFT 分成两段（400 簇 @ LCN 100，350 簇 @ LCN 600），
+// 共 3000 条记录，每条记录都带一个非常驻 DATA
+static std::vector<uint8_t> build_volume() {
+    TestVolumeLayout layout;
+    layout.frags = { {400, 100}, {350, 600} };
+    layout.clusters = 1000;
+    layout.file_data = true;
+    return build_test_volume(layout);
+}
+
+TEST(NTFSParser, RecordViewScanWithoutPerRecordAllocations) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-alloc-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+    NTFSFileRecord mft;
+    ASSERT_TRUE(p.read_mft_record(d, p.volume().mft_offset(), mft));
+    std::vector<std::pair<uint64_t,int64_t>> mft_runs = mft.data_runs;
+    ASSERT_EQ(mft_runs.size(), 2u);
+
+    // 串行视图扫描：分配次数与记录数无关（只有块缓冲区、读取计划与每块读取请求的分配）
+    MFTScanStats st;
+    uint64_t named = 0;
+    NTFSRunList runs;
+    MFTRecordViewCallback cb = [&](const NTFSRecordView& v) {
+        char buf[64];
+        named += v.name(buf, sizeof(buf)).size() > 0;
+        v.runs(runs);
+        return true;
+    };
+    size_t before = g_heap_allocs.load();
+    ASSERT_TRUE(p.scan_mft_views(d, mft_runs, 0, cb, &st));
+    size_t allocs = g_heap_allocs.load() - before;
+    EXPECT_EQ(named, st.records);
+    EXPECT_EQ(st.records, 3000u);
+    EXPECT_LT(allocs, 32u);
+    before = g_heap_allocs.load();
+    ASSERT_TRUE(p.scan_mft_views(d, mft_runs, 0, cb, &st, 64 * 1024));
+    allocs = g_heap_allocs.load() - before;
+    EXPECT_GT(st.chunks, 40u);
+    EXPECT_LT(allocs, st.chunks * 8);
+
+    // 并行视图扫描：结果数组在块之间复用，分配次数远少于记录数
+    p.set_threads(4);
+    named = 0;
+    before = g_heap_allocs.load();
+    ASSERT_TRUE(p.scan_mft_views(d, mft_runs, 0, cb, &st, 64 * 1024));
+    allocs = g_heap_allocs.load() - before;
+    EXPECT_EQ(named, st.records);
+    EXPECT_LT(allocs, st.records / 4);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
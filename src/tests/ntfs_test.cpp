@@ -1,13 +1,21 @@
 // ntfs_test.cpp — 验证 NTFS MFT 解析骨架
 #include "ntfs_mft.h"
+#include "mft_table.h"
+#include "mft_path.h"
+#include "fr.h"
 #include "disk_io.h"
 #include "ntfs.h"
+#include "ntfs_test_util.h"
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <cstring>
 #include <string>
+#include <algorithm>
+#include <map>
+#include <thread>
 
 TEST(NTFSParser, ReadMFTRecord) {
     using namespace std::filesystem;
@@ -189,6 +197,53 @@ TEST(NTFSParser, NonResidentDataRuns) {
     remove(tmp, ec);
 }
 
+TEST(NTFSParser, NamedStreamDoesNotReplaceData) {
+    // 未命名的非常驻 DATA 之后跟着常驻的命名流 Zone.Identifier（下载的文件常见）
+    std::vector<uint8_t> rec(1024, 0);
+    auto put = [&](size_t off, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) rec[off + i] = (v >> (8 * i)) & 0xFF; };
+    memcpy(rec.data(), "FILE", 4);
+    put(20, 56, 2);
+    put(22, 0x01, 2);
+    size_t a = 56;
+    put(a + 0, 0x80, 4);
+    put(a + 4, 72, 4);
+    rec[a + 8] = 1;
+    put(a + 32, 64, 2);
+    put(a + 48, 12345, 8);
+    const uint8_t runs[] = { 0x11, 0x04, 0x20, 0x00 };
+    memcpy(&rec[a + 64], runs, sizeof(runs));
+    a += 72;
+    const std::string ads = "Zone.Identifier";
+    put(a + 0, 0x80, 4);
+    put(a + 4, 24 + 32 + 32, 4);
+    rec[a + 9] = static_cast<uint8_t>(ads.size());
+    put(a + 10, 24, 2);
+    for (size_t k = 0; k < ads.size(); ++k) rec[a + 24 + 2 * k] = ads[k];
+    put(a + 16, 26, 4);
+    put(a + 20, 56, 2);
+    a += 88;
+    // 长度不足非常驻属性头的未命名 DATA 被忽略
+    put(a + 0, 0x80, 4);
+    put(a + 4, 40, 4);
+    rec[a + 8] = 1;
+    put(a + 32, 24, 2);
+    a += 40;
+    put(a, 0xFFFFFFFF, 4);
+
+    NTFSRecordView view;
+    ASSERT_TRUE(view.reset(rec.data(), rec.size(), 40, false));
+    EXPECT_TRUE(view.has_runlist());
+    EXPECT_EQ(view.data_size(), 12345u);
+    NTFSFileRecord r;
+    view.materialize(r);
+    EXPECT_EQ(r.size, 12345u);
+    EXPECT_EQ(r.data_runs, (std::vector<std::pair<uint64_t,int64_t>>{ {4, 0x20} }));
+    MFTTable t;
+    t.append(view);
+    EXPECT_EQ(t.file_size(0), 12345u);
+    EXPECT_EQ(t.runs(0).size(), 1u);
+}
+
 TEST(NTFSParser, CApiExtractDataRuns) {
     using namespace std::filesystem;
     auto tmpdir = temp_directory_path();
@@ -366,6 +421,171 @@ TEST(NTFSParser, ReadFileRangeFromRuns) {
     remove(tmp, ec);
 }
 
+TEST(NTFSParser, RunIndexRangeLookup) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-runindex-") + suffix + std::string(".bin"));
+    const uint64_t bpc = 512;
+    uint32_t seed = 5;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    // 碎片化文件：区段长 0..4 簇，约 1/8 稀疏，在磁盘上倒序排列（偏移为负）。
+    // 每个簇写入其在文件中的 32 位字偏移，读出后可逐字校验
+    NTFSFileRecord rec{};
+    int64_t lcn = 4000;
+    for (int i = 0; i < 600; ++i) {
+        uint64_t count = rnd() % 5;
+        if (rnd() % 8 == 0) {
+            rec.data_runs.emplace_back(count, -1);
+            continue;
+        }
+        lcn -= static_cast<int64_t>(count) + 1;
+        rec.data_runs.emplace_back(count, lcn);
+    }
+    ASSERT_GT(lcn, 0);
+    std::vector<uint8_t> img(4000 * bpc, 0);
+    uint64_t file_bytes = 0;
+    for (const auto& r : rec.data_runs) {
+        for (uint64_t c = 0; c < r.first; ++c, file_bytes += bpc) {
+            if (r.second == -1) continue;
+            for (uint64_t w = 0; w < bpc; w += 4) {
+                uint32_t v = static_cast<uint32_t>((file_bytes + w) / 4) | 0x80000000u;
+                memcpy(img.data() + (r.second + c) * bpc + w, &v, 4);
+            }
+        }
+    }
+    {
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    auto linear = [&](uint64_t off, size_t len, std::vector<std::pair<uint64_t,size_t>>& out) {
+        out.clear();
+        uint64_t cursor = 0;
+        for (const auto& r : rec.data_runs) {
+            uint64_t run_bytes = r.first * bpc;
+            if (off >= cursor + run_bytes) {
+                cursor += run_bytes;
+                continue;
+            }
+            uint64_t take = std::min<uint64_t>(run_bytes - (off - cursor), len);
+            if (r.second != -1) out.emplace_back(r.second * bpc + (off - cursor), take);
+            len -= take;
+            off += take;
+            cursor += run_bytes;
+            if (len == 0) break;
+        }
+        return len == 0;
+    };
+
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    std::vector<std::pair<uint64_t,size_t>> got, want;
+    std::vector<uint8_t> buf;
+    for (int i = 0; i < 500; ++i) {
+        uint64_t off = rnd() % (file_bytes + 1024);
+        size_t len = rnd() % 8192;
+        bool ok = linear(off, len, want);
+        ASSERT_EQ(p.map_file_range(rec, off, len, bpc, got), ok || len == 0) << "off " << off;
+        if (len != 0) {
+            EXPECT_EQ(got, want) << "off " << off << " len " << len;
+        }
+        // 读出的内容：非稀疏部分为文件偏移标记，稀疏部分与文件末尾之后为 0
+        off &= ~3ULL;
+        len &= ~static_cast<size_t>(3);
+        ASSERT_TRUE(p.read_file_range(d, rec, off, len, buf, bpc));
+        for (size_t w = 0; w < len; w += 4) {
+            uint32_t v;
+            memcpy(&v, buf.data() + w, 4);
+            uint32_t mark = static_cast<uint32_t>((off + w) / 4) | 0x80000000u;
+            ASSERT_TRUE(v == mark || v == 0) << "off " << off + w;
+        }
+    }
+    ASSERT_NE(rec.run_index, nullptr);
+    EXPECT_EQ(rec.run_index->size(), rec.data_runs.size());
+
+    // 追加区段后索引过期并重建
+    const size_t runs_before = rec.data_runs.size();
+    rec.data_runs.emplace_back(2, 1);
+    ASSERT_TRUE(p.map_file_range(rec, file_bytes, 2 * bpc, bpc, got));
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0], std::make_pair(uint64_t(bpc), size_t(2 * bpc)));
+    EXPECT_EQ(rec.run_index->size(), runs_before + 1);
+    EXPECT_EQ(rec.run_index->find(rec.run_index->total_clusters()), rec.run_index->size());
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, ReadFileRangeCoalescesExtents) {
+    // 规划：排序、首尾相接合并、跨越小间隔、上限截断、重叠
+    std::vector<NTFSExtent> ext = {
+        { 8192, 0, 1024 }, { 0, 1024, 512 }, { 512, 1536, 512 }, { 1024 + 100, 2048, 100 },
+        { 1 << 20, 2148, 4096 }, { (1 << 20) + 1024, 6244, 64 },
+    };
+    std::vector<NTFSExtentRead> reads;
+    ASSERT_EQ(coalesce_extents(ext, 0, 1 << 20, reads), 4u);
+    EXPECT_EQ(ext[0].disk_offset, 0u);
+    EXPECT_EQ(reads[0].disk_offset, 0u);
+    EXPECT_EQ(reads[0].size, 1024u);
+    EXPECT_EQ(reads[0].count, 2u);
+    EXPECT_EQ(reads[1].disk_offset, 1124u);
+    EXPECT_EQ(reads[3].count, 2u); // 重叠区间并入
+    EXPECT_EQ(reads[3].size, 4096u);
+    ASSERT_EQ(coalesce_extents(ext, 8192, 1 << 20, reads), 2u);
+    EXPECT_EQ(reads[0].size, 8192u + 1024u);
+    EXPECT_EQ(reads[0].count, 4u);
+    ASSERT_EQ(coalesce_extents(ext, 8192, 4096, reads), 3u); // 上限把 8192 处的区间分出
+    EXPECT_EQ(reads[0].size, 1224u);
+
+    // 读取：64 个单簇区段按打乱的顺序隔簇存放，中间的簇属于“其他文件”
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-coalesce-") + suffix + std::string(".bin"));
+    const uint64_t bpc = 512;
+    std::vector<uint8_t> img(400 * bpc, 0xEE);
+    std::vector<size_t> slot(64);
+    for (size_t i = 0; i < slot.size(); ++i) slot[i] = (i * 37) % 64;
+    NTFSFileRecord rec{};
+    for (size_t i = 0; i < slot.size(); ++i) {
+        if (i == 20) rec.data_runs.emplace_back(1, -1);
+        uint64_t lcn = 100 + slot[i] * 2;
+        rec.data_runs.emplace_back(1, static_cast<int64_t>(lcn));
+        for (uint64_t b = 0; b < bpc; ++b) img[lcn * bpc + b] = static_cast<uint8_t>(i * 7 + b / 64);
+    }
+    {
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    std::vector<uint8_t> want;
+    for (size_t i = 0; i < slot.size(); ++i) {
+        if (i == 20) want.insert(want.end(), bpc, 0);
+        for (uint64_t b = 0; b < bpc; ++b) want.push_back(static_cast<uint8_t>(i * 7 + b / 64));
+    }
+    want.insert(want.end(), 300, 0); // 文件末尾之后
+
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    const uint64_t gaps[] = { 0, bpc, NTFS_READ_DEFAULT_GAP };
+    for (uint64_t gap : gaps) {
+        p.set_read_coalescing(gap, gap == bpc ? 8 * bpc : NTFS_READ_DEFAULT_MAX);
+        std::vector<uint8_t> out;
+        ASSERT_TRUE(p.read_file_range(d, rec, 0, want.size(), out, bpc)) << "gap " << gap;
+        EXPECT_EQ(out, want) << "gap " << gap;
+        ASSERT_TRUE(p.read_file_range(d, rec, 700, 9000, out, bpc));
+        EXPECT_TRUE(std::equal(out.begin(), out.end(), want.begin() + 700)) << "gap " << gap;
+    }
+    EXPECT_EQ(p.read_gap(), NTFS_READ_DEFAULT_GAP);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
 TEST(NTFSParser, ComplexDataRunsWithSparseAndNegativeDelta) {
     using namespace std::filesystem;
     auto tmpdir = temp_directory_path();
@@ -486,8 +706,8 @@ TEST(NTFSParser, DataRunsFromBaseRecord) {
 
         // leading record at offset 0 references base record
         data[0] = 'F'; data[1] = 'I'; data[2] = 'L'; data[3] = 'E';
-        // write base_record at offset 32 (little-endian)
-        uint64_t base_ref = static_cast<uint64_t>(base);
+        // base_record (offset 32) is a file reference: record number 1, sequence 1
+        uint64_t base_ref = (1ULL << 48) | 1;
         for (int i = 0; i < 8; ++i) data[32 + i] = static_cast<uint8_t>((base_ref >> (8*i)) & 0xFF);
         data[20] = 48; data[21] = 0; // attribute offset (no DATA here)
 
@@ -507,6 +727,1621 @@ TEST(NTFSParser, DataRunsFromBaseRecord) {
     std::error_code ec;
     remove(tmp, ec);
 }
+
+TEST(NTFSParser, UsaFixupsBatch) {
+    const size_t REC = 1024;
+    std::vector<uint8_t> buf(6 * REC, 0);
+    for (size_t r = 0; r < 6; ++r) {
+        for (size_t i = 0; i < REC; ++i) buf[r * REC + i] = static_cast<uint8_t>(i * 13 + r);
+        if (r != 3) memcpy(&buf[r * REC], "FILE", 4);
+        buf[r * REC + 6] = 0; buf[r * REC + 7] = 0;
+    }
+    const std::vector<uint8_t> orig = buf;
+    protect_record(&buf[0], REC, 48, 0x0102);
+    protect_record(&buf[REC], REC, 48, 0x0304);
+    buf[REC + 1022] ^= 0xFF;                   // 记录 1：第二个扇区写入中断
+    protect_record(&buf[2 * REC], REC, 48, 7);
+    buf[2 * REC + 6] = 5;                      // 记录 2：USA 项数与记录大小不符
+    protect_record(&buf[5 * REC], REC, 48, 0xFFFF);
+    const std::vector<uint8_t> protected_buf = buf;
+
+    uint8_t st[6];
+    EXPECT_EQ(apply_usa_fixups(buf.data(), 6, REC, st), 2u);
+    EXPECT_EQ(st[0], MFT_FIXUP_OK);
+    EXPECT_EQ(st[1], MFT_FIXUP_TORN);
+    EXPECT_EQ(st[2], MFT_FIXUP_BAD_USA);
+    EXPECT_EQ(st[3], MFT_FIXUP_ABSENT); // 不是 FILE 记录
+    EXPECT_EQ(st[4], MFT_FIXUP_ABSENT); // 没有 USA
+    EXPECT_EQ(st[5], MFT_FIXUP_OK);
+    // 修正后扇区末尾恢复原值（USA 本身所在区域除外）；失败的记录保持原样
+    for (size_t r : { 0, 5 }) {
+        EXPECT_EQ(buf[r * REC + 510], orig[r * REC + 510]);
+        EXPECT_EQ(buf[r * REC + 1023], orig[r * REC + 1023]);
+        EXPECT_TRUE(std::equal(buf.begin() + r * REC + 64, buf.begin() + (r + 1) * REC, orig.begin() + r * REC + 64));
+    }
+    EXPECT_TRUE(std::equal(buf.begin() + REC, buf.begin() + 5 * REC, protected_buf.begin() + REC));
+
+    // 跨越多个内部批次的大缓冲区（4 KiB 记录，每条 8 个扇区），每 7 条有一条损坏
+    const size_t BIG = 4096, N = 300;
+    std::vector<uint8_t> big(N * BIG);
+    for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+    const std::vector<uint8_t> big_orig = big;
+    for (size_t r = 0; r < N; ++r) {
+        memcpy(&big[r * BIG], "FILE", 4);
+        protect_record(&big[r * BIG], BIG, 48, static_cast<uint16_t>(r + 1));
+        if (r % 7 == 3) big[r * BIG + 5 * 512 + 511] ^= 0x40;
+    }
+    std::vector<uint8_t> big_st(N);
+    EXPECT_EQ(apply_usa_fixups(big.data(), N, BIG, big_st.data()), (N + 3) / 7);
+    for (size_t r = 0; r < N; ++r) {
+        ASSERT_EQ(big_st[r], r % 7 == 3 ? MFT_FIXUP_TORN : MFT_FIXUP_OK) << r;
+        if (r % 7 != 3) {
+            for (size_t sct = 0; sct < 8; ++sct) {
+                size_t off = r * BIG + sct * 512 + 510;
+                ASSERT_EQ(big[off], big_orig[off]);
+                ASSERT_EQ(big[off + 1], big_orig[off + 1]);
+            }
+        }
+    }
+}
+
+TEST(NTFSParser, ScanFragmentedMFT) {
+    using namespace std::filesystem;
+    auto tmpdir = temp_directory_path();
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = tmpdir / (std::string("filerecover-mft-scan-") + suffix + std::string(".bin"));
+    // 512 字节簇、1024 字节记录；$MFT 分成三段：3 簇 @ LCN 10，5 簇 @ LCN 40，4 簇 @ LCN 20，
+    // 共 6 条记录。记录 1 跨越第一、二段的边界，记录 3 为空槽。
+    const uint64_t CLUSTER = 512;
+    const size_t REC = 1024;
+    const uint64_t frags[3][2] = { {3, 10}, {5, 40}, {4, 20} };
+    std::vector<uint8_t> mft(12 * CLUSTER, 0); // $MFT 的逻辑内容（按记录号排列）
+    auto write_u32 = [&](size_t off, uint32_t v){ for(int i=0;i<4;++i) mft[off+i] = (v>>(8*i)) & 0xFF; };
+    auto write_u16 = [&](size_t off, uint16_t v){ mft[off+0]=v&0xFF; mft[off+1]=(v>>8)&0xFF; };
+    auto write_u64 = [&](size_t off, uint64_t v){ for(int i=0;i<8;++i) mft[off+i] = (v>>(8*i)) & 0xFF; };
+    auto write_record = [&](size_t rec_no, size_t attr_off, const std::string& name) {
+        size_t r = rec_no * REC;
+        memcpy(&mft[r], "FILE", 4);
+        write_u16(r + 20, static_cast<uint16_t>(attr_off));
+        write_u16(r + 22, 0x01); // in use
+        size_t f = r + attr_off;
+        write_u32(f + 0, 0x30); // FILE_NAME
+        write_u32(f + 4, 0x70);
+        write_u32(f + 16, static_cast<uint32_t>(66 + name.size() * 2));
+        write_u16(f + 20, 24);
+        write_u64(f + 24, 5); // parent reference
+        mft[f + 24 + 64] = static_cast<uint8_t>(name.size());
+        for (size_t i = 0; i < name.size(); ++i) mft[f + 24 + 66 + i * 2] = name[i];
+        write_u32(f + 0x70, 0xFFFFFFFF);
+        return f + 0x70;
+    };
+    // 记录 0：$MFT 自身，在 FILE_NAME 之后放置非常驻 DATA 属性描述上述三段
+    size_t a = write_record(0, 48, "$MFT");
+    write_u32(a + 0, 0x80);
+    write_u32(a + 4, 80);
+    mft[a + 8] = 1;
+    write_u16(a + 32, 64);
+    write_u64(a + 48, mft.size());
+    const uint8_t runlist[] = { 0x11, 0x03, 0x0A, 0x11, 0x05, 0x1E, 0x11, 0x04, 0xEC, 0x00 };
+    memcpy(&mft[a + 64], runlist, sizeof(runlist));
+    write_u32(a + 80, 0xFFFFFFFF);
+    // 记录 1 的文件名跨越 512 字节处的碎片边界
+    write_record(1, 420, "split.txt");
+    write_record(2, 48, "f2");
+    write_record(4, 48, "f4");
+    write_record(5, 48, "f5");
+    // 加上 USA 保护：记录 1 的文件名首字符位于扇区末尾，未修正时会被序列号覆盖；
+    // 记录 5 的第二个扇区写入中断
+    for (size_t r : { 0, 1, 2, 4, 5 }) protect_record(&mft[r * REC], REC, 42, static_cast<uint16_t>(0x0100 + r));
+    mft[5 * REC + 1022] ^= 0xFF;
+    {
+        std::vector<uint8_t> disk(48 * CLUSTER, 0xEE);
+        uint64_t file_off = 0;
+        for (const auto& fr : frags) {
+            memcpy(&disk[fr[1] * CLUSTER], &mft[file_off], fr[0] * CLUSTER);
+            file_off += fr[0] * CLUSTER;
+        }
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(disk.data()), disk.size());
+    }
+
+    const std::vector<std::string> expect_names = { "$MFT", "split.txt", "f2", "f4", "f5" };
+    const std::vector<uint64_t> expect_ids = { 0, 1, 2, 4, 5 };
+    for (uint32_t flags : { static_cast<uint32_t>(DiskIO::OPEN_DEFAULT), static_cast<uint32_t>(DiskIO::OPEN_MAPPED) }) {
+        DiskIO d;
+        ASSERT_TRUE(d.open(tmp.string().c_str(), flags));
+        NTFSParser p;
+        NTFSVolume vol;
+        vol.cluster_size = CLUSTER;
+        vol.mft_record_size = REC;
+        vol.mft_lcn = 10;
+        p.set_volume(vol);
+        // 从 $MFT 记录自身读取 runlist 驱动扫描
+        std::vector<uint64_t> ids;
+        std::vector<std::string> names;
+        MFTScanStats st;
+        ASSERT_TRUE(p.scan_mft(d, [&](const NTFSFileRecord& r) {
+            ids.push_back(r.id);
+            names.push_back(r.name);
+            EXPECT_EQ(r.flags, 0x01);
+            EXPECT_EQ(r.torn, r.id == 5);
+            return true;
+        }, &st));
+        EXPECT_EQ(ids, expect_ids);
+        EXPECT_EQ(names, expect_names);
+        EXPECT_EQ(st.records, 5u);
+        EXPECT_EQ(st.skipped, 1u);
+        EXPECT_EQ(st.torn, 1u);
+        EXPECT_EQ(st.bytes_read, mft.size());
+        EXPECT_EQ(st.chunks, 3u);
+
+        // 小块读取：每块 1 KiB，记录 1 仍跨块拼接；回调返回 false 时提前结束
+        std::vector<std::pair<uint64_t,int64_t>> runs = { {3, 10}, {5, 40}, {4, 20} };
+        std::vector<NTFSFileRecord> got;
+        ASSERT_TRUE(p.scan_mft(d, runs, 0, [&](const NTFSFileRecord& r) {
+            got.push_back(r);
+            return got.size() < 3;
+        }, &st, 1024));
+        ASSERT_EQ(got.size(), 3u);
+        EXPECT_EQ(got[1].name, "split.txt");
+        EXPECT_EQ(got[1].parent_reference, 5u);
+        EXPECT_EQ(got[0].data_runs, runs);
+        EXPECT_EQ(got[2].id, 2u);
+        EXPECT_TRUE(got[2].data_runs.empty());
+    }
+
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, VolumeGeometryFromBootSector) {
+    using namespace std::filesystem;
+    std::vector<uint8_t> img;
+    auto write_u16 = [&](size_t off, uint16_t v){ img[off+0]=v&0xFF; img[off+1]=(v>>8)&0xFF; };
+    auto write_u32 = [&](size_t off, uint32_t v){ for(int i=0;i<4;++i) img[off+i] = (v>>(8*i)) & 0xFF; };
+    auto write_u64 = [&](size_t off, uint64_t v){ for(int i=0;i<8;++i) img[off+i] = (v>>(8*i)) & 0xFF; };
+    auto write_boot = [&](size_t b, uint16_t bps, uint8_t spc, uint64_t total, uint64_t mft_lcn,
+                          uint64_t mirr_lcn, uint8_t rec, uint8_t idx) {
+        memcpy(&img[b + 3], "NTFS    ", 8);
+        write_u16(b + 0x0B, bps);
+        img[b + 0x0D] = spc;
+        write_u64(b + 0x28, total);
+        write_u64(b + 0x30, mft_lcn);
+        write_u64(b + 0x38, mirr_lcn);
+        img[b + 0x40] = rec;
+        img[b + 0x44] = idx;
+        write_u64(b + 0x48, 0x1234ABCDULL);
+        img[b + 510] = 0x55; img[b + 511] = 0xAA;
+    };
+
+    // 常见格式：512 字节扇区、每簇 8 扇区、记录大小编码为 -10（1 KiB）
+    img.assign(512, 0);
+    write_boot(0, 512, 8, 0x1000000, 0x800, 2, 0xF6, 1);
+    NTFSVolume v;
+    ASSERT_TRUE(parse_ntfs_boot_sector(img.data(), img.size(), v));
+    EXPECT_EQ(v.bytes_per_sector, 512u);
+    EXPECT_EQ(v.cluster_size, 4096u);
+    EXPECT_EQ(v.mft_record_size, 1024u);
+    EXPECT_EQ(v.index_record_size, 4096u);
+    EXPECT_EQ(v.mft_lcn, 0x800u);
+    EXPECT_EQ(v.mft_offset(), 0x800ULL * 4096);
+    EXPECT_EQ(v.serial_number, 0x1234ABCDULL);
+    // 超大簇编码：0xF4 表示每簇 2^12 个扇区
+    img[0x0D] = 0xF4;
+    ASSERT_TRUE(parse_ntfs_boot_sector(img.data(), img.size(), v));
+    EXPECT_EQ(v.cluster_size, 2u * 1024 * 1024);
+    // 损坏的引导扇区
+    img[0x0D] = 8;
+    img[0x0B] = 0x58; // 每扇区 600 字节
+    EXPECT_FALSE(parse_ntfs_boot_sector(img.data(), img.size(), v));
+    write_u16(0x0B, 512);
+    img[511] = 0;
+    EXPECT_FALSE(parse_ntfs_boot_sector(img.data(), img.size(), v));
+
+    // 4K-native 卷，位于镜像偏移 8 KiB 处：4 KiB 扇区/簇/记录。
+    // $MFT：2 簇 @ LCN 4，1 簇 @ LCN 10；记录 1 的数据位于 LCN 12。
+    const size_t VOL = 8192, CL = 4096;
+    img.assign(VOL + 32 * CL, 0);
+    write_boot(VOL, 4096, 1, 32, 4, 1, 0xF4, 1);
+    auto rec_pos = [&](size_t rec_no) { return VOL + (rec_no < 2 ? 4 * CL + rec_no * CL : 10 * CL); };
+    auto write_record = [&](size_t rec_no, size_t attr_off, const std::string& name) {
+        size_t r = rec_pos(rec_no);
+        memcpy(&img[r], "FILE", 4);
+        write_u16(r + 20, static_cast<uint16_t>(attr_off));
+        write_u16(r + 22, 0x01);
+        size_t f = r + attr_off;
+        write_u32(f + 0, 0x30);
+        write_u32(f + 4, 0x70);
+        write_u32(f + 16, static_cast<uint32_t>(66 + name.size() * 2));
+        write_u16(f + 20, 24);
+        img[f + 24 + 64] = static_cast<uint8_t>(name.size());
+        for (size_t i = 0; i < name.size(); ++i) img[f + 24 + 66 + i * 2] = name[i];
+        write_u32(f + 0x70, 0xFFFFFFFF);
+        return f + 0x70;
+    };
+    auto write_data_attr = [&](size_t a, uint64_t real_size, const std::vector<uint8_t>& runlist) {
+        write_u32(a + 0, 0x80);
+        write_u32(a + 4, 80);
+        img[a + 8] = 1;
+        write_u16(a + 32, 64);
+        write_u64(a + 48, real_size);
+        memcpy(&img[a + 64], runlist.data(), runlist.size());
+        write_u32(a + 80, 0xFFFFFFFF);
+    };
+    write_data_attr(write_record(0, 56, "$MFT"), 3 * CL, { 0x11, 0x02, 0x04, 0x11, 0x01, 0x06, 0x00 });
+    // 属性位于 1 KiB 之后：只有按 4 KiB 记录解析才能看到
+    write_data_attr(write_record(1, 2048, "user.dat"), 5000, { 0x11, 0x02, 0x0C, 0x00 });
+    write_record(2, 56, "last.txt");
+    for (size_t i = 0; i < 2 * CL; ++i) img[VOL + 12 * CL + i] = static_cast<uint8_t>(i * 7);
+
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-vol4k-") + suffix + std::string(".bin"));
+    {
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    EXPECT_FALSE(p.open_volume(d, 0)); // 卷起始处才有引导扇区
+    ASSERT_TRUE(p.open_volume(d, VOL));
+    EXPECT_EQ(p.volume().bytes_per_sector, 4096u);
+    EXPECT_EQ(p.volume().cluster_size, 4096u);
+    EXPECT_EQ(p.volume().mft_record_size, 4096u);
+    EXPECT_EQ(p.volume().mft_offset(), VOL + 4 * CL);
+    EXPECT_EQ(p.volume().mftmirr_offset(), VOL + CL);
+
+    std::vector<NTFSFileRecord> recs;
+    MFTScanStats st;
+    ASSERT_TRUE(p.scan_mft(d, [&](const NTFSFileRecord& r) {
+        recs.push_back(r);
+        return true;
+    }, &st));
+    ASSERT_EQ(recs.size(), 3u);
+    EXPECT_EQ(recs[1].name, "user.dat");
+    EXPECT_EQ(recs[1].size, 5000u);
+    EXPECT_EQ(recs[2].name, "last.txt");
+    EXPECT_EQ(recs[2].id, 2u);
+    EXPECT_EQ(st.bytes_read, 3u * CL);
+
+    // 文件数据的簇号按卷几何换算（含卷起始偏移），调用方无需提供簇大小
+    std::vector<std::pair<uint64_t,size_t>> spans;
+    ASSERT_TRUE(p.map_file_range(recs[1], 100, 5000, spans));
+    ASSERT_EQ(spans.size(), 1u);
+    EXPECT_EQ(spans[0].first, VOL + 12 * CL + 100);
+    std::vector<uint8_t> data;
+    ASSERT_TRUE(p.read_file_range(d, recs[1], 0, 5000, data));
+    for (size_t i = 0; i < data.size(); ++i) ASSERT_EQ(data[i], static_cast<uint8_t>(i * 7)) << i;
+
+    NTFSFileRecord r1;
+    ASSERT_TRUE(p.read_mft_record(d, rec_pos(1), r1));
+    EXPECT_EQ(r1.name, "user.dat");
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+// 4 KiB 簇、1 KiB 记录的 NTFS 卷镜像：$MFT 分成三段（300 簇 @ LCN 100，200 簇 @ LCN 1000，
+// 250 簇 @ LCN 500），共 3000 条记录，带空槽位、写入中断的记录与 docs 目录（见 TestVolumeLayout）
+static std::vector<uint8_t> build_fragmented_volume() {
+    TestVolumeLayout layout;
+    layout.frags = { {300, 100}, {200, 1000}, {250, 500} };
+    layout.clusters = 1200;
+    layout.damaged = true;
+    layout.directories = true;
+    return build_test_volume(layout);
+}
+
+TEST(NTFSParser, ParallelScanKeepsRecordOrder) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-par-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_fragmented_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+
+    struct Seen {
+        uint64_t id;
+        std::string name;
+        bool torn;
+        bool operator==(const Seen& o) const { return id == o.id && name == o.name && torn == o.torn; }
+    };
+    auto run = [&](size_t threads, size_t chunk, std::vector<Seen>& out, MFTScanStats& st) {
+        p.set_threads(threads);
+        std::vector<std::pair<uint64_t,int64_t>> runs = { {300, 100}, {200, 1000}, {250, 500} };
+        return p.scan_mft(d, runs, 0, [&](const NTFSFileRecord& r) {
+            out.push_back(Seen{ r.id, r.name, r.torn });
+            return true;
+        }, &st, chunk);
+    };
+    std::vector<Seen> serial, parallel;
+    MFTScanStats s1, s2;
+    ASSERT_TRUE(run(1, MFT_SCAN_DEFAULT_CHUNK, serial, s1));
+    // 64 KiB 的块：多个块同时在途，验证跨块重排
+    ASSERT_TRUE(run(4, 64 * 1024, parallel, s2));
+    EXPECT_EQ(serial.size(), 3000u - 3000 / 97);
+    EXPECT_TRUE(serial == parallel);
+    EXPECT_EQ(s2.records, s1.records);
+    EXPECT_EQ(s2.skipped, 3000u / 97);
+    EXPECT_EQ(s2.torn, s1.torn);
+    EXPECT_GT(s1.torn, 0u);
+    EXPECT_EQ(s2.bytes_read, 3000u * 1024);
+    for (size_t i = 1; i < parallel.size(); ++i) ASSERT_LT(parallel[i - 1].id, parallel[i].id);
+
+    // 并行扫描中途停止：回调恰好执行到返回 false 的那一次
+    p.set_threads(0);
+    size_t calls = 0;
+    ASSERT_TRUE(p.scan_mft(d, [&](const NTFSFileRecord&) { return ++calls < 1000; }));
+    EXPECT_EQ(calls, 1000u);
+
+    // C API：按记录号顺序返回真实记录；中途关闭不会阻塞
+    char err[128] = {0};
+    ntfs_parser_t h = ntfs_open_ex(tmp.string().c_str(), 0, 4, err, sizeof(err));
+    ASSERT_NE(nullptr, h);
+    ntfs_file_record_t rec;
+    size_t count = 0;
+    uint64_t prev = 0;
+    while (ntfs_next_record(h, &rec) == 0) {
+        if (count > 0) {
+            ASSERT_GT(rec.file_reference, prev);
+        }
+        ASSERT_EQ(std::string(rec.file_name), serial[count].name);
+        prev = rec.file_reference;
+        ++count;
+    }
+    EXPECT_EQ(count, serial.size());
+    ntfs_close(h);
+    h = ntfs_open(tmp.string().c_str(), err, sizeof(err));
+    ASSERT_NE(nullptr, h);
+    ASSERT_EQ(ntfs_next_record(h, &rec), 0);
+    EXPECT_EQ(std::string(rec.file_name), "$MFT");
+    ntfs_close(h);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, SerialScanIgnoresOtherSubmits) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-sub-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_fragmented_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+
+    // 记录回调在同一句柄上提交一个无关请求，其完成回调一直阻塞到扫描结束（最多 5 秒），
+    // 模拟一个很慢的无关读取。串行扫描只等待自己的块：扫描先于该请求完成。
+    struct Blocker {
+        std::atomic<bool> scan_done{false};
+        std::atomic<bool> released_early{false};
+    } blocker;
+    unsigned char extra[512];
+    DiskIO::ReadRequest req;
+    req.offset = 0;
+    req.buf = extra;
+    req.size = sizeof(extra);
+    bool submitted = false;
+    std::vector<std::pair<uint64_t,int64_t>> runs = { {300, 100}, {200, 1000}, {250, 500} };
+    MFTScanStats st;
+    ASSERT_TRUE(p.scan_mft(d, runs, 0, [&](const NTFSFileRecord&) {
+        if (!submitted) {
+            submitted = d.submit(&req, 1, [](DiskIO::ReadRequest&, void* u) {
+                Blocker* b = static_cast<Blocker*>(u);
+                auto t0 = std::chrono::steady_clock::now();
+                while (!b->scan_done.load() && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(5)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                if (!b->scan_done.load()) b->released_early = true;
+            }, &blocker);
+        }
+        return true;
+    }, &st, 64 * 1024));
+    blocker.scan_done = true;
+    d.wait_all();
+    EXPECT_TRUE(submitted);
+    EXPECT_FALSE(blocker.released_early.load());
+    EXPECT_GT(st.chunks, 40u);
+    EXPECT_EQ(req.result, (ssize_t)sizeof(extra));
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, RecordViewScanMatchesRecords) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-view-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_fragmented_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+
+    // 视图与解码后的记录逐字段一致
+    std::vector<NTFSFileRecord> recs;
+    ASSERT_TRUE(p.scan_mft(d, [&](const NTFSFileRecord& r) { recs.push_back(r); return true; }));
+    size_t idx = 0;
+    bool same = true;
+    NTFSRunList runs;
+    ASSERT_TRUE(p.scan_mft_views(d, [&](const NTFSRecordView& v) {
+        const NTFSFileRecord& r = recs[idx++];
+        char buf[256];
+        NTFSFileRecord m;
+        v.materialize(m);
+        v.runs(runs);
+        same = same && v.id() == r.id && v.name(buf, sizeof(buf)) == r.name && v.torn() == r.torn &&
+               v.data_size() == r.size && v.parent_reference() == r.parent_reference &&
+               v.flags() == r.flags && m.name == r.name && m.data_runs == r.data_runs &&
+               std::vector<std::pair<uint64_t,int64_t>>(runs.begin(), runs.end()) == r.data_runs;
+        return same;
+    }));
+    EXPECT_TRUE(same);
+    EXPECT_EQ(idx, recs.size());
+    EXPECT_EQ(recs[0].data_runs.size(), 3u);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, ExtensionRecordsStitchRunlists) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-ext-") + suffix + std::string(".bin"));
+    const size_t CL = 4096, REC = 1024, MFT_LCN = 10;
+    {
+        std::vector<uint8_t> img(500 * CL, 0);
+        auto put = [&](uint8_t* p, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) p[i] = (v >> (8 * i)) & 0xFF; };
+        memcpy(&img[3], "NTFS    ", 8);
+        put(&img[0x0B], 512, 2);
+        img[0x0D] = 8;
+        put(&img[0x28], img.size() / 512, 8);
+        put(&img[0x30], MFT_LCN, 8);
+        put(&img[0x38], 2, 8);
+        img[0x40] = 0xF6;
+        img[0x44] = 1;
+        img[510] = 0x55; img[511] = 0xAA;
+
+        auto rec_at = [&](size_t no) { return &img[MFT_LCN * CL + no * REC]; };
+        // 记录头；返回第一个属性的位置
+        auto header = [&](size_t no, uint64_t base_ref) {
+            uint8_t* r = rec_at(no);
+            memcpy(r, "FILE", 4);
+            put(r + 16, 1, 2);
+            put(r + 20, 56, 2);
+            put(r + 22, 0x01, 2);
+            put(r + 32, base_ref, 8);
+            return r + 56;
+        };
+        // 非常驻 DATA 片段：起始 VCN、实际大小与 runlist
+        auto data_segment = [&](uint8_t* a, uint64_t vcn, uint64_t size, const std::vector<uint8_t>& rl) {
+            put(a + 0, 0x80, 4);
+            put(a + 4, 72, 4);
+            a[8] = 1;
+            put(a + 16, vcn, 8);
+            put(a + 32, 64, 2);
+            put(a + 48, size, 8);
+            memcpy(a + 64, rl.data(), rl.size());
+            return a + 72;
+        };
+        // ATTRIBUTE_LIST 条目：DATA 片段的起始 VCN 与所在记录（文件引用，序列号 1）
+        auto list_entry = [&](uint8_t* e, uint32_t type, uint64_t vcn, uint64_t rec_no) {
+            put(e + 0, type, 4);
+            put(e + 4, 32, 2);
+            e[7] = 26;
+            put(e + 8, vcn, 8);
+            put(e + 16, rec_no | (1ULL << 48), 8);
+            return e + 32;
+        };
+        auto finish = [&](size_t no, uint8_t* end) {
+            put(end, 0xFFFFFFFF, 4);
+            protect_record(rec_at(no), REC, 48, static_cast<uint16_t>(no));
+        };
+        const uint64_t ref30 = 30 | (1ULL << 48), ref31 = 31 | (1ULL << 48);
+
+        // 记录 30：常驻列表；VCN 0 在自身，4 在 41，12 在 44（空槽位），20 在 35
+        uint8_t* a = header(30, 0);
+        put(a + 0, 0x20, 4);
+        put(a + 4, 24 + 5 * 32, 4);
+        put(a + 16, 5 * 32, 4);
+        put(a + 20, 24, 2);
+        uint8_t* e = a + 24;
+        e = list_entry(e, 0x10, 0, 30);
+        e = list_entry(e, 0x80, 0, 30);
+        e = list_entry(e, 0x80, 4, 41);
+        e = list_entry(e, 0x80, 12, 44);
+        e = list_entry(e, 0x80, 20, 35);
+        finish(30, data_segment(e, 0, 24 * CL, { 0x21, 0x04, 0xC8, 0x00, 0x00 }));
+        finish(41, data_segment(header(41, ref30), 4, 0, { 0x21, 0x08, 0xCC, 0x00, 0x00 }));
+        finish(35, data_segment(header(35, ref30), 20, 0, { 0x21, 0x04, 0x2C, 0x01, 0x00 }));
+
+        // 记录 31：非常驻列表位于簇 400；DATA 全部位于扩展记录 36 与 37
+        a = header(31, 0);
+        put(a + 0, 0x20, 4);
+        put(a + 4, 72, 4);
+        a[8] = 1;
+        put(a + 32, 64, 2);
+        put(a + 48, 3 * 32, 8);
+        const uint8_t list_runs[] = { 0x21, 0x01, 0x90, 0x01, 0x00 };
+        memcpy(a + 64, list_runs, sizeof(list_runs));
+        finish(31, a + 72);
+        e = &img[400 * CL];
+        e = list_entry(e, 0x30, 0, 31);
+        e = list_entry(e, 0x80, 0, 36);
+        list_entry(e, 0x80, 5, 37);
+        finish(36, data_segment(header(36, ref31), 0, 40000, { 0x11, 0x05, 0x64, 0x00 }));
+        finish(37, data_segment(header(37, ref31), 5, 0, { 0x11, 0x05, 0x6E, 0x00 }));
+
+        // 记录 32：自身只有命名流 "ads"（VCN 0）；未命名 DATA 的 VCN 0 在 38，3 在 39
+        const uint64_t ref32 = 32 | (1ULL << 48);
+        a = header(32, 0);
+        put(a + 0, 0x20, 4);
+        put(a + 4, 24 + 3 * 32, 4);
+        put(a + 16, 3 * 32, 4);
+        put(a + 20, 24, 2);
+        e = a + 24;
+        e = list_entry(e, 0x80, 0, 38);
+        e = list_entry(e, 0x80, 3, 39);
+        e[6] = 3;
+        for (int k = 0; k < 3; ++k) e[26 + 2 * k] = "ads"[k];
+        e = list_entry(e, 0x80, 0, 32);
+        put(e + 0, 0x80, 4);
+        put(e + 4, 80, 4);
+        e[8] = 1;
+        e[9] = 3;
+        put(e + 10, 64, 2);
+        for (int k = 0; k < 3; ++k) e[64 + 2 * k] = "ads"[k];
+        put(e + 32, 72, 2);
+        put(e + 48, 100, 8);
+        const uint8_t ads_runs[] = { 0x11, 0x01, 0x78, 0x00 };
+        memcpy(e + 72, ads_runs, sizeof(ads_runs));
+        finish(32, e + 80);
+        finish(38, data_segment(header(38, ref32), 0, 5 * CL, { 0x11, 0x03, 0x7F, 0x00 }));
+        finish(39, data_segment(header(39, ref32), 3, 0, { 0x21, 0x02, 0x90, 0x00, 0x00 }));
+
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    typedef std::vector<std::pair<uint64_t,int64_t>> Runs;
+    const Runs want30 = { {12, 200}, {8, -1}, {4, 300} };
+    const Runs want31 = { {5, 100}, {5, 110} };
+    const Runs want32 = { {3, 127}, {2, 144} };
+
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+    const Runs mft_runs = { {16, static_cast<int64_t>(MFT_LCN)} };
+    for (size_t threads : { 1, 2 }) {
+        p.set_threads(threads);
+        std::map<uint64_t, NTFSFileRecord> seen;
+        MFTScanStats st;
+        ASSERT_TRUE(p.scan_mft(d, mft_runs, 0, [&](const NTFSFileRecord& r) {
+            seen[r.id] = r;
+            return true;
+        }, &st, 8 * 1024));
+        // 扩展记录 41/44/35/36/37/38/39 按块去重后各读取一次
+        EXPECT_EQ(st.extensions, 7u);
+        ASSERT_EQ(seen.count(30), 1u);
+        ASSERT_EQ(seen.count(31), 1u);
+        EXPECT_EQ(seen[30].data_runs, want30);
+        EXPECT_EQ(seen[30].size, 24 * CL);
+        EXPECT_EQ(seen[31].data_runs, want31);
+        EXPECT_EQ(seen[31].size, 40000u);
+        // 基本记录中的命名流不是未命名 DATA 的 VCN 0 片段
+        EXPECT_EQ(seen[32].data_runs, want32);
+        EXPECT_EQ(seen[32].size, 5 * CL);
+
+        // 列式表由视图扫描填充：扫描后同样批量取回扩展记录，为这些行拼接 runlist 与大小
+        MFTTable table;
+        ASSERT_TRUE(table.fill(p, d, mft_runs, 0, &st));
+        EXPECT_EQ(st.extensions, 7u);
+        for (const auto& want : { std::make_pair(30, want30), std::make_pair(31, want31), std::make_pair(32, want32) }) {
+            MFTRow row;
+            ASSERT_TRUE(table.find(want.first, row));
+            MFTRunSpan span = table.runs(row);
+            EXPECT_EQ(Runs(span.begin(), span.end()), want.second);
+            EXPECT_EQ(table.file_size(row), seen[want.first].size);
+        }
+        // 其余行的区段不受拼接重建的影响
+        MFTRow row;
+        ASSERT_TRUE(table.find(41, row));
+        MFTRunSpan span = table.runs(row);
+        EXPECT_EQ(Runs(span.begin(), span.end()), Runs({ {8, 204} }));
+        ASSERT_TRUE(table.find(39, row));
+        span = table.runs(row);
+        EXPECT_EQ(Runs(span.begin(), span.end()), Runs({ {2, 144} }));
+    }
+
+    NTFSFileRecord r;
+    ASSERT_TRUE(p.read_mft_record(d, MFT_LCN * CL + 30 * REC, r));
+    EXPECT_EQ(r.data_runs, want30);
+    ASSERT_TRUE(p.read_mft_record(d, MFT_LCN * CL + 31 * REC, r));
+    EXPECT_EQ(r.data_runs, want31);
+    EXPECT_EQ(r.size, 40000u);
+    ASSERT_TRUE(p.read_mft_record(d, MFT_LCN * CL + 32 * REC, r));
+    EXPECT_EQ(r.data_runs, want32);
+    EXPECT_EQ(r.size, 5 * CL);
+    // 从扩展记录出发：经 base_record 回到基本记录并拼接完整 runlist
+    ASSERT_TRUE(p.read_mft_record(d, MFT_LCN * CL + 41 * REC, r));
+    EXPECT_EQ(r.data_runs, want30);
+    EXPECT_EQ(r.size, 24 * CL);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+// 逐位转换的参考实现
+static std::vector<std::pair<uint64_t,uint64_t>> reference_free_extents(const std::vector<uint8_t>& bits, uint64_t clusters) {
+    std::vector<std::pair<uint64_t,uint64_t>> out;
+    for (uint64_t i = 0; i < clusters; ++i) {
+        if (bits[i / 8] & (1u << (i % 8))) continue;
+        if (!out.empty() && out.back().first + out.back().second == i) ++out.back().second;
+        else out.emplace_back(i, 1);
+    }
+    return out;
+}
+
+TEST(NTFSParser, BitmapFreeExtentsMatchReference) {
+    uint32_t seed = 4242;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    for (int iter = 0; iter < 300; ++iter) {
+        // 交替的已分配/空闲游程，长度从 1 簇到数百簇，覆盖整字跳过与字内边界
+        std::vector<uint8_t> bits(1 + rnd() % 700, 0);
+        const uint32_t max_run = iter % 3 == 0 ? 4 : iter % 3 == 1 ? 70 : 600;
+        bool set = rnd() % 2 != 0;
+        for (uint64_t i = 0; i < bits.size() * 8;) {
+            uint64_t len = 1 + rnd() % max_run;
+            for (uint64_t k = i; k < std::min<uint64_t>(i + len, bits.size() * 8); ++k) {
+                if (set) bits[k / 8] |= static_cast<uint8_t>(1u << (k % 8));
+            }
+            i += len;
+            set = !set;
+        }
+        const uint64_t clusters = bits.size() * 8 - rnd() % std::min<size_t>(bits.size() * 8, 80);
+        const auto want = reference_free_extents(bits, clusters);
+        uint64_t want_free = 0;
+        for (const auto& e : want) want_free += e.second;
+
+        std::vector<std::pair<uint64_t,uint64_t>> got;
+        ASSERT_EQ(bitmap_free_extents(bits.data(), bits.size(), 0, clusters, got), want_free) << "iter " << iter;
+        ASSERT_EQ(got, want) << "iter " << iter;
+
+        // 分段转换（段长任意，不必按字对齐）结果相同：跨段的区段并入前一段的末项
+        got.clear();
+        uint64_t total = 0;
+        for (uint64_t lcn = 0; lcn < clusters;) {
+            const size_t byte = static_cast<size_t>(lcn / 8);
+            const size_t n = std::min<size_t>(1 + rnd() % 90, bits.size() - byte);
+            const uint64_t count = std::min<uint64_t>(clusters - lcn, n * 8);
+            total += bitmap_free_extents(bits.data() + byte, n, lcn, count, got);
+            lcn += count;
+        }
+        ASSERT_EQ(total, want_free) << "iter " << iter;
+        ASSERT_EQ(got, want) << "iter " << iter;
+    }
+    // clusters 超出位图长度时按位图长度截断
+    std::vector<std::pair<uint64_t,uint64_t>> got;
+    const uint8_t two[2] = { 0x0F, 0x00 };
+    EXPECT_EQ(bitmap_free_extents(two, 2, 100, 1000, got), 12u);
+    EXPECT_EQ(got, (std::vector<std::pair<uint64_t,uint64_t>>{ {104, 12} }));
+}
+
+TEST(NTFSParser, FreeSpaceDeepScanReadsOnlyUnallocated) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-free-space-") + suffix + std::string(".bin"));
+    const size_t CL = 4096, REC = 1024, MFT_LCN = 10, CLUSTERS = 256;
+    {
+        std::vector<uint8_t> img(CLUSTERS * CL, 0);
+        auto put = [&](uint8_t* p, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) p[i] = (v >> (8 * i)) & 0xFF; };
+        memcpy(&img[3], "NTFS    ", 8);
+        put(&img[0x0B], 512, 2);
+        img[0x0D] = 8;
+        put(&img[0x28], CLUSTERS * CL / 512, 8);
+        put(&img[0x30], MFT_LCN, 8);
+        put(&img[0x38], 2, 8);
+        img[0x40] = 0xF6;
+        img[0x44] = 1;
+        img[510] = 0x55; img[511] = 0xAA;
+
+        // 带 FILE_NAME 与可选非常驻 DATA 的记录，写到磁盘偏移 off 处
+        auto write_record = [&](size_t off, uint32_t rec_no, uint16_t flags, const std::string& name,
+                                const std::vector<uint8_t>& runlist, uint64_t size) {
+            uint8_t* r = &img[off];
+            memcpy(r, "FILE", 4);
+            put(r + 16, 1, 2);
+            put(r + 20, 56, 2);
+            put(r + 22, flags, 2);
+            put(r + 44, rec_no, 4);
+            uint8_t* f = r + 56;
+            put(f + 0, 0x30, 4);
+            put(f + 4, 0x78, 4);
+            put(f + 16, 66 + name.size() * 2, 4);
+            put(f + 20, 24, 2);
+            put(f + 24, 5 | (1ULL << 48), 8);
+            f[24 + 64] = static_cast<uint8_t>(name.size());
+            for (size_t k = 0; k < name.size(); ++k) f[24 + 66 + k * 2] = name[k];
+            uint8_t* a = f + 0x78;
+            if (!runlist.empty()) {
+                put(a + 0, 0x80, 4);
+                put(a + 4, 72, 4);
+                a[8] = 1;
+                put(a + 32, 64, 2);
+                put(a + 48, size, 8);
+                memcpy(a + 64, runlist.data(), runlist.size());
+                a += 72;
+            }
+            put(a, 0xFFFFFFFF, 4);
+            protect_record(r, REC, 48, static_cast<uint16_t>(rec_no + 1));
+        };
+        const size_t mft = MFT_LCN * CL;
+        write_record(mft + 0 * REC, 0, 0x01, "$MFT", { 0x11, 0x04, 0x0A, 0x00 }, 16 * REC);
+        write_record(mft + 5 * REC, 5, 0x03, ".", {}, 0);
+        write_record(mft + 6 * REC, 6, 0x01, "$Bitmap", { 0x11, 0x01, 0x32, 0x00 }, CLUSTERS / 8);
+        write_record(mft + 12 * REC, 12, 0x01, "data.bin", { 0x11, 0x02, 0x3C, 0x00 }, 5000);
+        // 空闲簇 70 中残留的已删除记录；已分配簇 150 中的 FILE 签名不应被扫描到
+        write_record(70 * CL, 77, 0x00, "lost.txt", {}, 0);
+        write_record(150 * CL, 88, 0x01, "live.txt", {}, 0);
+        memcpy(&img[60 * CL + 6000], "SLACK!", 6);
+
+        // 已分配：0..13（引导扇区与 $MFT）、50（$Bitmap）、60..61（data.bin）、100..199
+        uint8_t* bm = &img[50 * CL];
+        auto mark = [&](size_t first, size_t count) {
+            for (size_t c = first; c < first + count; ++c) bm[c / 8] |= static_cast<uint8_t>(1u << (c % 8));
+        };
+        mark(0, 14);
+        mark(50, 1);
+        mark(60, 2);
+        mark(100, 100);
+
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    typedef std::vector<std::pair<uint64_t,uint64_t>> Spans;
+
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+    Spans free_extents;
+    uint64_t free_clusters = 0;
+    ASSERT_TRUE(p.load_free_extents(d, free_extents, &free_clusters));
+    EXPECT_EQ(free_extents, (Spans{ {14, 36}, {51, 9}, {62, 38}, {200, 56} }));
+    EXPECT_EQ(free_clusters, 139u);
+
+    // 只读取空闲簇：不合并间隔时读取量恰为空闲空间
+    Spans regions;
+    p.free_space_regions(free_extents, regions);
+    p.set_read_coalescing(0, NTFS_READ_DEFAULT_MAX);
+    NTFSRegionScanStats st;
+    uint64_t seen = 0, prev_end = 0;
+    ASSERT_TRUE(p.scan_regions(d, regions, [&](uint64_t off, const uint8_t*, size_t size) {
+        EXPECT_GE(off, prev_end);
+        prev_end = off + size;
+        seen += size;
+        return true;
+    }, &st));
+    EXPECT_EQ(seen, 139u * CL);
+    EXPECT_EQ(st.bytes, 139u * CL);
+    EXPECT_EQ(st.bytes_read, 139u * CL);
+    EXPECT_EQ(st.reads, 4u);
+    // 默认间隔：14..99 的三个区域跨过 $Bitmap 与 data.bin 的已分配簇合并为一次读取
+    p.set_read_coalescing(NTFS_READ_DEFAULT_GAP, NTFS_READ_DEFAULT_MAX);
+    ASSERT_TRUE(p.scan_regions(d, regions, [](uint64_t, const uint8_t*, size_t) { return true; }, &st));
+    EXPECT_EQ(st.bytes, 139u * CL);
+    EXPECT_EQ(st.bytes_read, (86u + 56u) * CL);
+    EXPECT_EQ(st.reads, 2u);
+    // 合并后的单次读取不超过片段大小
+    ASSERT_TRUE(p.scan_regions(d, regions, [](uint64_t, const uint8_t*, size_t size) { return size <= 64 * 1024; },
+                               &st, 64 * 1024));
+    EXPECT_EQ(st.bytes, 139u * CL);
+    EXPECT_LE(st.bytes_read, (86u + 56u) * CL);
+    EXPECT_GE(st.reads, (86u + 56u) * CL / (64 * 1024));
+    std::vector<std::pair<uint64_t,NTFSFileRecord>> orphans;
+    ASSERT_TRUE(p.find_orphan_records(d, regions, [&](uint64_t off, const NTFSFileRecord& r) {
+        orphans.emplace_back(off, r);
+        return true;
+    }, &st));
+    ASSERT_EQ(orphans.size(), 1u);
+    EXPECT_EQ(st.records, 1u);
+    EXPECT_EQ(orphans[0].first, 70u * CL);
+    EXPECT_EQ(orphans[0].second.id, 77u);
+    EXPECT_EQ(orphans[0].second.name, "lost.txt");
+
+    // slack：data.bin 5000 字节之后直到第 2 簇末尾，$Bitmap 32 字节之后直到簇末尾
+    MFTTable table;
+    ASSERT_TRUE(table.fill(p, d));
+    Spans slack;
+    table.slack_regions(p.volume(), slack);
+    EXPECT_EQ(slack, (Spans{ {50 * CL + 32, CL - 32}, {60 * CL + 5000, 2 * CL - 5000} }));
+    regions.insert(regions.end(), slack.begin(), slack.end());
+    bool marker = false;
+    ASSERT_TRUE(p.scan_regions(d, regions, [&](uint64_t, const uint8_t* data, size_t size) {
+        for (size_t i = 0; i + 6 <= size; ++i) marker = marker || memcmp(data + i, "SLACK!", 6) == 0;
+        return true;
+    }, &st));
+    EXPECT_TRUE(marker);
+    EXPECT_EQ(st.bytes, 139u * CL + (CL - 32) + (2 * CL - 5000));
+    d.close();
+
+    // C API：深度扫描把空闲簇中的孤儿记录报告为候选项，快速扫描不读取空闲簇
+    ASSERT_EQ(fr_init(temp_directory_path().string().c_str()), FR_OK);
+    fr_handle_t h = fr_open_image(tmp.string().c_str(), nullptr);
+    ASSERT_NE(h, nullptr);
+    fr_scan_params_t params;
+    memset(&params, 0, sizeof(params));
+    fr_candidate_t c;
+    ASSERT_EQ(fr_start_scan(h, &params), FR_OK);
+    EXPECT_EQ(fr_get_next_candidate(h, &c), FR_ERR_NOT_FOUND);
+    params.mode = FR_SCAN_DEEP;
+    ASSERT_EQ(fr_start_scan(h, &params), FR_OK);
+    ASSERT_EQ(fr_get_next_candidate(h, &c), FR_OK);
+    EXPECT_STREQ(c.file_name, "\\$OrphanFiles\\lost.txt");
+    EXPECT_EQ(c.offset, 70u * CL);
+    EXPECT_EQ(c.id, 13u); // 接在最大的 MFT 记录号之后
+    EXPECT_EQ(fr_get_next_candidate(h, &c), FR_ERR_NOT_FOUND);
+    fr_close(h);
+    fr_shutdown();
+
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(NTFSParser, RunListInlineAndOverflow) {
+    // 非常驻 DATA 的 runlist：10 个不相邻区段 + 1 个与前一区段相邻的区段 + 1 个稀疏区段
+    std::vector<uint8_t> rec(1024, 0);
+    memcpy(rec.data(), "FILE", 4);
+    rec[20] = 56;
+    rec[22] = 0x01;
+    uint8_t* a = rec.data() + 56;
+    a[0] = 0x80;
+    a[4] = 128;
+    a[8] = 1;
+    a[32] = 64;
+    a[48] = 0x00; a[49] = 0x10; // real size 4096
+    uint8_t* r = a + 64;
+    *r++ = 0x11; *r++ = 1; *r++ = 100;        // 1 @ 100
+    for (int i = 0; i < 9; ++i) {              // 1 @ 102, 104, ... 118
+        *r++ = 0x11; *r++ = 1; *r++ = 2;
+    }
+    *r++ = 0x11; *r++ = 2; *r++ = 1;           // 2 @ 119：与 118 相邻，被合并
+    *r++ = 0x01; *r++ = 3;                     // 3 sparse
+    *r++ = 0;
+    memset(a + 128, 0xFF, 4);
+
+    NTFSRecordView v;
+    ASSERT_TRUE(v.reset(rec.data(), rec.size(), 7));
+    EXPECT_TRUE(v.has_runlist());
+    EXPECT_FALSE(v.has_name());
+    EXPECT_EQ(v.data_size(), 4096u);
+    NTFSRunList runs;
+    ASSERT_TRUE(v.runs(runs));
+    std::vector<std::pair<uint64_t,int64_t>> want;
+    ASSERT_TRUE(decode_data_runs(a + 64, 64, want));
+    normalize_data_runs(want);
+    ASSERT_EQ(want.size(), 11u);
+    EXPECT_EQ(want[9], std::make_pair(uint64_t(3), int64_t(118)));
+    EXPECT_EQ(want[10], std::make_pair(uint64_t(3), int64_t(-1)));
+    std::vector<std::pair<uint64_t,int64_t>> got(runs.begin(), runs.end());
+    EXPECT_EQ(got, want);
+
+    // 截短回内联容量后仍可继续追加
+    runs.truncate(2);
+    EXPECT_EQ(runs.size(), 2u);
+    EXPECT_EQ(runs[1], std::make_pair(uint64_t(1), int64_t(102)));
+    runs.push_back(std::make_pair(uint64_t(5), int64_t(-1)));
+    EXPECT_EQ(runs[2].second, -1);
+
+    // 无效记录：视图被清空
+    rec[0] = 'X';
+    EXPECT_FALSE(v.reset(rec.data(), rec.size(), 7));
+    EXPECT_EQ(v.data(), nullptr);
+    EXPECT_FALSE(v.runs(runs));
+    EXPECT_TRUE(runs.empty());
+}
+
+// 逐字节组装字段、先解码后合并的参考实现（查表解码之前的逻辑）
+static bool reference_decode_runs(const uint8_t* runs, size_t len, std::vector<std::pair<uint64_t,int64_t>>& out) {
+    out.clear();
+    size_t pos = 0;
+    int64_t prev_lcn = 0;
+    while (pos < len) {
+        uint8_t header = runs[pos++];
+        if (header == 0) break;
+        int len_size = header & 0x0F;
+        int off_size = (header >> 4) & 0x0F;
+        if (len_size == 0) return false;
+        if (pos + len_size + off_size > len) return false;
+        uint64_t count = 0;
+        for (int i = 0; i < len_size; ++i) count |= static_cast<uint64_t>(runs[pos + i]) << (8 * i);
+        pos += len_size;
+        int64_t lcn = -1;
+        if (off_size != 0) {
+            uint64_t v = 0;
+            for (int i = 0; i < off_size; ++i) v |= static_cast<uint64_t>(runs[pos + i]) << (8 * i);
+            if (off_size < 8 && (v & (1ULL << (off_size * 8 - 1)))) v |= ~0ULL << (off_size * 8);
+            lcn = prev_lcn + static_cast<int64_t>(v);
+            prev_lcn = lcn;
+        }
+        pos += off_size;
+        out.emplace_back(count, lcn);
+    }
+    size_t w = 0;
+    for (size_t i = 1; i < out.size(); ++i) {
+        if (out[w].second != -1 && out[i].second != -1 && out[w].second + static_cast<int64_t>(out[w].first) == out[i].second) {
+            out[w].first += out[i].first;
+            continue;
+        }
+        out[++w] = out[i];
+    }
+    if (!out.empty()) out.resize(w + 1);
+    return true;
+}
+
+TEST(NTFSParser, FusedRunDecodeMatchesReference) {
+    uint32_t seed = 77;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    auto put = [](std::vector<uint8_t>& b, uint64_t v, int n) {
+        for (int i = 0; i < n; ++i) b.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    };
+    std::vector<uint8_t> rl;
+    std::vector<std::pair<uint64_t,int64_t>> want, got;
+    NTFSRunList list;
+    for (int iter = 0; iter < 3000; ++iter) {
+        // 随机 runlist：各种字段宽度、正负偏移、稀疏区段，约三成区段与前一区段物理相邻
+        rl.clear();
+        size_t nruns = iter % 50 == 0 ? 2000 + rnd() % 2000 : rnd() % 40;
+        uint64_t last_count = 0;
+        bool last_sparse = true;
+        for (size_t k = 0; k < nruns; ++k) {
+            int len_size = 1 + rnd() % 4;
+            uint64_t count = (static_cast<uint64_t>(rnd()) | 1) & ((1ULL << (8 * len_size - 1)) - 1);
+            uint32_t kind = rnd() % 10;
+            if (kind < 2) {
+                rl.push_back(static_cast<uint8_t>(len_size));
+                put(rl, count, len_size);
+                last_sparse = true;
+                continue;
+            }
+            int64_t delta;
+            int off_size;
+            if (kind < 5 && !last_sparse) {
+                delta = static_cast<int64_t>(last_count); // 相邻：可合并
+                off_size = len_size + 1;
+            } else {
+                off_size = 1 + rnd() % 8;
+                uint64_t raw = (static_cast<uint64_t>(rnd()) << 40) ^ (static_cast<uint64_t>(rnd()) << 16) ^ rnd();
+                delta = static_cast<int64_t>(off_size == 8 ? raw : raw & ((1ULL << (8 * off_size)) - 1));
+            }
+            rl.push_back(static_cast<uint8_t>(len_size | (off_size << 4)));
+            put(rl, count, len_size);
+            put(rl, static_cast<uint64_t>(delta), off_size);
+            last_count = count;
+            last_sparse = false;
+        }
+        if (rnd() % 4 != 0) rl.push_back(0);
+        // 部分用例截断 runlist，解码应同样失败
+        size_t len = rl.size();
+        if (len > 0 && rnd() % 5 == 0) len = rnd() % len;
+
+        bool ok = reference_decode_runs(rl.data(), len, want);
+        ASSERT_EQ(decode_normalized_runs(rl.data(), len, got), ok) << "iter " << iter;
+        ASSERT_EQ(decode_normalized_runs(rl.data(), len, list), ok);
+        if (!ok) {
+            EXPECT_TRUE(got.empty());
+            EXPECT_TRUE(list.empty());
+            continue;
+        }
+        ASSERT_EQ(got, want) << "iter " << iter;
+        std::vector<std::pair<uint64_t,int64_t>> from_list(list.begin(), list.end());
+        ASSERT_EQ(from_list, want);
+        // 未合并的解码 + normalize 与融合路径一致
+        std::vector<std::pair<uint64_t,int64_t>> split;
+        ASSERT_TRUE(decode_data_runs(rl.data(), len, split));
+        normalize_data_runs(split);
+        ASSERT_EQ(split, want);
+    }
+
+    // 输出容器跨调用复用容量
+    const uint8_t small[] = { 0x21, 0x04, 0x10, 0x00, 0x00 };
+    got.reserve(4096);
+    const std::pair<uint64_t,int64_t>* storage = got.data();
+    ASSERT_TRUE(decode_normalized_runs(small, sizeof(small), got));
+    EXPECT_EQ(got.data(), storage);
+    ASSERT_EQ(got.size(), 1u);
+    EXPECT_EQ(got[0], std::make_pair(uint64_t(4), int64_t(16)));
+    // 超过 8 字节的字段无效
+    const uint8_t wide[] = { 0x19, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
+    EXPECT_FALSE(decode_normalized_runs(wide, sizeof(wide), got));
+    EXPECT_TRUE(got.empty());
+}
+
+TEST(MFTTable, FillFromScanAndFilter) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-table-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_fragmented_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    DiskIO d;
+    ASSERT_TRUE(d.open(tmp.string().c_str()));
+    NTFSParser p;
+    ASSERT_TRUE(p.open_volume(d, 0));
+    std::vector<NTFSFileRecord> recs;
+    ASSERT_TRUE(p.scan_mft(d, [&](const NTFSFileRecord& r) { recs.push_back(r); return true; }));
+
+    MFTTable t;
+    MFTScanStats st;
+    p.set_threads(4);
+    ASSERT_TRUE(t.fill(p, d, &st));
+    ASSERT_EQ(t.size(), recs.size());
+    EXPECT_EQ(st.records, recs.size());
+    for (MFTRow r : t.rows()) {
+        NTFSFileRecord m;
+        t.materialize(r, m);
+        ASSERT_EQ(m.id, recs[r].id);
+        ASSERT_EQ(m.name, recs[r].name);
+        ASSERT_EQ(m.size, recs[r].size);
+        ASSERT_EQ(m.flags, recs[r].flags);
+        ASSERT_EQ(m.torn, recs[r].torn);
+        ASSERT_EQ(m.data_runs, recs[r].data_runs);
+    }
+    EXPECT_EQ(t.runs(0).size(), 3u);
+    EXPECT_TRUE(t.runs(1).empty());
+
+    // 过滤迭代器：只访问满足条件的行
+    size_t torn = 0;
+    for (MFTRow r : t.filter([&](MFTRow row) { return t.torn(row); })) {
+        EXPECT_EQ(t.id(r) % 113, 0u);
+        ++torn;
+    }
+    EXPECT_EQ(torn, st.torn);
+    size_t tens = 0;
+    for (MFTRow r : t.filter([&](MFTRow row) { return t.id(row) % 10 == 0; })) {
+        EXPECT_EQ(t.name(r), t.id(r) ? "file_" + std::to_string(t.id(r)) + ".dat" : "$MFT");
+        ++tens;
+    }
+    EXPECT_EQ(tens, static_cast<size_t>(std::count_if(recs.begin(), recs.end(),
+                                                       [](const NTFSFileRecord& r) { return r.id % 10 == 0 && r.id; })) + 1);
+
+    MFTRow row = 0;
+    ASSERT_TRUE(t.find(1234, row));
+    EXPECT_EQ(t.name(row), "file_1234.dat");
+    EXPECT_FALSE(t.find(97, row)); // 空槽位不在表中
+    EXPECT_FALSE(t.find(5000, row));
+
+    // 列式存储远小于逐条保存的 NTFSFileRecord
+    size_t naive = 0;
+    for (const auto& r : recs) naive += sizeof(NTFSFileRecord) + r.data_runs.capacity() * 16;
+    EXPECT_LT(t.memory_bytes(), naive);
+
+    d.close();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+TEST(MFTTable, NamePoolInterning) {
+    MFTNamePool pool;
+    EXPECT_EQ(pool.intern(""), 0u);
+    uint32_t a = pool.intern("desktop.ini");
+    uint32_t b = pool.intern("thumbs.db");
+    EXPECT_NE(a, 0u);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.intern("desktop.ini"), a);
+    EXPECT_EQ(pool.get(a), "desktop.ini");
+    EXPECT_EQ(pool.get(0), "");
+    // 扩容（重新散列）后 id 保持不变
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 5000; ++i) ids.push_back(pool.intern("n" + std::to_string(i)));
+    EXPECT_EQ(pool.intern("thumbs.db"), b);
+    for (int i = 0; i < 5000; ++i) ASSERT_EQ(pool.intern("n" + std::to_string(i)), ids[i]);
+    EXPECT_EQ(pool.count(), 5003u);
+
+    // 重复名称在表中只存一份
+    MFTTable t;
+    NTFSFileRecord r;
+    r.id = 16; r.size = 1; r.flags = 1; r.link_count = 1; r.creation_time = 0; r.modified_time = 0;
+    r.parent_reference = 5; r.name_namespace = 1;
+    r.name = "desktop.ini";
+    t.append(r);
+    r.id = 17;
+    r.data_runs = { {4, 100}, {2, -1} };
+    r.torn = true;
+    t.append(r);
+    EXPECT_EQ(t.name_id(0), t.name_id(1));
+    EXPECT_EQ(t.names().count(), 2u);
+    EXPECT_EQ(t.runs(1).size(), 2u);
+    EXPECT_TRUE(t.torn(1));
+    EXPECT_EQ(t.flags(1) & 0xFF, 1);
+    EXPECT_EQ(t.parent_reference(1), 5u);
+}
+
+// 带 $Extend\$UsnJrnl 的小卷：记录 20 为日志（常驻 $Max + 非常驻 $J），24..26 为普通文件
+TEST(MFTTable, RefreshFromUsnJournalAndFingerprints) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-refresh-") + suffix + std::string(".bin"));
+    path saved = temp_directory_path() / (std::string("filerecover-refresh-") + suffix + std::string(".tab"));
+    const size_t CL = 4096, REC = 1024, MFT_LCN = 10, J_LCN = 30, CLUSTERS = 64;
+    std::vector<uint8_t> img(CLUSTERS * CL, 0);
+    auto put = [&](uint8_t* p, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) p[i] = (v >> (8 * i)) & 0xFF; };
+    memcpy(&img[3], "NTFS    ", 8);
+    put(&img[0x0B], 512, 2);
+    img[0x0D] = 8;
+    put(&img[0x28], CLUSTERS * CL / 512, 8);
+    put(&img[0x30], MFT_LCN, 8);
+    put(&img[0x38], 2, 8);
+    img[0x40] = 0xF6;
+    img[0x44] = 1;
+    put(&img[0x48], 0x1122334455667788ULL, 8);
+    img[510] = 0x55; img[511] = 0xAA;
+
+    // 记录：FILE_NAME（parent 为记录号，序列号 1），可选常驻 $Max 与非常驻 $J
+    uint64_t journal_id = 0x1234, j_size = 0;
+    auto write_record = [&](uint32_t rec_no, uint64_t lsn, uint16_t flags, uint64_t parent, const std::string& name) {
+        uint8_t* r = &img[MFT_LCN * CL + rec_no * REC];
+        memset(r, 0, REC);
+        memcpy(r, "FILE", 4);
+        put(r + 8, lsn, 8);
+        put(r + 16, 1, 2);
+        put(r + 20, 56, 2);
+        put(r + 22, flags, 2);
+        put(r + 44, rec_no, 4);
+        uint8_t* a = r + 56;
+        put(a + 0, 0x30, 4);
+        put(a + 4, 0x78, 4);
+        put(a + 16, 66 + name.size() * 2, 4);
+        put(a + 20, 24, 2);
+        put(a + 24, parent | (1ULL << 48), 8);
+        a[24 + 64] = static_cast<uint8_t>(name.size());
+        for (size_t k = 0; k < name.size(); ++k) a[24 + 66 + k * 2] = name[k];
+        a += 0x78;
+        if (rec_no == 20) {
+            put(a + 0, 0x80, 4);
+            put(a + 4, 64, 4);
+            a[9] = 4;
+            put(a + 10, 24, 2);
+            for (int k = 0; k < 4; ++k) a[24 + 2 * k] = "$Max"[k];
+            put(a + 16, 32, 4);
+            put(a + 20, 32, 2);
+            put(a + 32, 1 << 20, 8);
+            put(a + 48, journal_id, 8);
+            put(a + 56, 0, 8); // LowestValidUsn
+            a += 64;
+            put(a + 0, 0x80, 4);
+            put(a + 4, 80, 4);
+            a[8] = 1;
+            a[9] = 2;
+            put(a + 10, 64, 2);
+            a[64] = '$'; a[66] = 'J';
+            put(a + 24, 1, 8);
+            put(a + 32, 72, 2);
+            put(a + 40, 2 * CL, 8);
+            put(a + 48, j_size, 8);
+            put(a + 56, j_size, 8);
+            const uint8_t runs[] = { 0x11, 0x02, J_LCN };
+            memcpy(a + 72, runs, sizeof(runs));
+            a += 80;
+        }
+        put(a, 0xFFFFFFFF, 4);
+        put(r + 24, a + 8 - r, 4);
+        protect_record(r, REC, 48, static_cast<uint16_t>(lsn));
+    };
+    // USN_RECORD_V2：64 字节，文件名两个字符
+    auto add_usn = [&](uint64_t file, uint64_t parent) {
+        uint8_t* u = &img[J_LCN * CL + j_size];
+        put(u + 0, 64, 4);
+        put(u + 4, 2, 2);
+        put(u + 8, file | (1ULL << 48), 8);
+        put(u + 16, parent | (1ULL << 48), 8);
+        put(u + 24, j_size, 8);
+        put(u + 56, 4, 2);
+        put(u + 58, 60, 2);
+        j_size += 64;
+    };
+    auto write_image = [&] {
+        std::ofstream of(tmp, std::ios::binary | std::ios::trunc);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    };
+    const uint64_t MFT_RECORDS = 32;
+    {
+        uint8_t* r = &img[MFT_LCN * CL];
+        write_record(0, 1, 0x01, 5, "$MFT");
+        uint8_t* a = r + 56 + 0x78;
+        put(a + 0, 0x80, 4);
+        put(a + 4, 72, 4);
+        a[8] = 1;
+        put(a + 32, 64, 2);
+        put(a + 40, MFT_RECORDS * REC, 8);
+        put(a + 48, MFT_RECORDS * REC, 8);
+        const uint8_t runs[] = { 0x11, MFT_RECORDS * REC / CL, MFT_LCN };
+        memcpy(a + 64, runs, sizeof(runs));
+        put(a + 72, 0xFFFFFFFF, 4);
+        put(r + 24, 56 + 0x78 + 80, 4);
+        protect_record(r, REC, 48, 1);
+    }
+    write_record(5, 2, 0x03, 5, ".");
+    write_record(11, 3, 0x03, 5, "$Extend");
+    add_usn(24, 5);
+    add_usn(25, 5);
+    write_record(20, 4, 0x01, 11, "$UsnJrnl");
+    write_record(24, 5, 0x01, 5, "a.txt");
+    write_record(25, 6, 0x01, 5, "b.txt");
+    write_record(26, 7, 0x01, 5, "c.txt");
+    write_image();
+
+    typedef std::vector<std::pair<uint64_t,int64_t>> Runs;
+    auto expect_same = [](const MFTTable& a, const MFTTable& b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (MFTRow r : a.rows()) {
+            ASSERT_EQ(a.id(r), b.id(r));
+            EXPECT_EQ(a.name(r), b.name(r));
+            EXPECT_EQ(a.file_size(r), b.file_size(r));
+            EXPECT_EQ(a.flags(r), b.flags(r));
+            EXPECT_EQ(a.sequence_number(r), b.sequence_number(r));
+            EXPECT_EQ(a.parent_reference(r), b.parent_reference(r));
+            EXPECT_EQ(a.lsn(r), b.lsn(r));
+            EXPECT_EQ(a.record_hash(r), b.record_hash(r));
+            EXPECT_EQ(Runs(a.runs(r).begin(), a.runs(r).end()), Runs(b.runs(r).begin(), b.runs(r).end()));
+        }
+    };
+
+    MFTTable t;
+    {
+        DiskIO d;
+        ASSERT_TRUE(d.open(tmp.string().c_str()));
+        NTFSParser p;
+        ASSERT_TRUE(p.open_volume(d, 0));
+        ASSERT_TRUE(t.fill(p, d));
+        ASSERT_EQ(t.size(), 7u);
+        EXPECT_EQ(t.stamp().serial_number, 0x1122334455667788ULL);
+        EXPECT_EQ(t.stamp().mft_record_size, REC);
+        EXPECT_EQ(t.stamp().journal_record, 20u);
+        EXPECT_EQ(t.stamp().journal_id, 0x1234u);
+        EXPECT_EQ(t.stamp().next_usn, 128u);
+        MFTRow row = 0;
+        ASSERT_TRUE(t.find(24, row));
+        EXPECT_EQ(t.lsn(row), 5u);
+        EXPECT_NE(t.record_hash(row), 0u);
+
+        // 日志中自 0 起涉及的记录及其父目录
+        std::vector<uint64_t> changed;
+        NTFSUsnJournalState js;
+        ASSERT_TRUE(p.read_usn_changes(d, 20, 0x1234, 0, changed, &js));
+        EXPECT_EQ(changed, (std::vector<uint64_t>{ 5, 24, 25 }));
+        EXPECT_EQ(js.next_usn, 128u);
+        EXPECT_FALSE(p.read_usn_changes(d, 20, 0x9999, 0, changed)); // 日志已重建
+        EXPECT_FALSE(p.read_usn_changes(d, 20, 0x1234, 4096, changed)); // 超出日志末尾
+    }
+
+    // 保存后载入：各列与 stamp 原样恢复；截断的文件载入失败且表不变
+    std::string err;
+    ASSERT_TRUE(t.save(saved.string().c_str(), &err)) << err;
+    MFTTable loaded;
+    ASSERT_TRUE(loaded.load(saved.string().c_str(), &err)) << err;
+    expect_same(loaded, t);
+    EXPECT_EQ(loaded.stamp().journal_id, t.stamp().journal_id);
+    EXPECT_EQ(loaded.stamp().next_usn, t.stamp().next_usn);
+    EXPECT_EQ(loaded.stamp().serial_number, t.stamp().serial_number);
+    MFTRow row = 0;
+    ASSERT_TRUE(loaded.find(25, row));
+    EXPECT_EQ(loaded.names().count(), t.names().count());
+    EXPECT_EQ(loaded.name(row), "b.txt");
+    resize_file(saved, file_size(saved) - 3);
+    EXPECT_FALSE(loaded.load(saved.string().c_str(), &err));
+    EXPECT_FALSE(err.empty());
+    EXPECT_EQ(loaded.size(), 7u);
+
+    // 日志路径：25 改名、26 失效、新增 27，日志追加三条记录；只重新读取变化的记录
+    write_record(25, 8, 0x01, 5, "bb.txt");
+    memset(&img[MFT_LCN * CL + 26 * REC], 0, REC);
+    write_record(27, 9, 0x01, 5, "d.txt");
+    add_usn(25, 5);
+    add_usn(26, 5);
+    add_usn(27, 5);
+    write_record(20, 10, 0x01, 11, "$UsnJrnl");
+    write_image();
+    {
+        DiskIO d;
+        ASSERT_TRUE(d.open(tmp.string().c_str()));
+        NTFSParser p;
+        ASSERT_TRUE(p.open_volume(d, 0));
+        MFTRefreshStats st;
+        ASSERT_TRUE(loaded.refresh(p, d, &st));
+        EXPECT_TRUE(st.journal);
+        EXPECT_FALSE(st.rebuilt);
+        EXPECT_EQ(st.reparsed, 6u); // 0、5、11（元文件）、20（日志）、25、27
+        EXPECT_EQ(st.unchanged, 1u);
+        EXPECT_EQ(st.removed, 1u);
+        EXPECT_EQ(st.scan.records, 0u);
+        EXPECT_EQ(loaded.stamp().next_usn, 320u);
+        MFTTable full;
+        ASSERT_TRUE(full.fill(p, d));
+        expect_same(loaded, full);
+        ASSERT_TRUE(loaded.find(25, row));
+        EXPECT_EQ(loaded.name(row), "bb.txt");
+        EXPECT_FALSE(loaded.find(26, row));
+    }
+
+    // 指纹路径：日志被重建（id 改变）时整表比较；24 的内容被改写但 LSN 未变，由哈希发现
+    journal_id = 0x5678;
+    write_record(20, 11, 0x01, 11, "$UsnJrnl");
+    write_record(24, 5, 0x01, 5, "x.txt");
+    write_image();
+    {
+        DiskIO d;
+        ASSERT_TRUE(d.open(tmp.string().c_str()));
+        NTFSParser p;
+        ASSERT_TRUE(p.open_volume(d, 0));
+        MFTRefreshStats st;
+        ASSERT_TRUE(loaded.refresh(p, d, &st));
+        EXPECT_FALSE(st.journal);
+        EXPECT_EQ(st.reparsed, 2u); // 20、24
+        EXPECT_EQ(st.unchanged, 5u);
+        EXPECT_EQ(st.removed, 0u);
+        EXPECT_EQ(st.scan.records, 7u);
+        EXPECT_EQ(loaded.stamp().journal_id, 0x5678u);
+        MFTTable full;
+        ASSERT_TRUE(full.fill(p, d));
+        expect_same(loaded, full);
+        ASSERT_TRUE(loaded.find(24, row));
+        EXPECT_EQ(loaded.name(row), "x.txt");
+        // 没有变化时全部沿用
+        ASSERT_TRUE(loaded.refresh(p, d, &st));
+        EXPECT_TRUE(st.journal);
+        EXPECT_EQ(st.reparsed, 4u);
+        EXPECT_EQ(st.unchanged, 3u);
+    }
+
+    // C API：项目保存后在新句柄中载入，再次扫描得到相同的候选项
+    ASSERT_EQ(fr_init(temp_directory_path().string().c_str()), FR_OK);
+    fr_handle_t h = fr_open_image(tmp.string().c_str(), nullptr);
+    ASSERT_NE(h, nullptr);
+    ASSERT_EQ(fr_start_scan(h, nullptr), FR_OK);
+    ASSERT_EQ(fr_save_project(h, saved.string().c_str()), FR_OK);
+    fr_close(h);
+    h = fr_open_image(tmp.string().c_str(), nullptr);
+    ASSERT_NE(h, nullptr);
+    ASSERT_EQ(fr_load_project(h, saved.string().c_str()), FR_OK);
+    ASSERT_EQ(fr_start_scan(h, nullptr), FR_OK);
+    fr_candidate_t c;
+    std::vector<std::string> names;
+    while (fr_get_next_candidate(h, &c) == FR_OK) names.push_back(c.file_name);
+    EXPECT_EQ(names, (std::vector<std::string>{ "\\$Extend\\$UsnJrnl", "\\x.txt", "\\bb.txt", "\\d.txt" }));
+    EXPECT_EQ(fr_load_project(h, (saved.string() + ".missing").c_str()), FR_ERR_IO);
+    fr_close(h);
+    fr_shutdown();
+
+    std::error_code ec;
+    remove(tmp, ec);
+    remove(saved, ec);
+}
+
+TEST(MFTPathResolver, ResolvesPathsOrphansAndCycles) {
+    MFTTable t;
+    auto add = [&](uint64_t id, const char* name, uint16_t flags, uint16_t seq, uint64_t parent, uint16_t parent_seq) {
+        NTFSFileRecord r;
+        r.id = id; r.name = name; r.size = 0; r.flags = flags; r.link_count = 1;
+        r.creation_time = 0; r.modified_time = 0; r.name_namespace = 1;
+        r.sequence_number = seq;
+        r.parent_reference = parent | (static_cast<uint64_t>(parent_seq) << 48);
+        return t.append(r);
+    };
+    MFTRow root = add(5, ".", 3, 5, 5, 5);
+    MFTRow users = add(40, "Users", 3, 1, 5, 5);
+    add(41, "alice", 3, 1, 40, 1);
+    MFTRow a = add(42, "a.txt", 1, 1, 41, 1);
+    MFTRow reused = add(43, "gone.txt", 1, 1, 44, 3);   // 父目录记录已被复用（序列号 5）
+    add(44, "newdir", 3, 5, 5, 5);
+    MFTRow x = add(45, "x", 3, 1, 46, 1);               // x ↔ y 成环
+    add(46, "y", 3, 1, 45, 1);
+    MFTRow c = add(47, "c.txt", 1, 1, 45, 1);
+    MFTRow del = add(48, "del.txt", 0, 2, 49, 2);       // 已删除文件引用已删除的目录
+    add(49, "old", 2, 3, 40, 1);
+    MFTRow lost = add(50, "lost.txt", 1, 1, 999, 1);
+    MFTRow unchecked = add(51, "raw.bin", 1, 1, 40, 0); // 引用未携带序列号
+    MFTRow under_file = add(52, "weird", 1, 1, 42, 1);  // 父记录不是目录
+
+    MFTPathResolver res(t);
+    std::string p;
+    EXPECT_EQ(res.path(root, p), MFT_PATH_OK);
+    EXPECT_EQ(p, "\\");
+    EXPECT_EQ(res.path(users), "\\Users");
+    EXPECT_EQ(res.path(a, p), MFT_PATH_OK);
+    EXPECT_EQ(p, "\\Users\\alice\\a.txt");
+    EXPECT_EQ(res.path(reused, p), MFT_PATH_ORPHAN);
+    EXPECT_EQ(p, "\\$OrphanFiles\\gone.txt");
+    EXPECT_EQ(res.path(c, p), MFT_PATH_CYCLE);
+    EXPECT_TRUE(p == "\\$OrphanFiles\\y\\x\\c.txt" || p == "\\$OrphanFiles\\x\\c.txt") << p;
+    EXPECT_EQ(res.status(x), MFT_PATH_CYCLE);
+    EXPECT_EQ(res.path(del, p), MFT_PATH_OK);
+    EXPECT_EQ(p, "\\Users\\old\\del.txt");
+    EXPECT_EQ(res.path(lost, p), MFT_PATH_ORPHAN);
+    EXPECT_EQ(p, "\\$OrphanFiles\\lost.txt");
+    EXPECT_EQ(res.path(unchecked), "\\Users\\raw.bin");
+    EXPECT_EQ(res.status(under_file), MFT_PATH_ORPHAN);
+    MFTRow parent = 0;
+    ASSERT_TRUE(res.parent(a, parent));
+    EXPECT_EQ(t.id(parent), 41u);
+    EXPECT_FALSE(res.parent(root, parent));
+
+    // 深层目录链：每个目录的路径只拼接一次，显式栈不会因深度溢出
+    MFTTable deep;
+    NTFSFileRecord r;
+    r.size = 0; r.link_count = 1; r.creation_time = 0; r.modified_time = 0; r.name_namespace = 1;
+    r.id = 5; r.name = "."; r.flags = 3; r.parent_reference = 5;
+    deep.append(r);
+    const uint64_t depth = 20000;
+    for (uint64_t i = 0; i < depth; ++i) {
+        r.id = 100 + 2 * i; r.name = "d"; r.flags = 3; r.parent_reference = i ? 100 + 2 * (i - 1) : 5;
+        deep.append(r);
+        r.id = 101 + 2 * i; r.name = "f"; r.flags = 1; r.parent_reference = r.id - 1;
+        deep.append(r);
+    }
+    MFTPathResolver dres(deep);
+    MFTRow last = static_cast<MFTRow>(deep.size() - 1);
+    EXPECT_EQ(dres.path(last, p), MFT_PATH_OK);
+    EXPECT_EQ(p.size(), depth * 2 + 2);
+    EXPECT_EQ(dres.memoized(), depth + 1);
+    for (MFTRow row : deep.rows()) ASSERT_EQ(dres.status(row), MFT_PATH_OK);
+    EXPECT_EQ(dres.memoized(), depth + 1);
+}
+
+TEST(MFTPathResolver, CandidatesCarryFullPaths) {
+    using namespace std::filesystem;
+    auto suffix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    path tmp = temp_directory_path() / (std::string("filerecover-mft-paths-") + suffix + std::string(".bin"));
+    {
+        std::vector<uint8_t> img = build_fragmented_volume();
+        std::ofstream of(tmp, std::ios::binary);
+        of.write(reinterpret_cast<const char*>(img.data()), img.size());
+    }
+    ASSERT_EQ(fr_init(temp_directory_path().string().c_str()), FR_OK);
+    fr_error_t err = FR_OK;
+    fr_handle_t h = fr_open_image(tmp.string().c_str(), &err);
+    ASSERT_NE(h, nullptr);
+    fr_scan_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.max_threads = 2;
+    ASSERT_EQ(fr_start_scan(h, &params), FR_OK);
+    fr_candidate_t c;
+    ASSERT_EQ(fr_get_next_candidate(h, &c), FR_OK);
+    EXPECT_EQ(c.id, 17u); // 16 是目录 docs
+    EXPECT_STREQ(c.file_name, "\\docs\\file_17.dat");
+    size_t n = 1;
+    while (fr_get_next_candidate(h, &c) == FR_OK) {
+        ASSERT_EQ(std::string(c.file_name), "\\docs\\file_" + std::to_string(c.id) + ".dat");
+        ++n;
+    }
+    EXPECT_EQ(n, 2983u - 30); // 记录 17..2999，去掉 30 个空槽位
+    fr_close(h);
+    fr_shutdown();
+    std::error_code ec;
+    remove(tmp, ec);
+}
+
+// 逐码元 push_back 的参考实现（向量化之前的转换逻辑），作为差分测试的基准
+static std::string reference_utf16le_to_utf8(const uint8_t* data, size_t bytes) {
+    std::string out;
+    auto append_utf8 = [&](uint32_t cp) {
+        if (cp <= 0x7F) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp <= 0x7FF) {
+            out.push_back(static_cast<char>(0xC0 | ((cp >> 6) & 0x1F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp <= 0xFFFF) {
+            out.push_back(static_cast<char>(0xE0 | ((cp >> 12) & 0x0F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | ((cp >> 18) & 0x07)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    };
+    size_t pos = 0;
+    while (pos + 1 < bytes) {
+        uint16_t w1 = static_cast<uint16_t>(data[pos] | (data[pos + 1] << 8));
+        pos += 2;
+        if (w1 >= 0xD800 && w1 <= 0xDBFF) {
+            if (pos + 1 >= bytes) {
+                append_utf8(0xFFFD);
+                break;
+            }
+            uint16_t w2 = static_cast<uint16_t>(data[pos] | (data[pos + 1] << 8));
+            pos += 2;
+            if (w2 >= 0xDC00 && w2 <= 0xDFFF) append_utf8(0x10000 + ((uint32_t(w1) - 0xD800) << 10) + (uint32_t(w2) - 0xDC00));
+            else append_utf8(0xFFFD);
+        } else if (w1 >= 0xDC00 && w1 <= 0xDFFF) {
+            append_utf8(0xFFFD);
+        } else {
+            append_utf8(w1);
+        }
+    }
+    return out;
+}
+
+TEST(NTFSParser, UTF16ConversionMatchesReference) {
+    const UTF16Impl impls[] = { UTF16_IMPL_SCALAR, UTF16_IMPL_SSE2, UTF16_IMPL_AVX2 };
+    EXPECT_TRUE(utf16le_to_utf8_impl_available(UTF16_IMPL_SCALAR));
+    EXPECT_TRUE(utf16le_to_utf8_impl_available(utf16le_to_utf8_active_impl()));
+
+    // 随机名称：以 ASCII 为主，混入 BMP 字符、合法代理对、孤立的高/低代理项，长度可为奇数字节
+    uint32_t seed = 2024;
+    auto rnd = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    std::vector<uint8_t> in;
+    char out[2048];
+    char cut[2048];
+    for (int iter = 0; iter < 4000; ++iter) {
+        in.clear();
+        size_t units = rnd() % 80;
+        int mix = iter % 4; // 0 纯 ASCII，1 偶有非 ASCII，2 半数非 ASCII，3 大量代理项
+        for (size_t k = 0; k < units; ++k) {
+            uint32_t r = rnd() % 100;
+            uint16_t u;
+            if (mix == 0 || (mix == 1 && r < 95) || (mix == 2 && r < 50)) u = static_cast<uint16_t>(0x20 + rnd() % 0x5F);
+            else if (mix == 3 && r < 30) u = static_cast<uint16_t>(0xD800 + rnd() % 0x400);
+            else if (mix == 3 && r < 60) u = static_cast<uint16_t>(0xDC00 + rnd() % 0x400);
+            else if (r % 3 == 0) u = static_cast<uint16_t>(0x80 + rnd() % 0x780);
+            else u = static_cast<uint16_t>(0x800 + rnd() % 0xD000);
+            in.push_back(static_cast<uint8_t>(u & 0xFF));
+            in.push_back(static_cast<uint8_t>(u >> 8));
+        }
+        if (rnd() % 8 == 0) in.push_back(static_cast<uint8_t>(rnd())); // 奇数字节
+        const std::string want = reference_utf16le_to_utf8(in.data(), in.size());
+        ASSERT_LE(want.size(), sizeof(out));
+        for (UTF16Impl impl : impls) {
+            if (!utf16le_to_utf8_impl_available(impl)) continue;
+            size_t n = utf16le_to_utf8_with(impl, in.data(), in.size(), out, sizeof(out));
+            ASSERT_EQ(std::string(out, n), want) << "impl " << impl << " iter " << iter;
+        }
+        // 输出空间不足时只写出完整的码点，各实现截断位置一致
+        size_t cap = rnd() % (want.size() + 1);
+        size_t base = utf16le_to_utf8_with(UTF16_IMPL_SCALAR, in.data(), in.size(), cut, cap);
+        ASSERT_LE(base, cap);
+        EXPECT_EQ(std::string(cut, base), want.substr(0, base));
+        for (UTF16Impl impl : impls) {
+            if (!utf16le_to_utf8_impl_available(impl)) continue;
+            size_t n = utf16le_to_utf8_with(impl, in.data(), in.size(), out, cap);
+            ASSERT_EQ(std::string(out, n), std::string(cut, base)) << "impl " << impl << " cap " << cap;
+        }
+    }
+    EXPECT_EQ(utf16le_to_utf8(nullptr, 4, out, sizeof(out)), 0u);
+}
+
 // ntfs_test.cpp — 单元测试：NTFS MFT 解析骨架
 #include "ntfs.h"
 #include <gtest/gtest.h>
@@ -0,0 +1,113 @@
+// ntfs_test_util.h — NTFS 测试共用的卷镜像构造辅助（ntfs_tests 与 ntfs_alloc_tests）
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 按 NTFS 写入方式给记录加上 USA 保护：各 512 字节扇区末尾两个字节换成序列号，原值存入 USA
+inline void protect_record(uint8_t* rec, size_t rec_size, uint16_t usa_off, uint16_t usn) {
+    const size_t sectors = rec_size / 512;
+    rec[4] = usa_off & 0xFF; rec[5] = usa_off >> 8;
+    rec[6] = (sectors + 1) & 0xFF; rec[7] = static_cast<uint8_t>((sectors + 1) >> 8);
+    rec[usa_off] = usn & 0xFF; rec[usa_off + 1] = usn >> 8;
+    for (size_t i = 0; i < sectors; ++i) {
+        memcpy(rec + usa_off + 2 * (i + 1), rec + i * 512 + 510, 2);
+        rec[i * 512 + 510] = usn & 0xFF;
+        rec[i * 512 + 511] = usn >> 8;
+    }
+}
+
+// build_test_volume 的卷布局。簇大小 4 KiB、记录大小 1 KiB；记录 i 名为 "file_<i>.dat"
+// （记录 0 为 "$MFT"），父目录为记录 5
+struct TestVolumeLayout {
+    std::vector<std::pair<uint64_t,uint64_t>> frags; // $MFT 各段 <簇数, LCN>，引导扇区指向第一段
+    size_t clusters = 0;      // 镜像总簇数
+    size_t records = 3000;
+    bool damaged = false;     // 记录号为 97 的倍数的槽位为空，为 113 的倍数的记录写入中断（USA 不匹配）
+    bool directories = false; // 记录 5 为根目录 "."，记录 16 为目录 "docs"，此后的记录都位于 docs 下
+    bool file_data = false;   // 记录 i（i > 0）带非常驻 DATA：大小 i * 100 字节，1 簇 @ LCN i
+};
+
+// 构造 layout 描述的 NTFS 卷镜像：$MFT 按 frags 分段写入，记录 0 的 DATA runlist 与之对应
+inline std::vector<uint8_t> build_test_volume(const TestVolumeLayout& layout) {
+    const size_t CL = 4096, REC = 1024, N = layout.records;
+    std::vector<uint8_t> img(layout.clusters * CL, 0);
+    auto put = [&](uint8_t* p, uint64_t v, int bytes) { for (int i = 0; i < bytes; ++i) p[i] = (v >> (8 * i)) & 0xFF; };
+    // 引导扇区
+    memcpy(&img[3], "NTFS    ", 8);
+    put(&img[0x0B], 512, 2);
+    img[0x0D] = 8;
+    put(&img[0x28], img.size() / 512, 8);
+    put(&img[0x30], layout.frags.front().second, 8);
+    put(&img[0x38], 2, 8);
+    img[0x40] = 0xF6;
+    img[0x44] = 1;
+    img[510] = 0x55; img[511] = 0xAA;
+
+    // $MFT 的 runlist：簇数与 LCN 增量各取所需的最少字节（增量按有符号数）
+    std::vector<uint8_t> mft_runlist;
+    int64_t prev_lcn = 0;
+    for (const auto& fr : layout.frags) {
+        int len_bytes = 1, off_bytes = 1;
+        while (len_bytes < 8 && (fr.first >> (8 * len_bytes)) != 0) ++len_bytes;
+        const int64_t delta = static_cast<int64_t>(fr.second) - prev_lcn;
+        while (off_bytes < 8 && (delta < -(int64_t(1) << (8 * off_bytes - 1)) || delta >= (int64_t(1) << (8 * off_bytes - 1)))) {
+            ++off_bytes;
+        }
+        mft_runlist.push_back(static_cast<uint8_t>(len_bytes | (off_bytes << 4)));
+        for (int i = 0; i < len_bytes; ++i) mft_runlist.push_back(static_cast<uint8_t>(fr.first >> (8 * i)));
+        for (int i = 0; i < off_bytes; ++i) mft_runlist.push_back(static_cast<uint8_t>(static_cast<uint64_t>(delta) >> (8 * i)));
+        prev_lcn = static_cast<int64_t>(fr.second);
+    }
+    mft_runlist.push_back(0x00);
+
+    std::vector<uint8_t> mft(N * REC, 0);
+    for (size_t i = 0; i < N; ++i) {
+        if (layout.damaged && i != 0 && i % 97 == 0) continue;
+        uint8_t* r = &mft[i * REC];
+        memcpy(r, "FILE", 4);
+        put(r + 16, 1, 2); // sequence number
+        put(r + 20, 56, 2);
+        const bool dir = layout.directories && (i == 5 || i == 16);
+        put(r + 22, dir ? 0x03 : 0x01, 2);
+        std::string name = i == 0 ? std::string("$MFT")
+                           : layout.directories && i == 5 ? std::string(".")
+                           : layout.directories && i == 16 ? std::string("docs")
+                           : "file_" + std::to_string(i) + ".dat";
+        const uint64_t parent = layout.directories && i > 16 ? 16 : 5;
+        uint8_t* f = r + 56;
+        put(f + 0, 0x30, 4);
+        put(f + 4, 0x78, 4);
+        put(f + 16, 66 + name.size() * 2, 4);
+        put(f + 20, 24, 2);
+        put(f + 24, parent | (1ULL << 48), 8);
+        f[24 + 64] = static_cast<uint8_t>(name.size());
+        for (size_t k = 0; k < name.size(); ++k) f[24 + 66 + k * 2] = name[k];
+        uint8_t* a = f + 0x78;
+        if (i == 0 || layout.file_data) {
+            const uint8_t file_runlist[] = { 0x21, 0x01, static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0x00 };
+            const uint8_t* rl = i == 0 ? mft_runlist.data() : file_runlist;
+            const size_t rl_len = i == 0 ? mft_runlist.size() : sizeof(file_runlist);
+            const size_t attr_len = (64 + rl_len + 7) / 8 * 8;
+            put(a + 0, 0x80, 4);
+            put(a + 4, attr_len, 4);
+            a[8] = 1;
+            put(a + 32, 64, 2);
+            put(a + 48, i == 0 ? mft.size() : i * 100, 8);
+            memcpy(a + 64, rl, rl_len);
+            a += attr_len;
+        }
+        put(a, 0xFFFFFFFF, 4);
+        protect_record(r, REC, 48, static_cast<uint16_t>(i + 1));
+        if (layout.damaged && i % 113 == 0 && i != 0) r[REC - 2] ^= 0x55;
+    }
+    uint64_t file_off = 0;
+    for (const auto& fr : layout.frags) {
+        memcpy(&img[fr.second * CL], &mft[file_off], fr.first * CL);
+        file_off += fr.first * CL;
+    }
+    return img;
+}